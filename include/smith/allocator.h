@@ -41,13 +41,14 @@ void smith_allocator_destroy(smith_allocator_t allocator);
  * Allocates memory for a single instance of type `type` using the specified allocator.
  */
 #define smith_allocator_allocate(allocator, type)                              \
-  (type *)(allocator.allocate)(allocator.state, sizeof(type), alignof(type))
+  (type *)((allocator).allocate)((allocator).state, sizeof(type),              \
+                                 alignof(type))
 
 /**
  * Allocates memory for an array of `count` elements of type `type`, using the specified allocator.
  */
 #define smith_allocator_allocate_array(allocator, type, count)                 \
-  (type *)(allocator.allocate)(allocator.state, sizeof(type) * count,          \
-                               alignof(type))
+  (type *)((allocator).allocate)((allocator).state, sizeof(type) * (count),    \
+                                 alignof(type))
 
 #endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "smith/allocator.h"
+
+/**
+ * The size of the first chunk an arena allocator requests from its parent.
+ * Each later chunk is twice the size of the one before it.
+ */
+#define SMITH_ARENA_MIN_CHUNK_SIZE 65536
+
+/**
+ * A structure representing the result of creating an arena allocator.
+ *
+ * @param allocator The created allocator.
+ * @param success Boolean indicating whether the allocator was successfully created.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  bool success;
+} smith_arena_allocator_create_result_t;
+
+/**
+ * Creates an arena allocator that hands out memory by bumping a pointer
+ * through chunks requested from its parent. Deallocating a single pointer
+ * does nothing; instead everything allocated from the arena is released at
+ * once when the arena is reset or destroyed. Chunks double in size, so the
+ * arena holds a logarithmic number of them and releasing it costs a handful
+ * of calls to the parent no matter how many allocations were made.
+ *
+ * Whatever is allocated from an arena, such as the nodes of an expression or
+ * the blocks of a flat AST, is owned by the arena and does not need to be
+ * destroyed on its own. The arena only borrows its parent: destroying the
+ * arena returns its chunks but leaves the parent alive, so short lived arenas,
+ * one per thread or per task, can share a single parent.
+ *
+ * @param parent The parent allocator to request chunks from.
+ * @return A result containing the new allocator and a success flag.
+ */
+smith_arena_allocator_create_result_t
+smith_arena_allocator_create(smith_allocator_t parent);
+
+/**
+ * Releases everything allocated from an arena while keeping its largest
+ * chunk, so that the next round of allocations of a similar size, such as
+ * the AST of the next incremental build, needs no calls to the parent.
+ *
+ * @param allocator An allocator created by `smith_arena_allocator_create`.
+ */
+void smith_arena_allocator_reset(smith_allocator_t allocator);
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/tokenizer.h"
+#include <stdint.h>
+
+/**
+ * Enumeration of binary operator kinds supported by the parser.
+ */
+typedef enum {
+  SMITH_BINARY_OPERATOR_KIND_ADD,
+  SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN,
+  SMITH_BINARY_OPERATOR_KIND_SUB,
+  SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN,
+  SMITH_BINARY_OPERATOR_KIND_MUL,
+  SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN,
+  SMITH_BINARY_OPERATOR_KIND_DIV,
+  SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN,
+  SMITH_BINARY_OPERATOR_KIND_ASSIGN,
+  SMITH_BINARY_OPERATOR_KIND_EQ,
+  SMITH_BINARY_OPERATOR_KIND_NOT,
+  SMITH_BINARY_OPERATOR_KIND_NOT_EQ,
+  SMITH_BINARY_OPERATOR_KIND_LT,
+  SMITH_BINARY_OPERATOR_KIND_LE,
+  SMITH_BINARY_OPERATOR_KIND_GT,
+  SMITH_BINARY_OPERATOR_KIND_GE,
+  SMITH_BINARY_OPERATOR_KIND_BIT_AND,
+  SMITH_BINARY_OPERATOR_KIND_AND,
+  SMITH_BINARY_OPERATOR_KIND_BIT_OR,
+  SMITH_BINARY_OPERATOR_KIND_OR,
+} smith_binary_operator_kind_t;
+
+/**
+ * Enumeration of operator precedence levels, from loosest to tightest binding.
+ */
+typedef enum {
+  SMITH_PRECEDENCE_LOWEST,
+  SMITH_PRECEDENCE_ASSIGN,
+  SMITH_PRECEDENCE_ADD,
+  SMITH_PRECEDENCE_MUL,
+  SMITH_PRECEDENCE_EQ,
+} smith_precedence_t;
+
+/**
+ * Enumeration of operator associativity types.
+ */
+typedef enum {
+  SMITH_ASSOCIATIVITY_LEFT,  // Left-to-right associativity
+  SMITH_ASSOCIATIVITY_RIGHT  // Right-to-left associativity
+} smith_associativity_t;
+
+/**
+ * Represents information about a binary operator including its kind,
+ * precedence, and associativity.
+ */
+typedef struct {
+  smith_binary_operator_kind_t kind;
+  smith_precedence_t precedence;
+  smith_associativity_t associativity;
+} smith_binary_operator_info_t;
+
+/**
+ * Enumeration of expression kinds.
+ */
+typedef enum {
+  SMITH_EXPRESSION_KIND_SYMBOL,
+  SMITH_EXPRESSION_KIND_INT,
+  SMITH_EXPRESSION_KIND_FLOAT,
+  SMITH_EXPRESSION_KIND_BINARY_OPERATOR,
+  SMITH_EXPRESSION_KIND_CONSTANT,
+} smith_expression_kind_t;
+
+/**
+ * Enumeration of the types of value a constant can have.
+ */
+typedef enum {
+  SMITH_CONSTANT_KIND_INT,
+  SMITH_CONSTANT_KIND_FLOAT,
+  SMITH_CONSTANT_KIND_BOOL,
+} smith_constant_kind_t;
+
+/**
+ * Union of the values a constant can have.
+ */
+typedef union {
+  int64_t int_;
+  double float_;
+  bool bool_;
+} smith_constant_value_t;
+
+/**
+ * Represents a value computed at compile time, such as the result of folding
+ * an operator whose operands are all literals. Unlike a literal it has no
+ * text of its own.
+ *
+ * @param kind The type of the value.
+ * @param value The value.
+ */
+typedef struct {
+  smith_constant_kind_t kind;
+  smith_constant_value_t value;
+} smith_constant_t;
+
+
+/**
+ * Identifies a node of a flat AST by its index.
+ */
+typedef uint32_t smith_ast_node_t;
+
+/**
+ * The two operands of a binary operator node.
+ *
+ * @param left The node of the left operand.
+ * @param right The node of the right operand.
+ */
+typedef struct {
+  smith_ast_node_t left;
+  smith_ast_node_t right;
+} smith_ast_children_t;
+
+/**
+ * The name or number a symbol, int or float node was built from.
+ *
+ * @param text The text of the leaf in the source text.
+ * @param interned The interned text, or 0 when parsed with the null interner.
+ */
+typedef struct {
+  smith_string_t text;
+  smith_interned_t interned;
+} smith_ast_leaf_t;
+
+/**
+ * The data of a node beyond its kind, span and children.
+ */
+typedef union {
+  smith_ast_leaf_t leaf;
+  smith_binary_operator_info_t binary_operator;
+  smith_constant_t constant;
+} smith_ast_payload_t;
+
+/**
+ * Represents expressions as a flat array of nodes stored as a struct of
+ * arrays, all carved out of a single allocation. Nodes refer to their
+ * children by 32 bit index rather than by pointer. Children always precede
+ * their parent, and the nodes of a subtree occupy a contiguous range ending
+ * at its root, so visiting every node bottom up is a linear scan.
+ *
+ * @param allocator Memory allocator for the node arrays.
+ * @param kinds The kind of each node, one byte each.
+ * @param spans The span of each leaf, or of the operator of each binary node.
+ * Constants span all of the text they were folded from.
+ * @param children The operands of each binary operator node.
+ * @param payloads The leaf text, operator info or constant value of each node.
+ * @param count The number of nodes.
+ * @param capacity The number of nodes the arrays can hold without growing.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  uint8_t *kinds;
+  smith_span_t *spans;
+  smith_ast_children_t *children;
+  smith_ast_payload_t *payloads;
+  uint32_t count;
+  uint32_t capacity;
+} smith_ast_t;
+
+/**
+ * Defines the minimum capacity of an AST once it allocates.
+ */
+#define SMITH_AST_MIN_CAPACITY 64
+
+/**
+ * Creates an empty AST. No memory is allocated until the first node is added.
+ *
+ * @param allocator The allocator to use for the node arrays.
+ * @return The empty AST.
+ */
+smith_ast_t smith_ast_create(smith_allocator_t allocator);
+
+/**
+ * Ensures the AST can hold at least `capacity` nodes without growing again.
+ *
+ * @param ast The AST.
+ * @param capacity The number of nodes to make room for.
+ * @return True if the node arrays could grow to hold them.
+ */
+bool smith_ast_reserve(smith_ast_t *ast, uint32_t capacity);
+
+/**
+ * Represents the result of adding a node to an AST.
+ *
+ * @param node The added node.
+ * @param success Indicates whether the node arrays could grow to hold it.
+ */
+typedef struct {
+  smith_ast_node_t node;
+  bool success;
+} smith_ast_push_result_t;
+
+/**
+ * Adds a symbol, int or float node.
+ *
+ * @param ast The AST.
+ * @param kind The kind of the leaf.
+ * @param span The span of the leaf in the source text.
+ * @param leaf The text of the leaf.
+ * @return The result of adding the node.
+ */
+smith_ast_push_result_t smith_ast_push_leaf(smith_ast_t *ast,
+                                            smith_expression_kind_t kind,
+                                            smith_span_t span,
+                                            smith_ast_leaf_t leaf);
+
+/**
+ * Adds a binary operator node over two nodes already in the AST.
+ *
+ * @param ast The AST.
+ * @param info The operator.
+ * @param op_span The span of the operator in the source text.
+ * @param children The operands.
+ * @return The result of adding the node.
+ */
+smith_ast_push_result_t
+smith_ast_push_binary_operator(smith_ast_t *ast,
+                               smith_binary_operator_info_t info,
+                               smith_span_t op_span,
+                               smith_ast_children_t children);
+
+/**
+ * Appends all the nodes of another AST, shifting their child indices so that
+ * they refer to the same nodes at their new positions. Node `i` of `other`
+ * becomes node `i + ast->count` of `ast`, counted from before the append.
+ *
+ * @param ast The AST to append to.
+ * @param other The AST whose nodes to append.
+ * @return True if the node arrays could grow to hold the nodes.
+ */
+bool smith_ast_append(smith_ast_t *ast, const smith_ast_t *other);
+
+/**
+ * Adds a constant node.
+ *
+ * @param ast The AST.
+ * @param span The span of the source text the constant was computed from.
+ * @param constant The value of the constant.
+ * @return The result of adding the node.
+ */
+smith_ast_push_result_t smith_ast_push_constant(smith_ast_t *ast,
+                                                smith_span_t span,
+                                                smith_constant_t constant);
+
+/**
+ * Finds the first node of the subtree rooted at `node`, so that the subtree
+ * occupies `[smith_ast_first(ast, node), node]`.
+ *
+ * @param ast The AST.
+ * @param node The root of the subtree.
+ * @return The first node of the subtree.
+ */
+smith_ast_node_t smith_ast_first(const smith_ast_t *ast, smith_ast_node_t node);
+
+/**
+ * Destroys the AST, releasing its nodes with a single deallocation.
+ *
+ * @param ast The AST to destroy.
+ */
+void smith_ast_destroy(smith_ast_t ast);
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "smith/ast.h"
+
+/**
+ * Stands for no node, such as the parent of a root.
+ */
+#define SMITH_AST_INDEX_NO_NODE UINT32_MAX
+
+/**
+ * Indexes the nodes of a flat AST by where they are in the source text, for
+ * editor queries such as finding the node under the cursor.
+ *
+ * Every node has a span of its own: the text of a leaf or constant, or the
+ * operator of a binary node. These spans never overlap, and listed in source
+ * order they are an in-order walk of each expression, in which neighbours are
+ * always ancestor and descendant. Sorting them once is enough to answer any
+ * query with a binary search. The extent of a node is all of the text of its
+ * subtree, from its leftmost to its rightmost leaf.
+ *
+ * The index is a snapshot: it does not follow later changes to the AST.
+ *
+ * @param allocator Memory allocator for the arrays.
+ * @param nodes Every node, sorted by where its own span starts.
+ * @param spans The own span of each entry of `nodes`.
+ * @param parents The parent of each node, or `SMITH_AST_INDEX_NO_NODE`.
+ * @param extents The extent of each node.
+ * @param count The number of nodes.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_ast_node_t *nodes;
+  smith_span_t *spans;
+  smith_ast_node_t *parents;
+  smith_span_t *extents;
+  uint32_t count;
+} smith_ast_index_t;
+
+/**
+ * Represents the result of indexing an AST.
+ *
+ * @param index The index.
+ * @param success Indicates whether the arrays could be allocated.
+ */
+typedef struct {
+  smith_ast_index_t index;
+  bool success;
+} smith_ast_index_create_result_t;
+
+/**
+ * Indexes every node of an AST. The parents, extents and source order of the
+ * nodes are all found in two linear passes. Only an AST whose expressions
+ * were not added in source order needs sorting.
+ *
+ * @param allocator The allocator to use for the index.
+ * @param ast The AST to index.
+ * @return The index, to be released with `smith_ast_index_destroy`.
+ */
+smith_ast_index_create_result_t
+smith_ast_index_create(smith_allocator_t allocator, const smith_ast_t *ast);
+
+/**
+ * Represents the result of looking up a node.
+ *
+ * @param node The node found.
+ * @param success False if no node covers the position.
+ */
+typedef struct {
+  smith_ast_node_t node;
+  bool success;
+} smith_ast_index_find_result_t;
+
+/**
+ * Finds the innermost node whose extent covers a position in O(log n): the
+ * leaf or operator at the position, or the binary node whose operands are on
+ * either side of it when it falls between tokens.
+ *
+ * @param index The index.
+ * @param position The position in the source text.
+ * @return The innermost node, or failure outside of every expression.
+ */
+smith_ast_index_find_result_t
+smith_ast_index_innermost(const smith_ast_index_t *index,
+                          smith_position_t position);
+
+/**
+ * Represents a range of the entries of an index, in source order.
+ *
+ * @param start The first entry.
+ * @param end One past the last entry.
+ */
+typedef struct {
+  uint32_t start;
+  uint32_t end;
+} smith_ast_index_range_t;
+
+/**
+ * Finds the nodes whose own span overlaps a range of the source text in
+ * O(log n). They are consecutive entries of `index->nodes`. The other nodes
+ * whose extent overlaps the range are their ancestors, which can be reached
+ * through `index->parents`.
+ *
+ * @param index The index.
+ * @param span The range of the source text.
+ * @return The entries of the nodes overlapping the range.
+ */
+smith_ast_index_range_t smith_ast_index_overlapping(const smith_ast_index_t *index,
+                                                    smith_span_t span);
+
+/**
+ * Destroys an index, releasing its arrays.
+ *
+ * @param index The index to destroy.
+ */
+void smith_ast_index_destroy(smith_ast_index_t index);
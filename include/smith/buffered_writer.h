@@ -0,0 +1,96 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/writer.h"
+
+/**
+ * Defines the default number of bytes gathered before they are written.
+ */
+#define SMITH_BUFFERED_WRITER_DEFAULT_CAPACITY 65536
+
+/**
+ * Represents a writer that gathers small writes into a buffer and passes
+ * them on a buffer at a time, so emitting output piece by piece costs one
+ * call to the underlying writer per buffer rather than per piece.
+ *
+ * @param allocator Memory allocator for the buffer.
+ * @param writer The writer the buffered bytes are passed to.
+ * @param buffer The bytes not yet passed on.
+ * @param length The number of bytes held in the buffer.
+ * @param capacity The number of bytes the buffer can hold.
+ * @param failed Whether a write has failed. Once set, later writes are
+ * dropped, so a sequence of writes can be checked once at the end.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_writer_t writer;
+  char *buffer;
+  size_t length;
+  size_t capacity;
+  bool failed;
+} smith_buffered_writer_t;
+
+/**
+ * Structure representing the result of creating a buffered writer.
+ *
+ * @param writer The created buffered writer.
+ * @param success Indicates whether the creation was successful.
+ */
+typedef struct {
+  smith_buffered_writer_t writer;
+  bool success;
+} smith_buffered_writer_create_result_t;
+
+/**
+ * Creates a buffered writer.
+ *
+ * @param allocator The allocator for the buffer.
+ * @param writer The writer to pass the bytes to. It is borrowed and must be
+ * destroyed separately.
+ * @param capacity The size of the buffer, or 0 for
+ * `SMITH_BUFFERED_WRITER_DEFAULT_CAPACITY`.
+ * @return A result containing the new buffered writer and a success flag.
+ */
+smith_buffered_writer_create_result_t
+smith_buffered_writer_create(smith_allocator_t allocator,
+                             smith_writer_t writer, size_t capacity);
+
+/**
+ * Writes bytes through the buffer. Writes larger than the buffer are passed
+ * on directly.
+ *
+ * @param writer The buffered writer.
+ * @param buffer The bytes to write.
+ * @param length The number of bytes to write.
+ * @return False if this or an earlier write failed.
+ */
+bool smith_buffered_writer_write(smith_buffered_writer_t *writer,
+                                 const char *buffer, size_t length);
+
+/**
+ * Formats into the buffer as `smith_format_string` does, without allocating
+ * a string for the result unless it is larger than the buffer.
+ *
+ * @param writer The buffered writer.
+ * @param format The format string (similar to printf format).
+ * @param ... Variable arguments providing additional data to format.
+ * @return False if this or an earlier write failed.
+ */
+bool smith_buffered_writer_format(smith_buffered_writer_t *writer,
+                                  const char *format, ...);
+
+/**
+ * Passes the buffered bytes on to the underlying writer.
+ *
+ * @param writer The buffered writer.
+ * @return False if this or an earlier write failed.
+ */
+bool smith_buffered_writer_flush(smith_buffered_writer_t *writer);
+
+/**
+ * Destroys the buffered writer, releasing its buffer. Bytes not yet flushed
+ * are dropped.
+ *
+ * @param writer The buffered writer to destroy.
+ */
+void smith_buffered_writer_destroy(smith_buffered_writer_t writer);
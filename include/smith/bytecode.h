@@ -0,0 +1,150 @@
+#pragma once
+
+#include "smith/parser.h"
+
+/**
+ * Enumeration of bytecode instructions. Every operator instruction is typed,
+ * so the interpreter never inspects the type of a value: the compiler picks
+ * the instruction for the types of the operands. Operators read `left` and
+ * `right` and write `destination`.
+ */
+typedef enum {
+  SMITH_OPCODE_MOVE, // Copies register `left` to `destination`.
+  SMITH_OPCODE_INT_ADD,
+  SMITH_OPCODE_INT_SUB,
+  SMITH_OPCODE_INT_MUL,
+  SMITH_OPCODE_INT_DIV,
+  SMITH_OPCODE_INT_EQ,
+  SMITH_OPCODE_INT_NOT_EQ,
+  SMITH_OPCODE_INT_LT,
+  SMITH_OPCODE_INT_LE,
+  SMITH_OPCODE_INT_GT,
+  SMITH_OPCODE_INT_GE,
+  SMITH_OPCODE_INT_BIT_AND,
+  SMITH_OPCODE_INT_BIT_OR,
+  SMITH_OPCODE_FLOAT_ADD,
+  SMITH_OPCODE_FLOAT_SUB,
+  SMITH_OPCODE_FLOAT_MUL,
+  SMITH_OPCODE_FLOAT_DIV,
+  SMITH_OPCODE_FLOAT_EQ,
+  SMITH_OPCODE_FLOAT_NOT_EQ,
+  SMITH_OPCODE_FLOAT_LT,
+  SMITH_OPCODE_FLOAT_LE,
+  SMITH_OPCODE_FLOAT_GT,
+  SMITH_OPCODE_FLOAT_GE,
+  SMITH_OPCODE_BOOL_EQ,
+  SMITH_OPCODE_BOOL_NOT_EQ,
+  SMITH_OPCODE_BOOL_AND,
+  SMITH_OPCODE_BOOL_OR,
+  SMITH_OPCODE_RETURN, // Returns register `left`.
+} smith_opcode_t;
+
+/**
+ * Represents one instruction: an opcode and three register operands, eight
+ * bytes in all.
+ *
+ * @param opcode The operation, a `smith_opcode_t`.
+ * @param destination The register written.
+ * @param left The first register read.
+ * @param right The second register read.
+ */
+typedef struct {
+  uint16_t opcode;
+  uint16_t destination;
+  uint16_t left;
+  uint16_t right;
+} smith_instruction_t;
+
+/**
+ * Defines the largest number of registers a program can use, as register
+ * operands are 16 bits.
+ */
+#define SMITH_BYTECODE_MAX_REGISTERS 65536
+
+/**
+ * Represents a compiled expression. Registers are laid out as the parameters,
+ * then the constants, then the variables the expression assigns, then the
+ * temporaries holding intermediate values. The constants pool is copied into
+ * its registers when the program starts, so instructions read constants like
+ * any other register and a literal costs no instruction.
+ *
+ * @param allocator The allocator for the instructions and constants.
+ * @param instructions The instructions, ending with a return.
+ * @param count The number of instructions.
+ * @param capacity The number of instructions the array can hold.
+ * @param constants The constants pool, each value once.
+ * @param constant_count The number of constants.
+ * @param parameter_count The number of parameters.
+ * @param register_count The number of registers the program uses.
+ * @param result_kind The type of the value the program returns.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_instruction_t *instructions;
+  size_t count;
+  size_t capacity;
+  smith_constant_value_t *constants;
+  uint32_t constant_count;
+  uint32_t parameter_count;
+  uint32_t register_count;
+  smith_constant_kind_t result_kind;
+} smith_bytecode_t;
+
+/**
+ * Represents a parameter of a compiled expression: a symbol whose value is
+ * passed in when the program runs.
+ *
+ * @param name The name of the parameter.
+ * @param kind The type of the parameter.
+ */
+typedef struct {
+  smith_string_t name;
+  smith_constant_kind_t kind;
+} smith_bytecode_parameter_t;
+
+/**
+ * Represents the result of compiling an expression.
+ *
+ * @param bytecode The compiled program.
+ * @param success Whether the expression could be compiled.
+ */
+typedef struct {
+  smith_bytecode_t bytecode;
+  bool success;
+} smith_bytecode_compile_result_t;
+
+/**
+ * Compiles an expression to register bytecode. The expression is walked in
+ * post-order without recursion, so arbitrarily deep expressions compile.
+ *
+ * Operators take operands of one type, as in `smith_constant_fold`: int and
+ * float arithmetic, comparisons producing bools, and bools compared for
+ * equality. `&` and `|` apply to ints and bools, and `and` and `or` to bools;
+ * their operands cannot have side effects, so both are evaluated. Assigning a
+ * symbol makes it a variable of the assigned type, and `+=`, `-=`, `*=` and
+ * `/=` update one. The value of an assignment is the assigned value.
+ *
+ * Compilation fails on operands of different types, an operator with no
+ * meaning for its operands, reading a symbol that is neither a parameter nor
+ * assigned before, assigning to something other than a symbol, a literal too
+ * large for its type, more than `SMITH_BYTECODE_MAX_REGISTERS` registers, or
+ * allocation failure.
+ *
+ * @param allocator The allocator for the program.
+ * @param expression The expression to compile.
+ * @param parameters The parameters, which take the first registers.
+ * @param parameter_count The number of parameters.
+ * @return The program, to be released with `smith_bytecode_destroy`.
+ */
+smith_bytecode_compile_result_t
+smith_bytecode_compile(smith_allocator_t allocator,
+                       const smith_expression_t *expression,
+                       const smith_bytecode_parameter_t *parameters,
+                       uint32_t parameter_count);
+
+/**
+ * Destroys a program, releasing its instructions and constants.
+ *
+ * @param bytecode The program to destroy.
+ */
+void smith_bytecode_destroy(smith_bytecode_t bytecode);
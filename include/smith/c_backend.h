@@ -0,0 +1,63 @@
+#pragma once
+
+#include "smith/buffered_writer.h"
+#include "smith/ir.h"
+
+/**
+ * Enumeration of what the C backend builds.
+ */
+typedef enum {
+  // A shared object exporting the function, to be loaded with `dlopen`.
+  SMITH_C_OUTPUT_SHARED_OBJECT,
+  // A program taking the arguments on its command line and printing the
+  // result, or exiting with status 1 if the function traps.
+  SMITH_C_OUTPUT_EXECUTABLE,
+} smith_c_output_kind_t;
+
+/**
+ * Emits a function as portable C99. The function is emitted as
+ *
+ *     bool name(const smith_value_t *arguments, smith_value_t *result);
+ *
+ * where `smith_value_t` is a union laid out as `smith_constant_value_t`, so
+ * a loaded function can be called with the same arguments as `smith_vm_run`.
+ * It returns false where the bytecode would trap, and otherwise stores the
+ * result. Each value becomes a local, so the C compiler allocates registers.
+ *
+ * @param writer The writer to emit to. It is not flushed.
+ * @param function The function, a single block, ideally optimized.
+ * @param parameters The parameters of the function, whose kinds an
+ * executable parses its arguments as.
+ * @param name The name of the function: an ASCII letter followed by letters,
+ * digits and underscores that is not a C keyword or a name the emitted file
+ * declares, such as `smith_value_t` or `smith_add`. An executable's function
+ * cannot be named `main`, or after the locals of `main`: `argc`, `argv`,
+ * `arguments` and `result`.
+ * @param kind Whether to emit a `main` calling the function as well.
+ * @return False if the name is not valid, the function has more than one
+ * block or the writer failed.
+ */
+bool smith_c_emit(smith_buffered_writer_t *writer,
+                  const smith_ir_function_t *function,
+                  const smith_bytecode_parameter_t *parameters,
+                  const char *name, smith_c_output_kind_t kind);
+
+/**
+ * Compiles a function to a native shared object or executable: the function
+ * is emitted to a temporary C file, which the system C compiler builds. The
+ * compiler is `$CC` if set and `cc` otherwise.
+ *
+ * @param allocator The allocator for the writers.
+ * @param function The function, a single block, ideally optimized.
+ * @param parameters The parameters of the function.
+ * @param name The name of the function, valid as for `smith_c_emit`.
+ * @param kind What to build.
+ * @param output_path Where the compiler writes the shared object or
+ * executable.
+ * @return Whether the output was built.
+ */
+bool smith_c_build(smith_allocator_t allocator,
+                   const smith_ir_function_t *function,
+                   const smith_bytecode_parameter_t *parameters,
+                   const char *name, smith_c_output_kind_t kind,
+                   const char *output_path);
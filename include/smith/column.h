@@ -0,0 +1,80 @@
+#pragma once
+
+#include "smith/bytecode.h"
+
+/**
+ * Defines how many rows are evaluated at a time. Each register holds a block
+ * of this many values, 8 KiB, so the blocks an expression works on at once
+ * stay in cache.
+ */
+#define SMITH_COLUMN_BLOCK_SIZE 1024
+
+/**
+ * Represents an expression compiled to evaluate a column at a time. The
+ * expression is compiled to bytecode, and each instruction runs as one loop
+ * over a block of rows, with SIMD kernels where the instruction set has them,
+ * rather than walking the expression once per row.
+ *
+ * @param allocator The allocator for the bytecode and the register blocks.
+ * @param bytecode The bytecode each block of rows runs. Its bool constants
+ * are ints of 0 or 1, as the kernels hold bools.
+ * @param parameter_kinds The type of each parameter's column.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_bytecode_t bytecode;
+  smith_constant_kind_t *parameter_kinds;
+} smith_column_program_t;
+
+/**
+ * Represents the result of compiling an expression to evaluate over columns.
+ *
+ * @param program The compiled program.
+ * @param success Whether the expression could be compiled, as for
+ * `smith_bytecode_compile`.
+ */
+typedef struct {
+  smith_column_program_t program;
+  bool success;
+} smith_column_compile_result_t;
+
+/**
+ * Compiles an expression to evaluate over columns. Each parameter is bound to
+ * a column: an `int64_t` array for an int, a `double` array for a float and a
+ * `bool` array for a bool.
+ *
+ * @param allocator The allocator for the program.
+ * @param expression The expression to compile.
+ * @param parameters The parameters of the expression.
+ * @param parameter_count The number of parameters.
+ * @return The program, to be released with `smith_column_program_destroy`.
+ */
+smith_column_compile_result_t
+smith_column_compile(smith_allocator_t allocator,
+                     const smith_expression_t *expression,
+                     const smith_bytecode_parameter_t *parameters,
+                     uint32_t parameter_count);
+
+/**
+ * Evaluates a program over every row of its columns. Each row computes what
+ * `smith_vm_run` would given that row's values as arguments. Variables do not
+ * carry over from one row to the next.
+ *
+ * @param program The program.
+ * @param columns The column of each parameter, with `row_count` values each.
+ * @param row_count The number of rows.
+ * @param results An array of `row_count` values of type
+ * `program->bytecode.result_kind`, laid out as the columns are.
+ * @return False if any row trapped, in which case the results are
+ * unspecified, or if the register blocks could not be allocated.
+ */
+bool smith_column_run(const smith_column_program_t *program,
+                      const void *const *columns, size_t row_count,
+                      void *results);
+
+/**
+ * Destroys a program.
+ *
+ * @param program The program to destroy.
+ */
+void smith_column_program_destroy(smith_column_program_t program);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "smith/ast.h"
+
+/**
+ * Represents the result of computing a constant.
+ *
+ * @param constant The computed constant.
+ * @param success Whether the value could be computed at compile time.
+ */
+typedef struct {
+  smith_constant_t constant;
+  bool success;
+} smith_constant_result_t;
+
+/**
+ * Computes the value of an int or float literal from its text. Ints are 64
+ * bit and signed; a literal too large for that fails, as does a float literal
+ * that is not a single decimal number, such as `1.2.3`.
+ *
+ * @param kind The kind of the literal, `SMITH_EXPRESSION_KIND_INT` or
+ * `SMITH_EXPRESSION_KIND_FLOAT`.
+ * @param text The text of the literal.
+ * @return The value of the literal, or failure.
+ */
+smith_constant_result_t smith_constant_from_literal(smith_expression_kind_t kind,
+                                                    smith_string_t text);
+
+/**
+ * Applies an arithmetic or comparison operator to two constants of the same
+ * type. Int arithmetic is checked: an operation that overflows 64 bits or
+ * divides by zero fails rather than producing a value, so it is left for the
+ * program to report when it runs. Division truncates toward zero. Float
+ * arithmetic follows IEEE 754 double precision, including infinities and
+ * NaN. Comparisons produce bools, and bools can only be compared for
+ * equality. Operands of different types and every other operator fail.
+ *
+ * @param kind The operator.
+ * @param left The left operand.
+ * @param right The right operand.
+ * @return The result of the operator, or failure.
+ */
+smith_constant_result_t smith_constant_fold(smith_binary_operator_kind_t kind,
+                                            smith_constant_t left,
+                                            smith_constant_t right);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/interner.h"
+
+/**
+ * Defines the size of the blocks the copying interner stores strings in.
+ * Strings longer than a block get a block of their own.
+ */
+#define SMITH_COPYING_INTERNER_BLOCK_SIZE 4096
+
+/**
+ * Structure representing the result of creating a copying interner.
+ *
+ * @param interner The created copying interner.
+ * @param success Indicates whether the creation was successful.
+ */
+typedef struct {
+  smith_interner_t interner;
+  bool success;
+} smith_copying_interner_create_result_t;
+
+/**
+ * Creates an interner that copies every newly interned string into storage it
+ * owns before handing it to the parent interner. Interners otherwise borrow
+ * the strings they are given, so this is required whenever the source text is
+ * transient, e.g. when tokenizing from a reusable stream buffer.
+ * Destroying the copying interner also destroys the parent interner.
+ *
+ * @param allocator The allocator to use for the copied strings.
+ * @param parent The interner that the copies are interned into.
+ * @return The result of creating the copying interner.
+ */
+smith_copying_interner_create_result_t
+smith_copying_interner_create(smith_allocator_t allocator,
+                              smith_interner_t parent);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -25,6 +26,18 @@ typedef struct {
   smith_position_t end;   // End position of the span.
 } smith_span_t;
 
+/**
+ * Represents a range of byte offsets into the source text.
+ * Unlike a span, offsets can be compared and shifted without knowing where lines start.
+ *
+ * @param start The offset of the first byte in the range.
+ * @param end The offset one past the last byte in the range.
+ */
+typedef struct {
+  size_t start; // Offset of the first byte.
+  size_t end;   // Offset one past the last byte.
+} smith_offsets_t;
+
 /**
  * Represents a cursor for text parsing that keeps track of the current position in the source text
  * and the associated character data.
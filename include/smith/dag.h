@@ -0,0 +1,171 @@
+#pragma once
+
+#include "smith/hash_index.h"
+#include "smith/parser.h"
+
+/**
+ * Identifies a node of an expression DAG by its index.
+ */
+typedef uint32_t smith_dag_node_t;
+
+/**
+ * Represents expressions with every structurally identical subtree stored
+ * once. Nodes are hash consed: a leaf is identified by its kind and text, a
+ * constant by its value and a binary operator by its operator and the nodes
+ * of its operands, so adding a subtree that is already in the DAG returns the
+ * existing node instead of a new one. Node indices are stable and children
+ * always precede their parents, but unlike a flat AST a node may have many
+ * parents, so a pass over the nodes in order visits every unique
+ * subexpression exactly once and results can be memoized in an array indexed
+ * by node. Spans are not part of a node's identity and are not kept.
+ *
+ * @param allocator Memory allocator for the node arrays and the hash table.
+ * @param kinds The kind of each node, one byte each.
+ * @param children The operands of each binary operator node.
+ * @param payloads The leaf text, operator info or constant value of each node.
+ * @param hashes The hash of each node.
+ * @param index The hash index of the nodes.
+ * @param count The number of nodes.
+ * @param capacity The number of nodes the arrays can hold without growing.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  uint8_t *kinds;
+  smith_ast_children_t *children;
+  smith_ast_payload_t *payloads;
+  uint64_t *hashes;
+  smith_hash_index_t index;
+  uint32_t count;
+  uint32_t capacity;
+} smith_dag_t;
+
+/**
+ * Defines the minimum capacity of a DAG once it allocates.
+ */
+#define SMITH_DAG_MIN_CAPACITY 64
+
+/**
+ * Creates an empty DAG. No memory is allocated until the first node is added.
+ *
+ * @param allocator The allocator to use for the node arrays and hash table.
+ * @return The empty DAG.
+ */
+smith_dag_t smith_dag_create(smith_allocator_t allocator);
+
+/**
+ * Represents the result of adding a node to a DAG.
+ *
+ * @param node The new node, or the existing node identical to it.
+ * @param success Indicates whether the DAG could grow to hold a new node.
+ */
+typedef struct {
+  smith_dag_node_t node;
+  bool success;
+} smith_dag_intern_result_t;
+
+/**
+ * Finds or adds a symbol, int or float node. Leaves are equal when their kind
+ * and text are.
+ *
+ * @param dag The DAG.
+ * @param kind The kind of the leaf.
+ * @param leaf The text of the leaf.
+ * @return The result of adding the node.
+ */
+smith_dag_intern_result_t smith_dag_intern_leaf(smith_dag_t *dag,
+                                                smith_expression_kind_t kind,
+                                                smith_ast_leaf_t leaf);
+
+/**
+ * Finds or adds a constant node. Constants are equal when their types and
+ * values are; floats are compared bit for bit.
+ *
+ * @param dag The DAG.
+ * @param constant The value of the constant.
+ * @return The result of adding the node.
+ */
+smith_dag_intern_result_t smith_dag_intern_constant(smith_dag_t *dag,
+                                                    smith_constant_t constant);
+
+/**
+ * Finds or adds a binary operator node over two nodes already in the DAG.
+ *
+ * @param dag The DAG.
+ * @param info The operator.
+ * @param children The operands.
+ * @return The result of adding the node.
+ */
+smith_dag_intern_result_t
+smith_dag_intern_binary_operator(smith_dag_t *dag,
+                                 smith_binary_operator_info_t info,
+                                 smith_ast_children_t children);
+
+/**
+ * Adds the subtree rooted at `root` of a flat AST, sharing every subtree the
+ * DAG already holds. The subtree is visited once, in node order.
+ *
+ * @param dag The DAG.
+ * @param ast The flat AST.
+ * @param root The root node of the subtree to add.
+ * @return The DAG node of the root.
+ */
+smith_dag_intern_result_t smith_dag_intern_ast(smith_dag_t *dag,
+                                               const smith_ast_t *ast,
+                                               smith_ast_node_t root);
+
+/**
+ * Adds an expression, sharing every subtree the DAG already holds. The
+ * expression is walked bottom up with an explicit stack, so arbitrarily deep
+ * expressions can be added.
+ *
+ * @param dag The DAG.
+ * @param expression The expression to add.
+ * @return The DAG node of the expression.
+ */
+smith_dag_intern_result_t
+smith_dag_intern_expression(smith_dag_t *dag, smith_expression_t expression);
+
+/**
+ * Marks the absence of a DAG node.
+ */
+#define SMITH_DAG_NO_NODE UINT32_MAX
+
+/**
+ * Gives the name of a parameter.
+ *
+ * @param parameters The parameters, of whatever type the caller keeps them in.
+ * @param index The index of the parameter.
+ * @return The name of the parameter.
+ */
+typedef smith_string_t (*smith_dag_parameter_name_t)(const void *parameters,
+                                                     uint32_t index);
+
+/**
+ * Numbers the symbols of an expression of a flat AST by interning them as
+ * leaves, so every use of a name gets the same node and what is known about
+ * each symbol can be kept in an array indexed by node. The parameter names
+ * are interned first, so the node of each parameter is its index.
+ *
+ * @param dag An empty DAG.
+ * @param ast The flat AST.
+ * @param root The root node of the expression.
+ * @param parameters The parameters, passed to `name`.
+ * @param parameter_count The number of parameters.
+ * @param name Gives the name of each parameter.
+ * @param symbols Receives the DAG node of each symbol node of the
+ * expression and `SMITH_DAG_NO_NODE` for every other node, indexed from the
+ * first node of the expression.
+ * @return Whether the DAG could grow and no two parameters share a name.
+ */
+bool smith_dag_number_symbols(smith_dag_t *dag, const smith_ast_t *ast,
+                              smith_ast_node_t root, const void *parameters,
+                              uint32_t parameter_count,
+                              smith_dag_parameter_name_t name,
+                              smith_dag_node_t *symbols);
+
+/**
+ * Destroys the DAG, releasing its nodes and hash table.
+ *
+ * @param dag The DAG to destroy.
+ */
+void smith_dag_destroy(smith_dag_t dag);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "smith/tokenizer.h"
+
+/**
+ * Fetches the next token from the source text using the lexer generated from
+ * smith/token_table.h. The generated DFA dispatches on character classes with
+ * direct-threaded computed gotos, so its cost per byte does not grow with the
+ * number of operators or delimiters. It produces exactly the same tokens and
+ * cursors as `smith_next_token`, which is kept as the reference
+ * implementation.
+ *
+ * @param interner The interner to use for string interning, or the null
+ * interner to skip interning.
+ * @param cursor The current position in the source text.
+ * @return The result of the tokenization attempt.
+ */
+smith_next_token_result_t smith_dfa_next_token(smith_interner_t interner,
+                                               smith_cursor_t cursor);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/reader.h"
+
+/**
+ * A structure representing the result of creating a file reader.
+ *
+ * @param reader The created reader.
+ * @param success Boolean indicating whether the reader was successfully created.
+ */
+typedef struct {
+  smith_reader_t reader;
+  bool success;
+} smith_file_reader_create_result_t;
+
+/**
+ * Creates a reader that pulls bytes from a file descriptor using `read(2)`.
+ * Works with regular files as well as pipes and sockets. The file descriptor
+ * is borrowed: destroying the reader does not close it.
+ *
+ * @param allocator The allocator to use for the reader state.
+ * @param file_descriptor The file descriptor to read from.
+ * @return A result containing the new reader and a success flag.
+ */
+smith_file_reader_create_result_t
+smith_file_reader_create(smith_allocator_t allocator, int file_descriptor);
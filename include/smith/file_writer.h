@@ -0,0 +1,28 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/writer.h"
+
+/**
+ * A structure representing the result of creating a file writer.
+ *
+ * @param writer The created writer.
+ * @param success Boolean indicating whether the writer was successfully
+ * created.
+ */
+typedef struct {
+  smith_writer_t writer;
+  bool success;
+} smith_file_writer_create_result_t;
+
+/**
+ * Creates a writer that pushes bytes to a file descriptor using `write(2)`,
+ * retrying short writes. The file descriptor is borrowed: destroying the
+ * writer does not close it.
+ *
+ * @param allocator The allocator to use for the writer state.
+ * @param file_descriptor The file descriptor to write to.
+ * @return A result containing the new writer and a success flag.
+ */
+smith_file_writer_create_result_t
+smith_file_writer_create(smith_allocator_t allocator, int file_descriptor);
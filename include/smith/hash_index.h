@@ -0,0 +1,81 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include <stdint.h>
+
+/**
+ * Represents the open addressing index of a hash consed table, such as the
+ * nodes of a DAG or the types of a type table. The table keeps its entries
+ * and their hashes in arrays of its own, and the index maps a hash to the ids
+ * of the entries that may be equal to it. There are twice as many slots as
+ * the table has room for entries and a power of two of them, so the index is
+ * at most half full and probing wraps with a mask.
+ *
+ * @param slots The entry id + 1 of each slot, where 0 marks an empty slot.
+ * @param mask The number of slots - 1.
+ */
+typedef struct {
+  uint32_t *slots;
+  uint32_t mask;
+} smith_hash_index_t;
+
+/**
+ * Mixes a value into a hash.
+ *
+ * @param hash The hash so far.
+ * @param value The value to mix in.
+ * @return The new hash.
+ */
+uint64_t smith_hash_mix(uint64_t hash, uint64_t value);
+
+/**
+ * Gives an index room for `capacity` entries, holding the first `count`
+ * entries of the table. The old slots are released.
+ *
+ * @param allocator The allocator of the slots.
+ * @param index The index, empty or holding fewer entries.
+ * @param capacity The number of entries the table can hold, a power of two no
+ * greater than `UINT32_MAX / 4`.
+ * @param hashes The hash of each entry of the table.
+ * @param count The number of entries of the table.
+ * @return Whether the slots could be allocated. On failure the index is
+ * unchanged.
+ */
+bool smith_hash_index_resize(smith_allocator_t allocator,
+                             smith_hash_index_t *index, uint32_t capacity,
+                             const uint64_t *hashes, uint32_t count);
+
+/**
+ * Compares an entry of a table with the value being looked up.
+ *
+ * @param state The table and the value being looked up.
+ * @param entry The id of an entry with the same hash as the value.
+ * @return Whether the entry is equal to the value.
+ */
+typedef bool (*smith_hash_index_equal_t)(const void *state, uint32_t entry);
+
+/**
+ * Probes an index for an entry equal to a value. `equal` is only called for
+ * entries whose hash is the value's.
+ *
+ * @param index The index, which must have room for at least one entry.
+ * @param hashes The hash of each entry of the table.
+ * @param hash The hash of the value.
+ * @param equal Compares an entry with the value.
+ * @param state Passed to `equal`.
+ * @return The slot of the equal entry, or the empty slot where the value
+ * belongs when there is none.
+ */
+uint32_t smith_hash_index_find(const smith_hash_index_t *index,
+                               const uint64_t *hashes, uint64_t hash,
+                               smith_hash_index_equal_t equal,
+                               const void *state);
+
+/**
+ * Releases the slots of an index.
+ *
+ * @param allocator The allocator of the slots.
+ * @param index The index to destroy.
+ */
+void smith_hash_index_destroy(smith_allocator_t allocator,
+                              smith_hash_index_t index);
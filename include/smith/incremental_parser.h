@@ -0,0 +1,50 @@
+#pragma once
+
+#include "smith/incremental_tokenizer.h"
+#include "smith/parser.h"
+
+/**
+ * Represents the result of reparsing a module after an edit.
+ *
+ * @param first The index of the first function that was reparsed.
+ * @param reparsed The number of functions produced by reparsing, starting at
+ * `first`. Every other function was reused.
+ * @param success Indicates whether the module and token buffer could be
+ * updated, which fails when memory runs out or the new source text has a
+ * syntax error. On failure they no longer describe the same source text, and
+ * the module should be parsed from scratch.
+ */
+typedef struct {
+  size_t first;
+  size_t reparsed;
+  bool success;
+} smith_reparse_result_t;
+
+/**
+ * Updates a module and its tokens after an edit without parsing the whole
+ * source again. The tokens are updated with `smith_relex`, and only the top
+ * level functions touching relexed tokens are parsed again. Parsing stops as
+ * soon as it reaches, past the relexed tokens, the start of a function that
+ * was there before the edit, since from there on the old functions are what
+ * parsing would produce. Every other node is reused where it is in the module
+ * AST without being touched: the functions after the edit record how far
+ * their nodes moved, as described in `smith_module_t`, so an edit costs time
+ * in proportion to the functions it parses and the number of functions rather
+ * than the number of nodes.
+ *
+ * Reused nodes keep identifiers interned from the old source text, so the
+ * interner must outlive it or own its strings. Once settled, the text of every
+ * node points into the new source text.
+ *
+ * @param context The parser context the module was parsed with.
+ * @param module The module parsed from the old source text, updated in place.
+ * @param buffer The tokens of the old source text, lexed with the null
+ * interner and updated in place.
+ * @param source The new null terminated source text, with the edit applied.
+ * @param edit The edit that turned the old source text into the new one.
+ * @return Which functions were reparsed.
+ */
+smith_reparse_result_t smith_reparse(smith_parser_context_t context,
+                                     smith_module_t *module,
+                                     smith_token_buffer_t *buffer,
+                                     char *source, smith_edit_t edit);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "smith/token_buffer.h"
+
+/**
+ * Represents a text edit: `removed_length` bytes at `offset` were replaced by
+ * `inserted`.
+ *
+ * @param offset The byte offset where the edit starts.
+ * @param removed_length The number of bytes removed from the old source text.
+ * @param inserted The text inserted in their place.
+ */
+typedef struct {
+  size_t offset;
+  size_t removed_length;
+  smith_string_t inserted;
+} smith_edit_t;
+
+/**
+ * Represents the result of re-tokenizing after an edit.
+ *
+ * @param success Indicates whether the token buffer could be updated.
+ * @param relexed The number of tokens that had to be produced by the tokenizer.
+ * @param first The index of the first relexed token.
+ * @param replaced The number of old tokens the relexed tokens replaced. Every
+ * token from `first + relexed` on is an old token that was only shifted.
+ */
+typedef struct {
+  bool success;
+  size_t relexed;
+  size_t first;
+  size_t replaced;
+} smith_relex_result_t;
+
+/**
+ * Updates a token buffer after an edit without tokenizing the whole source.
+ * Tokenization restarts at the last token boundary before the edit and stops
+ * as soon as a new token starts where an old token used to start past the
+ * edit, since from there on both token streams are identical. The remaining
+ * old tokens are not touched: the buffer moves its gap to them and records
+ * how far they moved, which is applied as they are read. An edit therefore
+ * costs time in proportion to the relexed tokens and to the number of tokens
+ * since the previous edit, not to the size of the source.
+ *
+ * Tokens left untouched keep identifiers interned from the old source text,
+ * so the interner must outlive it or own its strings. The buffer reads the
+ * text of every token from the new source text.
+ *
+ * @param interner The interner to use for string interning.
+ * @param buffer The tokens of the old source text, updated in place.
+ * @param source The new null terminated source text, with the edit applied.
+ * @param edit The edit that turned the old source text into the new one.
+ * @return The result of re-tokenizing.
+ */
+smith_relex_result_t smith_relex(smith_interner_t interner,
+                                 smith_token_buffer_t *buffer, char *source,
+                                 smith_edit_t edit);
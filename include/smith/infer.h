@@ -0,0 +1,61 @@
+#pragma once
+
+#include "smith/ast.h"
+#include "smith/type.h"
+
+/**
+ * Represents a parameter of an expression with its static type.
+ *
+ * @param name The name of the parameter.
+ * @param type The type of the parameter, an int, float or bool.
+ */
+typedef struct {
+  smith_string_t name;
+  smith_type_t type;
+} smith_typed_parameter_t;
+
+/**
+ * Represents the result of inferring the types of an expression.
+ *
+ * @param types The type of each node of the AST, indexed by node. Nodes
+ * outside the expression are `SMITH_TYPE_NONE`. To be released with the
+ * allocator given to `smith_infer_types`.
+ * @param function The type of the expression as a function of its
+ * parameters.
+ * @param error The node that could not be typed, or the root if memory ran
+ * out.
+ * @param success Whether every node of the expression was typed.
+ */
+typedef struct {
+  smith_type_t *types;
+  smith_type_t function;
+  smith_ast_node_t error;
+  bool success;
+} smith_infer_result_t;
+
+/**
+ * Infers the type of every node of an expression of a flat AST, checking
+ * them as `smith_bytecode_compile` does: operators take operands of one type,
+ * arithmetic applies to ints and floats, comparisons produce bools, `&` and
+ * `|` apply to ints and bools and `and` and `or` to bools. Assigning a symbol
+ * gives it the assigned type, which later assignments must keep.
+ *
+ * A literal has no type of its own: an int literal takes the int type of the
+ * operand it is combined with if it fits in that width, and a float literal
+ * the float type, so `x + 1` is an `i8` addition when `x` is an `i8`.
+ * Otherwise literals are 64 bit. A symbol node has the type of the value its
+ * operator reads.
+ *
+ * @param allocator The allocator for the types and for working memory.
+ * @param table The type table, which bool and function types are added to.
+ * @param ast The flat AST.
+ * @param root The root node of the expression.
+ * @param parameters The parameters of the expression.
+ * @param parameter_count The number of parameters.
+ * @return The type of each node, or the node that could not be typed.
+ */
+smith_infer_result_t
+smith_infer_types(smith_allocator_t allocator, smith_type_table_t *table,
+                  const smith_ast_t *ast, smith_ast_node_t root,
+                  const smith_typed_parameter_t *parameters,
+                  uint32_t parameter_count);
@@ -46,7 +46,17 @@ typedef struct {
 } smith_interner_t;
 
 /**
- * Interns a string using the specified interner.
+ * Determines whether an interner is the null interner, which has no intern
+ * function and leaves strings uninterned.
+ *
+ * @param interner The interner to check.
+ * @return True if the interner is the null interner.
+ */
+bool smith_interner_is_null(smith_interner_t interner);
+
+/**
+ * Interns a string using the specified interner. Interning with the null
+ * interner always fails.
  *
  * @param interner The interner to use.
  * @param string The string to intern.
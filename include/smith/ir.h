@@ -0,0 +1,205 @@
+#pragma once
+
+#include "smith/bytecode.h"
+
+/**
+ * Enumeration of the instructions of the intermediate representation.
+ * Operators take the type of their operands: `SMITH_IR_OPCODE_ADD` adds ints
+ * or floats.
+ */
+typedef enum {
+  SMITH_IR_OPCODE_PARAMETER, // The value of a parameter.
+  SMITH_IR_OPCODE_CONSTANT,  // A value known at compile time.
+  SMITH_IR_OPCODE_ADD,
+  SMITH_IR_OPCODE_SUB,
+  SMITH_IR_OPCODE_MUL,
+  SMITH_IR_OPCODE_DIV,
+  SMITH_IR_OPCODE_EQ,
+  SMITH_IR_OPCODE_NOT_EQ,
+  SMITH_IR_OPCODE_LT,
+  SMITH_IR_OPCODE_LE,
+  SMITH_IR_OPCODE_GT,
+  SMITH_IR_OPCODE_GE,
+  SMITH_IR_OPCODE_BIT_AND,
+  SMITH_IR_OPCODE_BIT_OR,
+  SMITH_IR_OPCODE_AND,
+  SMITH_IR_OPCODE_OR,
+  SMITH_IR_OPCODE_RETURN, // Ends its block, returning its first operand.
+} smith_ir_opcode_t;
+
+typedef struct smith_ir_block smith_ir_block_t;
+typedef struct smith_ir_instruction smith_ir_instruction_t;
+
+/**
+ * Represents an instruction, which is also the value it computes: SSA values
+ * are defined exactly once, so operands point straight at the instructions
+ * that compute them. Instructions are kept in a doubly linked list per
+ * block, so passes can remove them as they go.
+ *
+ * @param opcode What the instruction computes.
+ * @param type The type of its value. A return has the type it returns.
+ * @param id A number unique within the function, below its `value_count`,
+ * for passes to index side arrays by.
+ * @param operands The operands of an operator, or the returned value.
+ * @param constant The value of a constant.
+ * @param parameter The index of a parameter.
+ * @param block The block holding the instruction.
+ * @param previous The instruction before it in its block, or null.
+ * @param next The instruction after it in its block, or null.
+ */
+struct smith_ir_instruction {
+  smith_ir_opcode_t opcode;
+  smith_constant_kind_t type;
+  uint32_t id;
+  smith_ir_instruction_t *operands[2];
+  smith_constant_value_t constant;
+  uint32_t parameter;
+  smith_ir_block_t *block;
+  smith_ir_instruction_t *previous;
+  smith_ir_instruction_t *next;
+};
+
+/**
+ * Represents a basic block: instructions that run in order from the first
+ * to the last, which ends the block.
+ *
+ * @param id The index of the block in its function.
+ * @param first The first instruction.
+ * @param last The last instruction.
+ */
+struct smith_ir_block {
+  uint32_t id;
+  smith_ir_instruction_t *first;
+  smith_ir_instruction_t *last;
+};
+
+/**
+ * Represents a function in SSA form. Blocks and instructions are allocated
+ * from an arena owned by the function, so building them costs a pointer bump
+ * each and destroying the function releases them all at once. The language
+ * has no control flow yet, so every function built from an expression is a
+ * single block ending in a return.
+ *
+ * @param allocator The allocator passes use for their working memory, and
+ * the parent of the arena.
+ * @param arena The arena holding the blocks and instructions.
+ * @param blocks The blocks, the entry block first.
+ * @param block_count The number of blocks.
+ * @param parameter_count The number of parameters.
+ * @param value_count One more than the largest instruction id.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_allocator_t arena;
+  smith_ir_block_t *blocks;
+  uint32_t block_count;
+  uint32_t parameter_count;
+  uint32_t value_count;
+} smith_ir_function_t;
+
+/**
+ * Represents the result of building a function.
+ *
+ * @param function The built function.
+ * @param success Whether the expression is well typed and every symbol it
+ * reads has a value, as `smith_bytecode_compile` requires, and the function
+ * could be allocated.
+ */
+typedef struct {
+  smith_ir_function_t function;
+  bool success;
+} smith_ir_build_result_t;
+
+/**
+ * Builds a function computing an expression of a flat AST. The nodes are
+ * visited in order, children before parents. Assignments rebind a name to a
+ * new value rather than updating it, and a name read by an operator has the
+ * value bound to it when the operator runs, as in the bytecode.
+ *
+ * @param allocator The allocator for the function's arena and for its
+ * passes.
+ * @param ast The flat AST.
+ * @param root The root node of the expression.
+ * @param parameters The parameters of the expression.
+ * @param parameter_count The number of parameters.
+ * @return The function, to be released with `smith_ir_function_destroy`.
+ */
+smith_ir_build_result_t
+smith_ir_build(smith_allocator_t allocator, const smith_ast_t *ast,
+               smith_ast_node_t root,
+               const smith_bytecode_parameter_t *parameters,
+               uint32_t parameter_count);
+
+/**
+ * Replaces each operator whose operands are constants by its value, as
+ * `smith_constant_fold` computes it, with `&`, `|`, `and` and `or` computed
+ * directly. Operators the folder gives up on, such as a division by zero, are
+ * kept so they trap when the program runs.
+ *
+ * @param function The function to rewrite.
+ */
+void smith_ir_propagate_constants(smith_ir_function_t *function);
+
+/**
+ * Removes each instruction that computes the same value as an earlier one,
+ * pointing its uses at the earlier one instead. Instructions are equal when
+ * their opcodes, types and operands are, with the operands of commutative
+ * operators in either order, or when they are constants of the same value.
+ * A removed instruction that would trap only repeats one that already did.
+ *
+ * @param function The function to rewrite.
+ * @return False if the table of values could not be allocated, in which case
+ * the function is unchanged.
+ */
+bool smith_ir_eliminate_common_subexpressions(smith_ir_function_t *function);
+
+/**
+ * Removes each instruction whose value is never used. Int arithmetic that
+ * may trap is kept, since trapping is an effect of its own.
+ *
+ * @param function The function to rewrite.
+ * @return False if the live values could not be tracked, in which case the
+ * function is unchanged.
+ */
+bool smith_ir_eliminate_dead_code(smith_ir_function_t *function);
+
+/**
+ * The time spent in each pass, in nanoseconds. Optimizing adds to the times
+ * already there, so one instance can total the passes over many functions.
+ */
+typedef struct {
+  uint64_t constant_propagation;
+  uint64_t common_subexpression_elimination;
+  uint64_t dead_code_elimination;
+} smith_ir_pass_timings_t;
+
+/**
+ * Runs constant propagation, common subexpression elimination and dead code
+ * elimination, in that order.
+ *
+ * @param function The function to optimize.
+ * @param timings Where to add the time of each pass, or null.
+ * @return False if a pass could not allocate. The function is still valid.
+ */
+bool smith_ir_optimize(smith_ir_function_t *function,
+                       smith_ir_pass_timings_t *timings);
+
+/**
+ * Lowers a function to bytecode, giving each value a register that is
+ * reused once the value's last use has run.
+ *
+ * @param allocator The allocator for the bytecode.
+ * @param function The function, a single block.
+ * @return The bytecode, or failure if it needs more than
+ * `SMITH_BYTECODE_MAX_REGISTERS` registers or could not be allocated.
+ */
+smith_bytecode_compile_result_t
+smith_ir_to_bytecode(smith_allocator_t allocator,
+                     const smith_ir_function_t *function);
+
+/**
+ * Destroys a function, releasing its arena.
+ *
+ * @param function The function to destroy.
+ */
+void smith_ir_function_destroy(smith_ir_function_t function);
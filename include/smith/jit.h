@@ -0,0 +1,74 @@
+#pragma once
+
+#include "smith/vm.h"
+
+/**
+ * Represents a program compiled to native code. The expression is first
+ * compiled to bytecode, which is then translated to x86-64 machine code in
+ * `mmap`ed memory that is made executable once written. Bytecode registers
+ * are given machine registers by linear scan over their live ranges, and
+ * ranges that do not fit stay in the register file in memory. On other
+ * platforms, or if the memory cannot be mapped, `function` is null and the
+ * program runs on the interpreter instead.
+ *
+ * @param allocator The allocator for the bytecode and the register file.
+ * @param bytecode The bytecode the machine code was translated from.
+ * @param code The executable memory, or null.
+ * @param code_size The size of the executable memory in bytes.
+ * @param function The machine code, which runs on a register file holding
+ * the arguments and constants, leaves the result in the first register and
+ * returns false if the program trapped. Null when the interpreter is used.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_bytecode_t bytecode;
+  void *code;
+  size_t code_size;
+  bool (*function)(smith_constant_value_t *registers);
+} smith_jit_t;
+
+/**
+ * Represents the result of compiling an expression to native code.
+ *
+ * @param jit The compiled program.
+ * @param success Whether the expression could be compiled, as for
+ * `smith_bytecode_compile`. Failing to map executable memory is not a
+ * failure: the program then runs on the interpreter.
+ */
+typedef struct {
+  smith_jit_t jit;
+  bool success;
+} smith_jit_compile_result_t;
+
+/**
+ * Compiles an expression to native code.
+ *
+ * @param allocator The allocator for the program.
+ * @param expression The expression to compile.
+ * @param parameters The parameters of the expression.
+ * @param parameter_count The number of parameters.
+ * @return The program, to be released with `smith_jit_destroy`.
+ */
+smith_jit_compile_result_t
+smith_jit_compile(smith_allocator_t allocator,
+                  const smith_expression_t *expression,
+                  const smith_bytecode_parameter_t *parameters,
+                  uint32_t parameter_count);
+
+/**
+ * Runs a compiled program. It computes the same values and traps in the same
+ * places as `smith_vm_run` on its bytecode.
+ *
+ * @param jit The program.
+ * @param arguments The value of each parameter.
+ * @return The value the program returned, or failure.
+ */
+smith_vm_run_result_t smith_jit_run(const smith_jit_t *jit,
+                                    const smith_constant_value_t *arguments);
+
+/**
+ * Destroys a compiled program, unmapping its machine code.
+ *
+ * @param jit The program to destroy.
+ */
+void smith_jit_destroy(smith_jit_t jit);
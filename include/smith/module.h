@@ -0,0 +1,139 @@
+#pragma once
+
+#include "smith/ast.h"
+
+/**
+ * Describes how far the nodes of a function have moved since they were
+ * stored, as edits before the function moved its text. Columns only move on
+ * the line the function starts on, the one line it can share with the text
+ * before it. All zero means the nodes are up to date.
+ *
+ * @param line_delta The number of lines every position moved by.
+ * @param column_delta The number of columns positions on the first line of
+ * the function moved by.
+ * @param text_delta The number of bytes the text of every leaf moved by in
+ * memory, which includes moving into a new source text.
+ */
+typedef struct {
+  int64_t line_delta;
+  int64_t column_delta;
+  intptr_t text_delta;
+} smith_function_shift_t;
+
+/**
+ * Represents a top level function: `fn name(parameters) { body }`. The nodes
+ * of a function occupy a contiguous range of the module AST, from its first
+ * parameter through the root of its body.
+ *
+ * @param span The span from the `fn` keyword through the closing brace.
+ * @param offsets The byte offsets from the `fn` keyword through the closing
+ * brace.
+ * @param name The name of the function.
+ * @param name_span The span of the name in the source text.
+ * @param parameters The node of the first parameter. The parameters are
+ * symbol leaves in consecutive nodes; with none, this is the first node of the
+ * body.
+ * @param parameter_count The number of parameters.
+ * @param body The root node of the body expression.
+ * @param shift How far the nodes of the function moved since they were
+ * stored. The other fields are always up to date.
+ */
+typedef struct {
+  smith_span_t span;
+  smith_offsets_t offsets;
+  smith_ast_leaf_t name;
+  smith_span_t name_span;
+  smith_ast_node_t parameters;
+  uint32_t parameter_count;
+  smith_ast_node_t body;
+  smith_function_shift_t shift;
+} smith_function_t;
+
+/**
+ * Represents a parsed source file: its top level functions, in source order,
+ * and one flat AST holding the nodes of all of them.
+ *
+ * A parsed module is settled: its nodes are up to date and laid out in the
+ * order of the functions. Reparsing after an edit leaves the nodes of the
+ * functions it did not parse where they are, as they are, and records in each
+ * function how they moved, so it costs time in proportion to the functions it
+ * parses. The nodes it does parse may go to the end of the AST, leaving the
+ * ones they replace unused. Bring the nodes of a function up to date with
+ * `smith_module_settle_function` before reading them, or the whole module
+ * with `smith_module_settle`.
+ *
+ * @param ast The nodes of every function.
+ * @param functions The functions in source order.
+ * @param count The number of functions.
+ * @param capacity The number of functions the array can hold without growing.
+ * @param garbage The number of nodes in the AST that belong to no function.
+ */
+typedef struct {
+  smith_ast_t ast;
+  smith_function_t *functions;
+  size_t count;
+  size_t capacity;
+  uint32_t garbage;
+} smith_module_t;
+
+/**
+ * Defines the minimum capacity of the function array once it allocates.
+ */
+#define SMITH_MODULE_MIN_CAPACITY 16
+
+/**
+ * Creates an empty module. No memory is allocated until the first node or
+ * function is added.
+ *
+ * @param allocator The allocator to use for the AST and the function array.
+ * @return The empty module.
+ */
+smith_module_t smith_module_create(smith_allocator_t allocator);
+
+/**
+ * Ensures the module can hold at least `capacity` functions without growing
+ * again.
+ *
+ * @param module The module.
+ * @param capacity The number of functions to make room for.
+ * @return True if the function array could grow to hold them.
+ */
+bool smith_module_reserve(smith_module_t *module, size_t capacity);
+
+/**
+ * Adds a function whose nodes are already in the module AST.
+ *
+ * @param module The module.
+ * @param function The function to add.
+ * @return True if the function array could grow to hold it.
+ */
+bool smith_module_push_function(smith_module_t *module,
+                                smith_function_t function);
+
+/**
+ * Brings the nodes of a function up to date, applying the shift recorded for
+ * them. Costs time in proportion to the nodes of the function, and nothing
+ * once they are up to date.
+ *
+ * @param module The module.
+ * @param index The index of the function.
+ */
+void smith_module_settle_function(smith_module_t *module, size_t index);
+
+/**
+ * Brings every node up to date and lays the nodes out in the order of the
+ * functions again, dropping the unused ones, so the module is as parsing its
+ * source text from scratch makes it.
+ *
+ * @param module The module.
+ * @return True if the nodes could be laid out again. On failure the module is
+ * unchanged.
+ */
+bool smith_module_settle(smith_module_t *module);
+
+/**
+ * Destroys the module, releasing its AST and function array.
+ *
+ * @param module The module to destroy.
+ */
+void smith_module_destroy(smith_module_t module);
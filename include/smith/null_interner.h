@@ -0,0 +1,15 @@
+#pragma once
+
+#include "smith/interner.h"
+
+/**
+ * Creates an interner that does not intern anything. Tokenizers given the
+ * null interner skip interning entirely and emit symbols and numbers that
+ * carry only their span and text, which suits tools that only need the
+ * structure of the source text and lets the parser intern each name once when
+ * it builds a node. Interning with it always fails and nothing can be looked
+ * up.
+ *
+ * @return An interner that never interns strings.
+ */
+smith_interner_t smith_null_interner_create();
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "smith/parser.h"
+#include "smith/thread_pool.h"
+
+/**
+ * Defines how many batches of functions each thread of the pool is given
+ * when parsing in parallel. More batches than threads evens out the work
+ * when some functions are much larger than others.
+ */
+#define SMITH_PARALLEL_PARSER_BATCHES_PER_THREAD 4
+
+/**
+ * Parses a whole source file on a thread pool. A quick scan over the tokens
+ * finds every `fn` keyword outside of braces, which is where top level
+ * functions start. The functions are split into contiguous batches, and each
+ * batch is parsed concurrently without interning into an AST of its own,
+ * backed by an arena allocator of its own so the threads do not contend for
+ * the shared allocator. The batches are then merged in order: their nodes are
+ * appended to the module AST with their child indices shifted, and names are
+ * interned into `context.interner` in source order. The result is identical
+ * to `smith_parse_module` on the same tokens, including the first syntax
+ * error when there is one.
+ *
+ * The allocator in `context` is shared by all threads and must be thread
+ * safe.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param pool The thread pool to parse the batches on.
+ * @param buffer The tokens of the file, ending with an end of file token.
+ * @return The module, or the first syntax error.
+ */
+smith_parse_module_result_t
+smith_parse_module_parallel(smith_parser_context_t context,
+                            smith_thread_pool_t pool,
+                            const smith_token_buffer_t *buffer);
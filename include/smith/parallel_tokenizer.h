@@ -0,0 +1,33 @@
+#pragma once
+
+#include "smith/thread_pool.h"
+#include "smith/token_buffer.h"
+
+/**
+ * Defines the default number of bytes per piece when tokenizing in parallel.
+ */
+#define SMITH_PARALLEL_TOKENIZER_DEFAULT_PIECE_SIZE 65536
+
+/**
+ * Tokenizes a whole source text on a thread pool. The source is split into
+ * pieces of roughly `piece_size` bytes right after newlines, which only block
+ * comments span. Each piece is tokenized concurrently without interning,
+ * assuming it does not start inside a block comment; the rare pieces for which
+ * that is wrong are tokenized again serially. The pieces are then stitched
+ * together in order: positions and offsets are rebased and the text of
+ * symbols and numbers is interned into `interner` in source order. The result
+ * is identical to `smith_tokenize` on the same source.
+ *
+ * The allocator is shared by all threads and must be thread safe.
+ *
+ * @param allocator The allocator to use for the buffer and the workers.
+ * @param interner The interner to use for string interning.
+ * @param pool The thread pool to tokenize the pieces on.
+ * @param source The null terminated source text.
+ * @param piece_size The approximate number of bytes per piece.
+ * @return The result containing the tokens or an indication of failure.
+ */
+smith_tokenize_result_t
+smith_tokenize_parallel(smith_allocator_t allocator, smith_interner_t interner,
+                        smith_thread_pool_t pool,
+                        char *source, size_t piece_size);
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "smith/parser.h"
+
+/**
+ * Defines the version of the parse cache format. Caches written by another
+ * version are treated as missing.
+ */
+#define SMITH_PARSE_CACHE_VERSION 2
+
+/**
+ * Computes the 64 bit content hash parse caches are keyed by.
+ *
+ * @param source The source text.
+ * @return The hash of the source text.
+ */
+uint64_t smith_source_hash(smith_string_t source);
+
+/**
+ * Writes a parsed module to a cache file in a compact binary format. The node
+ * arrays are stored as they are, with children as node indices, followed by
+ * the functions and a string table. Leaves refer to the text of their symbol
+ * or literal by index into the string table, which holds each distinct text
+ * once, so interned identifiers, which only mean something to the interner
+ * that made them, are never stored. The file is written next to `path` and
+ * renamed into place, so a reader never sees a partially written cache.
+ *
+ * @param allocator The allocator to use for the file contents while writing.
+ * @param module The module to write, which must be settled.
+ * @param source_hash The hash of the source the module was parsed from.
+ * @param path The path of the cache file.
+ * @return True if the cache was written.
+ */
+bool smith_parse_cache_write(smith_allocator_t allocator,
+                             const smith_module_t *module,
+                             uint64_t source_hash, const char *path);
+
+/**
+ * Represents a loaded cache file, which is mapped into memory for as long as
+ * any module loaded from it is in use.
+ *
+ * @param mapping The start of the mapping, or null when nothing is mapped.
+ * @param size The size of the mapping.
+ */
+typedef struct {
+  void *mapping;
+  size_t size;
+} smith_parse_cache_t;
+
+/**
+ * Represents the result of loading a module from a cache file.
+ *
+ * @param module The loaded module.
+ * @param cache The mapping the text of the module's leaves points into.
+ * @param success False if the file is missing, was written for a different
+ * source, version or machine, or is malformed.
+ */
+typedef struct {
+  smith_module_t module;
+  smith_parse_cache_t cache;
+  bool success;
+} smith_parse_cache_load_result_t;
+
+/**
+ * Loads a module from a cache file by mapping it into memory. The node arrays
+ * are copied out in bulk, so loading allocates a handful of blocks however
+ * many nodes there are, and the text of every leaf points into the mapping
+ * rather than being copied. Each string in the string table is interned once
+ * into `interner`, and leaves get the identifier of their string. The whole
+ * file is validated first, so a corrupt cache is rejected instead of yielding
+ * a malformed module.
+ *
+ * @param allocator The allocator for the module.
+ * @param interner The interner to intern the string table into.
+ * @param path The path of the cache file.
+ * @param source_hash The hash of the source the module is wanted for.
+ * @return The module and the mapping it refers to, or failure.
+ */
+smith_parse_cache_load_result_t
+smith_parse_cache_load(smith_allocator_t allocator, smith_interner_t interner,
+                       const char *path, uint64_t source_hash);
+
+/**
+ * Unmaps a cache file. Modules loaded from it must not be used afterwards,
+ * and neither may an interner that refers to strings rather than copying
+ * them, just as with source text.
+ *
+ * @param cache The cache to close.
+ */
+void smith_parse_cache_close(smith_parse_cache_t cache);
+
+/**
+ * Represents the result of parsing a module through a cache.
+ *
+ * @param module The parsed or loaded module.
+ * @param cache The mapping the module refers to, when it was loaded.
+ * @param hit Whether the module was loaded from the cache.
+ * @param success Indicates whether the module could be loaded or parsed. It
+ * fails when memory runs out or the source has a syntax error, and then
+ * there is nothing to release.
+ */
+typedef struct {
+  smith_module_t module;
+  smith_parse_cache_t cache;
+  bool hit;
+  bool success;
+} smith_parse_module_cached_result_t;
+
+/**
+ * Parses a whole source file, skipping lexing and parsing entirely when the
+ * cache file at `path` was written for the same source. Otherwise the source
+ * is tokenized and parsed as usual and the cache is written for next time.
+ * On a hit the module refers to the cache, which must be closed with
+ * `smith_parse_cache_close` after the module is destroyed; on a miss it
+ * refers to the source text, as a freshly parsed module always does.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param source The null terminated source text.
+ * @param path The path of the cache file.
+ * @return The module and where it was loaded from, or a failure.
+ */
+smith_parse_module_cached_result_t
+smith_parse_module_cached(smith_parser_context_t context,
+                          smith_string_t source, const char *path);
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "smith/allocator.h"
+#include "smith/ast.h"
+#include "smith/module.h"
+#include "smith/token_buffer.h"
 #include "smith/tokenizer.h"
 
 /**
@@ -8,61 +11,6 @@
  */
 typedef struct smith_expression_t smith_expression_t;
 
-/**
- * Enumeration of binary operator kinds supported by the parser.
- */
-typedef enum {
-  SMITH_BINARY_OPERATOR_KIND_ADD,
-  SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN,
-  SMITH_BINARY_OPERATOR_KIND_SUB,
-  SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN,
-  SMITH_BINARY_OPERATOR_KIND_MUL,
-  SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN,
-  SMITH_BINARY_OPERATOR_KIND_DIV,
-  SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN,
-  SMITH_BINARY_OPERATOR_KIND_ASSIGN,
-  SMITH_BINARY_OPERATOR_KIND_EQ,
-  SMITH_BINARY_OPERATOR_KIND_NOT,
-  SMITH_BINARY_OPERATOR_KIND_NOT_EQ,
-  SMITH_BINARY_OPERATOR_KIND_LT,
-  SMITH_BINARY_OPERATOR_KIND_LE,
-  SMITH_BINARY_OPERATOR_KIND_GT,
-  SMITH_BINARY_OPERATOR_KIND_GE,
-  SMITH_BINARY_OPERATOR_KIND_BIT_AND,
-  SMITH_BINARY_OPERATOR_KIND_AND,
-  SMITH_BINARY_OPERATOR_KIND_BIT_OR,
-  SMITH_BINARY_OPERATOR_KIND_OR,
-} smith_binary_operator_kind_t;
-
-/**
- * Enumeration of operator precedence levels.
- */
-typedef enum {
-  SMITH_PRECEDENCE_LOWEST,
-  SMITH_PRECEDENCE_ASSIGN,
-  SMITH_PRECEDENCE_ADD,
-  SMITH_PRECEDENCE_MUL,
-  SMITH_PRECEDENCE_EQ,
-} smith_precedence_t;
-
-/**
- * Enumeration of operator associativity types.
- */
-typedef enum {
-  SMITH_ASSOCIATIVITY_LEFT,  // Left-to-right associativity
-  SMITH_ASSOCIATIVITY_RIGHT  // Right-to-left associativity
-} smith_associativity_t;
-
-/**
- * Represents information about a binary operator including its kind,
- * precedence, and associativity.
- */
-typedef struct {
-  smith_binary_operator_kind_t kind;
-  smith_precedence_t precedence;
-  smith_associativity_t associativity;
-} smith_binary_operator_info_t;
-
 /**
  * Represents a binary operator expression in the AST.
  *
@@ -79,14 +27,16 @@ typedef struct {
 } smith_binary_operator_t;
 
 /**
- * Enumeration of expression kinds.
+ * Represents a constant in the AST, such as the result of folding an operator
+ * whose operands are literals.
+ *
+ * @param span The span of the source text the constant was computed from.
+ * @param constant The value of the constant.
  */
-typedef enum {
-  SMITH_EXPRESSION_KIND_SYMBOL,
-  SMITH_EXPRESSION_KIND_INT,
-  SMITH_EXPRESSION_KIND_FLOAT,
-  SMITH_EXPRESSION_KIND_BINARY_OPERATOR,
-} smith_expression_kind_t;
+typedef struct {
+  smith_span_t span;
+  smith_constant_t constant;
+} smith_constant_expression_t;
 
 /**
  * Union of all possible expression values.
@@ -96,6 +46,7 @@ typedef union {
   smith_int_t int_;
   smith_float_t float_;
   smith_binary_operator_t binary_operator;
+  smith_constant_expression_t constant;
 } smith_expression_value_t;
 
 /**
@@ -114,27 +65,61 @@ struct smith_expression_t {
  *
  * @param expression The parsed expression.
  * @param cursor Position in the source text after parsing the expression.
+ * @param success Indicates whether memory could be allocated for the
+ * expression and its names interned.
  */
 typedef struct {
   smith_expression_t expression;
   smith_cursor_t cursor;
+  bool success;
 } smith_parse_result_t;
 
 /**
- * Represents the context for the parser, including memory allocation and keyword handling.
+ * Represents the result of parsing an expression from a token buffer.
+ *
+ * @param expression The parsed expression.
+ * @param index The index of the first token after the expression.
+ * @param success Indicates whether memory could be allocated for the
+ * expression and its names interned.
+ */
+typedef struct {
+  smith_expression_t expression;
+  size_t index;
+  bool success;
+} smith_parse_buffer_result_t;
+
+/**
+ * Represents the context for the parser, including memory allocation and string interning.
  *
  * @param allocator Memory allocator for dynamic allocations within the parser.
- * @param interner Interner for managing unique strings and identifiers.
- * @param keywords Set of keywords recognized by the parser.
+ * @param interner Interner for managing unique strings and identifiers. The
+ * parser interns each symbol and number once, in source order, as soon as
+ * the expression holding it is complete. Literals folded into constants are
+ * not interned. With the null interner nothing is interned and nodes only
+ * carry their text.
+ * @param fold_constants Whether to fold constants while parsing. An
+ * arithmetic or comparison operator whose operands are both int, float or
+ * already folded constants is replaced by a constant node holding its value,
+ * as computed by `smith_constant_fold`, so `60 * 60 * 24` parses to a single
+ * node. Operators that cannot be folded, such as an int division by zero,
+ * are kept as they are.
  */
 typedef struct {
   smith_allocator_t allocator;
   smith_interner_t interner;
-  smith_keywords_t keywords;
+  bool fold_constants;
 } smith_parser_context_t;
 
 /**
  * Parses an expression from the source text starting at the given cursor position.
+ * Binary operators group by the precedence and associativity in
+ * `smith_binary_operator_mapping`. Operands and pending operators are kept on
+ * explicit stacks rather than the native one, so arbitrarily long operator
+ * chains parse in linear time without recursion. Tokens are lexed on demand,
+ * which suits small inputs; whole files are better lexed up front and parsed
+ * with `smith_parse_expression_buffer`. A token that cannot start an operand
+ * stands as a symbol with empty text; syntax errors are only reported by
+ * `smith_parse_function` and `smith_parse_module`.
  *
  * @param context The parser context containing all necessary resources.
  * @param cursor The current position in the source text.
@@ -144,7 +129,177 @@ smith_parse_result_t smith_parse_expression(smith_parser_context_t context,
                                             smith_cursor_t cursor);
 
 /**
- * Destroys an expression, releasing any resources it holds.
+ * Parses an expression from tokens lexed ahead of time, starting at the token
+ * at `index`. It builds the same expression as `smith_parse_expression` would
+ * from the text the tokens were lexed from, but peeking is an index into the
+ * buffer, so the token ending the expression is never lexed twice. The buffer
+ * is best lexed with the null interner, since the parser interns every name
+ * it builds a node for.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param buffer The tokens to parse, ending with an end of file token.
+ * @param index The index of the first token of the expression.
+ * @return The parsed expression and the index of the token after it.
+ */
+smith_parse_buffer_result_t
+smith_parse_expression_buffer(smith_parser_context_t context,
+                              const smith_token_buffer_t *buffer,
+                              size_t index);
+
+/**
+ * Represents the result of parsing an expression into a flat AST.
+ *
+ * @param root The root node of the parsed expression.
+ * @param cursor Position in the source text after parsing the expression.
+ * @param success Indicates whether the nodes could be added and their names
+ * interned. On failure none of them are left in the AST.
+ */
+typedef struct {
+  smith_ast_node_t root;
+  smith_cursor_t cursor;
+  bool success;
+} smith_parse_ast_result_t;
+
+/**
+ * Parses an expression from the source text into a flat AST. This is what
+ * `smith_parse_expression` does before converting the nodes to pointers. The
+ * nodes of the expression are appended to `ast`, which may already hold other
+ * expressions.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param ast The AST to add the nodes of the expression to.
+ * @param cursor The current position in the source text.
+ * @return The root of the expression and the position after it.
+ */
+smith_parse_ast_result_t smith_parse_ast(smith_parser_context_t context,
+                                         smith_ast_t *ast,
+                                         smith_cursor_t cursor);
+
+/**
+ * Represents the result of parsing an expression from a token buffer into a
+ * flat AST.
+ *
+ * @param root The root node of the parsed expression.
+ * @param index The index of the first token after the expression.
+ * @param success Indicates whether the nodes could be added and their names
+ * interned. On failure none of them are left in the AST.
+ */
+typedef struct {
+  smith_ast_node_t root;
+  size_t index;
+  bool success;
+} smith_parse_ast_buffer_result_t;
+
+/**
+ * Parses an expression from tokens lexed ahead of time into a flat AST.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param ast The AST to add the nodes of the expression to.
+ * @param buffer The tokens to parse, ending with an end of file token.
+ * @param index The index of the first token of the expression.
+ * @return The root of the expression and the index of the token after it.
+ */
+smith_parse_ast_buffer_result_t
+smith_parse_ast_buffer(smith_parser_context_t context, smith_ast_t *ast,
+                       const smith_token_buffer_t *buffer, size_t index);
+
+/**
+ * Represents the result of parsing a top level function.
+ *
+ * @param function The parsed function.
+ * @param index The index of the first token after the function, or of the
+ * unexpected token on failure.
+ * @param error The span of the unexpected token on failure, or empty when
+ * memory ran out.
+ * @param success Indicates whether the tokens form a function and memory
+ * could be allocated for its nodes and names interned.
+ */
+typedef struct {
+  smith_function_t function;
+  size_t index;
+  smith_span_t error;
+  bool success;
+} smith_parse_function_result_t;
+
+/**
+ * Parses a top level function, `fn name(a, b) { a + b }`, from tokens lexed
+ * ahead of time. The parameters are appended to `ast` as symbol leaves,
+ * followed by the nodes of the body expression. On a syntax error no nodes
+ * are left in `ast`.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param ast The AST to add the nodes of the function to.
+ * @param buffer The tokens to parse, ending with an end of file token.
+ * @param index The index of the `fn` keyword.
+ * @return The function and the index of the token after its closing brace,
+ * or the first unexpected token.
+ */
+smith_parse_function_result_t
+smith_parse_function(smith_parser_context_t context, smith_ast_t *ast,
+                     const smith_token_buffer_t *buffer, size_t index);
+
+/**
+ * Represents the result of parsing a whole source file.
+ *
+ * @param module The parsed module, to be released with
+ * `smith_module_destroy`. It is empty on failure.
+ * @param error The span of the first unexpected token on failure, or empty
+ * when memory ran out.
+ * @param success Indicates whether the tokens form a sequence of functions
+ * and the module could be allocated.
+ */
+typedef struct {
+  smith_module_t module;
+  smith_span_t error;
+  bool success;
+} smith_parse_module_result_t;
+
+/**
+ * Parses a whole source file, a sequence of top level functions, from tokens
+ * lexed ahead of time. Large files can be parsed on a thread pool with
+ * `smith_parse_module_parallel` instead.
+ *
+ * @param context The parser context containing all necessary resources.
+ * @param buffer The tokens of the file, ending with an end of file token.
+ * @return The module, or the first syntax error.
+ */
+smith_parse_module_result_t
+smith_parse_module(smith_parser_context_t context,
+                   const smith_token_buffer_t *buffer);
+
+/**
+ * Represents the result of converting a flat AST into an expression.
+ *
+ * @param expression The expression, to be released with
+ * `smith_expression_destroy`.
+ * @param success Indicates whether memory could be allocated for the
+ * operands. On failure nothing is left to release.
+ */
+typedef struct {
+  smith_expression_t expression;
+  bool success;
+} smith_ast_to_expression_result_t;
+
+/**
+ * Converts the subtree rooted at `root` of a flat AST into an expression
+ * whose operands are individually allocated. The conversion walks the
+ * subtree's node range once, without recursion.
+ *
+ * @param allocator The allocator for the expression nodes.
+ * @param ast The flat AST.
+ * @param root The root node of the expression to convert.
+ * @return The expression.
+ */
+smith_ast_to_expression_result_t
+smith_ast_to_expression(smith_allocator_t allocator, const smith_ast_t *ast,
+                        smith_ast_node_t root);
+
+/**
+ * Destroys an expression, releasing any resources it holds. The tree is torn
+ * down in linear time without recursion or extra memory, so arbitrarily deep
+ * expressions are safe to destroy. Expressions whose nodes came from an arena
+ * allocator need not be destroyed at all: resetting or destroying the arena
+ * releases them at once.
  *
  * @param allocator The allocator used to manage memory for expressions.
  * @param expression The expression to destroy.
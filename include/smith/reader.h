@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Result structure for read operations.
+ *
+ * @param success Indicates whether the read was successful.
+ * @param length The number of bytes written into the buffer. A successful
+ * read of zero bytes marks the end of the stream.
+ */
+typedef struct {
+  bool success;
+  size_t length;
+} smith_read_result_t;
+
+/**
+ * Structure that represents a source of bytes that is consumed in chunks.
+ * Readers let the tokenizer work on input that is never fully materialized,
+ * such as pipes or generators.
+ *
+ * @param state Pointer to the reader-specific state.
+ * @param read Function to read up to `capacity` bytes into `buffer`.
+ * @param destroy Function to clean up any resources associated with the reader.
+ */
+typedef struct {
+  void *state;
+  smith_read_result_t (*read)(void *reader, char *buffer, size_t capacity);
+  void (*destroy)(void *reader);
+} smith_reader_t;
+
+/**
+ * Reads up to `capacity` bytes using the specified reader.
+ *
+ * @param reader The reader to use.
+ * @param buffer The buffer to read into.
+ * @param capacity The maximum number of bytes to read.
+ * @return The result of the read operation.
+ */
+smith_read_result_t smith_reader_read(smith_reader_t reader, char *buffer,
+                                      size_t capacity);
+
+/**
+ * Destroys the reader, releasing all associated resources.
+ *
+ * @param reader The reader to destroy.
+ */
+void smith_reader_destroy(smith_reader_t reader);
@@ -0,0 +1,16 @@
+#pragma once
+
+/**
+ * Finds the first occurrence of `a`, `b` or `c` in a null terminated string,
+ * or its null terminator if none of them occur. Where SSE2 is available the
+ * string is compared sixteen bytes at a time, which is what keeps string
+ * literals and comments from being lexed one byte at a time. To search for
+ * fewer bytes, pass the same byte more than once.
+ *
+ * @param source The null terminated string to search.
+ * @param a A byte to search for.
+ * @param b A byte to search for.
+ * @param c A byte to search for.
+ * @return A pointer to the first matching byte or to the null terminator.
+ */
+char *smith_scan(char *source, char a, char b, char c);
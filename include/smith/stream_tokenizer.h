@@ -0,0 +1,118 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/reader.h"
+#include "smith/tokenizer.h"
+
+/**
+ * Defines the default number of bytes requested from the reader per refill.
+ */
+#define SMITH_STREAM_TOKENIZER_DEFAULT_CHUNK_SIZE 65536
+
+/**
+ * Enumeration of the kinds of comment a stream tokenizer can be inside of
+ * when its buffered text runs out.
+ */
+typedef enum {
+  SMITH_STREAM_COMMENT_NONE,
+  SMITH_STREAM_COMMENT_LINE,
+  SMITH_STREAM_COMMENT_BLOCK,
+} smith_stream_comment_t;
+
+/**
+ * Represents a tokenizer that pulls its source text from a reader in chunks.
+ * Only the unconsumed tail of the input is buffered, so memory stays bounded
+ * by the chunk size plus the longest token regardless of the input size.
+ * Comments are not tokens: one that runs past the buffered text is skipped as
+ * it is read, and its bytes are dropped rather than kept.
+ *
+ * @param allocator Memory allocator for the chunk buffer.
+ * @param interner Interner for symbols and numbers. Since the buffer is reused,
+ * it must own its strings, e.g. a copying interner, or be the null interner.
+ * @param reader The reader providing the source text.
+ * @param buffer The window of the source text currently held in memory.
+ * @param length The number of bytes currently held in the buffer.
+ * @param end The last guaranteed token boundary in the buffer. Tokenization
+ * stops there so that no token is cut in half by the end of a chunk.
+ * @param held The byte at `end`, replaced by a null terminator while tokenizing.
+ * @param capacity The number of bytes the buffer can hold, excluding the terminator.
+ * @param chunk_size The number of bytes requested from the reader per refill.
+ * @param cursor The current position within the buffer.
+ * @param end_of_stream Whether the reader has been exhausted.
+ * @param comment The comment the start of the buffer is inside of, if any.
+ * @param comment_start The position of the start of that comment, for
+ * reporting it if it is never closed.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_interner_t interner;
+  smith_reader_t reader;
+  char *buffer;
+  size_t length;
+  char *end;
+  char held;
+  size_t capacity;
+  size_t chunk_size;
+  smith_cursor_t cursor;
+  bool end_of_stream;
+  smith_stream_comment_t comment;
+  smith_position_t comment_start;
+} smith_stream_tokenizer_t;
+
+/**
+ * Structure representing the result of creating a stream tokenizer.
+ *
+ * @param tokenizer The created stream tokenizer.
+ * @param success Indicates whether the creation was successful.
+ */
+typedef struct {
+  smith_stream_tokenizer_t tokenizer;
+  bool success;
+} smith_stream_tokenizer_create_result_t;
+
+/**
+ * Represents the result of fetching the next token from a stream.
+ * Strings referenced by the token (e.g. the text of a symbol) point into the
+ * chunk buffer and are only valid until the next call.
+ *
+ * @param token The next token.
+ * @param success False if the reader failed or the buffer could not grow.
+ */
+typedef struct {
+  smith_token_t token;
+  bool success;
+} smith_stream_next_token_result_t;
+
+/**
+ * Creates a stream tokenizer reading from the given reader.
+ *
+ * @param allocator The allocator to use for the chunk buffer.
+ * @param interner The interner to use, which must own the strings it interns,
+ * or the null interner to skip interning.
+ * @param reader The reader providing the source text.
+ * @param chunk_size The number of bytes requested from the reader per refill.
+ * @return The result of creating the stream tokenizer.
+ */
+smith_stream_tokenizer_create_result_t
+smith_stream_tokenizer_create(smith_allocator_t allocator,
+                              smith_interner_t interner, smith_reader_t reader,
+                              size_t chunk_size);
+
+/**
+ * Fetches the next token from the stream, reading more input whenever a token
+ * may continue past the buffered text. Produces the same tokens as calling
+ * `smith_next_token` on the whole input.
+ *
+ * @param tokenizer The stream tokenizer.
+ * @return The result of the tokenization attempt.
+ */
+smith_stream_next_token_result_t
+smith_stream_next_token(smith_stream_tokenizer_t *tokenizer);
+
+/**
+ * Destroys the stream tokenizer, releasing its buffer. The reader is borrowed
+ * and must be destroyed separately.
+ *
+ * @param tokenizer The stream tokenizer to destroy.
+ */
+void smith_stream_tokenizer_destroy(smith_stream_tokenizer_t tokenizer);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "smith/allocator.h"
+
+/**
+ * Represents a fixed set of worker threads that run batches of indexed tasks.
+ *
+ * @param state Pointer to the thread pool state.
+ */
+typedef struct {
+  void *state;
+} smith_thread_pool_t;
+
+/**
+ * Structure representing the result of creating a thread pool.
+ *
+ * @param pool The created thread pool.
+ * @param success Indicates whether the creation was successful.
+ */
+typedef struct {
+  smith_thread_pool_t pool;
+  bool success;
+} smith_thread_pool_create_result_t;
+
+/**
+ * Creates a thread pool. The thread calling `smith_thread_pool_run` always
+ * takes part in the work, so a pool with zero worker threads runs everything
+ * on the calling thread.
+ *
+ * @param allocator The allocator to use for the pool state.
+ * @param thread_count The number of worker threads to start.
+ * @return The result of creating the thread pool.
+ */
+smith_thread_pool_create_result_t
+smith_thread_pool_create(smith_allocator_t allocator, size_t thread_count);
+
+/**
+ * Runs `task(state, index)` for every index in `[0, count)` on the pool and
+ * waits until all of them have finished. Tasks may run in any order.
+ *
+ * @param pool The thread pool.
+ * @param task The function to run for each index.
+ * @param state Pointer passed to every task.
+ * @param count The number of tasks to run.
+ */
+void smith_thread_pool_run(smith_thread_pool_t pool,
+                           void (*task)(void *state, size_t index),
+                           void *state, size_t count);
+
+/**
+ * Returns the number of threads that take part in `smith_thread_pool_run`,
+ * including the calling thread.
+ *
+ * @param pool The thread pool.
+ * @return The number of threads.
+ */
+size_t smith_thread_pool_concurrency(smith_thread_pool_t pool);
+
+/**
+ * Stops the worker threads and releases the pool.
+ *
+ * @param pool The thread pool to destroy.
+ */
+void smith_thread_pool_destroy(smith_thread_pool_t pool);
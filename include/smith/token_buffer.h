@@ -0,0 +1,203 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/tokenizer.h"
+
+/**
+ * Defines the minimum capacity of a token buffer once it allocates.
+ */
+#define SMITH_TOKEN_BUFFER_MIN_CAPACITY 64
+
+/**
+ * Describes how far the tokens after the gap of a token buffer have moved
+ * since they were stored. Columns only move on the line the first of them
+ * starts on, the one line they share with the text before them.
+ *
+ * @param offset_delta The number of bytes every offset moved by.
+ * @param line_delta The number of lines every position moved by.
+ * @param column_delta The number of columns positions on `anchor_line` moved
+ * by.
+ * @param anchor_line The stored line the first token after the gap starts on.
+ */
+typedef struct {
+  int64_t offset_delta;
+  int64_t line_delta;
+  int64_t column_delta;
+  uint32_t anchor_line;
+} smith_token_shift_t;
+
+/**
+ * Represents a growable array of tokens together with the byte offsets each
+ * token occupies in the source text. A fully tokenized source always ends
+ * with an end of file token.
+ *
+ * The arrays are a gap buffer: the free slots sit after the first `gap`
+ * tokens rather than at the end, so tokens are replaced around an edit
+ * without moving the ones after it. Those are stored where they were before
+ * the edits since they were last moved, and `shift` says where they are now.
+ * It is applied as they are read, so an edit never touches them, and moving
+ * the gap to a later edit only touches the tokens in between. Read tokens
+ * with `smith_token_buffer_get` and `smith_token_buffer_offsets`; indexing
+ * the arrays directly is only valid while the gap is at the end, as it is
+ * after tokenizing.
+ *
+ * @param allocator Memory allocator for the arrays.
+ * @param tokens The tokens in source order, with the gap after the first
+ * `gap` of them.
+ * @param offsets The byte offsets of each token, parallel to `tokens`.
+ * @param count The number of tokens in the buffer.
+ * @param capacity The number of tokens the buffer can hold without growing.
+ * @param gap The number of tokens before the gap.
+ * @param shift How far the tokens after the gap moved since they were stored.
+ * @param source The source text the tokens are read from, or null to read
+ * their text as stored. Tokens read back point their text into it, so
+ * replacing it after an edit retargets every token at once.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_token_t *tokens;
+  smith_offsets_t *offsets;
+  size_t count;
+  size_t capacity;
+  size_t gap;
+  smith_token_shift_t shift;
+  char *source;
+} smith_token_buffer_t;
+
+/**
+ * Represents the result of tokenizing a whole source text.
+ *
+ * @param buffer The tokens of the source text.
+ * @param success Indicates whether the buffer could be allocated.
+ */
+typedef struct {
+  smith_token_buffer_t buffer;
+  bool success;
+} smith_tokenize_result_t;
+
+/**
+ * Creates an empty token buffer. No memory is allocated until the first push.
+ *
+ * @param allocator The allocator to use for the buffer.
+ * @return The empty token buffer.
+ */
+smith_token_buffer_t smith_token_buffer_create(smith_allocator_t allocator);
+
+/**
+ * Ensures the buffer can hold at least `capacity` tokens without growing.
+ *
+ * @param buffer The token buffer.
+ * @param capacity The required capacity.
+ * @return True if the buffer has the required capacity.
+ */
+bool smith_token_buffer_reserve(smith_token_buffer_t *buffer, size_t capacity);
+
+/**
+ * Appends a token to the buffer.
+ *
+ * @param buffer The token buffer.
+ * @param token The token to append.
+ * @param offsets The byte offsets the token occupies in the source text.
+ * @return True if the token was appended.
+ */
+bool smith_token_buffer_push(smith_token_buffer_t *buffer, smith_token_t token,
+                             smith_offsets_t offsets);
+
+/**
+ * Reads a token as it is now, with its positions shifted and its text
+ * pointed into the buffer's source text.
+ *
+ * @param buffer The token buffer.
+ * @param index The index of the token.
+ * @return The token.
+ */
+smith_token_t smith_token_buffer_get(const smith_token_buffer_t *buffer,
+                                     size_t index);
+
+/**
+ * Reads the byte offsets a token occupies in the source text now.
+ *
+ * @param buffer The token buffer.
+ * @param index The index of the token.
+ * @return The offsets of the token.
+ */
+smith_offsets_t smith_token_buffer_offsets(const smith_token_buffer_t *buffer,
+                                           size_t index);
+
+/**
+ * Moves the tokens from `index` on by a number of bytes, lines and columns,
+ * as an edit before them does. Columns only move on the line the token at
+ * `index` starts on. The tokens are not touched: the gap moves to `index`
+ * and the shift is recorded for them, so this costs time in proportion to
+ * how far the gap moves.
+ *
+ * @param buffer The token buffer.
+ * @param index The index of the first token to move.
+ * @param offset_delta The number of bytes to move the offsets by.
+ * @param line_delta The number of lines to move the positions by.
+ * @param column_delta The number of columns to move the positions on the
+ * line of the token at `index` by.
+ */
+void smith_token_buffer_shift(smith_token_buffer_t *buffer, size_t index,
+                              int64_t offset_delta, int64_t line_delta,
+                              int64_t column_delta);
+
+/**
+ * Replaces the tokens in `[start, end)` with all tokens of `replacement`.
+ * The gap moves to the end of the replacement, so the tokens after it are
+ * not moved.
+ *
+ * @param buffer The token buffer.
+ * @param start The index of the first token to replace.
+ * @param end The index one past the last token to replace.
+ * @param replacement The tokens to insert.
+ * @return True if the tokens were replaced.
+ */
+bool smith_token_buffer_splice(smith_token_buffer_t *buffer, size_t start,
+                               size_t end,
+                               const smith_token_buffer_t *replacement);
+
+/**
+ * Finds the index of the first token whose end offset is at least `offset`.
+ * Returns the token count if there is none.
+ *
+ * @param buffer The token buffer.
+ * @param offset The byte offset to search for.
+ * @return The index of the first token ending at or after the offset.
+ */
+size_t smith_token_buffer_find(const smith_token_buffer_t *buffer,
+                               size_t offset);
+
+/**
+ * Looks `lookahead` tokens past `index` in a fully tokenized buffer. Looking
+ * past the end yields the trailing end of file token, so any amount of
+ * lookahead is safe and costs a single index computation.
+ *
+ * @param buffer The token buffer, which must end with an end of file token.
+ * @param index The index of the current token.
+ * @param lookahead How many tokens past the current one to look.
+ * @return The token `lookahead` tokens past `index`, as read by
+ * `smith_token_buffer_get`.
+ */
+smith_token_t smith_token_buffer_peek(const smith_token_buffer_t *buffer,
+                                      size_t index, size_t lookahead);
+
+/**
+ * Destroys the token buffer, releasing its memory.
+ *
+ * @param buffer The token buffer to destroy.
+ */
+void smith_token_buffer_destroy(smith_token_buffer_t buffer);
+
+/**
+ * Tokenizes a whole null terminated source text into a token buffer,
+ * including the trailing end of file token.
+ *
+ * @param allocator The allocator to use for the buffer.
+ * @param interner The interner to use for string interning, or the null
+ * interner to skip interning.
+ * @param source The source text.
+ * @return The result containing the tokens or an indication of failure.
+ */
+smith_tokenize_result_t smith_tokenize(smith_allocator_t allocator,
+                                       smith_interner_t interner, char *source);
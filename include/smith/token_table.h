@@ -0,0 +1,56 @@
+#pragma once
+
+/**
+ * Declarative description of every token the tokenizer recognizes. The kind
+ * enumerations in smith/tokenizer.h are expanded from these tables, and
+ * tools/generate_lexer.py compiles them into the minimal DFA in
+ * src/dfa_lexer.inc used by `smith_dfa_next_token`. After editing a table,
+ * regenerate the lexer with
+ *
+ *   python3 tools/generate_lexer.py
+ *
+ * Each entry is X(NAME, spelling). Operators and delimiters are spelled
+ * literally. Literal shapes are regular expressions supporting character
+ * classes, grouping, `|`, `*`, `+`, `?` and backslash escapes; when two shapes
+ * match the same text the earlier entry wins. Keywords are matched by the
+ * SYMBOL shape and then classified by the perfect hash the generator writes to
+ * src/keyword_hash.inc, so they must differ in length, first or last byte.
+ */
+
+#define SMITH_TOKEN_TABLE_OPERATORS(X)                                         \
+  X(ADD, "+")                                                                  \
+  X(ADD_ASSIGN, "+=")                                                          \
+  X(SUB, "-")                                                                  \
+  X(SUB_ASSIGN, "-=")                                                          \
+  X(MUL, "*")                                                                  \
+  X(MUL_ASSIGN, "*=")                                                          \
+  X(DIV, "/")                                                                  \
+  X(DIV_ASSIGN, "/=")                                                          \
+  X(ASSIGN, "=")                                                               \
+  X(EQ, "==")                                                                  \
+  X(NOT, "!")                                                                  \
+  X(NOT_EQ, "!=")                                                              \
+  X(LT, "<")                                                                   \
+  X(LE, "<=")                                                                  \
+  X(GT, ">")                                                                   \
+  X(GE, ">=")                                                                  \
+  X(BIT_AND, "&")                                                              \
+  X(AND, "&&")                                                                 \
+  X(BIT_OR, "|")                                                               \
+  X(OR, "||")
+
+#define SMITH_TOKEN_TABLE_DELIMITERS(X)                                        \
+  X(OPEN_PAREN, "(")                                                           \
+  X(CLOSE_PAREN, ")")                                                          \
+  X(OPEN_BRACE, "{")                                                           \
+  X(CLOSE_BRACE, "}")                                                          \
+  X(OPEN_BRACKET, "[")                                                         \
+  X(CLOSE_BRACKET, "]")                                                        \
+  X(COMMA, ",")
+
+#define SMITH_TOKEN_TABLE_KEYWORDS(X) X(FN, "fn")
+
+#define SMITH_TOKEN_TABLE_LITERALS(X)                                          \
+  X(SYMBOL, "[A-Za-z_][A-Za-z0-9_]*")                                          \
+  X(INT, "[0-9]+")                                                             \
+  X(FLOAT, "[0-9]*\\.[0-9.]*")
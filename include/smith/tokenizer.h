@@ -1,16 +1,21 @@
 #pragma once
 
+#include "smith/allocator.h"
 #include "smith/cursor.h"
 #include "smith/interner.h"
+#include "smith/token_table.h"
 
 /**
  * Represents a symbol within the source text.
- * 
+ *
  * @param span The location of the symbol in the source text.
- * @param interned The interned identifier for the symbol.
+ * @param text The text of the symbol, pointing into the source text.
+ * @param interned The interned identifier for the symbol. Zero if the symbol
+ * was tokenized with the null interner and has not been interned yet.
  */
 typedef struct {
   smith_span_t span;
+  smith_string_t text;
   smith_interned_t interned;
 } smith_symbol_t;
 
@@ -18,10 +23,15 @@ typedef struct {
  * Represents a floating-point number within the source text.
  *
  * @param span The location of the floating-point number in the source text.
- * @param interned The interned identifier for the floating-point value.
+ * @param text The text of the floating-point number, pointing into the source
+ * text.
+ * @param interned The interned identifier for the floating-point value. Zero
+ * if the number was tokenized with the null interner and has not been interned
+ * yet.
  */
 typedef struct {
   smith_span_t span;
+  smith_string_t text;
   smith_interned_t interned;
 } smith_float_t;
 
@@ -29,38 +39,41 @@ typedef struct {
  * Represents an integer within the source text.
  *
  * @param span The location of the integer in the source text.
- * @param interned The interned identifier for the integer value.
+ * @param text The text of the integer, pointing into the source text.
+ * @param interned The interned identifier for the integer value. Zero if the
+ * integer was tokenized with the null interner and has not been interned yet.
  */
 typedef struct {
   smith_span_t span;
+  smith_string_t text;
   smith_interned_t interned;
 } smith_int_t;
 
 /**
- * Enumeration of all operator kinds recognized by the tokenizer.
+ * Represents a string literal within the source text. String literals may not
+ * span lines and support the escape sequences \\, \", \n, \t, \r and \0.
+ *
+ * @param span The location of the string literal, including its quotes.
+ * @param text The text between the quotes, pointing into the source text.
+ * Escape sequences are left as they are written.
+ * @param escaped Whether the text contains escape sequences. If not, the text
+ * already is the value of the string literal.
+ */
+typedef struct {
+  smith_span_t span;
+  smith_string_t text;
+  bool escaped;
+} smith_string_literal_t;
+
+/**
+ * Enumeration of all operator kinds recognized by the tokenizer, expanded from
+ * SMITH_TOKEN_TABLE_OPERATORS.
  */
+#define SMITH_OPERATOR_KIND(name, spelling) SMITH_OPERATOR_KIND_##name,
 typedef enum {
-  SMITH_OPERATOR_KIND_ADD,
-  SMITH_OPERATOR_KIND_ADD_ASSIGN,
-  SMITH_OPERATOR_KIND_SUB,
-  SMITH_OPERATOR_KIND_SUB_ASSIGN,
-  SMITH_OPERATOR_KIND_MUL,
-  SMITH_OPERATOR_KIND_MUL_ASSIGN,
-  SMITH_OPERATOR_KIND_DIV,
-  SMITH_OPERATOR_KIND_DIV_ASSIGN,
-  SMITH_OPERATOR_KIND_ASSIGN,
-  SMITH_OPERATOR_KIND_EQ,
-  SMITH_OPERATOR_KIND_NOT,
-  SMITH_OPERATOR_KIND_NOT_EQ,
-  SMITH_OPERATOR_KIND_LT,
-  SMITH_OPERATOR_KIND_LE,
-  SMITH_OPERATOR_KIND_GT,
-  SMITH_OPERATOR_KIND_GE,
-  SMITH_OPERATOR_KIND_BIT_AND,
-  SMITH_OPERATOR_KIND_AND,
-  SMITH_OPERATOR_KIND_BIT_OR,
-  SMITH_OPERATOR_KIND_OR,
+  SMITH_TOKEN_TABLE_OPERATORS(SMITH_OPERATOR_KIND)
 } smith_operator_kind_t;
+#undef SMITH_OPERATOR_KIND
 
 /**
  * Represents an operator in the source text.
@@ -74,17 +87,14 @@ typedef struct {
 } smith_operator_t;
 
 /**
- * Enumeration of all delimiter kinds recognized by the tokenizer.
+ * Enumeration of all delimiter kinds recognized by the tokenizer, expanded from
+ * SMITH_TOKEN_TABLE_DELIMITERS.
  */
+#define SMITH_DELIMITER_KIND(name, spelling) SMITH_DELIMITER_KIND_##name,
 typedef enum {
-  SMITH_DELIMITER_KIND_OPEN_PAREN,
-  SMITH_DELIMITER_KIND_CLOSE_PAREN,
-  SMITH_DELIMITER_KIND_OPEN_BRACE,
-  SMITH_DELIMITER_KIND_CLOSE_BRACE,
-  SMITH_DELIMITER_KIND_OPEN_BRACKET,
-  SMITH_DELIMITER_KIND_CLOSE_BRACKET,
-  SMITH_DELIMITER_KIND_COMMA,
+  SMITH_TOKEN_TABLE_DELIMITERS(SMITH_DELIMITER_KIND)
 } smith_delimiter_kind_t;
+#undef SMITH_DELIMITER_KIND
 
 /**
  * Represents a delimiter in the source text.
@@ -98,11 +108,14 @@ typedef struct {
 } smith_delimiter_t;
 
 /**
- * Enumeration of all keyword kinds recognized by the tokenizer.
+ * Enumeration of all keyword kinds recognized by the tokenizer, expanded from
+ * SMITH_TOKEN_TABLE_KEYWORDS.
  */
+#define SMITH_KEYWORD_KIND(name, spelling) SMITH_KEYWORD_KIND_##name,
 typedef enum {
-  SMITH_KEYWORD_KIND_FN,  // Represents the "function" keyword in many languages.
+  SMITH_TOKEN_TABLE_KEYWORDS(SMITH_KEYWORD_KIND)
 } smith_keyword_kind_t;
+#undef SMITH_KEYWORD_KIND
 
 /**
  * Represents a keyword in the source text.
@@ -125,10 +138,13 @@ typedef struct {
 } smith_end_of_file_t;
 
 /**
- * Represents an unexpected character error in the source text.
+ * Represents an unexpected character error in the source text. A non-ASCII
+ * character is consumed as a whole code point, or as a single byte when it is
+ * not well formed UTF-8.
  *
  * @param span The location of the unexpected character.
- * @param character The unexpected character that was encountered.
+ * @param character The unexpected character, or the first byte of it when it
+ * is not ASCII.
  */
 typedef struct {
   smith_span_t span;
@@ -146,12 +162,46 @@ typedef struct {
   smith_string_t string;
 } smith_interning_failed_t;
 
+/**
+ * Represents a string literal that is not closed before the end of its line.
+ *
+ * @param span The location from the opening quote to the end of the line.
+ */
+typedef struct {
+  smith_span_t span;
+} smith_unterminated_string_t;
+
+/**
+ * Represents an unknown escape sequence in a string literal. The whole string
+ * literal is consumed so tokenization can continue after it.
+ *
+ * @param span The location of the escape sequence.
+ * @param character The character following the backslash.
+ */
+typedef struct {
+  smith_span_t span;
+  char character;
+} smith_invalid_escape_t;
+
+/**
+ * Represents a block comment that is not closed before the end of the file.
+ *
+ * @param span The location from the start of the comment to the end of the
+ * file.
+ */
+typedef struct {
+  smith_span_t span;
+} smith_unterminated_comment_t;
+
 /**
  * Enumeration of all error kinds that can be encountered by the tokenizer.
  */
 typedef enum {
   SMITH_ERROR_KIND_UNEXPECTED_CHARACTER,
   SMITH_ERROR_KIND_INTERNING_FAILED,
+  SMITH_ERROR_KIND_UNTERMINATED_STRING,
+  SMITH_ERROR_KIND_INVALID_ESCAPE,
+  SMITH_ERROR_KIND_UNTERMINATED_COMMENT,
 } smith_error_kind_t;
 
 /**
@@ -160,6 +210,9 @@ typedef enum {
 typedef union {
   smith_unexpected_character_t unexpected_character;
   smith_interning_failed_t interning_failed;
+  smith_unterminated_string_t unterminated_string;
+  smith_invalid_escape_t invalid_escape;
+  smith_unterminated_comment_t unterminated_comment;
 } smith_error_value_t;
 
 /**
@@ -180,6 +233,7 @@ typedef enum {
   SMITH_TOKEN_KIND_SYMBOL,
   SMITH_TOKEN_KIND_FLOAT,
   SMITH_TOKEN_KIND_INT,
+  SMITH_TOKEN_KIND_STRING,
   SMITH_TOKEN_KIND_OPERATOR,
   SMITH_TOKEN_KIND_DELIMITER,
   SMITH_TOKEN_KIND_KEYWORD,
@@ -194,6 +248,7 @@ typedef union {
   smith_symbol_t symbol;
   smith_float_t float_;
   smith_int_t int_;
+  smith_string_literal_t string;
   smith_operator_t operator_;
   smith_delimiter_t delimiter;
   smith_keyword_t keyword;
@@ -212,15 +267,6 @@ typedef struct {
   smith_token_value_t value;
 } smith_token_t;
 
-/**
- * Represents a collection of keyword identifiers.
- *
- * @param fn The interned identifier for the "fn" keyword.
- */
-typedef struct {
-  smith_interned_t fn;
-} smith_keywords_t;
-
 /**
  * Represents the result of fetching the next token from the source text.
  *
@@ -233,33 +279,157 @@ typedef struct {
 } smith_next_token_result_t;
 
 /**
- * Represents the result of creating a set of keywords for use in tokenization.
- * This structure provides feedback on the success of the operation along with the created keywords.
+ * Represents the result of classifying a string as a keyword.
  *
- * @param keywords The set of keywords successfully created and interned.
- * @param success Boolean flag indicating whether the keyword creation was successful.
+ * @param kind The keyword the string spells, if any.
+ * @param success True if the string is a keyword, false otherwise.
  */
 typedef struct {
-  smith_keywords_t keywords;  // Contains the interned identifiers for each recognized keyword.
-  bool success;               // True if all keywords were successfully created, false otherwise.
-} smith_keywords_create_result_t;
+  smith_keyword_kind_t kind;
+  bool success;
+} smith_keyword_lookup_result_t;
 
 /**
- * Creates a collection of keywords from the given interner.
+ * Classifies a string as a keyword without interning it. Keywords are found
+ * through a perfect hash of their length, first and last byte generated from
+ * SMITH_TOKEN_TABLE_KEYWORDS, so no setup is needed and each lookup costs at
+ * most one comparison. Keyword tokens are identified by their kind alone and
+ * never occupy a slot in the interner.
  *
- * @param interner The interner to use for creating keyword identifiers.
- * @return The result containing the created keywords or an indication of failure.
+ * @param string The string to classify.
+ * @return The result containing the keyword kind, or failure if the string is
+ * not a keyword.
  */
-smith_keywords_create_result_t smith_keywords_create(smith_interner_t interner);
+smith_keyword_lookup_result_t smith_keyword_lookup(smith_string_t string);
 
 /**
- * Fetches the next token from the source text using the given interner and keywords.
+ * Returns the span of a token regardless of its kind.
+ *
+ * @param token The token.
+ * @return A pointer to the span stored inside the token.
+ */
+smith_span_t *smith_token_span(smith_token_t *token);
+
+/**
+ * Returns the source text a token refers to, which symbols and numbers keep
+ * so they can be interned after tokenization. For string literals this is the
+ * text between the quotes.
+ *
+ * @param token The token.
+ * @return A pointer to the text stored inside the token, or null if the token
+ * does not keep its text.
+ */
+smith_string_t *smith_token_text(smith_token_t *token);
+
+/**
+ * Interns the text of a symbol or number token that was produced with the
+ * null interner. If interning fails the token becomes an interning failed
+ * error, exactly as if the tokenizer had failed to intern it. Other tokens are
+ * returned unchanged.
  *
  * @param interner The interner to use for string interning.
+ * @param token The token to intern.
+ * @return The interned token.
+ */
+smith_token_t smith_token_intern(smith_interner_t interner,
+                                 smith_token_t token);
+
+/**
+ * Represents the result of decoding a string literal.
+ *
+ * @param string The value of the string literal.
+ * @param success Indicates whether the decoded string could be allocated.
+ */
+typedef struct {
+  smith_string_t string;
+  bool success;
+} smith_decode_string_result_t;
+
+/**
+ * Decodes the escape sequences of a string literal. A literal without escape
+ * sequences is returned as a slice of the source text without allocating, so
+ * the result only has to be deallocated if `literal.escaped` is true.
+ *
+ * @param allocator The allocator to use for the decoded string.
+ * @param literal The string literal to decode.
+ * @return The result containing the null terminated value of the literal.
+ */
+smith_decode_string_result_t
+smith_decode_string(smith_allocator_t allocator,
+                    smith_string_literal_t literal);
+
+/**
+ * Advances the cursor past any whitespace and comments, updating its line and
+ * column. Line comments run from two slashes to the end of the line and block
+ * comments from a slash star to the next star slash. The cursor is left on the
+ * first character of the next token, on the null terminator if nothing else
+ * remains, or on the start of a block comment that is never closed.
+ *
+ * @param cursor The current position in the source text.
+ * @return The cursor positioned at the start of the next token.
+ */
+smith_cursor_t smith_trim_whitespace(smith_cursor_t cursor);
+
+/**
+ * Determines whether a token boundary is guaranteed between two adjacent
+ * characters, regardless of what precedes them. No token ever spans such a
+ * boundary, so the source can be cut there and the two halves tokenized
+ * independently. Returns false when the characters may belong to one token.
+ * String literals and comments are not taken into account, so the characters
+ * must not be inside either. Every non-ASCII byte may belong to an identifier,
+ * so the source is never cut inside a multi-byte code point.
+ *
+ * @param previous The character before the candidate boundary.
+ * @param next The character after the candidate boundary.
+ * @return True if no token can span the two characters.
+ */
+bool smith_is_token_boundary(char previous, char next);
+
+/**
+ * Tokenizes the string literal whose opening quote is under the cursor.
+ * The closing quote, backslash and newline bytes are found with `smith_scan`,
+ * so the text between them is skipped sixteen bytes at a time.
+ *
+ * @param cursor The position of the opening quote.
+ * @return The string literal or an error if it is malformed.
+ */
+smith_next_token_result_t smith_tokenize_string(smith_cursor_t cursor);
+
+/**
+ * Tokenizes a block comment that is never closed, as left under the cursor by
+ * `smith_trim_whitespace`. The error consumes the rest of the source text.
+ *
+ * @param cursor The position of the start of the comment.
+ * @return The unterminated comment error.
+ */
+smith_next_token_result_t
+smith_tokenize_unterminated_comment(smith_cursor_t cursor);
+
+/**
+ * Tokenizes the source text from a non-ASCII byte. A code point with the
+ * XID_Start property begins a symbol that runs through ASCII identifier
+ * characters and XID_Continue code points. Any other code point, or a byte
+ * that does not begin well formed UTF-8, is an unexpected character. Pure
+ * ASCII source never reaches this path.
+ *
+ * @param interner The interner to use for string interning, or the null
+ * interner to skip interning.
+ * @param cursor The position of the non-ASCII byte.
+ * @return The symbol or an unexpected character error.
+ */
+smith_next_token_result_t smith_tokenize_non_ascii(smith_interner_t interner,
+                                                   smith_cursor_t cursor);
+
+/**
+ * Fetches the next token from the source text using the given interner.
+ * Symbols and numbers always carry their text. When the interner is the null
+ * interner they are not interned at all, leaving that to whoever consumes the
+ * token, e.g. the parser when it builds a node.
+ *
+ * @param interner The interner to use for string interning, or the null
+ * interner to skip interning.
  * @param cursor The current position in the source text.
- * @param keywords The set of keywords to recognize.
  * @return The result of the tokenization attempt.
  */
 smith_next_token_result_t smith_next_token(smith_interner_t interner,
-                                           smith_cursor_t cursor,
-                                           smith_keywords_t keywords);
+                                           smith_cursor_t cursor);
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "smith/allocator.h"
+#include "smith/hash_index.h"
+#include <stdint.h>
+
+/**
+ * Identifies a type by its index in a type table. Types are hash consed, so
+ * two types are the same exactly when their ids are equal.
+ */
+typedef uint32_t smith_type_t;
+
+/**
+ * Marks the absence of a type.
+ */
+#define SMITH_TYPE_NONE UINT32_MAX
+
+/**
+ * Enumeration of the kinds of types.
+ */
+typedef enum {
+  SMITH_TYPE_KIND_INT,      // A signed int of some width.
+  SMITH_TYPE_KIND_FLOAT,    // An IEEE float of 32 or 64 bits.
+  SMITH_TYPE_KIND_BOOL,
+  SMITH_TYPE_KIND_FUNCTION, // Parameter types and a result type.
+} smith_type_kind_t;
+
+/**
+ * Describes a type.
+ *
+ * @param kind The kind of the type.
+ * @param width The number of bits of an int or float.
+ * @param parameters The index of a function's first parameter type in the
+ * table's `parameters`.
+ * @param parameter_count The number of parameters of a function.
+ * @param result The result type of a function.
+ */
+typedef struct {
+  smith_type_kind_t kind;
+  uint32_t width;
+  uint32_t parameters;
+  uint32_t parameter_count;
+  smith_type_t result;
+} smith_type_info_t;
+
+/**
+ * Represents a table of types, each stored once. Adding a type that is
+ * already in the table returns the existing id, so type equality is id
+ * equality and a type can be stored per node in a plain array of ids.
+ *
+ * @param allocator Memory allocator for the arrays and the hash table.
+ * @param types The description of each type.
+ * @param hashes The hash of each type.
+ * @param index The hash index of the types.
+ * @param count The number of types.
+ * @param capacity The number of types the arrays can hold without growing.
+ * @param parameters The parameter types of every function type, one list
+ * after another.
+ * @param parameter_count The number of parameter types held.
+ * @param parameter_capacity The number of parameter types that can be held
+ * without growing.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_type_info_t *types;
+  uint64_t *hashes;
+  smith_hash_index_t index;
+  uint32_t count;
+  uint32_t capacity;
+  smith_type_t *parameters;
+  uint32_t parameter_count;
+  uint32_t parameter_capacity;
+} smith_type_table_t;
+
+/**
+ * Defines the minimum capacity of a type table once it allocates.
+ */
+#define SMITH_TYPE_TABLE_MIN_CAPACITY 16
+
+/**
+ * Creates an empty type table. No memory is allocated until the first type is
+ * added.
+ *
+ * @param allocator The allocator to use for the arrays and hash table.
+ * @return The empty table.
+ */
+smith_type_table_t smith_type_table_create(smith_allocator_t allocator);
+
+/**
+ * Represents the result of adding a type to a table.
+ *
+ * @param type The new type, or the existing type equal to it.
+ * @param success Indicates whether the type is valid and the table could grow
+ * to hold it.
+ */
+typedef struct {
+  smith_type_t type;
+  bool success;
+} smith_type_intern_result_t;
+
+/**
+ * Finds or adds a signed int type.
+ *
+ * @param table The type table.
+ * @param width The number of bits, from 1 to 64.
+ * @return The result of adding the type.
+ */
+smith_type_intern_result_t smith_type_intern_int(smith_type_table_t *table,
+                                                 uint32_t width);
+
+/**
+ * Finds or adds a float type.
+ *
+ * @param table The type table.
+ * @param width The number of bits, 32 or 64.
+ * @return The result of adding the type.
+ */
+smith_type_intern_result_t smith_type_intern_float(smith_type_table_t *table,
+                                                   uint32_t width);
+
+/**
+ * Finds or adds the bool type.
+ *
+ * @param table The type table.
+ * @return The result of adding the type.
+ */
+smith_type_intern_result_t smith_type_intern_bool(smith_type_table_t *table);
+
+/**
+ * Finds or adds a function type. Function types are equal when their
+ * parameter types and result types are.
+ *
+ * @param table The type table.
+ * @param parameters The parameter types, which must be in the table.
+ * @param parameter_count The number of parameters.
+ * @param result The result type, which must be in the table.
+ * @return The result of adding the type.
+ */
+smith_type_intern_result_t
+smith_type_intern_function(smith_type_table_t *table,
+                           const smith_type_t *parameters,
+                           uint32_t parameter_count, smith_type_t result);
+
+/**
+ * Destroys a type table.
+ *
+ * @param table The type table to destroy.
+ */
+void smith_type_table_destroy(smith_type_table_t table);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "smith/string.h"
+#include <stdint.h>
+
+/**
+ * Represents the result of validating a string as UTF-8.
+ *
+ * @param offset The offset of the first byte of the first malformed sequence,
+ * or the length of the string when it is valid.
+ * @param success Whether the whole string is well formed UTF-8.
+ */
+typedef struct {
+  size_t offset;
+  bool success;
+} smith_utf8_validate_result_t;
+
+/**
+ * Checks that a string is well formed UTF-8: no stray continuation bytes,
+ * truncated or overlong sequences, surrogates or code points above U+10FFFF.
+ * Meant to be run once over a whole source file before it is lexed. Where SSE2
+ * is available ASCII is skipped sixteen bytes at a time, so source that is
+ * mostly ASCII costs little more than a pass over memory; only the multi-byte
+ * sequences themselves are checked one code point at a time.
+ *
+ * @param string The string to validate.
+ * @return The result of the validation.
+ */
+smith_utf8_validate_result_t smith_utf8_validate(smith_string_t string);
+
+/**
+ * Represents the result of decoding one code point.
+ *
+ * @param code_point The decoded code point.
+ * @param length The number of bytes the code point was encoded in.
+ * @param success Whether the bytes held a well formed code point.
+ */
+typedef struct {
+  uint32_t code_point;
+  uint8_t length;
+  bool success;
+} smith_utf8_decode_result_t;
+
+/**
+ * Decodes the code point at the start of a null terminated string. Malformed
+ * input fails rather than being read past, so the lexer can decode text that
+ * has not been validated.
+ *
+ * @param source The null terminated string to decode from.
+ * @return The result of the decoding attempt.
+ */
+smith_utf8_decode_result_t smith_utf8_decode(const char *source);
+
+/**
+ * Determines whether a code point may start an identifier, following the
+ * Unicode XID_Start property. The property is looked up in a two stage table
+ * generated by tools/generate_lexer.py.
+ *
+ * @param code_point The code point to classify.
+ * @return True if the code point has the XID_Start property.
+ */
+bool smith_is_xid_start(uint32_t code_point);
+
+/**
+ * Determines whether a code point may continue an identifier, following the
+ * Unicode XID_Continue property.
+ *
+ * @param code_point The code point to classify.
+ * @return True if the code point has the XID_Continue property.
+ */
+bool smith_is_xid_continue(uint32_t code_point);
+
+/**
+ * Skips the rest of an identifier: ASCII letters, digits and underscores as
+ * well as any non-ASCII code point with the XID_Continue property. Stops at
+ * the first byte that cannot continue an identifier, including the first byte
+ * of a malformed sequence.
+ *
+ * @param source The null terminated string to skip through.
+ * @return A pointer to the first byte after the identifier.
+ */
+char *smith_skip_identifier(char *source);
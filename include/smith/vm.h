@@ -0,0 +1,41 @@
+#pragma once
+
+#include "smith/bytecode.h"
+
+/**
+ * Defines how many registers a program can use before running it allocates
+ * its register file rather than keeping it on the native stack.
+ */
+#define SMITH_VM_INLINE_REGISTERS 256
+
+/**
+ * Represents the result of running a program.
+ *
+ * @param value The value the program returned, of type
+ * `bytecode->result_kind`.
+ * @param success False if the program trapped, on an int operation that
+ * overflows 64 bits or divides by zero, or if its registers could not be
+ * allocated.
+ */
+typedef struct {
+  smith_constant_value_t value;
+  bool success;
+} smith_vm_run_result_t;
+
+/**
+ * Runs a program. Instructions are dispatched with computed gotos, each
+ * handler jumping straight to the handler of the next instruction, so the
+ * branch predictor sees one indirect branch per handler rather than a single
+ * shared one. Int arithmetic is checked as in `smith_constant_fold`: where
+ * the folder would give up, the program traps.
+ *
+ * @param allocator The allocator for the registers of a program with more
+ * than `SMITH_VM_INLINE_REGISTERS` of them.
+ * @param bytecode The program.
+ * @param arguments The value of each parameter, of the type it was compiled
+ * with.
+ * @return The value the program returned, or failure.
+ */
+smith_vm_run_result_t smith_vm_run(smith_allocator_t allocator,
+                                   const smith_bytecode_t *bytecode,
+                                   const smith_constant_value_t *arguments);
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "smith/parser.h"
+
+/**
+ * Enumeration of the orders a walk can visit nodes in.
+ */
+typedef enum {
+  SMITH_WALK_ORDER_PRE,  // Every node before its operands, left to right.
+  SMITH_WALK_ORDER_POST, // Every node after its operands, left to right.
+} smith_walk_order_t;
+
+/**
+ * Defines how many pending nodes a walk holds before its stack allocates.
+ */
+#define SMITH_WALK_INLINE_CAPACITY 32
+
+/**
+ * Walks the subtree of a flat AST one node at a time. A post-order walk is a
+ * linear scan of the subtree's node range, since that is the order nodes are
+ * stored in. A pre-order walk keeps the operands it has yet to visit on an
+ * explicit stack, prefetching each node as it is pushed.
+ *
+ * @param allocator The allocator for the stack once it outgrows the inline
+ * storage.
+ * @param ast The AST.
+ * @param order The order to visit nodes in.
+ * @param next The next node of a post-order walk.
+ * @param root The root of the subtree.
+ * @param stack The pending nodes of a pre-order walk, or null while they fit
+ * in `inline_stack`.
+ * @param count The number of pending nodes.
+ * @param capacity The number of pending nodes the stack can hold.
+ * @param failed Whether the walk ended early because the stack could not
+ * grow.
+ * @param inline_stack Storage for the first pending nodes.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  const smith_ast_t *ast;
+  smith_walk_order_t order;
+  smith_ast_node_t next;
+  smith_ast_node_t root;
+  smith_ast_node_t *stack;
+  size_t count;
+  size_t capacity;
+  bool failed;
+  smith_ast_node_t inline_stack[SMITH_WALK_INLINE_CAPACITY];
+} smith_ast_iterator_t;
+
+/**
+ * Starts a walk of the subtree rooted at `root`. Nothing is allocated until
+ * a pre-order walk holds more than `SMITH_WALK_INLINE_CAPACITY` pending
+ * nodes.
+ *
+ * @param allocator The allocator for the stack.
+ * @param ast The AST to walk.
+ * @param root The root of the subtree to walk.
+ * @param order The order to visit nodes in.
+ * @return The walk, to be released with `smith_ast_iterator_destroy`.
+ */
+smith_ast_iterator_t smith_ast_iterator_create(smith_allocator_t allocator,
+                                               const smith_ast_t *ast,
+                                               smith_ast_node_t root,
+                                               smith_walk_order_t order);
+
+/**
+ * Represents the next node of a walk.
+ *
+ * @param node The node.
+ * @param success False once the walk is over.
+ */
+typedef struct {
+  smith_ast_node_t node;
+  bool success;
+} smith_ast_iterator_next_result_t;
+
+/**
+ * Moves a walk on to its next node.
+ *
+ * @param iterator The walk.
+ * @return The next node, or failure once every node has been visited or the
+ * stack could not grow, which `iterator->failed` tells apart.
+ */
+smith_ast_iterator_next_result_t
+smith_ast_iterator_next(smith_ast_iterator_t *iterator);
+
+/**
+ * Destroys a walk, releasing its stack.
+ *
+ * @param iterator The walk to destroy.
+ */
+void smith_ast_iterator_destroy(smith_ast_iterator_t iterator);
+
+/**
+ * Walks an expression tree one node at a time, keeping the nodes it has yet
+ * to visit on an explicit stack rather than recursing, so arbitrarily deep
+ * expressions can be walked. Operands are prefetched as they are pushed, so
+ * that the memory of a node is on its way by the time it is visited.
+ *
+ * @param allocator The allocator for the stack once it outgrows the inline
+ * storage.
+ * @param order The order to visit nodes in.
+ * @param stack The pending nodes, or null while they fit in `inline_stack`.
+ * @param expanded For a post-order walk, whether the operands of each pending
+ * node have already been pushed.
+ * @param count The number of pending nodes.
+ * @param capacity The number of pending nodes the stack can hold.
+ * @param failed Whether the walk ended early because the stack could not
+ * grow.
+ * @param inline_stack Storage for the first pending nodes.
+ * @param inline_expanded Storage for the first expanded flags.
+ */
+typedef struct {
+  smith_allocator_t allocator;
+  smith_walk_order_t order;
+  const smith_expression_t **stack;
+  bool *expanded;
+  size_t count;
+  size_t capacity;
+  bool failed;
+  const smith_expression_t *inline_stack[SMITH_WALK_INLINE_CAPACITY];
+  bool inline_expanded[SMITH_WALK_INLINE_CAPACITY];
+} smith_expression_iterator_t;
+
+/**
+ * Starts a walk of an expression tree, which must outlive the walk.
+ *
+ * @param allocator The allocator for the stack.
+ * @param expression The root of the tree to walk.
+ * @param order The order to visit nodes in.
+ * @return The walk, to be released with `smith_expression_iterator_destroy`.
+ */
+smith_expression_iterator_t
+smith_expression_iterator_create(smith_allocator_t allocator,
+                                 const smith_expression_t *expression,
+                                 smith_walk_order_t order);
+
+/**
+ * Moves a walk on to its next node.
+ *
+ * @param iterator The walk.
+ * @return The next node, or null once every node has been visited or the
+ * stack could not grow, which `iterator->failed` tells apart.
+ */
+const smith_expression_t *
+smith_expression_iterator_next(smith_expression_iterator_t *iterator);
+
+/**
+ * Destroys a walk, releasing its stack.
+ *
+ * @param iterator The walk to destroy.
+ */
+void smith_expression_iterator_destroy(smith_expression_iterator_t iterator);
+
+/**
+ * Defines the largest number of nodes a batch visitor is handed at once.
+ */
+#define SMITH_WALK_BATCH_SIZE 64
+
+/**
+ * Receives the nodes of a flat AST in batches of one kind.
+ *
+ * @param state Pointer to the visitor-specific state.
+ * @param visit Called with up to `SMITH_WALK_BATCH_SIZE` nodes, all of
+ * `kind`.
+ */
+typedef struct {
+  void *state;
+  void (*visit)(void *state, smith_expression_kind_t kind,
+                const smith_ast_node_t *nodes, size_t count);
+} smith_ast_batch_visitor_t;
+
+/**
+ * Hands every node of the subtree rooted at `root` to a visitor, grouped by
+ * kind, so that a pass can handle many nodes of one kind in a tight loop
+ * instead of switching on the kind of every node. Within a kind nodes arrive
+ * in post-order; there is no order between batches of different kinds.
+ *
+ * @param ast The AST.
+ * @param root The root of the subtree to visit.
+ * @param visitor The visitor.
+ */
+void smith_ast_visit_batches(const smith_ast_t *ast, smith_ast_node_t root,
+                             smith_ast_batch_visitor_t visitor);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Structure that represents a sink of bytes that is fed in chunks, the
+ * counterpart of a reader.
+ *
+ * @param state Pointer to the writer-specific state.
+ * @param write Function to write all `length` bytes of `buffer`, returning
+ * false if they could not be written.
+ * @param destroy Function to clean up any resources associated with the writer.
+ */
+typedef struct {
+  void *state;
+  bool (*write)(void *writer, const char *buffer, size_t length);
+  void (*destroy)(void *writer);
+} smith_writer_t;
+
+/**
+ * Writes `length` bytes using the specified writer.
+ *
+ * @param writer The writer to use.
+ * @param buffer The bytes to write.
+ * @param length The number of bytes to write.
+ * @return Whether every byte was written.
+ */
+bool smith_writer_write(smith_writer_t writer, const char *buffer,
+                        size_t length);
+
+/**
+ * Destroys the writer, releasing all associated resources.
+ *
+ * @param writer The writer to destroy.
+ */
+void smith_writer_destroy(smith_writer_t writer);
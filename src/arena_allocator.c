@@ -0,0 +1,121 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/arena_allocator.h"
+#include <assert.h>
+#include <stdint.h>
+
+typedef struct chunk_t chunk_t;
+
+struct chunk_t {
+  chunk_t *previous;
+  size_t size;
+  alignas(max_align_t) char data[];
+};
+
+typedef struct {
+  smith_allocator_t parent;
+  chunk_t *chunk;
+  size_t used;
+} arena_allocator_t;
+
+static chunk_t *chunk_create(smith_allocator_t parent, size_t size,
+                             chunk_t *previous) {
+  chunk_t *chunk = parent.allocate(parent.state, sizeof(chunk_t) + size,
+                                   alignof(chunk_t));
+  if (chunk == NULL) {
+    return NULL;
+  }
+  *chunk = (chunk_t){.previous = previous, .size = size};
+  return chunk;
+}
+
+// Returns the offset into the chunk at which an allocation aligned to
+// `alignment` could start, which may be past the end of the chunk.
+static size_t align_offset(chunk_t *chunk, size_t used, size_t alignment) {
+  uintptr_t address = (uintptr_t)chunk->data + used;
+  uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+  return used + (aligned - address);
+}
+
+static void *allocate(void *allocator, size_t size, size_t alignment) {
+  assert(allocator != NULL);
+  arena_allocator_t *arena = allocator;
+  chunk_t *chunk = arena->chunk;
+  if (chunk != NULL) {
+    size_t start = align_offset(chunk, arena->used, alignment);
+    if (start <= chunk->size && chunk->size - start >= size) {
+      arena->used = start + size;
+      return chunk->data + start;
+    }
+  }
+  // Start a new chunk big enough for the allocation and at least twice the
+  // size of the last one. The rest of the old chunk is left unused.
+  size_t chunk_size =
+      chunk == NULL ? SMITH_ARENA_MIN_CHUNK_SIZE : chunk->size * 2;
+  size_t needed = size + alignment;
+  if (needed < size) {
+    return NULL;
+  }
+  while (chunk_size < needed) {
+    if (chunk_size > SIZE_MAX / 2) {
+      return NULL;
+    }
+    chunk_size *= 2;
+  }
+  chunk_t *next = chunk_create(arena->parent, chunk_size, chunk);
+  if (next == NULL) {
+    return NULL;
+  }
+  size_t start = align_offset(next, 0, alignment);
+  arena->chunk = next;
+  arena->used = start + size;
+  return next->data + start;
+}
+
+static void deallocate(void *allocator, void *pointer) {}
+
+static void release_previous(arena_allocator_t *arena) {
+  chunk_t *chunk = arena->chunk->previous;
+  while (chunk != NULL) {
+    chunk_t *previous = chunk->previous;
+    smith_allocator_deallocate(arena->parent, chunk);
+    chunk = previous;
+  }
+  arena->chunk->previous = NULL;
+}
+
+static void destroy(void *allocator) {
+  assert(allocator != NULL);
+  arena_allocator_t *arena = allocator;
+  smith_allocator_t parent = arena->parent;
+  if (arena->chunk != NULL) {
+    release_previous(arena);
+    smith_allocator_deallocate(parent, arena->chunk);
+  }
+  smith_allocator_deallocate(parent, arena);
+}
+
+smith_arena_allocator_create_result_t
+smith_arena_allocator_create(smith_allocator_t parent) {
+  arena_allocator_t *arena = smith_allocator_allocate(parent, arena_allocator_t);
+  if (arena == NULL) {
+    return (smith_arena_allocator_create_result_t){};
+  }
+  *arena = (arena_allocator_t){.parent = parent};
+  return (smith_arena_allocator_create_result_t){
+      .allocator = {.allocate = allocate,
+                    .deallocate = deallocate,
+                    .destroy = destroy,
+                    .state = arena},
+      .success = true};
+}
+
+// The newest chunk is always the largest, so it is the one worth keeping.
+void smith_arena_allocator_reset(smith_allocator_t allocator) {
+  assert(allocator.allocate == allocate);
+  arena_allocator_t *arena = allocator.state;
+  if (arena->chunk != NULL) {
+    release_previous(arena);
+  }
+  arena->used = 0;
+}
@@ -0,0 +1,132 @@
+#include "smith/ast.h"
+#include <string.h>
+
+smith_ast_t smith_ast_create(smith_allocator_t allocator) {
+  return (smith_ast_t){.allocator = allocator};
+}
+
+// All four arrays share one block, ordered from the most to the least
+// strictly aligned so that none of them needs padding.
+static size_t block_size(uint32_t capacity) {
+  return capacity * (sizeof(smith_ast_payload_t) + sizeof(smith_span_t) +
+                     sizeof(smith_ast_children_t) + sizeof(uint8_t));
+}
+
+bool smith_ast_reserve(smith_ast_t *ast, uint32_t capacity) {
+  if (capacity <= ast->capacity) {
+    return true;
+  }
+  uint64_t new_capacity = (uint64_t)ast->capacity * 2;
+  if (new_capacity < capacity) {
+    new_capacity = capacity;
+  }
+  if (new_capacity < SMITH_AST_MIN_CAPACITY) {
+    new_capacity = SMITH_AST_MIN_CAPACITY;
+  }
+  if (new_capacity > UINT32_MAX) {
+    new_capacity = UINT32_MAX;
+  }
+  char *block = ast->allocator.allocate(ast->allocator.state,
+                                        block_size((uint32_t)new_capacity),
+                                        alignof(smith_ast_payload_t));
+  if (block == nullptr) {
+    return false;
+  }
+  smith_ast_payload_t *payloads = (smith_ast_payload_t *)block;
+  smith_span_t *spans = (smith_span_t *)(payloads + new_capacity);
+  smith_ast_children_t *children =
+      (smith_ast_children_t *)(spans + new_capacity);
+  uint8_t *kinds = (uint8_t *)(children + new_capacity);
+  if (ast->count > 0) {
+    memcpy(payloads, ast->payloads, ast->count * sizeof(smith_ast_payload_t));
+    memcpy(spans, ast->spans, ast->count * sizeof(smith_span_t));
+    memcpy(children, ast->children, ast->count * sizeof(smith_ast_children_t));
+    memcpy(kinds, ast->kinds, ast->count * sizeof(uint8_t));
+  }
+  smith_allocator_deallocate(ast->allocator, ast->payloads);
+  ast->payloads = payloads;
+  ast->spans = spans;
+  ast->children = children;
+  ast->kinds = kinds;
+  ast->capacity = (uint32_t)new_capacity;
+  return true;
+}
+
+static smith_ast_push_result_t push(smith_ast_t *ast, uint8_t kind,
+                                    smith_span_t span,
+                                    smith_ast_children_t children,
+                                    smith_ast_payload_t payload) {
+  if (ast->count == UINT32_MAX || !smith_ast_reserve(ast, ast->count + 1)) {
+    return (smith_ast_push_result_t){};
+  }
+  smith_ast_node_t node = ast->count;
+  ast->kinds[node] = kind;
+  ast->spans[node] = span;
+  ast->children[node] = children;
+  ast->payloads[node] = payload;
+  ast->count++;
+  return (smith_ast_push_result_t){.node = node, .success = true};
+}
+
+smith_ast_push_result_t smith_ast_push_leaf(smith_ast_t *ast,
+                                            smith_expression_kind_t kind,
+                                            smith_span_t span,
+                                            smith_ast_leaf_t leaf) {
+  return push(ast, kind, span, (smith_ast_children_t){},
+              (smith_ast_payload_t){.leaf = leaf});
+}
+
+smith_ast_push_result_t
+smith_ast_push_binary_operator(smith_ast_t *ast,
+                               smith_binary_operator_info_t info,
+                               smith_span_t op_span,
+                               smith_ast_children_t children) {
+  return push(ast, SMITH_EXPRESSION_KIND_BINARY_OPERATOR, op_span, children,
+              (smith_ast_payload_t){.binary_operator = info});
+}
+
+smith_ast_push_result_t smith_ast_push_constant(smith_ast_t *ast,
+                                                smith_span_t span,
+                                                smith_constant_t constant) {
+  return push(ast, SMITH_EXPRESSION_KIND_CONSTANT, span,
+              (smith_ast_children_t){},
+              (smith_ast_payload_t){.constant = constant});
+}
+
+bool smith_ast_append(smith_ast_t *ast, const smith_ast_t *other) {
+  if (other->count == 0) {
+    return true;
+  }
+  if (other->count > UINT32_MAX - ast->count ||
+      !smith_ast_reserve(ast, ast->count + other->count)) {
+    return false;
+  }
+  uint32_t base = ast->count;
+  memcpy(ast->payloads + base, other->payloads,
+         other->count * sizeof(smith_ast_payload_t));
+  memcpy(ast->spans + base, other->spans, other->count * sizeof(smith_span_t));
+  memcpy(ast->kinds + base, other->kinds, other->count * sizeof(uint8_t));
+  for (uint32_t node = 0; node < other->count; node++) {
+    smith_ast_children_t children = other->children[node];
+    if (other->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      children.left += base;
+      children.right += base;
+    }
+    ast->children[base + node] = children;
+  }
+  ast->count += other->count;
+  return true;
+}
+
+// The first node of a subtree in bottom up order is its leftmost leaf.
+smith_ast_node_t smith_ast_first(const smith_ast_t *ast,
+                                 smith_ast_node_t node) {
+  while (ast->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    node = ast->children[node].left;
+  }
+  return node;
+}
+
+void smith_ast_destroy(smith_ast_t ast) {
+  smith_allocator_deallocate(ast.allocator, ast.payloads);
+}
@@ -0,0 +1,188 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/ast_index.h"
+#include <stdlib.h>
+
+static inline bool position_less(smith_position_t a, smith_position_t b) {
+  return a.line < b.line || (a.line == b.line && a.column < b.column);
+}
+
+static inline bool contains(smith_span_t span, smith_position_t position) {
+  return !position_less(position, span.start) &&
+         position_less(position, span.end);
+}
+
+// All four arrays share one block, with the spans first for alignment.
+static size_t block_size(uint32_t count) {
+  return count * (2 * sizeof(smith_span_t) + 2 * sizeof(smith_ast_node_t));
+}
+
+typedef struct {
+  smith_span_t span;
+  smith_ast_node_t node;
+} entry_t;
+
+static int compare_entries(const void *a, const void *b) {
+  smith_position_t left = ((const entry_t *)a)->span.start;
+  smith_position_t right = ((const entry_t *)b)->span.start;
+  return position_less(left, right) ? -1 : position_less(right, left);
+}
+
+// Sorts the entries of an AST whose expressions are not in source order.
+static bool sort_entries(smith_ast_index_t *index) {
+  uint32_t count = index->count;
+  entry_t *entries = smith_allocator_allocate_array(index->allocator, entry_t,
+                                                    count);
+  if (entries == nullptr) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    entries[i] = (entry_t){.span = index->spans[i], .node = index->nodes[i]};
+  }
+  qsort(entries, count, sizeof(entry_t), compare_entries);
+  for (uint32_t i = 0; i < count; i++) {
+    index->spans[i] = entries[i].span;
+    index->nodes[i] = entries[i].node;
+  }
+  smith_allocator_deallocate(index->allocator, entries);
+  return true;
+}
+
+smith_ast_index_create_result_t
+smith_ast_index_create(smith_allocator_t allocator, const smith_ast_t *ast) {
+  smith_ast_index_t index = {.allocator = allocator, .count = ast->count};
+  uint32_t count = ast->count;
+  if (count == 0) {
+    return (smith_ast_index_create_result_t){.index = index, .success = true};
+  }
+  char *block = allocator.allocate(allocator.state, block_size(count),
+                                   alignof(smith_span_t));
+  // The first node of each subtree, then where each subtree starts in source
+  // order.
+  uint32_t scratch_count = count * 2;
+  smith_ast_node_t *scratch = smith_allocator_allocate_array(
+      allocator, smith_ast_node_t, scratch_count);
+  if (block == nullptr || scratch == nullptr) {
+    smith_allocator_deallocate(allocator, block);
+    smith_allocator_deallocate(allocator, scratch);
+    return (smith_ast_index_create_result_t){};
+  }
+  index.spans = (smith_span_t *)block;
+  index.extents = index.spans + count;
+  index.nodes = (smith_ast_node_t *)(index.extents + count);
+  index.parents = index.nodes + count;
+  smith_ast_node_t *first = scratch;
+  uint32_t *start = scratch + count;
+  // Children precede their parents, so one pass up the tree finds parents,
+  // extents and the first node of every subtree.
+  for (smith_ast_node_t node = 0; node < count; node++) {
+    index.parents[node] = SMITH_AST_INDEX_NO_NODE;
+    if (ast->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      smith_ast_children_t children = ast->children[node];
+      index.parents[children.left] = node;
+      index.parents[children.right] = node;
+      first[node] = first[children.left];
+      index.extents[node] = (smith_span_t){
+          .start = index.extents[children.left].start,
+          .end = index.extents[children.right].end};
+    } else {
+      first[node] = node;
+      index.extents[node] = ast->spans[node];
+    }
+  }
+  // Expressions are laid out one after another in node order, and within
+  // one the left operand of a node comes before it in source order and the
+  // right operand after it, so one pass down the tree places every node.
+  uint32_t base = 0;
+  for (smith_ast_node_t node = 0; node < count; node++) {
+    if (index.parents[node] == SMITH_AST_INDEX_NO_NODE) {
+      start[node] = base;
+      base += node - first[node] + 1;
+    }
+  }
+  for (smith_ast_node_t node = count; node-- > 0;) {
+    if (ast->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      smith_ast_children_t children = ast->children[node];
+      uint32_t position = start[node] + (children.left - first[node] + 1);
+      index.nodes[position] = node;
+      start[children.left] = start[node];
+      start[children.right] = position + 1;
+    } else {
+      index.nodes[start[node]] = node;
+    }
+  }
+  smith_allocator_deallocate(allocator, scratch);
+  bool sorted = true;
+  for (uint32_t i = 0; i < count; i++) {
+    index.spans[i] = ast->spans[index.nodes[i]];
+    sorted = sorted && (i == 0 || !position_less(index.spans[i].start,
+                                                 index.spans[i - 1].start));
+  }
+  if (!sorted && !sort_entries(&index)) {
+    smith_ast_index_destroy(index);
+    return (smith_ast_index_create_result_t){};
+  }
+  return (smith_ast_index_create_result_t){.index = index, .success = true};
+}
+
+smith_ast_index_find_result_t
+smith_ast_index_innermost(const smith_ast_index_t *index,
+                          smith_position_t position) {
+  // Count the entries starting at or before the position.
+  uint32_t low = 0;
+  uint32_t high = index->count;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (position_less(position, index->spans[middle].start)) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  if (low == 0) {
+    return (smith_ast_index_find_result_t){};
+  }
+  smith_ast_node_t before = index->nodes[low - 1];
+  if (position_less(position, index->spans[low - 1].end) ||
+      contains(index->extents[before], position)) {
+    return (smith_ast_index_find_result_t){.node = before, .success = true};
+  }
+  // Between two tokens, the innermost node is whichever of their nodes is the
+  // ancestor of the other, if either reaches across.
+  if (low < index->count &&
+      contains(index->extents[index->nodes[low]], position)) {
+    return (smith_ast_index_find_result_t){.node = index->nodes[low],
+                                           .success = true};
+  }
+  return (smith_ast_index_find_result_t){};
+}
+
+smith_ast_index_range_t smith_ast_index_overlapping(const smith_ast_index_t *index,
+                                                    smith_span_t span) {
+  // Own spans do not overlap, so their ends are sorted as well.
+  uint32_t low = 0;
+  uint32_t high = index->count;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (position_less(span.start, index->spans[middle].end)) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  uint32_t start = low;
+  high = index->count;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (position_less(index->spans[middle].start, span.end)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return (smith_ast_index_range_t){.start = start, .end = low};
+}
+
+void smith_ast_index_destroy(smith_ast_index_t index) {
+  smith_allocator_deallocate(index.allocator, index.spans);
+}
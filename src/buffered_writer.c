@@ -0,0 +1,102 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/buffered_writer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+smith_buffered_writer_create_result_t
+smith_buffered_writer_create(smith_allocator_t allocator,
+                             smith_writer_t writer, size_t capacity) {
+  if (capacity == 0) {
+    capacity = SMITH_BUFFERED_WRITER_DEFAULT_CAPACITY;
+  }
+  char *buffer = smith_allocator_allocate_array(allocator, char, capacity);
+  if (buffer == nullptr) {
+    return (smith_buffered_writer_create_result_t){};
+  }
+  return (smith_buffered_writer_create_result_t){
+      .writer = {.allocator = allocator,
+                 .writer = writer,
+                 .buffer = buffer,
+                 .capacity = capacity},
+      .success = true};
+}
+
+bool smith_buffered_writer_flush(smith_buffered_writer_t *writer) {
+  if (!writer->failed && writer->length > 0) {
+    writer->failed = !smith_writer_write(writer->writer, writer->buffer,
+                                         writer->length);
+  }
+  writer->length = 0;
+  return !writer->failed;
+}
+
+bool smith_buffered_writer_write(smith_buffered_writer_t *writer,
+                                 const char *buffer, size_t length) {
+  if (writer->failed) {
+    return false;
+  }
+  if (writer->capacity - writer->length < length &&
+      !smith_buffered_writer_flush(writer)) {
+    return false;
+  }
+  if (length > writer->capacity) {
+    writer->failed = !smith_writer_write(writer->writer, buffer, length);
+    return !writer->failed;
+  }
+  memcpy(writer->buffer + writer->length, buffer, length);
+  writer->length += length;
+  return true;
+}
+
+bool smith_buffered_writer_format(smith_buffered_writer_t *writer,
+                                  const char *format, ...) {
+  if (writer->failed) {
+    return false;
+  }
+  // Format straight into the free end of the buffer, which `vsnprintf`
+  // terminates, so a full buffer leaves one byte spare.
+  va_list args;
+  va_start(args, format);
+  size_t available = writer->capacity - writer->length;
+  int length = vsnprintf(writer->buffer + writer->length, available, format,
+                         args);
+  va_end(args);
+  if (length < 0) {
+    writer->failed = true;
+    return false;
+  }
+  if ((size_t)length < available) {
+    writer->length += length;
+    return true;
+  }
+  if (!smith_buffered_writer_flush(writer)) {
+    return false;
+  }
+  if ((size_t)length < writer->capacity) {
+    va_start(args, format);
+    vsnprintf(writer->buffer, writer->capacity, format, args);
+    va_end(args);
+    writer->length = length;
+    return true;
+  }
+  // Too large for the buffer: format it on its own and pass it on.
+  size_t size = (size_t)length + 1;
+  char *formatted =
+      smith_allocator_allocate_array(writer->allocator, char, size);
+  if (formatted == nullptr) {
+    writer->failed = true;
+    return false;
+  }
+  va_start(args, format);
+  vsnprintf(formatted, size, format, args);
+  va_end(args);
+  writer->failed = !smith_writer_write(writer->writer, formatted, length);
+  smith_allocator_deallocate(writer->allocator, formatted);
+  return !writer->failed;
+}
+
+void smith_buffered_writer_destroy(smith_buffered_writer_t writer) {
+  smith_allocator_deallocate(writer.allocator, writer.buffer);
+}
@@ -0,0 +1,437 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/bytecode.h"
+#include "smith/constant.h"
+#include "smith/dag.h"
+#include "smith/walk.h"
+#include <string.h>
+
+// The instruction for each operator and operand type. An operator with no
+// meaning for a type maps to `SMITH_OPCODE_MOVE`, which no operator compiles
+// to.
+static const smith_opcode_t opcodes[][SMITH_CONSTANT_KIND_BOOL + 1] = {
+    [SMITH_BINARY_OPERATOR_KIND_ADD] = {SMITH_OPCODE_INT_ADD,
+                                        SMITH_OPCODE_FLOAT_ADD},
+    [SMITH_BINARY_OPERATOR_KIND_SUB] = {SMITH_OPCODE_INT_SUB,
+                                        SMITH_OPCODE_FLOAT_SUB},
+    [SMITH_BINARY_OPERATOR_KIND_MUL] = {SMITH_OPCODE_INT_MUL,
+                                        SMITH_OPCODE_FLOAT_MUL},
+    [SMITH_BINARY_OPERATOR_KIND_DIV] = {SMITH_OPCODE_INT_DIV,
+                                        SMITH_OPCODE_FLOAT_DIV},
+    [SMITH_BINARY_OPERATOR_KIND_EQ] = {SMITH_OPCODE_INT_EQ,
+                                       SMITH_OPCODE_FLOAT_EQ,
+                                       SMITH_OPCODE_BOOL_EQ},
+    [SMITH_BINARY_OPERATOR_KIND_NOT_EQ] = {SMITH_OPCODE_INT_NOT_EQ,
+                                           SMITH_OPCODE_FLOAT_NOT_EQ,
+                                           SMITH_OPCODE_BOOL_NOT_EQ},
+    [SMITH_BINARY_OPERATOR_KIND_LT] = {SMITH_OPCODE_INT_LT,
+                                       SMITH_OPCODE_FLOAT_LT},
+    [SMITH_BINARY_OPERATOR_KIND_LE] = {SMITH_OPCODE_INT_LE,
+                                       SMITH_OPCODE_FLOAT_LE},
+    [SMITH_BINARY_OPERATOR_KIND_GT] = {SMITH_OPCODE_INT_GT,
+                                       SMITH_OPCODE_FLOAT_GT},
+    [SMITH_BINARY_OPERATOR_KIND_GE] = {SMITH_OPCODE_INT_GE,
+                                       SMITH_OPCODE_FLOAT_GE},
+    [SMITH_BINARY_OPERATOR_KIND_BIT_AND] = {SMITH_OPCODE_INT_BIT_AND,
+                                            SMITH_OPCODE_MOVE,
+                                            SMITH_OPCODE_BOOL_AND},
+    [SMITH_BINARY_OPERATOR_KIND_BIT_OR] = {SMITH_OPCODE_INT_BIT_OR,
+                                           SMITH_OPCODE_MOVE,
+                                           SMITH_OPCODE_BOOL_OR},
+    [SMITH_BINARY_OPERATOR_KIND_AND] = {SMITH_OPCODE_MOVE, SMITH_OPCODE_MOVE,
+                                        SMITH_OPCODE_BOOL_AND},
+    [SMITH_BINARY_OPERATOR_KIND_OR] = {SMITH_OPCODE_MOVE, SMITH_OPCODE_MOVE,
+                                       SMITH_OPCODE_BOOL_OR},
+};
+
+// The operator a compound assignment applies, or the operator itself.
+static smith_binary_operator_kind_t
+underlying_operator(smith_binary_operator_kind_t kind) {
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN:
+    return SMITH_BINARY_OPERATOR_KIND_ADD;
+  case SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN:
+    return SMITH_BINARY_OPERATOR_KIND_SUB;
+  case SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN:
+    return SMITH_BINARY_OPERATOR_KIND_MUL;
+  case SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN:
+    return SMITH_BINARY_OPERATOR_KIND_DIV;
+  default:
+    return kind;
+  }
+}
+
+static bool is_comparison(smith_binary_operator_kind_t kind) {
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_EQ:
+  case SMITH_BINARY_OPERATOR_KIND_NOT_EQ:
+  case SMITH_BINARY_OPERATOR_KIND_LT:
+  case SMITH_BINARY_OPERATOR_KIND_LE:
+  case SMITH_BINARY_OPERATOR_KIND_GT:
+  case SMITH_BINARY_OPERATOR_KIND_GE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+#define NO_NODE UINT32_MAX
+
+// What is known about a symbol or constant, by its DAG node.
+typedef struct {
+  uint32_t register_;
+  smith_constant_kind_t kind;
+  bool defined;
+} slot_t;
+
+// A value on the compile-time stack: the register holding it, or for a
+// symbol not yet known to be read or assigned, its DAG node.
+typedef struct {
+  uint32_t register_;
+  smith_constant_kind_t kind;
+  smith_dag_node_t symbol;
+} value_t;
+
+typedef struct {
+  smith_bytecode_t bytecode;
+  smith_dag_t dag;
+  // The DAG node of every leaf, in the order the walk visits them.
+  smith_dag_node_t *leaves;
+  size_t leaf_count;
+  size_t leaf_capacity;
+  slot_t *slots;
+  value_t *values;
+  size_t value_count;
+  size_t value_capacity;
+  uint32_t temporaries;
+} compiler_t;
+
+static bool reserve(smith_allocator_t allocator, void **items,
+                    size_t *capacity, size_t needed, size_t size,
+                    size_t alignment) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  size_t new_capacity = *capacity == 0 ? 64 : *capacity * 2;
+  void *new_items =
+      allocator.allocate(allocator.state, new_capacity * size, alignment);
+  if (new_items == nullptr) {
+    return false;
+  }
+  if (*items != nullptr) {
+    memcpy(new_items, *items, *capacity * size);
+  }
+  smith_allocator_deallocate(allocator, *items);
+  *items = new_items;
+  *capacity = new_capacity;
+  return true;
+}
+
+static bool emit(compiler_t *compiler, smith_instruction_t instruction) {
+  smith_bytecode_t *bytecode = &compiler->bytecode;
+  if (!reserve(bytecode->allocator, (void **)&bytecode->instructions,
+               &bytecode->capacity, bytecode->count + 1,
+               sizeof(smith_instruction_t), alignof(smith_instruction_t))) {
+    return false;
+  }
+  bytecode->instructions[bytecode->count++] = instruction;
+  return true;
+}
+
+static smith_ast_leaf_t symbol_leaf(const smith_expression_t *expression) {
+  return (smith_ast_leaf_t){.text = expression->value.symbol.text,
+                            .interned = expression->value.symbol.interned};
+}
+
+static smith_constant_result_t
+constant_of(const smith_expression_t *expression) {
+  switch (expression->kind) {
+  case SMITH_EXPRESSION_KIND_INT:
+    return smith_constant_from_literal(expression->kind,
+                                       expression->value.int_.text);
+  case SMITH_EXPRESSION_KIND_FLOAT:
+    return smith_constant_from_literal(expression->kind,
+                                       expression->value.float_.text);
+  default:
+    return (smith_constant_result_t){
+        .constant = expression->value.constant.constant, .success = true};
+  }
+}
+
+// Finds the symbols and constants of the expression, giving each a DAG
+// node, so that every distinct constant takes one register and every symbol
+// one variable.
+static bool collect_leaves(compiler_t *compiler,
+                           const smith_expression_t *expression) {
+  smith_allocator_t allocator = compiler->bytecode.allocator;
+  smith_expression_iterator_t iterator = smith_expression_iterator_create(
+      allocator, expression, SMITH_WALK_ORDER_POST);
+  bool success = true;
+  const smith_expression_t *current;
+  while (success &&
+         (current = smith_expression_iterator_next(&iterator)) != nullptr) {
+    if (current->kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      continue;
+    }
+    smith_dag_intern_result_t intern_result;
+    if (current->kind == SMITH_EXPRESSION_KIND_SYMBOL) {
+      intern_result = smith_dag_intern_leaf(
+          &compiler->dag, SMITH_EXPRESSION_KIND_SYMBOL, symbol_leaf(current));
+    } else {
+      smith_constant_result_t constant_result = constant_of(current);
+      if (!constant_result.success) {
+        success = false;
+        break;
+      }
+      intern_result =
+          smith_dag_intern_constant(&compiler->dag, constant_result.constant);
+    }
+    success = intern_result.success &&
+              reserve(allocator, (void **)&compiler->leaves,
+                      &compiler->leaf_capacity, compiler->leaf_count + 1,
+                      sizeof(smith_dag_node_t), alignof(smith_dag_node_t));
+    if (success) {
+      compiler->leaves[compiler->leaf_count++] = intern_result.node;
+    }
+  }
+  success = success && !iterator.failed;
+  smith_expression_iterator_destroy(iterator);
+  return success;
+}
+
+// Lays out the registers: parameters, constants, variables, then
+// temporaries.
+static bool assign_registers(compiler_t *compiler,
+                             const smith_bytecode_parameter_t *parameters,
+                             uint32_t parameter_count) {
+  smith_allocator_t allocator = compiler->bytecode.allocator;
+  smith_dag_t *dag = &compiler->dag;
+  uint32_t count = dag->count;
+  compiler->slots = smith_allocator_allocate_array(allocator, slot_t, count);
+  uint32_t constant_count = 0;
+  for (smith_dag_node_t node = parameter_count; node < count; node++) {
+    constant_count += dag->kinds[node] == SMITH_EXPRESSION_KIND_CONSTANT;
+  }
+  compiler->bytecode.constants = smith_allocator_allocate_array(
+      allocator, smith_constant_value_t, constant_count);
+  if (compiler->slots == nullptr ||
+      (constant_count > 0 && compiler->bytecode.constants == nullptr)) {
+    return false;
+  }
+  for (smith_dag_node_t node = 0; node < parameter_count; node++) {
+    compiler->slots[node] = (slot_t){
+        .register_ = node, .kind = parameters[node].kind, .defined = true};
+  }
+  uint32_t constant_register = parameter_count;
+  uint32_t variable_register = parameter_count + constant_count;
+  for (smith_dag_node_t node = parameter_count; node < count; node++) {
+    if (dag->kinds[node] == SMITH_EXPRESSION_KIND_CONSTANT) {
+      smith_constant_t constant = dag->payloads[node].constant;
+      compiler->bytecode.constants[constant_register - parameter_count] =
+          constant.value;
+      compiler->slots[node] = (slot_t){.register_ = constant_register++,
+                                       .kind = constant.kind,
+                                       .defined = true};
+    } else {
+      compiler->slots[node] = (slot_t){.register_ = variable_register++};
+    }
+  }
+  compiler->bytecode.constant_count = constant_count;
+  compiler->temporaries = variable_register;
+  return true;
+}
+
+// Gives the register of a value that is read, failing for a symbol that is
+// not yet a parameter or variable.
+static bool read_value(compiler_t *compiler, value_t *value) {
+  if (value->symbol == NO_NODE) {
+    return true;
+  }
+  slot_t slot = compiler->slots[value->symbol];
+  if (!slot.defined) {
+    return false;
+  }
+  *value = (value_t){
+      .register_ = slot.register_, .kind = slot.kind, .symbol = NO_NODE};
+  return true;
+}
+
+static bool push_value(compiler_t *compiler, value_t value) {
+  if (!reserve(compiler->bytecode.allocator, (void **)&compiler->values,
+               &compiler->value_capacity, compiler->value_count + 1,
+               sizeof(value_t), alignof(value_t))) {
+    return false;
+  }
+  compiler->values[compiler->value_count++] = value;
+  return true;
+}
+
+// The register of the temporary at the given depth of the value stack.
+static bool temporary(compiler_t *compiler, size_t depth, uint32_t *register_) {
+  uint64_t index = (uint64_t)compiler->temporaries + depth;
+  if (index >= SMITH_BYTECODE_MAX_REGISTERS) {
+    return false;
+  }
+  *register_ = (uint32_t)index;
+  if (index + 1 > compiler->bytecode.register_count) {
+    compiler->bytecode.register_count = (uint32_t)index + 1;
+  }
+  return true;
+}
+
+static bool compile_assignment(compiler_t *compiler,
+                               smith_binary_operator_kind_t kind,
+                               value_t target, value_t value) {
+  if (target.symbol == NO_NODE || !read_value(compiler, &value)) {
+    return false;
+  }
+  slot_t *slot = &compiler->slots[target.symbol];
+  if (kind == SMITH_BINARY_OPERATOR_KIND_ASSIGN) {
+    if (slot->defined && slot->kind != value.kind) {
+      return false;
+    }
+    slot->kind = value.kind;
+    slot->defined = true;
+    smith_bytecode_t *bytecode = &compiler->bytecode;
+    smith_instruction_t *last =
+        bytecode->count > 0 ? &bytecode->instructions[bytecode->count - 1]
+                            : nullptr;
+    if (value.register_ >= compiler->temporaries && last != nullptr &&
+        last->destination == value.register_) {
+      // The value was just computed, so compute it into the variable.
+      last->destination = slot->register_;
+    } else if (value.register_ != slot->register_ &&
+               !emit(compiler,
+                     (smith_instruction_t){.opcode = SMITH_OPCODE_MOVE,
+                                           .destination = slot->register_,
+                                           .left = value.register_})) {
+      return false;
+    }
+  } else {
+    if (!slot->defined || slot->kind != value.kind) {
+      return false;
+    }
+    smith_opcode_t opcode = opcodes[underlying_operator(kind)][value.kind];
+    if (opcode == SMITH_OPCODE_MOVE ||
+        !emit(compiler, (smith_instruction_t){.opcode = opcode,
+                                              .destination = slot->register_,
+                                              .left = slot->register_,
+                                              .right = value.register_})) {
+      return false;
+    }
+  }
+  return push_value(compiler,
+                    (value_t){.register_ = slot->register_,
+                              .kind = slot->kind,
+                              .symbol = NO_NODE});
+}
+
+static bool compile_binary_operator(compiler_t *compiler,
+                                    smith_binary_operator_kind_t kind) {
+  compiler->value_count -= 2;
+  size_t depth = compiler->value_count;
+  value_t left = compiler->values[depth];
+  value_t right = compiler->values[depth + 1];
+  if (kind == SMITH_BINARY_OPERATOR_KIND_ASSIGN ||
+      underlying_operator(kind) != kind) {
+    return compile_assignment(compiler, kind, left, right);
+  }
+  if (!read_value(compiler, &left) || !read_value(compiler, &right) ||
+      left.kind != right.kind) {
+    return false;
+  }
+  smith_opcode_t opcode = opcodes[kind][left.kind];
+  uint32_t destination;
+  if (opcode == SMITH_OPCODE_MOVE ||
+      !temporary(compiler, depth, &destination) ||
+      !emit(compiler, (smith_instruction_t){.opcode = opcode,
+                                            .destination = destination,
+                                            .left = left.register_,
+                                            .right = right.register_})) {
+    return false;
+  }
+  return push_value(
+      compiler,
+      (value_t){.register_ = destination,
+                .kind = is_comparison(kind) ? SMITH_CONSTANT_KIND_BOOL
+                                            : left.kind,
+                .symbol = NO_NODE});
+}
+
+static bool compile_instructions(compiler_t *compiler,
+                                 const smith_expression_t *expression) {
+  smith_expression_iterator_t iterator =
+      smith_expression_iterator_create(compiler->bytecode.allocator,
+                                       expression, SMITH_WALK_ORDER_POST);
+  size_t leaf = 0;
+  bool success = true;
+  const smith_expression_t *current;
+  while (success &&
+         (current = smith_expression_iterator_next(&iterator)) != nullptr) {
+    if (current->kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      success = compile_binary_operator(
+          compiler, current->value.binary_operator.info.kind);
+      continue;
+    }
+    smith_dag_node_t node = compiler->leaves[leaf++];
+    if (current->kind == SMITH_EXPRESSION_KIND_SYMBOL) {
+      // Whether a symbol is read or assigned is only known at its operator.
+      success = push_value(compiler, (value_t){.symbol = node});
+    } else {
+      slot_t slot = compiler->slots[node];
+      success = push_value(compiler, (value_t){.register_ = slot.register_,
+                                               .kind = slot.kind,
+                                               .symbol = NO_NODE});
+    }
+  }
+  success = success && !iterator.failed;
+  smith_expression_iterator_destroy(iterator);
+  if (!success) {
+    return false;
+  }
+  value_t result = compiler->values[0];
+  if (!read_value(compiler, &result)) {
+    return false;
+  }
+  compiler->bytecode.result_kind = result.kind;
+  return emit(compiler, (smith_instruction_t){.opcode = SMITH_OPCODE_RETURN,
+                                              .left = result.register_});
+}
+
+smith_bytecode_compile_result_t
+smith_bytecode_compile(smith_allocator_t allocator,
+                       const smith_expression_t *expression,
+                       const smith_bytecode_parameter_t *parameters,
+                       uint32_t parameter_count) {
+  compiler_t compiler = {
+      .bytecode = {.allocator = allocator, .parameter_count = parameter_count},
+      .dag = smith_dag_create(allocator)};
+  // Parameters are interned first, so each one's DAG node is its register.
+  bool success = parameter_count < SMITH_BYTECODE_MAX_REGISTERS;
+  for (uint32_t i = 0; success && i < parameter_count; i++) {
+    smith_dag_intern_result_t intern_result =
+        smith_dag_intern_leaf(&compiler.dag, SMITH_EXPRESSION_KIND_SYMBOL,
+                              (smith_ast_leaf_t){.text = parameters[i].name});
+    success = intern_result.success && intern_result.node == i;
+  }
+  success = success && collect_leaves(&compiler, expression) &&
+            assign_registers(&compiler, parameters, parameter_count);
+  compiler.bytecode.register_count = compiler.temporaries;
+  success = success && compiler.temporaries <= SMITH_BYTECODE_MAX_REGISTERS &&
+            compile_instructions(&compiler, expression);
+  smith_allocator_deallocate(allocator, compiler.values);
+  smith_allocator_deallocate(allocator, compiler.slots);
+  smith_allocator_deallocate(allocator, compiler.leaves);
+  smith_dag_destroy(compiler.dag);
+  if (!success) {
+    smith_bytecode_destroy(compiler.bytecode);
+    return (smith_bytecode_compile_result_t){};
+  }
+  return (smith_bytecode_compile_result_t){.bytecode = compiler.bytecode,
+                                           .success = true};
+}
+
+void smith_bytecode_destroy(smith_bytecode_t bytecode) {
+  smith_allocator_deallocate(bytecode.allocator, bytecode.instructions);
+  smith_allocator_deallocate(bytecode.allocator, bytecode.constants);
+}
@@ -0,0 +1,413 @@
+// For `mkstemps`, which strict C modes hide.
+#define _DEFAULT_SOURCE 1
+
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/c_backend.h"
+#include "smith/file_writer.h"
+#include "smith/format.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// Declarations every emitted file starts with. Int arithmetic uses the
+// overflow builtins where the compiler has them and plain checks elsewhere.
+static const char prelude[] =
+    "#include <inttypes.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <stdint.h>\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "typedef union {\n"
+    "  int64_t int_;\n"
+    "  double float_;\n"
+    "  bool bool_;\n"
+    "} smith_value_t;\n"
+    "\n"
+    "#if defined(__GNUC__)\n"
+    "#define smith_add(a, b, d) __builtin_add_overflow(a, b, d)\n"
+    "#define smith_sub(a, b, d) __builtin_sub_overflow(a, b, d)\n"
+    "#define smith_mul(a, b, d) __builtin_mul_overflow(a, b, d)\n"
+    "#else\n"
+    "static inline bool smith_add(int64_t a, int64_t b, int64_t *d) {\n"
+    "  if (b > 0 ? a > INT64_MAX - b : a < INT64_MIN - b) {\n"
+    "    return true;\n"
+    "  }\n"
+    "  *d = a + b;\n"
+    "  return false;\n"
+    "}\n"
+    "\n"
+    "static inline bool smith_sub(int64_t a, int64_t b, int64_t *d) {\n"
+    "  if (b < 0 ? a > INT64_MAX + b : a < INT64_MIN + b) {\n"
+    "    return true;\n"
+    "  }\n"
+    "  *d = a - b;\n"
+    "  return false;\n"
+    "}\n"
+    "\n"
+    "static inline bool smith_mul(int64_t a, int64_t b, int64_t *d) {\n"
+    "  bool overflow = a > 0 ? (b > 0 ? a > INT64_MAX / b\n"
+    "                                  : b < INT64_MIN / a)\n"
+    "                        : (b > 0 ? a < INT64_MIN / b\n"
+    "                                 : a != 0 && b < INT64_MAX / a);\n"
+    "  if (overflow) {\n"
+    "    return true;\n"
+    "  }\n"
+    "  *d = a * b;\n"
+    "  return false;\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "static inline bool smith_div(int64_t a, int64_t b, int64_t *d) {\n"
+    "  if (b == 0 || (a == INT64_MIN && b == -1)) {\n"
+    "    return true;\n"
+    "  }\n"
+    "  *d = a / b;\n"
+    "  return false;\n"
+    "}\n"
+    "\n"
+    "static inline double smith_float(uint64_t bits) {\n"
+    "  double value;\n"
+    "  memcpy(&value, &bits, sizeof(value));\n"
+    "  return value;\n"
+    "}\n"
+    "\n";
+
+static const char *const c_types[] = {
+    [SMITH_CONSTANT_KIND_INT] = "int64_t",
+    [SMITH_CONSTANT_KIND_FLOAT] = "double",
+    [SMITH_CONSTANT_KIND_BOOL] = "bool",
+};
+
+static const char *const fields[] = {
+    [SMITH_CONSTANT_KIND_INT] = "int_",
+    [SMITH_CONSTANT_KIND_FLOAT] = "float_",
+    [SMITH_CONSTANT_KIND_BOOL] = "bool_",
+};
+
+// The C operator computing each instruction that is a single expression.
+static const char *const operators[] = {
+    [SMITH_IR_OPCODE_ADD] = "+",     [SMITH_IR_OPCODE_SUB] = "-",
+    [SMITH_IR_OPCODE_MUL] = "*",     [SMITH_IR_OPCODE_DIV] = "/",
+    [SMITH_IR_OPCODE_EQ] = "==",     [SMITH_IR_OPCODE_NOT_EQ] = "!=",
+    [SMITH_IR_OPCODE_LT] = "<",      [SMITH_IR_OPCODE_LE] = "<=",
+    [SMITH_IR_OPCODE_GT] = ">",      [SMITH_IR_OPCODE_GE] = ">=",
+    [SMITH_IR_OPCODE_BIT_AND] = "&", [SMITH_IR_OPCODE_BIT_OR] = "|",
+    [SMITH_IR_OPCODE_AND] = "&&",    [SMITH_IR_OPCODE_OR] = "||",
+};
+
+// The helper for each int operator that may trap.
+static const char *const checked[] = {
+    [SMITH_IR_OPCODE_ADD] = "smith_add",
+    [SMITH_IR_OPCODE_SUB] = "smith_sub",
+    [SMITH_IR_OPCODE_MUL] = "smith_mul",
+    [SMITH_IR_OPCODE_DIV] = "smith_div",
+};
+
+// Emits a constant so the C compiler reads back exactly its value: the most
+// negative int has no literal, and floats are written in hex, or as bits if
+// they are not finite.
+static void emit_constant(smith_buffered_writer_t *writer,
+                          const smith_ir_instruction_t *instruction) {
+  smith_constant_value_t constant = instruction->constant;
+  switch (instruction->type) {
+  case SMITH_CONSTANT_KIND_INT:
+    if (constant.int_ == INT64_MIN) {
+      smith_buffered_writer_format(writer, "INT64_MIN");
+    } else {
+      smith_buffered_writer_format(writer, "INT64_C(%" PRId64 ")",
+                                   constant.int_);
+    }
+    break;
+  case SMITH_CONSTANT_KIND_FLOAT:
+    if (isfinite(constant.float_)) {
+      smith_buffered_writer_format(writer, "%a", constant.float_);
+    } else {
+      uint64_t bits;
+      memcpy(&bits, &constant.float_, sizeof(bits));
+      smith_buffered_writer_format(writer, "smith_float(UINT64_C(0x%" PRIx64
+                                           "))",
+                                   bits);
+    }
+    break;
+  case SMITH_CONSTANT_KIND_BOOL:
+    smith_buffered_writer_format(writer, constant.bool_ ? "true" : "false");
+    break;
+  }
+}
+
+static void emit_instruction(smith_buffered_writer_t *writer,
+                             const smith_ir_instruction_t *instruction) {
+  const smith_ir_instruction_t *left = instruction->operands[0];
+  const smith_ir_instruction_t *right = instruction->operands[1];
+  const char *type = c_types[instruction->type];
+  switch (instruction->opcode) {
+  case SMITH_IR_OPCODE_PARAMETER:
+    smith_buffered_writer_format(writer,
+                                 "  const %s v%" PRIu32
+                                 " = arguments[%" PRIu32 "].%s;\n",
+                                 type, instruction->id, instruction->parameter,
+                                 fields[instruction->type]);
+    return;
+  case SMITH_IR_OPCODE_CONSTANT:
+    smith_buffered_writer_format(writer, "  const %s v%" PRIu32 " = ", type,
+                                 instruction->id);
+    emit_constant(writer, instruction);
+    smith_buffered_writer_format(writer, ";\n");
+    return;
+  case SMITH_IR_OPCODE_RETURN:
+    smith_buffered_writer_format(writer,
+                                 "  result->%s = v%" PRIu32 ";\n"
+                                 "  return true;\n",
+                                 fields[instruction->type], left->id);
+    return;
+  default:
+    break;
+  }
+  if (instruction->type == SMITH_CONSTANT_KIND_INT &&
+      instruction->opcode <= SMITH_IR_OPCODE_DIV) {
+    smith_buffered_writer_format(writer,
+                                 "  int64_t v%" PRIu32 ";\n"
+                                 "  if (%s(v%" PRIu32 ", v%" PRIu32
+                                 ", &v%" PRIu32 ")) {\n"
+                                 "    return false;\n"
+                                 "  }\n",
+                                 instruction->id, checked[instruction->opcode],
+                                 left->id, right->id, instruction->id);
+    return;
+  }
+  smith_buffered_writer_format(
+      writer, "  const %s v%" PRIu32 " = v%" PRIu32 " %s v%" PRIu32 ";\n", type,
+      instruction->id, left->id, operators[instruction->opcode], right->id);
+}
+
+// Emits a `main` that parses each argument as its parameter's kind, runs
+// the function and prints the result.
+static void emit_main(smith_buffered_writer_t *writer,
+                      const smith_ir_function_t *function,
+                      const smith_bytecode_parameter_t *parameters,
+                      const char *name, smith_constant_kind_t result_kind) {
+  uint32_t count = function->parameter_count;
+  smith_buffered_writer_format(writer,
+                               "\n"
+                               "int main(int argc, char **argv) {\n"
+                               "  if (argc != %" PRIu32 ") {\n"
+                               "    fprintf(stderr, \"expected %" PRIu32
+                               " arguments\\n\");\n"
+                               "    return 2;\n"
+                               "  }\n"
+                               "  smith_value_t arguments[%" PRIu32 "];\n",
+                               count + 1, count, count > 0 ? count : 1);
+  for (uint32_t i = 0; i < count; i++) {
+    switch (parameters[i].kind) {
+    case SMITH_CONSTANT_KIND_INT:
+      smith_buffered_writer_format(
+          writer,
+          "  arguments[%" PRIu32 "].int_ = strtoll(argv[%" PRIu32
+          "], NULL, 10);\n",
+          i, i + 1);
+      break;
+    case SMITH_CONSTANT_KIND_FLOAT:
+      smith_buffered_writer_format(writer,
+                                   "  arguments[%" PRIu32
+                                   "].float_ = strtod(argv[%" PRIu32
+                                   "], NULL);\n",
+                                   i, i + 1);
+      break;
+    case SMITH_CONSTANT_KIND_BOOL:
+      smith_buffered_writer_format(
+          writer,
+          "  arguments[%" PRIu32 "].bool_ = strcmp(argv[%" PRIu32
+          "], \"true\") == 0;\n",
+          i, i + 1);
+      break;
+    }
+  }
+  static const char *const prints[] = {
+      [SMITH_CONSTANT_KIND_INT] = "printf(\"%\" PRId64 \"\\n\", result.int_)",
+      [SMITH_CONSTANT_KIND_FLOAT] = "printf(\"%.17g\\n\", result.float_)",
+      [SMITH_CONSTANT_KIND_BOOL] =
+          "puts(result.bool_ ? \"true\" : \"false\")",
+  };
+  smith_buffered_writer_format(writer,
+                               "  smith_value_t result;\n"
+                               "  if (!%s(arguments, &result)) {\n"
+                               "    fputs(\"trap\\n\", stderr);\n"
+                               "    return 1;\n"
+                               "  }\n"
+                               "  %s;\n"
+                               "  return 0;\n"
+                               "}\n",
+                               name, prints[result_kind]);
+}
+
+// Names the emitted file declares or the C language takes, which the
+// function cannot have. Names starting with an underscore are reserved too.
+static const char *const reserved_names[] = {
+    "smith_value_t", "smith_add", "smith_sub",    "smith_mul", "smith_div",
+    "smith_float",   "bool",      "true",         "false",     "auto",
+    "break",         "case",      "char",         "const",     "continue",
+    "default",       "do",        "double",       "else",      "enum",
+    "extern",        "float",     "for",          "goto",      "if",
+    "inline",        "int",       "long",         "register",  "restrict",
+    "return",        "short",     "signed",       "sizeof",    "static",
+    "struct",        "switch",    "typedef",      "union",     "unsigned",
+    "void",          "volatile",  "while",
+};
+
+// Names `main` declares, which the function of an executable cannot have.
+static const char *const main_names[] = {"main", "argc", "argv", "arguments",
+                                         "result"};
+
+static bool is_name_in(const char *name, const char *const *names,
+                       size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (strcmp(name, names[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool is_letter(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_valid_name(const char *name, smith_c_output_kind_t kind) {
+  if (!is_letter(name[0])) {
+    return false;
+  }
+  for (const char *c = name; *c != '\0'; c++) {
+    if (!is_letter(*c) && !(*c >= '0' && *c <= '9') && *c != '_') {
+      return false;
+    }
+  }
+  size_t reserved_count = sizeof(reserved_names) / sizeof(reserved_names[0]);
+  size_t main_count = sizeof(main_names) / sizeof(main_names[0]);
+  return !is_name_in(name, reserved_names, reserved_count) &&
+         (kind != SMITH_C_OUTPUT_EXECUTABLE ||
+          !is_name_in(name, main_names, main_count));
+}
+
+bool smith_c_emit(smith_buffered_writer_t *writer,
+                  const smith_ir_function_t *function,
+                  const smith_bytecode_parameter_t *parameters,
+                  const char *name, smith_c_output_kind_t kind) {
+  if (function->block_count != 1 || !is_valid_name(name, kind)) {
+    return false;
+  }
+  smith_buffered_writer_write(writer, prelude, sizeof(prelude) - 1);
+  smith_buffered_writer_format(writer,
+                               "bool %s(const smith_value_t *arguments, "
+                               "smith_value_t *result) {\n",
+                               name);
+  const smith_ir_block_t *block = &function->blocks[0];
+  for (const smith_ir_instruction_t *instruction = block->first;
+       instruction != nullptr; instruction = instruction->next) {
+    emit_instruction(writer, instruction);
+  }
+  smith_buffered_writer_format(writer, "}\n");
+  if (kind == SMITH_C_OUTPUT_EXECUTABLE) {
+    emit_main(writer, function, parameters, name, block->last->type);
+  }
+  return !writer->failed;
+}
+
+// Writes the C source of the function to an open file.
+static bool write_source(smith_allocator_t allocator,
+                         const smith_ir_function_t *function,
+                         const smith_bytecode_parameter_t *parameters,
+                         const char *name, smith_c_output_kind_t kind,
+                         int file_descriptor) {
+  smith_file_writer_create_result_t file_result =
+      smith_file_writer_create(allocator, file_descriptor);
+  if (!file_result.success) {
+    return false;
+  }
+  smith_buffered_writer_create_result_t buffered_result =
+      smith_buffered_writer_create(allocator, file_result.writer, 0);
+  bool success = buffered_result.success &&
+                 smith_c_emit(&buffered_result.writer, function, parameters,
+                              name, kind) &&
+                 smith_buffered_writer_flush(&buffered_result.writer);
+  if (buffered_result.success) {
+    smith_buffered_writer_destroy(buffered_result.writer);
+  }
+  smith_writer_destroy(file_result.writer);
+  return success;
+}
+
+// Runs the compiler on a source file and waits for it. `-std=c99` keeps
+// floating point contraction off, so results round as in the bytecode.
+static bool run_compiler(const char *source_path, smith_c_output_kind_t kind,
+                         const char *output_path) {
+  const char *compiler = getenv("CC");
+  if (compiler == nullptr || compiler[0] == '\0') {
+    compiler = "cc";
+  }
+  char *arguments[10];
+  size_t count = 0;
+  arguments[count++] = (char *)compiler;
+  arguments[count++] = "-std=c99";
+  arguments[count++] = "-O2";
+  if (kind == SMITH_C_OUTPUT_SHARED_OBJECT) {
+    arguments[count++] = "-shared";
+    arguments[count++] = "-fPIC";
+  }
+  arguments[count++] = "-o";
+  arguments[count++] = (char *)output_path;
+  arguments[count++] = (char *)source_path;
+  arguments[count] = nullptr;
+  pid_t pid;
+  if (posix_spawnp(&pid, compiler, nullptr, nullptr, arguments, environ) !=
+      0) {
+    return false;
+  }
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool smith_c_build(smith_allocator_t allocator,
+                   const smith_ir_function_t *function,
+                   const smith_bytecode_parameter_t *parameters,
+                   const char *name, smith_c_output_kind_t kind,
+                   const char *output_path) {
+  if (!is_valid_name(name, kind)) {
+    return false;
+  }
+  const char *directory = getenv("TMPDIR");
+  if (directory == nullptr || directory[0] == '\0') {
+    directory = "/tmp";
+  }
+  char *source_path =
+      smith_format_string(allocator, "%s/smith-XXXXXX.c", directory);
+  if (source_path == nullptr) {
+    return false;
+  }
+  int file_descriptor = mkstemps(source_path, 2);
+  if (file_descriptor < 0) {
+    smith_allocator_deallocate(allocator, source_path);
+    return false;
+  }
+  bool success = write_source(allocator, function, parameters, name, kind,
+                              file_descriptor);
+  success = close(file_descriptor) == 0 && success;
+  success = success && run_compiler(source_path, kind, output_path);
+  unlink(source_path);
+  smith_allocator_deallocate(allocator, source_path);
+  return success;
+}
@@ -0,0 +1,410 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/column.h"
+#include <string.h>
+
+// Bools are held in registers as ints of 0 or 1, so comparisons can write
+// whole SIMD masks and bool operators can share the int kernels.
+typedef bool (*kernel_t)(const smith_constant_value_t *left,
+                         const smith_constant_value_t *right,
+                         smith_constant_value_t *destination, size_t count);
+
+// A kernel may write its destination as it reads its operands: the
+// destination of an update is also its left operand.
+#define CHECKED_KERNEL(name, builtin)                                          \
+  static bool name(const smith_constant_value_t *left,                        \
+                   const smith_constant_value_t *right,                       \
+                   smith_constant_value_t *destination, size_t count) {       \
+    bool overflow = false;                                                     \
+    for (size_t i = 0; i < count; i++) {                                       \
+      /* The operands are read first: the builtins may read them back after */ \
+      /* writing the result, which an update overwrites. */                   \
+      int64_t a = left[i].int_;                                                \
+      int64_t b = right[i].int_;                                               \
+      overflow |= builtin(a, b, &destination[i].int_);                         \
+    }                                                                          \
+    return !overflow;                                                          \
+  }
+
+#define KERNEL(name, result, operand, operator)                                \
+  static bool name(const smith_constant_value_t *left,                        \
+                   const smith_constant_value_t *right,                       \
+                   smith_constant_value_t *destination, size_t count) {       \
+    for (size_t i = 0; i < count; i++) {                                       \
+      destination[i].result = left[i].operand operator right[i].operand;      \
+    }                                                                          \
+    return true;                                                               \
+  }
+
+CHECKED_KERNEL(int_add, __builtin_add_overflow)
+CHECKED_KERNEL(int_sub, __builtin_sub_overflow)
+CHECKED_KERNEL(int_mul, __builtin_mul_overflow)
+KERNEL(int_eq, int_, int_, ==)
+KERNEL(int_not_eq, int_, int_, !=)
+KERNEL(int_lt, int_, int_, <)
+KERNEL(int_le, int_, int_, <=)
+KERNEL(int_gt, int_, int_, >)
+KERNEL(int_ge, int_, int_, >=)
+KERNEL(int_bit_and, int_, int_, &)
+KERNEL(int_bit_or, int_, int_, |)
+KERNEL(float_add, float_, float_, +)
+KERNEL(float_sub, float_, float_, -)
+KERNEL(float_mul, float_, float_, *)
+KERNEL(float_div, float_, float_, /)
+KERNEL(float_eq, int_, float_, ==)
+KERNEL(float_not_eq, int_, float_, !=)
+KERNEL(float_lt, int_, float_, <)
+KERNEL(float_le, int_, float_, <=)
+KERNEL(float_gt, int_, float_, >)
+KERNEL(float_ge, int_, float_, >=)
+
+static bool int_div(const smith_constant_value_t *left,
+                    const smith_constant_value_t *right,
+                    smith_constant_value_t *destination, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (right[i].int_ == 0 ||
+        (left[i].int_ == INT64_MIN && right[i].int_ == -1)) {
+      return false;
+    }
+    destination[i].int_ = left[i].int_ / right[i].int_;
+  }
+  return true;
+}
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+// SSE2 has no 64 bit int comparisons or multiplication, so only the float
+// operators, int addition and subtraction and the bitwise operators get two
+// lane kernels. Each finishes an odd row with its scalar kernel.
+
+#define SSE2_FLOAT_KERNEL(name, scalar, operation)                             \
+  static bool name(const smith_constant_value_t *left,                        \
+                   const smith_constant_value_t *right,                       \
+                   smith_constant_value_t *destination, size_t count) {       \
+    size_t i = 0;                                                              \
+    for (; i + 2 <= count; i += 2) {                                           \
+      __m128d result = operation(_mm_loadu_pd(&left[i].float_),               \
+                                 _mm_loadu_pd(&right[i].float_));             \
+      _mm_storeu_pd(&destination[i].float_, result);                           \
+    }                                                                          \
+    return scalar(left + i, right + i, destination + i, count - i);            \
+  }
+
+// A comparison gives a lane of all ones or all zeros, masked down to 1 or 0.
+#define SSE2_COMPARISON_KERNEL(name, scalar, comparison)                       \
+  static bool name(const smith_constant_value_t *left,                        \
+                   const smith_constant_value_t *right,                       \
+                   smith_constant_value_t *destination, size_t count) {       \
+    __m128i one = _mm_set1_epi64x(1);                                          \
+    size_t i = 0;                                                              \
+    for (; i + 2 <= count; i += 2) {                                           \
+      __m128d mask = comparison(_mm_loadu_pd(&left[i].float_),                \
+                                _mm_loadu_pd(&right[i].float_));              \
+      _mm_storeu_si128((__m128i *)&destination[i],                             \
+                       _mm_and_si128(_mm_castpd_si128(mask), one));            \
+    }                                                                          \
+    return scalar(left + i, right + i, destination + i, count - i);            \
+  }
+
+#define SSE2_INT_KERNEL(name, scalar, operation)                               \
+  static bool name(const smith_constant_value_t *left,                        \
+                   const smith_constant_value_t *right,                       \
+                   smith_constant_value_t *destination, size_t count) {       \
+    size_t i = 0;                                                              \
+    for (; i + 2 <= count; i += 2) {                                           \
+      __m128i result =                                                         \
+          operation(_mm_loadu_si128((const __m128i *)&left[i]),                \
+                    _mm_loadu_si128((const __m128i *)&right[i]));              \
+      _mm_storeu_si128((__m128i *)&destination[i], result);                    \
+    }                                                                          \
+    return scalar(left + i, right + i, destination + i, count - i);            \
+  }
+
+// Addition and subtraction wrap, and a lane overflowed when the sign of its
+// result is wrong for the signs of its operands. The signs are gathered over
+// the block, which traps once at the end.
+#define SSE2_CHECKED_KERNEL(name, scalar, operation, overflow)                 \
+  static bool name(const smith_constant_value_t *left,                        \
+                   const smith_constant_value_t *right,                       \
+                   smith_constant_value_t *destination, size_t count) {       \
+    __m128i overflows = _mm_setzero_si128();                                   \
+    size_t i = 0;                                                              \
+    for (; i + 2 <= count; i += 2) {                                           \
+      __m128i a = _mm_loadu_si128((const __m128i *)&left[i]);                  \
+      __m128i b = _mm_loadu_si128((const __m128i *)&right[i]);                 \
+      __m128i result = operation(a, b);                                        \
+      overflows = _mm_or_si128(overflows, overflow);                           \
+      _mm_storeu_si128((__m128i *)&destination[i], result);                    \
+    }                                                                          \
+    if (_mm_movemask_pd(_mm_castsi128_pd(overflows)) != 0) {                   \
+      return false;                                                            \
+    }                                                                          \
+    return scalar(left + i, right + i, destination + i, count - i);            \
+  }
+
+SSE2_CHECKED_KERNEL(sse2_int_add, int_add, _mm_add_epi64,
+                    _mm_and_si128(_mm_xor_si128(a, result),
+                                  _mm_xor_si128(b, result)))
+SSE2_CHECKED_KERNEL(sse2_int_sub, int_sub, _mm_sub_epi64,
+                    _mm_and_si128(_mm_xor_si128(a, b),
+                                  _mm_xor_si128(a, result)))
+SSE2_INT_KERNEL(sse2_int_bit_and, int_bit_and, _mm_and_si128)
+SSE2_INT_KERNEL(sse2_int_bit_or, int_bit_or, _mm_or_si128)
+SSE2_FLOAT_KERNEL(sse2_float_add, float_add, _mm_add_pd)
+SSE2_FLOAT_KERNEL(sse2_float_sub, float_sub, _mm_sub_pd)
+SSE2_FLOAT_KERNEL(sse2_float_mul, float_mul, _mm_mul_pd)
+SSE2_FLOAT_KERNEL(sse2_float_div, float_div, _mm_div_pd)
+SSE2_COMPARISON_KERNEL(sse2_float_eq, float_eq, _mm_cmpeq_pd)
+SSE2_COMPARISON_KERNEL(sse2_float_not_eq, float_not_eq, _mm_cmpneq_pd)
+SSE2_COMPARISON_KERNEL(sse2_float_lt, float_lt, _mm_cmplt_pd)
+SSE2_COMPARISON_KERNEL(sse2_float_le, float_le, _mm_cmple_pd)
+SSE2_COMPARISON_KERNEL(sse2_float_gt, float_gt, _mm_cmpgt_pd)
+SSE2_COMPARISON_KERNEL(sse2_float_ge, float_ge, _mm_cmpge_pd)
+
+#define VECTOR(kernel) sse2_##kernel
+
+#else
+
+#define VECTOR(kernel) kernel
+
+#endif
+
+static const kernel_t kernels[] = {
+    [SMITH_OPCODE_INT_ADD] = VECTOR(int_add),
+    [SMITH_OPCODE_INT_SUB] = VECTOR(int_sub),
+    [SMITH_OPCODE_INT_MUL] = int_mul,
+    [SMITH_OPCODE_INT_DIV] = int_div,
+    [SMITH_OPCODE_INT_EQ] = int_eq,
+    [SMITH_OPCODE_INT_NOT_EQ] = int_not_eq,
+    [SMITH_OPCODE_INT_LT] = int_lt,
+    [SMITH_OPCODE_INT_LE] = int_le,
+    [SMITH_OPCODE_INT_GT] = int_gt,
+    [SMITH_OPCODE_INT_GE] = int_ge,
+    [SMITH_OPCODE_INT_BIT_AND] = VECTOR(int_bit_and),
+    [SMITH_OPCODE_INT_BIT_OR] = VECTOR(int_bit_or),
+    [SMITH_OPCODE_FLOAT_ADD] = VECTOR(float_add),
+    [SMITH_OPCODE_FLOAT_SUB] = VECTOR(float_sub),
+    [SMITH_OPCODE_FLOAT_MUL] = VECTOR(float_mul),
+    [SMITH_OPCODE_FLOAT_DIV] = VECTOR(float_div),
+    [SMITH_OPCODE_FLOAT_EQ] = VECTOR(float_eq),
+    [SMITH_OPCODE_FLOAT_NOT_EQ] = VECTOR(float_not_eq),
+    [SMITH_OPCODE_FLOAT_LT] = VECTOR(float_lt),
+    [SMITH_OPCODE_FLOAT_LE] = VECTOR(float_le),
+    [SMITH_OPCODE_FLOAT_GT] = VECTOR(float_gt),
+    [SMITH_OPCODE_FLOAT_GE] = VECTOR(float_ge),
+    [SMITH_OPCODE_BOOL_EQ] = int_eq,
+    [SMITH_OPCODE_BOOL_NOT_EQ] = int_not_eq,
+    [SMITH_OPCODE_BOOL_AND] = VECTOR(int_bit_and),
+    [SMITH_OPCODE_BOOL_OR] = VECTOR(int_bit_or),
+};
+
+// Rewrites the bool constants of the bytecode as ints of 0 or 1, as the
+// kernels hold bools. The bytecode does not keep the types of its constants,
+// but every value that is read reaches a bool operator or the return through
+// moves, so walking the instructions backwards finds which registers hold a
+// bool where they are read.
+static bool hold_bools_as_ints(smith_allocator_t allocator,
+                               smith_bytecode_t *bytecode) {
+  size_t capacity = (size_t)bytecode->register_count + 1;
+  bool *read_as_bool =
+      smith_allocator_allocate_array(allocator, bool, capacity);
+  if (read_as_bool == nullptr) {
+    return false;
+  }
+  memset(read_as_bool, 0, capacity * sizeof(bool));
+  for (size_t i = bytecode->count; i-- > 0;) {
+    smith_instruction_t instruction = bytecode->instructions[i];
+    switch (instruction.opcode) {
+    case SMITH_OPCODE_RETURN:
+      read_as_bool[instruction.left] =
+          bytecode->result_kind == SMITH_CONSTANT_KIND_BOOL;
+      break;
+    case SMITH_OPCODE_MOVE: {
+      // Before it is written, a register holds a value of its own.
+      bool moved = read_as_bool[instruction.destination];
+      read_as_bool[instruction.destination] = false;
+      read_as_bool[instruction.left] |= moved;
+      break;
+    }
+    default: {
+      read_as_bool[instruction.destination] = false;
+      bool operands = instruction.opcode == SMITH_OPCODE_BOOL_EQ ||
+                      instruction.opcode == SMITH_OPCODE_BOOL_NOT_EQ ||
+                      instruction.opcode == SMITH_OPCODE_BOOL_AND ||
+                      instruction.opcode == SMITH_OPCODE_BOOL_OR;
+      read_as_bool[instruction.left] |= operands;
+      read_as_bool[instruction.right] |= operands;
+      break;
+    }
+    }
+  }
+  for (uint32_t i = 0; i < bytecode->constant_count; i++) {
+    smith_constant_value_t *constant = &bytecode->constants[i];
+    if (read_as_bool[bytecode->parameter_count + i]) {
+      *constant = (smith_constant_value_t){.int_ = constant->bool_ ? 1 : 0};
+    }
+  }
+  smith_allocator_deallocate(allocator, read_as_bool);
+  return true;
+}
+
+smith_column_compile_result_t
+smith_column_compile(smith_allocator_t allocator,
+                     const smith_expression_t *expression,
+                     const smith_bytecode_parameter_t *parameters,
+                     uint32_t parameter_count) {
+  smith_bytecode_compile_result_t compile_result = smith_bytecode_compile(
+      allocator, expression, parameters, parameter_count);
+  if (!compile_result.success) {
+    return (smith_column_compile_result_t){};
+  }
+  size_t capacity = (size_t)parameter_count + 1;
+  smith_constant_kind_t *parameter_kinds = smith_allocator_allocate_array(
+      allocator, smith_constant_kind_t, capacity);
+  if (parameter_kinds == nullptr ||
+      !hold_bools_as_ints(allocator, &compile_result.bytecode)) {
+    smith_allocator_deallocate(allocator, parameter_kinds);
+    smith_bytecode_destroy(compile_result.bytecode);
+    return (smith_column_compile_result_t){};
+  }
+  for (uint32_t i = 0; i < parameter_count; i++) {
+    parameter_kinds[i] = parameters[i].kind;
+  }
+  return (smith_column_compile_result_t){
+      .program = {.allocator = allocator,
+                  .bytecode = compile_result.bytecode,
+                  .parameter_kinds = parameter_kinds},
+      .success = true};
+}
+
+typedef struct {
+  const smith_bytecode_t *bytecode;
+  const smith_constant_kind_t *parameter_kinds;
+  smith_constant_value_t **registers;
+  // Whether each parameter is evaluated from a copy of its column rather
+  // than the column itself: when it is a bool, held as an int, or is updated.
+  bool *copied;
+} machine_t;
+
+// Points each parameter register at the block of its column, copying it
+// where the column cannot be used in place.
+static void load_block(machine_t *machine, const void *const *columns,
+                       size_t start, size_t count) {
+  for (uint32_t i = 0; i < machine->bytecode->parameter_count; i++) {
+    smith_constant_value_t *block = machine->registers[i];
+    if (!machine->copied[i]) {
+      machine->registers[i] = (smith_constant_value_t *)columns[i] + start;
+    } else if (machine->parameter_kinds[i] == SMITH_CONSTANT_KIND_BOOL) {
+      const bool *column = (const bool *)columns[i] + start;
+      for (size_t j = 0; j < count; j++) {
+        block[j].int_ = column[j];
+      }
+    } else {
+      memcpy(block, (const smith_constant_value_t *)columns[i] + start,
+             count * sizeof(smith_constant_value_t));
+    }
+  }
+}
+
+static void store_block(smith_constant_kind_t kind,
+                        const smith_constant_value_t *block, void *results,
+                        size_t start, size_t count) {
+  if (kind == SMITH_CONSTANT_KIND_BOOL) {
+    bool *column = (bool *)results + start;
+    for (size_t j = 0; j < count; j++) {
+      column[j] = block[j].int_ != 0;
+    }
+  } else {
+    memcpy((smith_constant_value_t *)results + start, block,
+           count * sizeof(smith_constant_value_t));
+  }
+}
+
+static bool run_block(const machine_t *machine, void *results, size_t start,
+                      size_t count) {
+  const smith_bytecode_t *bytecode = machine->bytecode;
+  smith_constant_value_t **registers = machine->registers;
+  for (size_t i = 0; i < bytecode->count; i++) {
+    smith_instruction_t instruction = bytecode->instructions[i];
+    smith_constant_value_t *left = registers[instruction.left];
+    switch (instruction.opcode) {
+    case SMITH_OPCODE_MOVE:
+      memmove(registers[instruction.destination], left,
+              count * sizeof(smith_constant_value_t));
+      break;
+    case SMITH_OPCODE_RETURN:
+      store_block(bytecode->result_kind, left, results, start, count);
+      return true;
+    default:
+      if (!kernels[instruction.opcode](left, registers[instruction.right],
+                                       registers[instruction.destination],
+                                       count)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool smith_column_run(const smith_column_program_t *program,
+                      const void *const *columns, size_t row_count,
+                      void *results) {
+  const smith_bytecode_t *bytecode = &program->bytecode;
+  smith_allocator_t allocator = program->allocator;
+  uint32_t register_count = bytecode->register_count;
+  uint32_t parameter_count = bytecode->parameter_count;
+  size_t block_count = register_count * (size_t)SMITH_COLUMN_BLOCK_SIZE;
+  smith_constant_value_t **registers = smith_allocator_allocate_array(
+      allocator, smith_constant_value_t *, register_count);
+  smith_constant_value_t *blocks = smith_allocator_allocate_array(
+      allocator, smith_constant_value_t, block_count);
+  size_t parameter_capacity = parameter_count + 1;
+  bool *copied =
+      smith_allocator_allocate_array(allocator, bool, parameter_capacity);
+  bool success = registers != nullptr && blocks != nullptr && copied != nullptr;
+  if (success) {
+    for (uint32_t i = 0; i < register_count; i++) {
+      registers[i] = blocks + (size_t)i * SMITH_COLUMN_BLOCK_SIZE;
+    }
+    for (uint32_t i = 0; i < parameter_count; i++) {
+      copied[i] = program->parameter_kinds[i] == SMITH_CONSTANT_KIND_BOOL;
+    }
+    for (size_t i = 0; i < bytecode->count; i++) {
+      smith_instruction_t instruction = bytecode->instructions[i];
+      if (instruction.opcode != SMITH_OPCODE_RETURN &&
+          instruction.destination < parameter_count) {
+        copied[instruction.destination] = true;
+      }
+    }
+    // Constants fill their blocks once for every block of rows.
+    for (uint32_t i = 0; i < bytecode->constant_count; i++) {
+      smith_constant_value_t *block = registers[parameter_count + i];
+      for (size_t j = 0; j < SMITH_COLUMN_BLOCK_SIZE; j++) {
+        block[j] = bytecode->constants[i];
+      }
+    }
+  }
+  machine_t machine = {.bytecode = bytecode,
+                       .parameter_kinds = program->parameter_kinds,
+                       .registers = registers,
+                       .copied = copied};
+  for (size_t start = 0; success && start < row_count;
+       start += SMITH_COLUMN_BLOCK_SIZE) {
+    size_t count = row_count - start < SMITH_COLUMN_BLOCK_SIZE
+                       ? row_count - start
+                       : SMITH_COLUMN_BLOCK_SIZE;
+    load_block(&machine, columns, start, count);
+    success = run_block(&machine, results, start, count);
+  }
+  smith_allocator_deallocate(allocator, copied);
+  smith_allocator_deallocate(allocator, blocks);
+  smith_allocator_deallocate(allocator, registers);
+  return success;
+}
+
+void smith_column_program_destroy(smith_column_program_t program) {
+  smith_allocator_deallocate(program.allocator, program.parameter_kinds);
+  smith_bytecode_destroy(program.bytecode);
+}
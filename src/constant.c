@@ -0,0 +1,166 @@
+#include "smith/constant.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Long enough for any float literal that still has meaningful digits.
+#define FLOAT_LITERAL_MAX_LENGTH 63
+
+static smith_constant_result_t from_int(smith_string_t text) {
+  int64_t value = 0;
+  for (size_t i = 0; i < text.length; i++) {
+    if (__builtin_mul_overflow(value, 10, &value) ||
+        __builtin_add_overflow(value, text.data[i] - '0', &value)) {
+      return (smith_constant_result_t){};
+    }
+  }
+  return (smith_constant_result_t){
+      .constant = {.kind = SMITH_CONSTANT_KIND_INT, .value.int_ = value},
+      .success = true};
+}
+
+// The literal is copied out first: in the source it may be followed by text
+// `strtod` would also accept, such as an `e3` that lexes as a symbol.
+static smith_constant_result_t from_float(smith_string_t text) {
+  if (text.length > FLOAT_LITERAL_MAX_LENGTH) {
+    return (smith_constant_result_t){};
+  }
+  char buffer[FLOAT_LITERAL_MAX_LENGTH + 1];
+  memcpy(buffer, text.data, text.length);
+  buffer[text.length] = '\0';
+  char *end;
+  double value = strtod(buffer, &end);
+  if (text.length == 0 || end != buffer + text.length) {
+    return (smith_constant_result_t){};
+  }
+  return (smith_constant_result_t){
+      .constant = {.kind = SMITH_CONSTANT_KIND_FLOAT, .value.float_ = value},
+      .success = true};
+}
+
+smith_constant_result_t smith_constant_from_literal(smith_expression_kind_t kind,
+                                                    smith_string_t text) {
+  switch (kind) {
+  case SMITH_EXPRESSION_KIND_INT:
+    return from_int(text);
+  case SMITH_EXPRESSION_KIND_FLOAT:
+    return from_float(text);
+  default:
+    return (smith_constant_result_t){};
+  }
+}
+
+static smith_constant_result_t int_result(int64_t value) {
+  return (smith_constant_result_t){
+      .constant = {.kind = SMITH_CONSTANT_KIND_INT, .value.int_ = value},
+      .success = true};
+}
+
+static smith_constant_result_t float_result(double value) {
+  return (smith_constant_result_t){
+      .constant = {.kind = SMITH_CONSTANT_KIND_FLOAT, .value.float_ = value},
+      .success = true};
+}
+
+static smith_constant_result_t bool_result(bool value) {
+  return (smith_constant_result_t){
+      .constant = {.kind = SMITH_CONSTANT_KIND_BOOL, .value.bool_ = value},
+      .success = true};
+}
+
+static smith_constant_result_t fold_int(smith_binary_operator_kind_t kind,
+                                        int64_t left, int64_t right) {
+  int64_t value;
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_ADD:
+    if (__builtin_add_overflow(left, right, &value)) {
+      return (smith_constant_result_t){};
+    }
+    return int_result(value);
+  case SMITH_BINARY_OPERATOR_KIND_SUB:
+    if (__builtin_sub_overflow(left, right, &value)) {
+      return (smith_constant_result_t){};
+    }
+    return int_result(value);
+  case SMITH_BINARY_OPERATOR_KIND_MUL:
+    if (__builtin_mul_overflow(left, right, &value)) {
+      return (smith_constant_result_t){};
+    }
+    return int_result(value);
+  case SMITH_BINARY_OPERATOR_KIND_DIV:
+    if (right == 0 || (left == INT64_MIN && right == -1)) {
+      return (smith_constant_result_t){};
+    }
+    return int_result(left / right);
+  case SMITH_BINARY_OPERATOR_KIND_EQ:
+    return bool_result(left == right);
+  case SMITH_BINARY_OPERATOR_KIND_NOT_EQ:
+    return bool_result(left != right);
+  case SMITH_BINARY_OPERATOR_KIND_LT:
+    return bool_result(left < right);
+  case SMITH_BINARY_OPERATOR_KIND_LE:
+    return bool_result(left <= right);
+  case SMITH_BINARY_OPERATOR_KIND_GT:
+    return bool_result(left > right);
+  case SMITH_BINARY_OPERATOR_KIND_GE:
+    return bool_result(left >= right);
+  default:
+    return (smith_constant_result_t){};
+  }
+}
+
+static smith_constant_result_t fold_float(smith_binary_operator_kind_t kind,
+                                          double left, double right) {
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_ADD:
+    return float_result(left + right);
+  case SMITH_BINARY_OPERATOR_KIND_SUB:
+    return float_result(left - right);
+  case SMITH_BINARY_OPERATOR_KIND_MUL:
+    return float_result(left * right);
+  case SMITH_BINARY_OPERATOR_KIND_DIV:
+    return float_result(left / right);
+  case SMITH_BINARY_OPERATOR_KIND_EQ:
+    return bool_result(left == right);
+  case SMITH_BINARY_OPERATOR_KIND_NOT_EQ:
+    return bool_result(left != right);
+  case SMITH_BINARY_OPERATOR_KIND_LT:
+    return bool_result(left < right);
+  case SMITH_BINARY_OPERATOR_KIND_LE:
+    return bool_result(left <= right);
+  case SMITH_BINARY_OPERATOR_KIND_GT:
+    return bool_result(left > right);
+  case SMITH_BINARY_OPERATOR_KIND_GE:
+    return bool_result(left >= right);
+  default:
+    return (smith_constant_result_t){};
+  }
+}
+
+static smith_constant_result_t fold_bool(smith_binary_operator_kind_t kind,
+                                         bool left, bool right) {
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_EQ:
+    return bool_result(left == right);
+  case SMITH_BINARY_OPERATOR_KIND_NOT_EQ:
+    return bool_result(left != right);
+  default:
+    return (smith_constant_result_t){};
+  }
+}
+
+smith_constant_result_t smith_constant_fold(smith_binary_operator_kind_t kind,
+                                            smith_constant_t left,
+                                            smith_constant_t right) {
+  if (left.kind != right.kind) {
+    return (smith_constant_result_t){};
+  }
+  switch (left.kind) {
+  case SMITH_CONSTANT_KIND_INT:
+    return fold_int(kind, left.value.int_, right.value.int_);
+  case SMITH_CONSTANT_KIND_FLOAT:
+    return fold_float(kind, left.value.float_, right.value.float_);
+  case SMITH_CONSTANT_KIND_BOOL:
+    return fold_bool(kind, left.value.bool_, right.value.bool_);
+  }
+  return (smith_constant_result_t){};
+}
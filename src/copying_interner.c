@@ -0,0 +1,100 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/copying_interner.h"
+#include <assert.h>
+#include <string.h>
+
+typedef struct block_t block_t;
+
+struct block_t {
+  block_t *previous;
+  size_t used;
+  size_t capacity;
+  char data[];
+};
+
+typedef struct {
+  smith_allocator_t allocator;
+  smith_interner_t parent;
+  block_t *block;
+} copying_interner_t;
+
+static size_t max(size_t a, size_t b) { return a > b ? a : b; }
+
+static char *reserve(copying_interner_t *interner, size_t length) {
+  block_t *block = interner->block;
+  if (block != nullptr && block->capacity - block->used >= length) {
+    return block->data + block->used;
+  }
+  size_t capacity = max(length, SMITH_COPYING_INTERNER_BLOCK_SIZE);
+  block_t *new_block = interner->allocator.allocate(
+      interner->allocator.state, sizeof(block_t) + capacity, alignof(block_t));
+  if (new_block == nullptr) {
+    return nullptr;
+  }
+  *new_block = (block_t){.previous = block, .capacity = capacity};
+  interner->block = new_block;
+  return new_block->data;
+}
+
+static smith_intern_result_t intern(void *interner, smith_string_t string) {
+  assert(interner != nullptr);
+  copying_interner_t *copying_interner = interner;
+  char *data = reserve(copying_interner, string.length);
+  if (data == nullptr) {
+    return (smith_intern_result_t){};
+  }
+  memcpy(data, string.data, string.length);
+  smith_string_t copy = {.data = data, .length = string.length};
+  smith_intern_result_t intern_result =
+      smith_interner_intern(copying_interner->parent, copy);
+  if (!intern_result.success) {
+    return intern_result;
+  }
+  smith_lookup_result_t lookup_result =
+      smith_interner_lookup(copying_interner->parent, intern_result.interned);
+  if (lookup_result.success && lookup_result.string.data == data) {
+    // The copy was kept by the parent, so it must survive.
+    copying_interner->block->used += string.length;
+  }
+  return intern_result;
+}
+
+static smith_lookup_result_t lookup(const void *interner,
+                                    smith_interned_t interned) {
+  assert(interner != nullptr);
+  const copying_interner_t *copying_interner = interner;
+  return smith_interner_lookup(copying_interner->parent, interned);
+}
+
+static void destroy(void *interner) {
+  assert(interner != nullptr);
+  copying_interner_t *copying_interner = interner;
+  smith_allocator_t allocator = copying_interner->allocator;
+  smith_interner_destroy(copying_interner->parent);
+  block_t *block = copying_interner->block;
+  while (block != nullptr) {
+    block_t *previous = block->previous;
+    smith_allocator_deallocate(allocator, block);
+    block = previous;
+  }
+  smith_allocator_deallocate(allocator, copying_interner);
+}
+
+smith_copying_interner_create_result_t
+smith_copying_interner_create(smith_allocator_t allocator,
+                              smith_interner_t parent) {
+  copying_interner_t *copying_interner =
+      smith_allocator_allocate(allocator, copying_interner_t);
+  if (copying_interner == nullptr) {
+    return (smith_copying_interner_create_result_t){};
+  }
+  *copying_interner =
+      (copying_interner_t){.allocator = allocator, .parent = parent};
+  return (smith_copying_interner_create_result_t){
+      .interner = {.intern = intern,
+                   .lookup = lookup,
+                   .destroy = destroy,
+                   .state = copying_interner},
+      .success = true};
+}
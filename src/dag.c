@@ -0,0 +1,351 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/dag.h"
+#include "smith/walk.h"
+#include <string.h>
+
+smith_dag_t smith_dag_create(smith_allocator_t allocator) {
+  return (smith_dag_t){.allocator = allocator};
+}
+
+static uint64_t hash_leaf(smith_expression_kind_t kind, smith_string_t text) {
+  uint64_t hash = kind;
+  for (size_t i = 0; i < text.length; i++) {
+    hash = hash * 31 + text.data[i];
+  }
+  return smith_hash_mix(hash, text.length);
+}
+
+static uint64_t hash_binary_operator(smith_binary_operator_kind_t kind,
+                                     smith_ast_children_t children) {
+  uint64_t hash = smith_hash_mix(SMITH_EXPRESSION_KIND_BINARY_OPERATOR, kind);
+  return smith_hash_mix(smith_hash_mix(hash, children.left), children.right);
+}
+
+static uint64_t hash_constant(smith_constant_t constant) {
+  uint64_t bits = 0;
+  switch (constant.kind) {
+  case SMITH_CONSTANT_KIND_INT:
+    bits = (uint64_t)constant.value.int_;
+    break;
+  case SMITH_CONSTANT_KIND_FLOAT:
+    memcpy(&bits, &constant.value.float_, sizeof(bits));
+    break;
+  case SMITH_CONSTANT_KIND_BOOL:
+    bits = constant.value.bool_;
+    break;
+  }
+  return smith_hash_mix(
+      smith_hash_mix(SMITH_EXPRESSION_KIND_CONSTANT, constant.kind), bits);
+}
+
+static size_t block_size(uint32_t capacity) {
+  return capacity * (sizeof(smith_ast_payload_t) + sizeof(uint64_t) +
+                     sizeof(smith_ast_children_t) + sizeof(uint8_t));
+}
+
+static bool grow_if_needed(smith_dag_t *dag) {
+  if (dag->count < dag->capacity) {
+    return true;
+  }
+  if (dag->capacity > UINT32_MAX / 4) {
+    return false;
+  }
+  uint32_t capacity =
+      dag->capacity == 0 ? SMITH_DAG_MIN_CAPACITY : dag->capacity * 2;
+  smith_allocator_t allocator = dag->allocator;
+  char *block = allocator.allocate(allocator.state, block_size(capacity),
+                                   alignof(smith_ast_payload_t));
+  if (block == nullptr) {
+    return false;
+  }
+  if (!smith_hash_index_resize(allocator, &dag->index, capacity, dag->hashes,
+                               dag->count)) {
+    smith_allocator_deallocate(allocator, block);
+    return false;
+  }
+  smith_ast_payload_t *payloads = (smith_ast_payload_t *)block;
+  uint64_t *hashes = (uint64_t *)(payloads + capacity);
+  smith_ast_children_t *children = (smith_ast_children_t *)(hashes + capacity);
+  uint8_t *kinds = (uint8_t *)(children + capacity);
+  if (dag->count > 0) {
+    memcpy(payloads, dag->payloads, dag->count * sizeof(smith_ast_payload_t));
+    memcpy(hashes, dag->hashes, dag->count * sizeof(uint64_t));
+    memcpy(children, dag->children, dag->count * sizeof(smith_ast_children_t));
+    memcpy(kinds, dag->kinds, dag->count * sizeof(uint8_t));
+  }
+  smith_allocator_deallocate(allocator, dag->payloads);
+  dag->payloads = payloads;
+  dag->hashes = hashes;
+  dag->children = children;
+  dag->kinds = kinds;
+  dag->capacity = capacity;
+  return true;
+}
+
+// What a node is looked up by, along with the DAG, for the equality
+// callbacks of the hash index.
+typedef struct {
+  const smith_dag_t *dag;
+  uint8_t kind;
+  smith_ast_children_t children;
+  smith_ast_payload_t payload;
+} dag_key_t;
+
+static bool leaf_equal(const void *state, uint32_t node) {
+  const dag_key_t *key = state;
+  smith_string_t text = key->dag->payloads[node].leaf.text;
+  smith_string_t expected = key->payload.leaf.text;
+  return key->dag->kinds[node] == key->kind &&
+         text.length == expected.length &&
+         memcmp(text.data, expected.data, text.length) == 0;
+}
+
+static bool binary_operator_equal(const void *state, uint32_t node) {
+  const dag_key_t *key = state;
+  const smith_dag_t *dag = key->dag;
+  return dag->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR &&
+         dag->payloads[node].binary_operator.kind ==
+             key->payload.binary_operator.kind &&
+         dag->children[node].left == key->children.left &&
+         dag->children[node].right == key->children.right;
+}
+
+// Floats are compared bit for bit, so 0.0 and -0.0 stay apart and a NaN is
+// shared with an identical NaN.
+static bool constant_equal(const void *state, uint32_t node) {
+  const dag_key_t *key = state;
+  const smith_dag_t *dag = key->dag;
+  smith_constant_t constant = key->payload.constant;
+  if (dag->kinds[node] != SMITH_EXPRESSION_KIND_CONSTANT ||
+      dag->payloads[node].constant.kind != constant.kind) {
+    return false;
+  }
+  smith_constant_value_t value = dag->payloads[node].constant.value;
+  switch (constant.kind) {
+  case SMITH_CONSTANT_KIND_INT:
+    return value.int_ == constant.value.int_;
+  case SMITH_CONSTANT_KIND_FLOAT:
+    return memcmp(&value.float_, &constant.value.float_, sizeof(double)) == 0;
+  case SMITH_CONSTANT_KIND_BOOL:
+    return value.bool_ == constant.value.bool_;
+  }
+  return false;
+}
+
+// Finds the node equal to the key, or adds it.
+static smith_dag_intern_result_t intern(smith_dag_t *dag, dag_key_t key,
+                                        uint64_t hash,
+                                        smith_hash_index_equal_t equal) {
+  // Growing first keeps the slot found below valid for the insertion.
+  if (!grow_if_needed(dag)) {
+    return (smith_dag_intern_result_t){};
+  }
+  uint32_t slot =
+      smith_hash_index_find(&dag->index, dag->hashes, hash, equal, &key);
+  if (dag->index.slots[slot] != 0) {
+    return (smith_dag_intern_result_t){.node = dag->index.slots[slot] - 1,
+                                       .success = true};
+  }
+  smith_dag_node_t node = dag->count;
+  dag->kinds[node] = key.kind;
+  dag->children[node] = key.children;
+  dag->payloads[node] = key.payload;
+  dag->hashes[node] = hash;
+  dag->index.slots[slot] = node + 1;
+  dag->count++;
+  return (smith_dag_intern_result_t){.node = node, .success = true};
+}
+
+smith_dag_intern_result_t smith_dag_intern_leaf(smith_dag_t *dag,
+                                                smith_expression_kind_t kind,
+                                                smith_ast_leaf_t leaf) {
+  dag_key_t key = {.dag = dag, .kind = kind, .payload = {.leaf = leaf}};
+  return intern(dag, key, hash_leaf(kind, leaf.text), leaf_equal);
+}
+
+smith_dag_intern_result_t
+smith_dag_intern_binary_operator(smith_dag_t *dag,
+                                 smith_binary_operator_info_t info,
+                                 smith_ast_children_t children) {
+  dag_key_t key = {.dag = dag,
+                   .kind = SMITH_EXPRESSION_KIND_BINARY_OPERATOR,
+                   .children = children,
+                   .payload = {.binary_operator = info}};
+  return intern(dag, key, hash_binary_operator(info.kind, children),
+                binary_operator_equal);
+}
+
+smith_dag_intern_result_t smith_dag_intern_constant(smith_dag_t *dag,
+                                                    smith_constant_t constant) {
+  dag_key_t key = {.dag = dag,
+                   .kind = SMITH_EXPRESSION_KIND_CONSTANT,
+                   .payload = {.constant = constant}};
+  return intern(dag, key, hash_constant(constant), constant_equal);
+}
+
+// Children precede their parents in the flat AST, so one pass over the
+// subtree in node order finds the DAG node of every operand before the
+// operator that holds it.
+smith_dag_intern_result_t smith_dag_intern_ast(smith_dag_t *dag,
+                                               const smith_ast_t *ast,
+                                               smith_ast_node_t root) {
+  smith_ast_node_t first = smith_ast_first(ast, root);
+  size_t count = root - first + 1;
+  smith_dag_node_t *nodes =
+      smith_allocator_allocate_array(dag->allocator, smith_dag_node_t, count);
+  if (nodes == nullptr) {
+    return (smith_dag_intern_result_t){};
+  }
+  smith_dag_intern_result_t intern_result = {};
+  for (smith_ast_node_t node = first; node <= root; node++) {
+    switch (ast->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_BINARY_OPERATOR: {
+      smith_ast_children_t children = ast->children[node];
+      intern_result = smith_dag_intern_binary_operator(
+          dag, ast->payloads[node].binary_operator,
+          (smith_ast_children_t){.left = nodes[children.left - first],
+                                 .right = nodes[children.right - first]});
+      break;
+    }
+    case SMITH_EXPRESSION_KIND_CONSTANT:
+      intern_result =
+          smith_dag_intern_constant(dag, ast->payloads[node].constant);
+      break;
+    default:
+      intern_result = smith_dag_intern_leaf(dag, ast->kinds[node],
+                                            ast->payloads[node].leaf);
+      break;
+    }
+    if (!intern_result.success) {
+      break;
+    }
+    nodes[node - first] = intern_result.node;
+  }
+  smith_allocator_deallocate(dag->allocator, nodes);
+  return intern_result;
+}
+
+bool smith_dag_number_symbols(smith_dag_t *dag, const smith_ast_t *ast,
+                              smith_ast_node_t root, const void *parameters,
+                              uint32_t parameter_count,
+                              smith_dag_parameter_name_t name,
+                              smith_dag_node_t *symbols) {
+  for (uint32_t i = 0; i < parameter_count; i++) {
+    smith_ast_leaf_t leaf = {.text = name(parameters, i)};
+    smith_dag_intern_result_t intern_result =
+        smith_dag_intern_leaf(dag, SMITH_EXPRESSION_KIND_SYMBOL, leaf);
+    if (!intern_result.success || intern_result.node != i) {
+      return false;
+    }
+  }
+  smith_ast_node_t first = smith_ast_first(ast, root);
+  for (smith_ast_node_t node = first; node <= root; node++) {
+    smith_dag_node_t *symbol = &symbols[node - first];
+    *symbol = SMITH_DAG_NO_NODE;
+    if (ast->kinds[node] != SMITH_EXPRESSION_KIND_SYMBOL) {
+      continue;
+    }
+    smith_dag_intern_result_t intern_result = smith_dag_intern_leaf(
+        dag, SMITH_EXPRESSION_KIND_SYMBOL, ast->payloads[node].leaf);
+    if (!intern_result.success) {
+      return false;
+    }
+    *symbol = intern_result.node;
+  }
+  return true;
+}
+
+static smith_ast_leaf_t leaf_of(smith_expression_t expression) {
+  switch (expression.kind) {
+  case SMITH_EXPRESSION_KIND_SYMBOL:
+    return (smith_ast_leaf_t){.text = expression.value.symbol.text,
+                              .interned = expression.value.symbol.interned};
+  case SMITH_EXPRESSION_KIND_INT:
+    return (smith_ast_leaf_t){.text = expression.value.int_.text,
+                              .interned = expression.value.int_.interned};
+  default:
+    return (smith_ast_leaf_t){.text = expression.value.float_.text,
+                              .interned = expression.value.float_.interned};
+  }
+}
+
+#define NODE_STACK_INLINE_CAPACITY 32
+
+// The nodes interned for operands whose operator has yet to be visited.
+typedef struct {
+  smith_dag_node_t *nodes;
+  size_t count;
+  size_t capacity;
+  smith_dag_node_t inline_nodes[NODE_STACK_INLINE_CAPACITY];
+} node_stack_t;
+
+static bool node_stack_reserve(smith_allocator_t allocator, node_stack_t *stack,
+                               size_t capacity) {
+  if (capacity <= stack->capacity) {
+    return true;
+  }
+  size_t new_capacity = stack->capacity * 2;
+  smith_dag_node_t *nodes =
+      smith_allocator_allocate_array(allocator, smith_dag_node_t, new_capacity);
+  if (nodes == nullptr) {
+    return false;
+  }
+  memcpy(nodes, stack->nodes, stack->count * sizeof(smith_dag_node_t));
+  if (stack->nodes != stack->inline_nodes) {
+    smith_allocator_deallocate(allocator, stack->nodes);
+  }
+  stack->nodes = nodes;
+  stack->capacity = new_capacity;
+  return true;
+}
+
+smith_dag_intern_result_t
+smith_dag_intern_expression(smith_dag_t *dag, smith_expression_t expression) {
+  // Operands come before their operator in post-order, so both of its nodes
+  // are on top of the node stack when an operator is visited.
+  smith_expression_iterator_t iterator = smith_expression_iterator_create(
+      dag->allocator, &expression, SMITH_WALK_ORDER_POST);
+  node_stack_t stack = {.capacity = NODE_STACK_INLINE_CAPACITY};
+  stack.nodes = stack.inline_nodes;
+  smith_dag_intern_result_t intern_result = {.success = true};
+  const smith_expression_t *current;
+  while (intern_result.success &&
+         (current = smith_expression_iterator_next(&iterator)) != nullptr) {
+    if (!node_stack_reserve(dag->allocator, &stack, stack.count + 1)) {
+      intern_result = (smith_dag_intern_result_t){};
+      break;
+    }
+    switch (current->kind) {
+    case SMITH_EXPRESSION_KIND_CONSTANT:
+      intern_result =
+          smith_dag_intern_constant(dag, current->value.constant.constant);
+      break;
+    case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
+      stack.count -= 2;
+      intern_result = smith_dag_intern_binary_operator(
+          dag, current->value.binary_operator.info,
+          (smith_ast_children_t){.left = stack.nodes[stack.count],
+                                 .right = stack.nodes[stack.count + 1]});
+      break;
+    default:
+      intern_result =
+          smith_dag_intern_leaf(dag, current->kind, leaf_of(*current));
+      break;
+    }
+    stack.nodes[stack.count++] = intern_result.node;
+  }
+  if (iterator.failed) {
+    intern_result = (smith_dag_intern_result_t){};
+  }
+  smith_expression_iterator_destroy(iterator);
+  if (stack.nodes != stack.inline_nodes) {
+    smith_allocator_deallocate(dag->allocator, stack.nodes);
+  }
+  return intern_result;
+}
+
+void smith_dag_destroy(smith_dag_t dag) {
+  smith_allocator_deallocate(dag.allocator, dag.payloads);
+  smith_hash_index_destroy(dag.allocator, dag.index);
+}
@@ -0,0 +1,162 @@
+#include "smith/dfa_tokenizer.h"
+#include "smith/unicode.h"
+#include <stdint.h>
+#include <string.h>
+
+#include "keyword_hash.inc"
+
+static inline smith_span_t span_of(smith_cursor_t cursor, size_t length) {
+  return (smith_span_t){.start = cursor.position,
+                        .end = {.line = cursor.position.line,
+                                .column = cursor.position.column + length}};
+}
+
+static inline smith_cursor_t advance(smith_cursor_t cursor, size_t length) {
+  return (smith_cursor_t){
+      .source = cursor.source + length,
+      .position = {.line = cursor.position.line,
+                   .column = cursor.position.column + length}};
+}
+
+// Every accepting path returns a compound literal so the token is built
+// directly in the caller's result rather than copied out of a local.
+
+// A slash star is only left in front of the lexer when the block comment it
+// opens is never closed. The check folds away for every operator but `/`.
+#define SMITH_DFA_ACCEPT_OPERATOR(kind_)                                       \
+  if (SMITH_OPERATOR_KIND_##kind_ == SMITH_OPERATOR_KIND_DIV &&               \
+      source[1] == '*') {                                                      \
+    return smith_tokenize_unterminated_comment(cursor);                        \
+  }                                                                            \
+  return (smith_next_token_result_t) {                                         \
+    .token = {.kind = SMITH_TOKEN_KIND_OPERATOR,                               \
+              .value.operator_ = {.kind = SMITH_OPERATOR_KIND_##kind_,         \
+                                  .span = span_of(cursor, length)}},           \
+    .cursor = advance(cursor, length),                                         \
+  }
+
+#define SMITH_DFA_ACCEPT_DELIMITER(kind_)                                      \
+  return (smith_next_token_result_t) {                                         \
+    .token = {.kind = SMITH_TOKEN_KIND_DELIMITER,                              \
+              .value.delimiter = {.kind = SMITH_DELIMITER_KIND_##kind_,        \
+                                  .span = span_of(cursor, length)}},           \
+    .cursor = advance(cursor, length),                                         \
+  }
+
+#define SMITH_DFA_ACCEPT_LITERAL(kind_)                                        \
+  do {                                                                         \
+    literal_kind = SMITH_TOKEN_KIND_##kind_;                                   \
+    goto accept_literal;                                                       \
+  } while (0)
+
+#define SMITH_DFA_ACCEPT_SYMBOL() SMITH_DFA_ACCEPT_LITERAL(SYMBOL)
+#define SMITH_DFA_ACCEPT_INT() SMITH_DFA_ACCEPT_LITERAL(INT)
+#define SMITH_DFA_ACCEPT_FLOAT() SMITH_DFA_ACCEPT_LITERAL(FLOAT)
+#define SMITH_DFA_REJECT() goto reject
+
+smith_next_token_result_t smith_dfa_next_token(smith_interner_t interner,
+                                               smith_cursor_t cursor) {
+  cursor = smith_trim_whitespace(cursor);
+  char *source = cursor.source;
+  size_t length = 0;
+  smith_token_kind_t literal_kind;
+  smith_string_t string;
+  smith_span_t span;
+  smith_keyword_lookup_result_t keyword_lookup_result;
+  smith_intern_result_t intern_result;
+  smith_interned_t interned = 0;
+
+#include "dfa_lexer.inc"
+
+accept_literal:
+  // The generated DFA only knows ASCII. A symbol running into a non-ASCII byte
+  // may continue with XID_Continue code points.
+  if (literal_kind == SMITH_TOKEN_KIND_SYMBOL &&
+      (uint8_t)source[length] >= 0x80) {
+    length = smith_skip_identifier(source + length) - source;
+  }
+  string = (smith_string_t){.data = source, .length = length};
+  span = span_of(cursor, length);
+  if (literal_kind == SMITH_TOKEN_KIND_SYMBOL) {
+    keyword_lookup_result = keyword_lookup(string);
+    if (keyword_lookup_result.success) {
+      return (smith_next_token_result_t){
+          .token = {.kind = SMITH_TOKEN_KIND_KEYWORD,
+                    .value.keyword = {.kind = keyword_lookup_result.kind,
+                                      .span = span}},
+          .cursor = advance(cursor, length),
+      };
+    }
+  }
+  if (!smith_interner_is_null(interner)) {
+    intern_result = smith_interner_intern(interner, string);
+    if (!intern_result.success) {
+      return (smith_next_token_result_t){
+          .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                    .value.error = {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
+                                    .value.interning_failed = {.string =
+                                                                   string,
+                                                               .span = span}}},
+          .cursor = advance(cursor, length),
+      };
+    }
+    interned = intern_result.interned;
+  }
+  switch (literal_kind) {
+  case SMITH_TOKEN_KIND_INT:
+    return (smith_next_token_result_t){
+        .token = {.kind = SMITH_TOKEN_KIND_INT,
+                  .value.int_ = {.interned = interned,
+                                 .text = string,
+                                 .span = span}},
+        .cursor = advance(cursor, length),
+    };
+  case SMITH_TOKEN_KIND_FLOAT:
+    return (smith_next_token_result_t){
+        .token = {.kind = SMITH_TOKEN_KIND_FLOAT,
+                  .value.float_ = {.interned = interned,
+                                   .text = string,
+                                   .span = span}},
+        .cursor = advance(cursor, length),
+    };
+  default:
+    return (smith_next_token_result_t){
+        .token = {.kind = SMITH_TOKEN_KIND_SYMBOL,
+                  .value.symbol = {.interned = interned,
+                                   .text = string,
+                                   .span = span}},
+        .cursor = advance(cursor, length),
+    };
+  }
+
+reject:
+  if (source[0] == '"') {
+    return smith_tokenize_string(cursor);
+  }
+  if ((uint8_t)source[0] >= 0x80) {
+    return smith_tokenize_non_ascii(interner, cursor);
+  }
+  if (source[0] == '\0') {
+    return (smith_next_token_result_t){
+        .token = {.kind = SMITH_TOKEN_KIND_END_OF_FILE,
+                  .value.end_of_file = {.span = span_of(cursor, 0)}},
+        .cursor = cursor,
+    };
+  }
+  return (smith_next_token_result_t){
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_UNEXPECTED_CHARACTER,
+                                .value.unexpected_character =
+                                    {.character = source[0],
+                                     .span = span_of(cursor, 0)}}},
+      .cursor = advance(cursor, 1),
+  };
+}
+
+#undef SMITH_DFA_ACCEPT_OPERATOR
+#undef SMITH_DFA_ACCEPT_DELIMITER
+#undef SMITH_DFA_ACCEPT_LITERAL
+#undef SMITH_DFA_ACCEPT_SYMBOL
+#undef SMITH_DFA_ACCEPT_INT
+#undef SMITH_DFA_ACCEPT_FLOAT
+#undef SMITH_DFA_REJECT
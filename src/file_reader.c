@@ -0,0 +1,43 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/file_reader.h"
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+
+typedef struct {
+  smith_allocator_t allocator;
+  int file_descriptor;
+} file_reader_t;
+
+static smith_read_result_t read_(void *reader, char *buffer, size_t capacity) {
+  assert(reader != nullptr);
+  file_reader_t *file_reader = reader;
+  while (true) {
+    ssize_t length = read(file_reader->file_descriptor, buffer, capacity);
+    if (length >= 0) {
+      return (smith_read_result_t){.success = true, .length = length};
+    }
+    if (errno != EINTR) {
+      return (smith_read_result_t){};
+    }
+  }
+}
+
+static void destroy(void *reader) {
+  assert(reader != nullptr);
+  file_reader_t *file_reader = reader;
+  smith_allocator_deallocate(file_reader->allocator, file_reader);
+}
+
+smith_file_reader_create_result_t
+smith_file_reader_create(smith_allocator_t allocator, int file_descriptor) {
+  file_reader_t *file_reader = smith_allocator_allocate(allocator, file_reader_t);
+  if (file_reader == nullptr) {
+    return (smith_file_reader_create_result_t){};
+  }
+  *file_reader = (file_reader_t){allocator, file_descriptor};
+  return (smith_file_reader_create_result_t){
+      .reader = {.read = read_, .destroy = destroy, .state = file_reader},
+      .success = true};
+}
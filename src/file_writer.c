@@ -0,0 +1,47 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/file_writer.h"
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+
+typedef struct {
+  smith_allocator_t allocator;
+  int file_descriptor;
+} file_writer_t;
+
+static bool write_(void *writer, const char *buffer, size_t length) {
+  assert(writer != nullptr);
+  file_writer_t *file_writer = writer;
+  while (length > 0) {
+    ssize_t written = write(file_writer->file_descriptor, buffer, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buffer += written;
+    length -= written;
+  }
+  return true;
+}
+
+static void destroy(void *writer) {
+  assert(writer != nullptr);
+  file_writer_t *file_writer = writer;
+  smith_allocator_deallocate(file_writer->allocator, file_writer);
+}
+
+smith_file_writer_create_result_t
+smith_file_writer_create(smith_allocator_t allocator, int file_descriptor) {
+  file_writer_t *file_writer =
+      smith_allocator_allocate(allocator, file_writer_t);
+  if (file_writer == nullptr) {
+    return (smith_file_writer_create_result_t){};
+  }
+  *file_writer = (file_writer_t){allocator, file_descriptor};
+  return (smith_file_writer_create_result_t){
+      .writer = {.write = write_, .destroy = destroy, .state = file_writer},
+      .success = true};
+}
@@ -0,0 +1,52 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/hash_index.h"
+#include <string.h>
+
+uint64_t smith_hash_mix(uint64_t hash, uint64_t value) {
+  hash = (hash ^ value) * 0x9E3779B97F4A7C15;
+  return hash ^ hash >> 32;
+}
+
+bool smith_hash_index_resize(smith_allocator_t allocator,
+                             smith_hash_index_t *index, uint32_t capacity,
+                             const uint64_t *hashes, uint32_t count) {
+  uint32_t slot_capacity = capacity * 2;
+  uint32_t *slots =
+      smith_allocator_allocate_array(allocator, uint32_t, slot_capacity);
+  if (slots == nullptr) {
+    return false;
+  }
+  memset(slots, 0, slot_capacity * sizeof(uint32_t));
+  uint32_t mask = slot_capacity - 1;
+  for (uint32_t entry = 0; entry < count; entry++) {
+    uint32_t slot = hashes[entry] & mask;
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = entry + 1;
+  }
+  smith_allocator_deallocate(allocator, index->slots);
+  *index = (smith_hash_index_t){.slots = slots, .mask = mask};
+  return true;
+}
+
+uint32_t smith_hash_index_find(const smith_hash_index_t *index,
+                               const uint64_t *hashes, uint64_t hash,
+                               smith_hash_index_equal_t equal,
+                               const void *state) {
+  uint32_t slot = hash & index->mask;
+  while (index->slots[slot] != 0) {
+    uint32_t entry = index->slots[slot] - 1;
+    if (hashes[entry] == hash && equal(state, entry)) {
+      break;
+    }
+    slot = (slot + 1) & index->mask;
+  }
+  return slot;
+}
+
+void smith_hash_index_destroy(smith_allocator_t allocator,
+                              smith_hash_index_t index) {
+  smith_allocator_deallocate(allocator, index.slots);
+}
@@ -5,11 +5,17 @@
 #include <stdint.h>
 #include <string.h>
 
+/**
+ * Strings are stored densely in the order they were first interned, so an
+ * interned identifier is simply an index into `strings` and stays stable when
+ * the table grows. `slots` is an open addressing table of identifiers + 1,
+ * where 0 marks an empty slot. It always has twice the capacity of `strings`.
+ */
 typedef struct {
   smith_allocator_t allocator;
   smith_string_t *strings;
   uint64_t *hashes;
-  bool *occupied;
+  size_t *slots;
   size_t capacity;
   size_t count;
 } smith_hash_interner_t;
@@ -24,12 +30,22 @@ static uint64_t hash(smith_string_t string) {
 
 static size_t max(size_t a, size_t b) { return a > b ? a : b; }
 
+static void insert_slot(size_t *slots, size_t slot_capacity, uint64_t hash,
+                        size_t interned) {
+  size_t index = hash % slot_capacity;
+  while (slots[index] != 0) {
+    index = (index + 1) % slot_capacity;
+  }
+  slots[index] = interned + 1;
+}
+
 static bool grow_if_needed(smith_hash_interner_t *interner) {
   if (interner->count < interner->capacity)
     return true;
   size_t new_capacity =
       max(interner->capacity * SMITH_HASH_INTERNER_GROWTH_FACTOR,
           SMITH_HASH_INTERNER_MIN_CAPACITY);
+  size_t slot_capacity = new_capacity * 2;
   smith_allocator_t allocator = interner->allocator;
   smith_string_t *strings =
       smith_allocator_allocate_array(allocator, smith_string_t, new_capacity);
@@ -42,22 +58,28 @@ static bool grow_if_needed(smith_hash_interner_t *interner) {
     smith_allocator_deallocate(allocator, strings);
     return false;
   }
-  bool *occupied =
-      smith_allocator_allocate_array(allocator, bool, new_capacity);
-  if (occupied == nullptr) {
+  size_t *slots =
+      smith_allocator_allocate_array(allocator, size_t, slot_capacity);
+  if (slots == nullptr) {
     smith_allocator_deallocate(allocator, strings);
     smith_allocator_deallocate(allocator, hashes);
     return false;
   }
-  memcpy(strings, interner->strings, interner->count * sizeof(smith_string_t));
-  memcpy(hashes, interner->hashes, interner->count * sizeof(uint64_t));
-  memcpy(occupied, interner->occupied, interner->count * sizeof(bool));
+  memset(slots, 0, slot_capacity * sizeof(size_t));
+  if (interner->count > 0) {
+    memcpy(strings, interner->strings,
+           interner->count * sizeof(smith_string_t));
+    memcpy(hashes, interner->hashes, interner->count * sizeof(uint64_t));
+  }
+  for (size_t i = 0; i < interner->count; i++) {
+    insert_slot(slots, slot_capacity, hashes[i], i);
+  }
   smith_allocator_deallocate(allocator, interner->strings);
   smith_allocator_deallocate(allocator, interner->hashes);
-  smith_allocator_deallocate(allocator, interner->occupied);
+  smith_allocator_deallocate(allocator, interner->slots);
   interner->strings = strings;
   interner->hashes = hashes;
-  interner->occupied = occupied;
+  interner->slots = slots;
   interner->capacity = new_capacity;
   return true;
 }
@@ -69,32 +91,32 @@ static smith_intern_result_t intern(void *interner, smith_string_t string) {
     return (smith_intern_result_t){};
   }
   uint64_t hash_value = hash(string);
-  for (size_t i = 0; i < hash_interner->capacity; i++) {
-    size_t index = (i + hash_value) % hash_interner->capacity;
-    if (!hash_interner->occupied[index]) {
-      hash_interner->strings[index] = string;
-      hash_interner->hashes[index] = hash_value;
-      hash_interner->occupied[index] = true;
-      hash_interner->count++;
-      return (smith_intern_result_t){.success = true, .interned = index};
-    }
-    smith_string_t existing_string = hash_interner->strings[index];
+  size_t slot_capacity = hash_interner->capacity * 2;
+  size_t index = hash_value % slot_capacity;
+  while (hash_interner->slots[index] != 0) {
+    size_t interned = hash_interner->slots[index] - 1;
+    smith_string_t existing_string = hash_interner->strings[interned];
     bool same_string =
-        hash_interner->hashes[index] == hash_value &&
+        hash_interner->hashes[interned] == hash_value &&
         existing_string.length == string.length &&
         memcmp(existing_string.data, string.data, string.length) == 0;
     if (same_string) {
-      return (smith_intern_result_t){.success = true, .interned = index};
+      return (smith_intern_result_t){.success = true, .interned = interned};
     }
+    index = (index + 1) % slot_capacity;
   }
-  return (smith_intern_result_t){};
+  size_t interned = hash_interner->count++;
+  hash_interner->strings[interned] = string;
+  hash_interner->hashes[interned] = hash_value;
+  hash_interner->slots[index] = interned + 1;
+  return (smith_intern_result_t){.success = true, .interned = interned};
 }
 
 static smith_lookup_result_t lookup(const void *interner,
                                     smith_interned_t interned) {
   assert(interner != nullptr);
   smith_hash_interner_t *hash_interner = (smith_hash_interner_t *)interner;
-  if (!hash_interner->occupied[interned]) {
+  if (interned >= hash_interner->count) {
     return (smith_lookup_result_t){};
   }
   return (smith_lookup_result_t){.success = true,
@@ -107,7 +129,8 @@ static void destroy(void *interner) {
   smith_allocator_t allocator = hash_interner->allocator;
   smith_allocator_deallocate(allocator, hash_interner->strings);
   smith_allocator_deallocate(allocator, hash_interner->hashes);
-  smith_allocator_deallocate(allocator, hash_interner->occupied);
+  smith_allocator_deallocate(allocator, hash_interner->slots);
+  smith_allocator_deallocate(allocator, hash_interner);
 }
 
 smith_hash_interner_create_result_t
@@ -0,0 +1,231 @@
+#include "smith/incremental_parser.h"
+#include "smith/null_interner.h"
+#include <string.h>
+
+// Describes where text from the old source ends up in the new one. Positions
+// on the line of the anchor move by columns as well as lines, as in
+// `smith_relex`.
+typedef struct {
+  const char *old_source;
+  char *source;
+  int64_t offset_delta;
+  uint32_t anchor_line;
+  int64_t line_delta;
+  int64_t column_delta;
+} shift_t;
+
+static void shift_position(smith_position_t *position, const shift_t *shift) {
+  if (position->line == shift->anchor_line) {
+    position->column = (uint32_t)((int64_t)position->column + shift->column_delta);
+  }
+  position->line = (uint32_t)((int64_t)position->line + shift->line_delta);
+}
+
+static void shift_span(smith_span_t *span, const shift_t *shift) {
+  shift_position(&span->start, shift);
+  shift_position(&span->end, shift);
+}
+
+static void shift_text(smith_string_t *text, const shift_t *shift) {
+  text->data =
+      shift->source + (text->data - shift->old_source) + shift->offset_delta;
+}
+
+// Moves a function as its text moved, recording in it how its nodes moved
+// rather than touching them.
+static void shift_function(smith_function_t *function, const shift_t *shift) {
+  if (function->span.start.line == shift->anchor_line) {
+    function->shift.column_delta += shift->column_delta;
+  }
+  function->shift.line_delta += shift->line_delta;
+  function->offsets.start += shift->offset_delta;
+  function->offsets.end += shift->offset_delta;
+  if (shift->old_source != nullptr) {
+    uintptr_t old_text = (uintptr_t)function->name.text.data;
+    shift_text(&function->name.text, shift);
+    function->shift.text_delta +=
+        (intptr_t)((uintptr_t)function->name.text.data - old_text);
+  }
+  shift_span(&function->span, shift);
+  shift_span(&function->name_span, shift);
+}
+
+// The index of the first function ending after `offset`.
+static size_t first_ending_after(const smith_module_t *module, size_t offset) {
+  size_t low = 0;
+  size_t high = module->count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (module->functions[middle].offsets.end > offset) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+// The index of the first function from `low` on starting at or after
+// `offset`.
+static size_t first_starting_from(const smith_module_t *module, size_t low,
+                                  size_t offset) {
+  size_t high = module->count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (module->functions[middle].offsets.start >= offset) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+smith_reparse_result_t smith_reparse(smith_parser_context_t context,
+                                     smith_module_t *module,
+                                     smith_token_buffer_t *buffer,
+                                     char *source, smith_edit_t edit) {
+  const char *old_source = buffer->source;
+  smith_relex_result_t relex_result =
+      smith_relex(smith_null_interner_create(), buffer, source, edit);
+  if (!relex_result.success) {
+    return (smith_reparse_result_t){};
+  }
+  int64_t offset_delta =
+      (int64_t)edit.inserted.length - (int64_t)edit.removed_length;
+  // Tokens from `tail` on are old tokens that were only shifted.
+  size_t tail = relex_result.first + relex_result.relexed;
+  size_t relexed_start =
+      smith_token_buffer_offsets(buffer, relex_result.first).start;
+  // The functions before `first` end before the relexed tokens, so they are
+  // unchanged. Reparsing starts at the first function that may not be, or
+  // right after the last unchanged one when the edit is between functions.
+  size_t first = first_ending_after(module, relexed_start);
+  size_t index = 0;
+  if (first < module->count &&
+      module->functions[first].offsets.start < relexed_start) {
+    index = smith_token_buffer_find(buffer,
+                                    module->functions[first].offsets.start + 1);
+  } else if (first > 0) {
+    index = smith_token_buffer_find(
+        buffer, module->functions[first - 1].offsets.end + 1);
+  }
+  size_t reused = first;
+  if (tail < buffer->count) {
+    size_t old_start =
+        smith_token_buffer_offsets(buffer, tail).start - offset_delta;
+    reused = first_starting_from(module, first, old_start);
+  }
+  smith_module_t reparsed = smith_module_create(context.allocator);
+  while (true) {
+    if (smith_token_buffer_peek(buffer, index, 0).kind ==
+        SMITH_TOKEN_KIND_END_OF_FILE) {
+      reused = module->count;
+      break;
+    }
+    if (index >= tail) {
+      size_t old_start =
+          smith_token_buffer_offsets(buffer, index).start - offset_delta;
+      while (reused < module->count &&
+             module->functions[reused].offsets.start < old_start) {
+        reused++;
+      }
+      if (reused < module->count &&
+          module->functions[reused].offsets.start == old_start) {
+        break;
+      }
+    }
+    smith_parse_function_result_t parse_result =
+        smith_parse_function(context, &reparsed.ast, buffer, index);
+    if (!parse_result.success ||
+        !smith_module_push_function(&reparsed, parse_result.function)) {
+      smith_module_destroy(reparsed);
+      return (smith_reparse_result_t){};
+    }
+    index = parse_result.index;
+  }
+
+  shift_t before = {.old_source = old_source, .source = source};
+  shift_t after = before;
+  after.offset_delta = offset_delta;
+  if (reused < module->count) {
+    smith_position_t old_anchor = module->functions[reused].span.start;
+    smith_token_t token = smith_token_buffer_get(buffer, index);
+    smith_position_t anchor = smith_token_span(&token)->start;
+    after.anchor_line = old_anchor.line;
+    after.line_delta = (int64_t)anchor.line - old_anchor.line;
+    after.column_delta = (int64_t)anchor.column - old_anchor.column;
+  }
+
+  size_t function_count = first + reparsed.count + (module->count - reused);
+  if (!smith_module_reserve(module, function_count)) {
+    smith_module_destroy(reparsed);
+    return (smith_reparse_result_t){};
+  }
+  // The new nodes take the place of the replaced ones when those are one
+  // block they fit in, or that ends the AST. Otherwise they go at the end and
+  // the replaced ones are left unused. No other node moves.
+  smith_ast_t *ast = &module->ast;
+  uint32_t replaced = 0;
+  bool contiguous = true;
+  for (size_t i = first; i < reused; i++) {
+    smith_function_t function = module->functions[i];
+    replaced += function.body + 1 - function.parameters;
+    if (i > first && function.parameters != module->functions[i - 1].body + 1) {
+      contiguous = false;
+    }
+  }
+  smith_ast_node_t base = ast->count;
+  uint32_t garbage = replaced;
+  if (replaced > 0 && contiguous) {
+    smith_ast_node_t start = module->functions[first].parameters;
+    if (start + replaced == ast->count) {
+      ast->count = start;
+      base = start;
+      garbage = 0;
+    } else if (reparsed.ast.count <= replaced) {
+      base = start;
+      garbage = replaced - reparsed.ast.count;
+    }
+  }
+  uint32_t count = ast->count;
+  ast->count = base;
+  bool appended = smith_ast_append(ast, &reparsed.ast);
+  if (ast->count < count) {
+    ast->count = count;
+  }
+  if (!appended) {
+    smith_module_destroy(reparsed);
+    return (smith_reparse_result_t){};
+  }
+  module->garbage += garbage;
+
+  size_t moved_function = first + reparsed.count;
+  if (moved_function != reused) {
+    memmove(module->functions + moved_function, module->functions + reused,
+            (module->count - reused) * sizeof(smith_function_t));
+  }
+  for (size_t i = 0; i < reparsed.count; i++) {
+    smith_function_t function = reparsed.functions[i];
+    function.parameters += base;
+    function.body += base;
+    module->functions[first + i] = function;
+  }
+  module->count = function_count;
+  if (old_source != source) {
+    for (size_t i = 0; i < first; i++) {
+      shift_function(&module->functions[i], &before);
+    }
+  }
+  for (size_t i = moved_function; i < module->count; i++) {
+    shift_function(&module->functions[i], &after);
+  }
+  smith_module_destroy(reparsed);
+  // Laying the nodes out again costs as much as the unused ones did to make.
+  // Failing to only leaves them for later.
+  if (module->garbage > ast->count - module->garbage) {
+    smith_module_settle(module);
+  }
+  return (smith_reparse_result_t){
+      .first = first, .reparsed = moved_function - first, .success = true};
+}
@@ -0,0 +1,97 @@
+#include "smith/incremental_tokenizer.h"
+#include "smith/dfa_tokenizer.h"
+
+// The span of an invalid escape starts at the escape rather than at the start
+// of its string literal, so its position cannot anchor a restart or a shift.
+static bool spans_from_start(smith_token_t token) {
+  return token.kind != SMITH_TOKEN_KIND_ERROR ||
+         token.value.error.kind != SMITH_ERROR_KIND_INVALID_ESCAPE;
+}
+
+static smith_position_t start_of(const smith_token_buffer_t *buffer,
+                                 size_t index) {
+  smith_token_t token = smith_token_buffer_get(buffer, index);
+  return smith_token_span(&token)->start;
+}
+
+smith_relex_result_t smith_relex(smith_interner_t interner,
+                                 smith_token_buffer_t *buffer, char *source,
+                                 smith_edit_t edit) {
+  size_t edit_end = edit.offset + edit.inserted.length;
+  // The lexer decides where a symbol ends by decoding the code point after it,
+  // so a token ending up to three bytes before the edit may be extended by it.
+  // The restart point is the start of the first token ending at or after that
+  // probe, or of the token before it when the probe falls in the whitespace
+  // between them.
+  size_t probe = edit.offset > 3 ? edit.offset - 3 : 0;
+  size_t first = smith_token_buffer_find(buffer, probe);
+  if (first > 0 && smith_token_buffer_offsets(buffer, first).start > probe) {
+    first--;
+  }
+  while (first > 0 &&
+         !spans_from_start(smith_token_buffer_get(buffer, first))) {
+    first--;
+  }
+  smith_cursor_t cursor = {.source = source};
+  size_t first_start = smith_token_buffer_offsets(buffer, first).start;
+  if (first_start <= edit.offset &&
+      spans_from_start(smith_token_buffer_get(buffer, first))) {
+    cursor = (smith_cursor_t){.source = source + first_start,
+                              .position = start_of(buffer, first)};
+  }
+  smith_token_buffer_t relexed = smith_token_buffer_create(buffer->allocator);
+  size_t resync = first;
+  while (true) {
+    cursor = smith_trim_whitespace(cursor);
+    size_t start = cursor.source - source;
+    if (start >= edit_end) {
+      size_t old_start = start - edit.inserted.length + edit.removed_length;
+      while (resync < buffer->count &&
+             smith_token_buffer_offsets(buffer, resync).start < old_start) {
+        resync++;
+      }
+      if (resync < buffer->count &&
+          smith_token_buffer_offsets(buffer, resync).start == old_start &&
+          spans_from_start(smith_token_buffer_get(buffer, resync))) {
+        break;
+      }
+    }
+    smith_next_token_result_t result = smith_dfa_next_token(interner, cursor);
+    smith_offsets_t offsets = {.start = start,
+                               .end = result.cursor.source - source};
+    if (!smith_token_buffer_push(&relexed, result.token, offsets)) {
+      smith_token_buffer_destroy(relexed);
+      return (smith_relex_result_t){};
+    }
+    if (result.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      // Only reachable if the edit does not describe the new source text.
+      resync = buffer->count;
+      break;
+    }
+    cursor = result.cursor;
+  }
+  size_t count = first + relexed.count + buffer->count - resync;
+  if (!smith_token_buffer_reserve(buffer, count)) {
+    smith_token_buffer_destroy(relexed);
+    return (smith_relex_result_t){};
+  }
+  // The old tokens from `resync` on are only shifted, which the buffer
+  // records rather than applies, so they are never touched.
+  if (resync < buffer->count) {
+    smith_position_t old_position = start_of(buffer, resync);
+    smith_token_buffer_shift(
+        buffer, resync,
+        (int64_t)(cursor.source - source) -
+            (int64_t)smith_token_buffer_offsets(buffer, resync).start,
+        (int64_t)cursor.position.line - old_position.line,
+        (int64_t)cursor.position.column - old_position.column);
+  }
+  // Room was reserved above, so splicing cannot fail.
+  smith_token_buffer_splice(buffer, first, resync, &relexed);
+  buffer->source = source;
+  smith_token_buffer_destroy(relexed);
+  return (smith_relex_result_t){.success = true,
+                                .relexed = relexed.count,
+                                .first = first,
+                                .replaced = resync - first};
+}
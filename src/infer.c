@@ -0,0 +1,281 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/infer.h"
+#include "smith/constant.h"
+#include "smith/dag.h"
+
+typedef struct {
+  smith_type_table_t *table;
+  const smith_ast_t *ast;
+  smith_ast_node_t first;
+  smith_type_t *types;
+  smith_dag_t dag;
+  // The DAG node of each symbol of the expression, indexed from `first`.
+  smith_dag_node_t *symbols;
+  // The type bound to each symbol, by DAG node, or none.
+  smith_type_t *bindings;
+  smith_type_t bool_;
+  smith_ast_node_t error;
+} inferrer_t;
+
+static bool is_literal(const inferrer_t *inferrer, smith_ast_node_t node) {
+  switch ((smith_expression_kind_t)inferrer->ast->kinds[node]) {
+  case SMITH_EXPRESSION_KIND_INT:
+  case SMITH_EXPRESSION_KIND_FLOAT:
+    return true;
+  case SMITH_EXPRESSION_KIND_CONSTANT:
+    return inferrer->ast->payloads[node].constant.kind !=
+           SMITH_CONSTANT_KIND_BOOL;
+  default:
+    return false;
+  }
+}
+
+static bool fits(int64_t value, uint32_t width) {
+  if (width >= 64) {
+    return true;
+  }
+  int64_t limit = (int64_t)1 << (width - 1);
+  return value >= -limit && value < limit;
+}
+
+// The type of a literal combined with an operand of type `hint`, which may
+// be none.
+static smith_type_t literal_type(inferrer_t *inferrer, smith_ast_node_t node,
+                                 smith_type_t hint) {
+  const smith_ast_t *ast = inferrer->ast;
+  smith_constant_t constant;
+  if (ast->kinds[node] == SMITH_EXPRESSION_KIND_CONSTANT) {
+    constant = ast->payloads[node].constant;
+  } else {
+    smith_constant_result_t constant_result =
+        smith_constant_from_literal((smith_expression_kind_t)ast->kinds[node],
+                                    ast->payloads[node].leaf.text);
+    if (!constant_result.success) {
+      return SMITH_TYPE_NONE;
+    }
+    constant = constant_result.constant;
+  }
+  smith_type_table_t *table = inferrer->table;
+  if (hint != SMITH_TYPE_NONE) {
+    smith_type_info_t info = table->types[hint];
+    if (constant.kind == SMITH_CONSTANT_KIND_INT &&
+        info.kind == SMITH_TYPE_KIND_INT &&
+        fits(constant.value.int_, info.width)) {
+      return hint;
+    }
+    if (constant.kind == SMITH_CONSTANT_KIND_FLOAT &&
+        info.kind == SMITH_TYPE_KIND_FLOAT) {
+      return hint;
+    }
+  }
+  smith_type_intern_result_t intern_result =
+      constant.kind == SMITH_CONSTANT_KIND_INT
+          ? smith_type_intern_int(table, 64)
+          : smith_type_intern_float(table, 64);
+  return intern_result.success ? intern_result.type : SMITH_TYPE_NONE;
+}
+
+// Types a node as its operator reads it. Symbols and literals are typed
+// here rather than when visited, as their type depends on their operator.
+static smith_type_t resolve(inferrer_t *inferrer, smith_ast_node_t node,
+                            smith_type_t hint) {
+  smith_type_t type = inferrer->types[node];
+  smith_dag_node_t symbol = inferrer->symbols[node - inferrer->first];
+  if (symbol != SMITH_DAG_NO_NODE) {
+    type = inferrer->bindings[symbol];
+  } else if (is_literal(inferrer, node)) {
+    type = literal_type(inferrer, node, hint);
+  }
+  if (type == SMITH_TYPE_NONE) {
+    inferrer->error = node;
+  }
+  inferrer->types[node] = type;
+  return type;
+}
+
+// Whether an operator applies to operands of a type, and the type of its
+// result.
+static bool check_operator(const inferrer_t *inferrer,
+                           smith_binary_operator_kind_t kind,
+                           smith_type_t operand, smith_type_t *result) {
+  smith_type_kind_t type_kind = inferrer->table->types[operand].kind;
+  bool number =
+      type_kind == SMITH_TYPE_KIND_INT || type_kind == SMITH_TYPE_KIND_FLOAT;
+  *result = operand;
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_ADD:
+  case SMITH_BINARY_OPERATOR_KIND_SUB:
+  case SMITH_BINARY_OPERATOR_KIND_MUL:
+  case SMITH_BINARY_OPERATOR_KIND_DIV:
+  case SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN:
+  case SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN:
+  case SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN:
+  case SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN:
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_EQ:
+  case SMITH_BINARY_OPERATOR_KIND_NOT_EQ:
+    *result = inferrer->bool_;
+    return type_kind != SMITH_TYPE_KIND_FUNCTION;
+  case SMITH_BINARY_OPERATOR_KIND_LT:
+  case SMITH_BINARY_OPERATOR_KIND_LE:
+  case SMITH_BINARY_OPERATOR_KIND_GT:
+  case SMITH_BINARY_OPERATOR_KIND_GE:
+    *result = inferrer->bool_;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_BIT_AND:
+  case SMITH_BINARY_OPERATOR_KIND_BIT_OR:
+    return type_kind == SMITH_TYPE_KIND_INT ||
+           type_kind == SMITH_TYPE_KIND_BOOL;
+  case SMITH_BINARY_OPERATOR_KIND_AND:
+  case SMITH_BINARY_OPERATOR_KIND_OR:
+    return type_kind == SMITH_TYPE_KIND_BOOL;
+  default:
+    return false;
+  }
+}
+
+static bool infer_binary_operator(inferrer_t *inferrer, smith_ast_node_t node) {
+  smith_ast_children_t children = inferrer->ast->children[node];
+  smith_binary_operator_kind_t kind =
+      inferrer->ast->payloads[node].binary_operator.kind;
+  smith_dag_node_t symbol = inferrer->symbols[children.left - inferrer->first];
+  if (kind == SMITH_BINARY_OPERATOR_KIND_ASSIGN) {
+    if (symbol == SMITH_DAG_NO_NODE) {
+      inferrer->error = node;
+      return false;
+    }
+    smith_type_t bound = inferrer->bindings[symbol];
+    smith_type_t type = resolve(inferrer, children.right, bound);
+    if (type == SMITH_TYPE_NONE) {
+      return false;
+    }
+    if (bound != SMITH_TYPE_NONE && bound != type) {
+      inferrer->error = node;
+      return false;
+    }
+    inferrer->bindings[symbol] = type;
+    inferrer->types[children.left] = type;
+    inferrer->types[node] = type;
+    return true;
+  }
+  bool assigns = kind == SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN ||
+                 kind == SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN ||
+                 kind == SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN ||
+                 kind == SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN;
+  if (assigns && symbol == SMITH_DAG_NO_NODE) {
+    inferrer->error = node;
+    return false;
+  }
+  // A literal on the left takes its type from the right.
+  smith_type_t left = SMITH_TYPE_NONE;
+  if (!is_literal(inferrer, children.left)) {
+    left = resolve(inferrer, children.left, SMITH_TYPE_NONE);
+    if (left == SMITH_TYPE_NONE) {
+      return false;
+    }
+  }
+  smith_type_t right = resolve(inferrer, children.right, left);
+  if (right == SMITH_TYPE_NONE) {
+    return false;
+  }
+  if (left == SMITH_TYPE_NONE) {
+    left = resolve(inferrer, children.left, right);
+    if (left == SMITH_TYPE_NONE) {
+      return false;
+    }
+  }
+  smith_type_t result;
+  if (left != right || !check_operator(inferrer, kind, left, &result)) {
+    inferrer->error = node;
+    return false;
+  }
+  inferrer->types[node] = result;
+  return true;
+}
+
+// Visits the nodes in order, children before parents, so each operator is
+// typed after its operands and before any later assignment rebinds them.
+static bool infer(inferrer_t *inferrer, smith_ast_node_t root) {
+  for (smith_ast_node_t node = inferrer->first; node <= root; node++) {
+    uint8_t kind = inferrer->ast->kinds[node];
+    if (kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      if (!infer_binary_operator(inferrer, node)) {
+        return false;
+      }
+    } else if (kind == SMITH_EXPRESSION_KIND_CONSTANT &&
+               !is_literal(inferrer, node)) {
+      inferrer->types[node] = inferrer->bool_;
+    }
+  }
+  return resolve(inferrer, root, SMITH_TYPE_NONE) != SMITH_TYPE_NONE;
+}
+
+static smith_string_t parameter_name(const void *parameters, uint32_t index) {
+  return ((const smith_typed_parameter_t *)parameters)[index].name;
+}
+
+smith_infer_result_t
+smith_infer_types(smith_allocator_t allocator, smith_type_table_t *table,
+                  const smith_ast_t *ast, smith_ast_node_t root,
+                  const smith_typed_parameter_t *parameters,
+                  uint32_t parameter_count) {
+  smith_type_intern_result_t bool_result = smith_type_intern_bool(table);
+  size_t node_count = ast->count;
+  inferrer_t inferrer = {
+      .table = table,
+      .ast = ast,
+      .first = smith_ast_first(ast, root),
+      .types = smith_allocator_allocate_array(allocator, smith_type_t,
+                                              node_count),
+      .dag = smith_dag_create(allocator),
+      .bool_ = bool_result.type,
+      .error = root,
+  };
+  size_t symbol_count = root - inferrer.first + 1;
+  inferrer.symbols = smith_allocator_allocate_array(
+      allocator, smith_dag_node_t, symbol_count);
+  bool success = bool_result.success && inferrer.types != nullptr &&
+                 inferrer.symbols != nullptr &&
+                 smith_dag_number_symbols(&inferrer.dag, ast, root, parameters,
+                                          parameter_count, parameter_name,
+                                          inferrer.symbols);
+  if (success) {
+    size_t binding_count = inferrer.dag.count;
+    inferrer.bindings = smith_allocator_allocate_array(
+        allocator, smith_type_t, binding_count);
+    success = inferrer.bindings != nullptr;
+  }
+  if (success) {
+    for (size_t node = 0; node < node_count; node++) {
+      inferrer.types[node] = SMITH_TYPE_NONE;
+    }
+    for (uint32_t i = 0; i < inferrer.dag.count; i++) {
+      inferrer.bindings[i] =
+          i < parameter_count ? parameters[i].type : SMITH_TYPE_NONE;
+    }
+    success = infer(&inferrer, root);
+  }
+  smith_type_intern_result_t function_result = {};
+  if (success) {
+    // The bindings are done with, so they hold the parameter types.
+    smith_type_t *parameter_types = inferrer.bindings;
+    for (uint32_t i = 0; i < parameter_count; i++) {
+      parameter_types[i] = parameters[i].type;
+    }
+    function_result =
+        smith_type_intern_function(table, parameter_types, parameter_count,
+                                   inferrer.types[root]);
+    success = function_result.success;
+  }
+  smith_allocator_deallocate(allocator, inferrer.bindings);
+  smith_allocator_deallocate(allocator, inferrer.symbols);
+  smith_dag_destroy(inferrer.dag);
+  if (!success) {
+    smith_allocator_deallocate(allocator, inferrer.types);
+    return (smith_infer_result_t){.error = inferrer.error};
+  }
+  return (smith_infer_result_t){.types = inferrer.types,
+                                .function = function_result.type,
+                                .success = true};
+}
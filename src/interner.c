@@ -1,7 +1,14 @@
 #include "smith/interner.h"
 
+bool smith_interner_is_null(smith_interner_t interner) {
+  return interner.intern == nullptr;
+}
+
 smith_intern_result_t smith_interner_intern(smith_interner_t interner,
                                             smith_string_t string) {
+  if (interner.intern == nullptr) {
+    return (smith_intern_result_t){};
+  }
   return interner.intern(interner.state, string);
 }
 
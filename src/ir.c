@@ -0,0 +1,736 @@
+// For `clock_gettime`, which strict C modes hide.
+#define _DEFAULT_SOURCE 1
+
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/ir.h"
+#include "smith/arena_allocator.h"
+#include "smith/constant.h"
+#include "smith/dag.h"
+#include <string.h>
+#include <time.h>
+
+static smith_ir_instruction_t *append(smith_ir_function_t *function,
+                                      smith_ir_block_t *block,
+                                      smith_ir_instruction_t instruction) {
+  smith_ir_instruction_t *appended =
+      smith_allocator_allocate(function->arena, smith_ir_instruction_t);
+  if (appended == nullptr) {
+    return nullptr;
+  }
+  instruction.id = function->value_count++;
+  instruction.block = block;
+  instruction.previous = block->last;
+  instruction.next = nullptr;
+  *appended = instruction;
+  if (block->last != nullptr) {
+    block->last->next = appended;
+  } else {
+    block->first = appended;
+  }
+  block->last = appended;
+  return appended;
+}
+
+static void unlink_instruction(smith_ir_instruction_t *instruction) {
+  smith_ir_block_t *block = instruction->block;
+  if (instruction->previous != nullptr) {
+    instruction->previous->next = instruction->next;
+  } else {
+    block->first = instruction->next;
+  }
+  if (instruction->next != nullptr) {
+    instruction->next->previous = instruction->previous;
+  } else {
+    block->last = instruction->previous;
+  }
+}
+
+static bool is_operator(smith_ir_opcode_t opcode) {
+  return opcode >= SMITH_IR_OPCODE_ADD && opcode <= SMITH_IR_OPCODE_OR;
+}
+
+// The instruction for an operator on operands of a type, and the type of its
+// value, or false for an operator with no meaning for the type. `&` and `|`
+// on bools are `and` and `or`, so each operation has one opcode.
+static bool select_opcode(smith_binary_operator_kind_t kind,
+                          smith_constant_kind_t type,
+                          smith_ir_opcode_t *opcode,
+                          smith_constant_kind_t *result) {
+  bool number = type != SMITH_CONSTANT_KIND_BOOL;
+  *result = SMITH_CONSTANT_KIND_BOOL;
+  switch (kind) {
+  case SMITH_BINARY_OPERATOR_KIND_ADD:
+  case SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN:
+    *opcode = SMITH_IR_OPCODE_ADD;
+    *result = type;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_SUB:
+  case SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN:
+    *opcode = SMITH_IR_OPCODE_SUB;
+    *result = type;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_MUL:
+  case SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN:
+    *opcode = SMITH_IR_OPCODE_MUL;
+    *result = type;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_DIV:
+  case SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN:
+    *opcode = SMITH_IR_OPCODE_DIV;
+    *result = type;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_EQ:
+    *opcode = SMITH_IR_OPCODE_EQ;
+    return true;
+  case SMITH_BINARY_OPERATOR_KIND_NOT_EQ:
+    *opcode = SMITH_IR_OPCODE_NOT_EQ;
+    return true;
+  case SMITH_BINARY_OPERATOR_KIND_LT:
+    *opcode = SMITH_IR_OPCODE_LT;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_LE:
+    *opcode = SMITH_IR_OPCODE_LE;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_GT:
+    *opcode = SMITH_IR_OPCODE_GT;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_GE:
+    *opcode = SMITH_IR_OPCODE_GE;
+    return number;
+  case SMITH_BINARY_OPERATOR_KIND_BIT_AND:
+    *opcode = number ? SMITH_IR_OPCODE_BIT_AND : SMITH_IR_OPCODE_AND;
+    *result = type;
+    return type != SMITH_CONSTANT_KIND_FLOAT;
+  case SMITH_BINARY_OPERATOR_KIND_BIT_OR:
+    *opcode = number ? SMITH_IR_OPCODE_BIT_OR : SMITH_IR_OPCODE_OR;
+    *result = type;
+    return type != SMITH_CONSTANT_KIND_FLOAT;
+  case SMITH_BINARY_OPERATOR_KIND_AND:
+    *opcode = SMITH_IR_OPCODE_AND;
+    return !number;
+  case SMITH_BINARY_OPERATOR_KIND_OR:
+    *opcode = SMITH_IR_OPCODE_OR;
+    return !number;
+  default:
+    return false;
+  }
+}
+
+// What a node of the expression evaluates to: the value it computed, or for
+// a symbol, whose value is only looked up by its operator, its DAG node.
+typedef struct {
+  smith_ir_instruction_t *value;
+  smith_dag_node_t symbol;
+} operand_t;
+
+typedef struct {
+  smith_ir_function_t function;
+  const smith_ast_t *ast;
+  smith_ast_node_t first;
+  smith_dag_t dag;
+  // The DAG node of each symbol of the expression, indexed from `first`.
+  smith_dag_node_t *symbols;
+  // The value bound to each symbol, by DAG node, or null.
+  smith_ir_instruction_t **bindings;
+  operand_t *operands;
+} builder_t;
+
+static smith_ir_instruction_t *read_operand(builder_t *builder,
+                                            operand_t operand) {
+  if (operand.symbol == SMITH_DAG_NO_NODE) {
+    return operand.value;
+  }
+  return builder->bindings[operand.symbol];
+}
+
+static smith_ir_instruction_t *build_constant(builder_t *builder,
+                                              smith_constant_t constant) {
+  return append(&builder->function, &builder->function.blocks[0],
+                (smith_ir_instruction_t){.opcode = SMITH_IR_OPCODE_CONSTANT,
+                                         .type = constant.kind,
+                                         .constant = constant.value});
+}
+
+static smith_ir_instruction_t *
+build_binary_operator(builder_t *builder, smith_binary_operator_kind_t kind,
+                      operand_t left, operand_t right) {
+  smith_ir_instruction_t *value = read_operand(builder, right);
+  if (value == nullptr) {
+    return nullptr;
+  }
+  if (kind == SMITH_BINARY_OPERATOR_KIND_ASSIGN) {
+    if (left.symbol == SMITH_DAG_NO_NODE) {
+      return nullptr;
+    }
+    smith_ir_instruction_t **binding = &builder->bindings[left.symbol];
+    if (*binding != nullptr && (*binding)->type != value->type) {
+      return nullptr;
+    }
+    *binding = value;
+    return value;
+  }
+  bool assigns = kind == SMITH_BINARY_OPERATOR_KIND_ADD_ASSIGN ||
+                 kind == SMITH_BINARY_OPERATOR_KIND_SUB_ASSIGN ||
+                 kind == SMITH_BINARY_OPERATOR_KIND_MUL_ASSIGN ||
+                 kind == SMITH_BINARY_OPERATOR_KIND_DIV_ASSIGN;
+  if (assigns && left.symbol == SMITH_DAG_NO_NODE) {
+    return nullptr;
+  }
+  smith_ir_instruction_t *target = read_operand(builder, left);
+  smith_ir_opcode_t opcode;
+  smith_constant_kind_t type;
+  if (target == nullptr || target->type != value->type ||
+      !select_opcode(kind, value->type, &opcode, &type)) {
+    return nullptr;
+  }
+  smith_ir_instruction_t *result =
+      append(&builder->function, &builder->function.blocks[0],
+             (smith_ir_instruction_t){
+                 .opcode = opcode, .type = type, .operands = {target, value}});
+  if (assigns) {
+    builder->bindings[left.symbol] = result;
+  }
+  return result;
+}
+
+static bool build_instructions(builder_t *builder, smith_ast_node_t root,
+                               const smith_bytecode_parameter_t *parameters) {
+  const smith_ast_t *ast = builder->ast;
+  smith_ir_function_t *function = &builder->function;
+  for (uint32_t i = 0; i < function->parameter_count; i++) {
+    builder->bindings[i] = append(
+        function, &function->blocks[0],
+        (smith_ir_instruction_t){.opcode = SMITH_IR_OPCODE_PARAMETER,
+                                 .type = parameters[i].kind,
+                                 .parameter = i});
+    if (builder->bindings[i] == nullptr) {
+      return false;
+    }
+  }
+  for (smith_ast_node_t node = builder->first; node <= root; node++) {
+    operand_t *operand = &builder->operands[node - builder->first];
+    *operand = (operand_t){.symbol = builder->symbols[node - builder->first]};
+    smith_ast_payload_t payload = ast->payloads[node];
+    switch ((smith_expression_kind_t)ast->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_SYMBOL:
+      // The DAG node was found before building.
+      continue;
+    case SMITH_EXPRESSION_KIND_INT:
+    case SMITH_EXPRESSION_KIND_FLOAT: {
+      smith_constant_result_t constant_result = smith_constant_from_literal(
+          (smith_expression_kind_t)ast->kinds[node], payload.leaf.text);
+      if (!constant_result.success) {
+        return false;
+      }
+      operand->value = build_constant(builder, constant_result.constant);
+      break;
+    }
+    case SMITH_EXPRESSION_KIND_CONSTANT:
+      operand->value = build_constant(builder, payload.constant);
+      break;
+    case SMITH_EXPRESSION_KIND_BINARY_OPERATOR: {
+      smith_ast_children_t children = ast->children[node];
+      operand->value = build_binary_operator(
+          builder, payload.binary_operator.kind,
+          builder->operands[children.left - builder->first],
+          builder->operands[children.right - builder->first]);
+      break;
+    }
+    }
+    if (operand->value == nullptr) {
+      return false;
+    }
+  }
+  smith_ir_instruction_t *result =
+      read_operand(builder, builder->operands[root - builder->first]);
+  return result != nullptr &&
+         append(function, &function->blocks[0],
+                (smith_ir_instruction_t){.opcode = SMITH_IR_OPCODE_RETURN,
+                                         .type = result->type,
+                                         .operands = {result}}) != nullptr;
+}
+
+static smith_string_t parameter_name(const void *parameters, uint32_t index) {
+  return ((const smith_bytecode_parameter_t *)parameters)[index].name;
+}
+
+smith_ir_build_result_t
+smith_ir_build(smith_allocator_t allocator, const smith_ast_t *ast,
+               smith_ast_node_t root,
+               const smith_bytecode_parameter_t *parameters,
+               uint32_t parameter_count) {
+  smith_arena_allocator_create_result_t arena_result =
+      smith_arena_allocator_create(allocator);
+  if (!arena_result.success) {
+    return (smith_ir_build_result_t){};
+  }
+  builder_t builder = {.function = {.allocator = allocator,
+                                    .arena = arena_result.allocator,
+                                    .parameter_count = parameter_count},
+                       .ast = ast,
+                       .first = smith_ast_first(ast, root),
+                       .dag = smith_dag_create(allocator)};
+  size_t node_count = root - builder.first + 1;
+  builder.operands =
+      smith_allocator_allocate_array(allocator, operand_t, node_count);
+  builder.symbols =
+      smith_allocator_allocate_array(allocator, smith_dag_node_t, node_count);
+  builder.function.blocks =
+      smith_allocator_allocate(builder.function.arena, smith_ir_block_t);
+  bool success = builder.operands != nullptr && builder.symbols != nullptr &&
+                 builder.function.blocks != nullptr &&
+                 smith_dag_number_symbols(&builder.dag, ast, root, parameters,
+                                          parameter_count, parameter_name,
+                                          builder.symbols);
+  if (success) {
+    builder.function.blocks[0] = (smith_ir_block_t){};
+    builder.function.block_count = 1;
+    size_t symbol_count = builder.dag.count;
+    builder.bindings = smith_allocator_allocate_array(
+        allocator, smith_ir_instruction_t *, symbol_count);
+    success = builder.bindings != nullptr;
+  }
+  if (success) {
+    for (uint32_t i = 0; i < builder.dag.count; i++) {
+      builder.bindings[i] = nullptr;
+    }
+    success = build_instructions(&builder, root, parameters);
+  }
+  smith_allocator_deallocate(allocator, builder.bindings);
+  smith_allocator_deallocate(allocator, builder.symbols);
+  smith_allocator_deallocate(allocator, builder.operands);
+  smith_dag_destroy(builder.dag);
+  if (!success) {
+    smith_ir_function_destroy(builder.function);
+    return (smith_ir_build_result_t){};
+  }
+  return (smith_ir_build_result_t){.function = builder.function,
+                                   .success = true};
+}
+
+static smith_binary_operator_kind_t operator_kind(smith_ir_opcode_t opcode) {
+  switch (opcode) {
+  case SMITH_IR_OPCODE_ADD:
+    return SMITH_BINARY_OPERATOR_KIND_ADD;
+  case SMITH_IR_OPCODE_SUB:
+    return SMITH_BINARY_OPERATOR_KIND_SUB;
+  case SMITH_IR_OPCODE_MUL:
+    return SMITH_BINARY_OPERATOR_KIND_MUL;
+  case SMITH_IR_OPCODE_DIV:
+    return SMITH_BINARY_OPERATOR_KIND_DIV;
+  case SMITH_IR_OPCODE_EQ:
+    return SMITH_BINARY_OPERATOR_KIND_EQ;
+  case SMITH_IR_OPCODE_NOT_EQ:
+    return SMITH_BINARY_OPERATOR_KIND_NOT_EQ;
+  case SMITH_IR_OPCODE_LT:
+    return SMITH_BINARY_OPERATOR_KIND_LT;
+  case SMITH_IR_OPCODE_LE:
+    return SMITH_BINARY_OPERATOR_KIND_LE;
+  case SMITH_IR_OPCODE_GT:
+    return SMITH_BINARY_OPERATOR_KIND_GT;
+  default:
+    return SMITH_BINARY_OPERATOR_KIND_GE;
+  }
+}
+
+static smith_constant_result_t fold(const smith_ir_instruction_t *instruction) {
+  const smith_ir_instruction_t *left = instruction->operands[0];
+  const smith_ir_instruction_t *right = instruction->operands[1];
+  smith_constant_value_t value = {};
+  switch (instruction->opcode) {
+  case SMITH_IR_OPCODE_BIT_AND:
+    value.int_ = left->constant.int_ & right->constant.int_;
+    break;
+  case SMITH_IR_OPCODE_BIT_OR:
+    value.int_ = left->constant.int_ | right->constant.int_;
+    break;
+  case SMITH_IR_OPCODE_AND:
+    value.bool_ = left->constant.bool_ && right->constant.bool_;
+    break;
+  case SMITH_IR_OPCODE_OR:
+    value.bool_ = left->constant.bool_ || right->constant.bool_;
+    break;
+  default:
+    return smith_constant_fold(
+        operator_kind(instruction->opcode),
+        (smith_constant_t){.kind = left->type, .value = left->constant},
+        (smith_constant_t){.kind = right->type, .value = right->constant});
+  }
+  return (smith_constant_result_t){
+      .constant = {.kind = instruction->type, .value = value},
+      .success = true};
+}
+
+// Instructions are in order in their blocks and operands come before their
+// uses, so one pass sees every operand already folded.
+void smith_ir_propagate_constants(smith_ir_function_t *function) {
+  for (uint32_t i = 0; i < function->block_count; i++) {
+    for (smith_ir_instruction_t *instruction = function->blocks[i].first;
+         instruction != nullptr; instruction = instruction->next) {
+      if (!is_operator(instruction->opcode) ||
+          instruction->operands[0]->opcode != SMITH_IR_OPCODE_CONSTANT ||
+          instruction->operands[1]->opcode != SMITH_IR_OPCODE_CONSTANT) {
+        continue;
+      }
+      smith_constant_result_t fold_result = fold(instruction);
+      if (fold_result.success) {
+        instruction->opcode = SMITH_IR_OPCODE_CONSTANT;
+        instruction->constant = fold_result.constant.value;
+        instruction->operands[0] = nullptr;
+        instruction->operands[1] = nullptr;
+      }
+    }
+  }
+}
+
+static bool is_commutative(smith_ir_opcode_t opcode) {
+  switch (opcode) {
+  case SMITH_IR_OPCODE_ADD:
+  case SMITH_IR_OPCODE_MUL:
+  case SMITH_IR_OPCODE_EQ:
+  case SMITH_IR_OPCODE_NOT_EQ:
+  case SMITH_IR_OPCODE_BIT_AND:
+  case SMITH_IR_OPCODE_BIT_OR:
+  case SMITH_IR_OPCODE_AND:
+  case SMITH_IR_OPCODE_OR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// The bits of a constant that make up its value. Only the first byte of a
+// bool is meaningful.
+static uint64_t constant_bits(const smith_ir_instruction_t *instruction) {
+  if (instruction->type == SMITH_CONSTANT_KIND_BOOL) {
+    return instruction->constant.bool_;
+  }
+  uint64_t bits;
+  memcpy(&bits, &instruction->constant, sizeof(bits));
+  return bits;
+}
+
+static uint64_t hash_instruction(const smith_ir_instruction_t *instruction) {
+  uint64_t hash = (uint64_t)instruction->opcode * 0x9E3779B97F4A7C15u ^
+                  (uint64_t)instruction->type;
+  switch (instruction->opcode) {
+  case SMITH_IR_OPCODE_PARAMETER:
+    hash ^= instruction->parameter;
+    break;
+  case SMITH_IR_OPCODE_CONSTANT:
+    hash ^= constant_bits(instruction);
+    break;
+  default:
+    hash ^= (uint64_t)instruction->operands[0]->id << 32 |
+            instruction->operands[1]->id;
+  }
+  hash *= 0xFF51AFD7ED558CCDu;
+  return hash ^ hash >> 32;
+}
+
+static bool equal_instructions(const smith_ir_instruction_t *a,
+                               const smith_ir_instruction_t *b) {
+  if (a->opcode != b->opcode || a->type != b->type) {
+    return false;
+  }
+  switch (a->opcode) {
+  case SMITH_IR_OPCODE_PARAMETER:
+    return a->parameter == b->parameter;
+  case SMITH_IR_OPCODE_CONSTANT:
+    return constant_bits(a) == constant_bits(b);
+  default:
+    return a->operands[0] == b->operands[0] &&
+           a->operands[1] == b->operands[1];
+  }
+}
+
+// Values are numbered by hashing each instruction once its operands are
+// replaced by their numbered values. Returns end blocks and are never
+// numbered.
+bool smith_ir_eliminate_common_subexpressions(smith_ir_function_t *function) {
+  smith_allocator_t allocator = function->allocator;
+  size_t capacity = 64;
+  while (capacity < (size_t)function->value_count * 2) {
+    capacity *= 2;
+  }
+  smith_ir_instruction_t **table = smith_allocator_allocate_array(
+      allocator, smith_ir_instruction_t *, capacity);
+  size_t value_count = function->value_count;
+  smith_ir_instruction_t **replacements = smith_allocator_allocate_array(
+      allocator, smith_ir_instruction_t *, value_count);
+  if (table == nullptr || (value_count > 0 && replacements == nullptr)) {
+    smith_allocator_deallocate(allocator, table);
+    smith_allocator_deallocate(allocator, replacements);
+    return false;
+  }
+  memset(table, 0, capacity * sizeof(*table));
+  for (uint32_t i = 0; i < function->block_count; i++) {
+    smith_ir_instruction_t *next;
+    for (smith_ir_instruction_t *instruction = function->blocks[i].first;
+         instruction != nullptr; instruction = next) {
+      next = instruction->next;
+      replacements[instruction->id] = instruction;
+      for (size_t j = 0; j < 2; j++) {
+        smith_ir_instruction_t *operand = instruction->operands[j];
+        if (operand != nullptr) {
+          instruction->operands[j] = replacements[operand->id];
+        }
+      }
+      if (instruction->opcode == SMITH_IR_OPCODE_RETURN) {
+        continue;
+      }
+      if (is_commutative(instruction->opcode) &&
+          instruction->operands[0]->id > instruction->operands[1]->id) {
+        smith_ir_instruction_t *operand = instruction->operands[0];
+        instruction->operands[0] = instruction->operands[1];
+        instruction->operands[1] = operand;
+      }
+      size_t slot = hash_instruction(instruction) & (capacity - 1);
+      while (table[slot] != nullptr &&
+             !equal_instructions(table[slot], instruction)) {
+        slot = (slot + 1) & (capacity - 1);
+      }
+      if (table[slot] == nullptr) {
+        table[slot] = instruction;
+      } else {
+        replacements[instruction->id] = table[slot];
+        unlink_instruction(instruction);
+      }
+    }
+  }
+  smith_allocator_deallocate(allocator, replacements);
+  smith_allocator_deallocate(allocator, table);
+  return true;
+}
+
+static bool may_trap(const smith_ir_instruction_t *instruction) {
+  switch (instruction->opcode) {
+  case SMITH_IR_OPCODE_ADD:
+  case SMITH_IR_OPCODE_SUB:
+  case SMITH_IR_OPCODE_MUL:
+  case SMITH_IR_OPCODE_DIV:
+    return instruction->type == SMITH_CONSTANT_KIND_INT;
+  default:
+    return false;
+  }
+}
+
+// Uses come after definitions, so walking each block backwards sees every
+// use of a value before the value itself.
+bool smith_ir_eliminate_dead_code(smith_ir_function_t *function) {
+  smith_allocator_t allocator = function->allocator;
+  size_t value_count = function->value_count;
+  bool *live = smith_allocator_allocate_array(allocator, bool, value_count);
+  if (value_count > 0 && live == nullptr) {
+    return false;
+  }
+  for (size_t i = 0; i < value_count; i++) {
+    live[i] = false;
+  }
+  for (uint32_t i = function->block_count; i-- > 0;) {
+    smith_ir_instruction_t *previous;
+    for (smith_ir_instruction_t *instruction = function->blocks[i].last;
+         instruction != nullptr; instruction = previous) {
+      previous = instruction->previous;
+      if (instruction->opcode != SMITH_IR_OPCODE_RETURN &&
+          !live[instruction->id] && !may_trap(instruction)) {
+        unlink_instruction(instruction);
+        continue;
+      }
+      for (size_t j = 0; j < 2; j++) {
+        if (instruction->operands[j] != nullptr) {
+          live[instruction->operands[j]->id] = true;
+        }
+      }
+    }
+  }
+  smith_allocator_deallocate(allocator, live);
+  return true;
+}
+
+static uint64_t now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+bool smith_ir_optimize(smith_ir_function_t *function,
+                       smith_ir_pass_timings_t *timings) {
+  uint64_t start = now();
+  smith_ir_propagate_constants(function);
+  uint64_t propagated = now();
+  bool success = smith_ir_eliminate_common_subexpressions(function);
+  uint64_t eliminated = now();
+  success = smith_ir_eliminate_dead_code(function) && success;
+  uint64_t end = now();
+  if (timings != nullptr) {
+    timings->constant_propagation += propagated - start;
+    timings->common_subexpression_elimination += eliminated - propagated;
+    timings->dead_code_elimination += end - eliminated;
+  }
+  return success;
+}
+
+// The bytecode for each operator and operand type.
+static const smith_opcode_t opcodes[][SMITH_CONSTANT_KIND_BOOL + 1] = {
+    [SMITH_IR_OPCODE_ADD] = {SMITH_OPCODE_INT_ADD, SMITH_OPCODE_FLOAT_ADD},
+    [SMITH_IR_OPCODE_SUB] = {SMITH_OPCODE_INT_SUB, SMITH_OPCODE_FLOAT_SUB},
+    [SMITH_IR_OPCODE_MUL] = {SMITH_OPCODE_INT_MUL, SMITH_OPCODE_FLOAT_MUL},
+    [SMITH_IR_OPCODE_DIV] = {SMITH_OPCODE_INT_DIV, SMITH_OPCODE_FLOAT_DIV},
+    [SMITH_IR_OPCODE_EQ] = {SMITH_OPCODE_INT_EQ, SMITH_OPCODE_FLOAT_EQ,
+                            SMITH_OPCODE_BOOL_EQ},
+    [SMITH_IR_OPCODE_NOT_EQ] = {SMITH_OPCODE_INT_NOT_EQ,
+                                SMITH_OPCODE_FLOAT_NOT_EQ,
+                                SMITH_OPCODE_BOOL_NOT_EQ},
+    [SMITH_IR_OPCODE_LT] = {SMITH_OPCODE_INT_LT, SMITH_OPCODE_FLOAT_LT},
+    [SMITH_IR_OPCODE_LE] = {SMITH_OPCODE_INT_LE, SMITH_OPCODE_FLOAT_LE},
+    [SMITH_IR_OPCODE_GT] = {SMITH_OPCODE_INT_GT, SMITH_OPCODE_FLOAT_GT},
+    [SMITH_IR_OPCODE_GE] = {SMITH_OPCODE_INT_GE, SMITH_OPCODE_FLOAT_GE},
+    [SMITH_IR_OPCODE_BIT_AND] = {SMITH_OPCODE_INT_BIT_AND},
+    [SMITH_IR_OPCODE_BIT_OR] = {SMITH_OPCODE_INT_BIT_OR},
+    [SMITH_IR_OPCODE_AND] = {[SMITH_CONSTANT_KIND_BOOL] =
+                                 SMITH_OPCODE_BOOL_AND},
+    [SMITH_IR_OPCODE_OR] = {[SMITH_CONSTANT_KIND_BOOL] = SMITH_OPCODE_BOOL_OR},
+};
+
+typedef struct {
+  smith_bytecode_t bytecode;
+  // The register of each value and the position of its last use, by id.
+  uint32_t *registers;
+  uint32_t *last_uses;
+  // Temporaries free to reuse, as a stack.
+  uint32_t *free;
+  uint32_t free_count;
+  uint32_t temporaries;
+} lowering_t;
+
+static bool allocate_temporary(lowering_t *lowering, uint32_t *register_) {
+  if (lowering->free_count > 0) {
+    *register_ = lowering->free[--lowering->free_count];
+    return true;
+  }
+  if (lowering->bytecode.register_count >= SMITH_BYTECODE_MAX_REGISTERS) {
+    return false;
+  }
+  *register_ = lowering->bytecode.register_count++;
+  return true;
+}
+
+static void release(lowering_t *lowering, const smith_ir_instruction_t *value,
+                    uint32_t position) {
+  uint32_t register_ = lowering->registers[value->id];
+  if (register_ >= lowering->temporaries &&
+      lowering->last_uses[value->id] == position) {
+    lowering->free[lowering->free_count++] = register_;
+  }
+}
+
+// Lays out the registers as the compiler does, then emits the instructions,
+// each operator into a temporary freed after the last use of its value.
+static bool lower(lowering_t *lowering, const smith_ir_block_t *block) {
+  smith_bytecode_t *bytecode = &lowering->bytecode;
+  uint32_t constant_count = 0;
+  uint32_t position = 0;
+  for (const smith_ir_instruction_t *instruction = block->first;
+       instruction != nullptr; instruction = instruction->next) {
+    lowering->last_uses[instruction->id] = position;
+    for (size_t j = 0; j < 2; j++) {
+      if (instruction->operands[j] != nullptr) {
+        lowering->last_uses[instruction->operands[j]->id] = position;
+      }
+    }
+    if (instruction->opcode == SMITH_IR_OPCODE_CONSTANT) {
+      constant_count++;
+    } else if (instruction->opcode != SMITH_IR_OPCODE_PARAMETER) {
+      bytecode->count++;
+    }
+    position++;
+  }
+  bytecode->constants = smith_allocator_allocate_array(
+      bytecode->allocator, smith_constant_value_t, constant_count);
+  bytecode->instructions = smith_allocator_allocate_array(
+      bytecode->allocator, smith_instruction_t, bytecode->count);
+  uint64_t temporaries = (uint64_t)bytecode->parameter_count + constant_count;
+  if ((constant_count > 0 && bytecode->constants == nullptr) ||
+      bytecode->instructions == nullptr ||
+      temporaries > SMITH_BYTECODE_MAX_REGISTERS) {
+    return false;
+  }
+  bytecode->capacity = bytecode->count;
+  bytecode->count = 0;
+  lowering->temporaries = (uint32_t)temporaries;
+  bytecode->register_count = lowering->temporaries;
+  position = 0;
+  for (const smith_ir_instruction_t *instruction = block->first;
+       instruction != nullptr; instruction = instruction->next, position++) {
+    uint32_t *register_ = &lowering->registers[instruction->id];
+    switch (instruction->opcode) {
+    case SMITH_IR_OPCODE_PARAMETER:
+      *register_ = instruction->parameter;
+      continue;
+    case SMITH_IR_OPCODE_CONSTANT:
+      *register_ = bytecode->parameter_count + bytecode->constant_count;
+      bytecode->constants[bytecode->constant_count++] = instruction->constant;
+      continue;
+    case SMITH_IR_OPCODE_RETURN:
+      bytecode->result_kind = instruction->type;
+      bytecode->instructions[bytecode->count++] = (smith_instruction_t){
+          .opcode = SMITH_OPCODE_RETURN,
+          .left = lowering->registers[instruction->operands[0]->id]};
+      continue;
+    default:
+      break;
+    }
+    const smith_ir_instruction_t *left = instruction->operands[0];
+    const smith_ir_instruction_t *right = instruction->operands[1];
+    smith_instruction_t lowered = {
+        .opcode = opcodes[instruction->opcode][left->type],
+        .left = lowering->registers[left->id],
+        .right = lowering->registers[right->id]};
+    // The operands are read before the destination is written, so the
+    // destination can reuse an operand's register.
+    release(lowering, left, position);
+    if (right != left) {
+      release(lowering, right, position);
+    }
+    if (!allocate_temporary(lowering, register_)) {
+      return false;
+    }
+    lowered.destination = *register_;
+    bytecode->instructions[bytecode->count++] = lowered;
+    // A value nothing reads frees its register at once.
+    release(lowering, instruction, position);
+  }
+  return true;
+}
+
+smith_bytecode_compile_result_t
+smith_ir_to_bytecode(smith_allocator_t allocator,
+                     const smith_ir_function_t *function) {
+  size_t value_count = function->value_count;
+  lowering_t lowering = {
+      .bytecode = {.allocator = allocator,
+                   .parameter_count = function->parameter_count},
+      .registers =
+          smith_allocator_allocate_array(allocator, uint32_t, value_count),
+      .last_uses =
+          smith_allocator_allocate_array(allocator, uint32_t, value_count),
+      .free = smith_allocator_allocate_array(allocator, uint32_t, value_count)};
+  bool success = function->block_count == 1 && lowering.registers != nullptr &&
+                 lowering.last_uses != nullptr && lowering.free != nullptr &&
+                 lower(&lowering, &function->blocks[0]);
+  smith_allocator_deallocate(allocator, lowering.free);
+  smith_allocator_deallocate(allocator, lowering.last_uses);
+  smith_allocator_deallocate(allocator, lowering.registers);
+  if (!success) {
+    smith_bytecode_destroy(lowering.bytecode);
+    return (smith_bytecode_compile_result_t){};
+  }
+  return (smith_bytecode_compile_result_t){.bytecode = lowering.bytecode,
+                                           .success = true};
+}
+
+void smith_ir_function_destroy(smith_ir_function_t function) {
+  smith_allocator_destroy(function.arena);
+}
@@ -0,0 +1,721 @@
+// For `MAP_ANONYMOUS`, which strict C modes hide.
+#define _DEFAULT_SOURCE 1
+
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/jit.h"
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__unix__)
+
+#include <sys/mman.h>
+
+enum {
+  RAX,
+  RCX,
+  RDX,
+  RBX,
+  RSP,
+  RBP,
+  RSI,
+  RDI,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15,
+};
+
+// `rdi` points at the register file. `rax`, `rdx` and `r11`, and `xmm0` and
+// `xmm1`, hold operands while an instruction is computed, so they are never
+// allocated.
+static const uint8_t allocatable_gprs[] = {RCX, RSI, R8,  R9,  R10,
+                                           RBX, R12, R13, R14, R15};
+static const uint8_t allocatable_xmms[] = {2, 3,  4,  5,  6,  7,  8,
+                                           9, 10, 11, 12, 13, 14, 15};
+
+#define GPR_COUNT (sizeof(allocatable_gprs) / sizeof(allocatable_gprs[0]))
+#define XMM_COUNT (sizeof(allocatable_xmms) / sizeof(allocatable_xmms[0]))
+
+static bool is_callee_saved(uint8_t gpr) {
+  return gpr == RBX || gpr >= R12;
+}
+
+typedef enum {
+  LOCATION_GPR,
+  LOCATION_XMM,
+  LOCATION_MEMORY,
+} location_kind_t;
+
+// Where a value lives: a machine register, or its register's slot in the
+// register file.
+typedef struct {
+  location_kind_t kind;
+  uint8_t number;
+  int32_t displacement;
+} location_t;
+
+static location_t gpr(uint8_t number) {
+  return (location_t){.kind = LOCATION_GPR, .number = number};
+}
+
+static location_t xmm(uint8_t number) {
+  return (location_t){.kind = LOCATION_XMM, .number = number};
+}
+
+static location_t memory(uint32_t register_) {
+  return (location_t){.kind = LOCATION_MEMORY,
+                      .displacement =
+                          (int32_t)(register_ * sizeof(smith_constant_value_t))};
+}
+
+#define NO_RANGE UINT32_MAX
+
+// The live range of one value of a bytecode register: from the instruction
+// that writes it, or its first read for a parameter or constant, to its last
+// read. Reads are at position `2 * i` and writes at `2 * i + 1`, so a value
+// whose last read is at an instruction can hand its machine register to the
+// value that instruction writes.
+typedef struct {
+  uint32_t register_;
+  uint32_t start;
+  uint32_t end;
+  bool is_float;
+  bool live_in;
+  bool loaded;
+  location_t location;
+} range_t;
+
+// The ranges each instruction reads and writes.
+typedef struct {
+  uint32_t left;
+  uint32_t right;
+  uint32_t destination;
+} operands_t;
+
+static bool reads_right(smith_opcode_t opcode) {
+  return opcode != SMITH_OPCODE_MOVE && opcode != SMITH_OPCODE_RETURN;
+}
+
+static bool is_float_operation(smith_opcode_t opcode) {
+  return opcode >= SMITH_OPCODE_FLOAT_ADD && opcode <= SMITH_OPCODE_FLOAT_GE;
+}
+
+static uint32_t read_range(range_t *ranges, size_t *range_count,
+                           uint32_t *current, uint32_t register_,
+                           uint32_t position, bool is_float) {
+  uint32_t range = current[register_];
+  if (range == NO_RANGE) {
+    range = (uint32_t)(*range_count)++;
+    ranges[range] = (range_t){.register_ = register_,
+                              .start = position,
+                              .is_float = is_float,
+                              .live_in = true};
+    current[register_] = range;
+  }
+  ranges[range].end = position;
+  return range;
+}
+
+// Splits the registers into live ranges, in order of their starts.
+static size_t build_ranges(const smith_bytecode_t *bytecode, range_t *ranges,
+                           operands_t *operands, uint32_t *current) {
+  size_t range_count = 0;
+  for (uint32_t i = 0; i < bytecode->register_count; i++) {
+    current[i] = NO_RANGE;
+  }
+  for (size_t i = 0; i < bytecode->count; i++) {
+    smith_instruction_t instruction = bytecode->instructions[i];
+    smith_opcode_t opcode = instruction.opcode;
+    bool is_float = is_float_operation(opcode);
+    uint32_t position = (uint32_t)(2 * i);
+    operands[i].left = read_range(ranges, &range_count, current,
+                                  instruction.left, position, is_float);
+    operands[i].right = NO_RANGE;
+    operands[i].destination = NO_RANGE;
+    if (reads_right(opcode)) {
+      operands[i].right = read_range(ranges, &range_count, current,
+                                     instruction.right, position, is_float);
+    }
+    if (opcode == SMITH_OPCODE_RETURN) {
+      continue;
+    }
+    bool writes_float = opcode == SMITH_OPCODE_MOVE
+                            ? ranges[operands[i].left].is_float
+                            : opcode <= SMITH_OPCODE_FLOAT_DIV && is_float;
+    uint32_t range = (uint32_t)range_count++;
+    ranges[range] = (range_t){.register_ = instruction.destination,
+                              .start = position + 1,
+                              .end = position + 1,
+                              .is_float = writes_float};
+    operands[i].destination = range;
+    current[instruction.destination] = range;
+  }
+  return range_count;
+}
+
+// Gives each range a machine register of its class while one is free. When
+// none is, the range that ends last, this one or an active one, stays in
+// memory.
+static uint32_t allocate_registers(range_t *ranges, size_t range_count) {
+  uint32_t active[GPR_COUNT + XMM_COUNT];
+  size_t active_count = 0;
+  bool gpr_used[GPR_COUNT] = {};
+  bool xmm_used[XMM_COUNT] = {};
+  uint32_t callee_saved = 0;
+  for (uint32_t i = 0; i < range_count; i++) {
+    range_t *range = &ranges[i];
+    size_t kept = 0;
+    for (size_t j = 0; j < active_count; j++) {
+      range_t *other = &ranges[active[j]];
+      if (other->end < range->start) {
+        bool *pool = other->is_float ? xmm_used : gpr_used;
+        pool[other->location.displacement] = false;
+      } else {
+        active[kept++] = active[j];
+      }
+    }
+    active_count = kept;
+    bool *used = range->is_float ? xmm_used : gpr_used;
+    const uint8_t *registers =
+        range->is_float ? allocatable_xmms : allocatable_gprs;
+    size_t count = range->is_float ? XMM_COUNT : GPR_COUNT;
+    // While allocating, a location's displacement holds its index in the pool.
+    size_t index = 0;
+    while (index < count && used[index]) {
+      index++;
+    }
+    if (index == count) {
+      uint32_t victim = NO_RANGE;
+      for (size_t j = 0; j < active_count; j++) {
+        range_t *other = &ranges[active[j]];
+        if (other->is_float == range->is_float &&
+            (victim == NO_RANGE || other->end > ranges[active[victim]].end)) {
+          victim = (uint32_t)j;
+        }
+      }
+      range_t *spilled = &ranges[active[victim]];
+      if (spilled->end <= range->end) {
+        range->location = memory(range->register_);
+        continue;
+      }
+      index = (size_t)spilled->location.displacement;
+      spilled->location = memory(spilled->register_);
+      active[victim] = active[--active_count];
+    }
+    used[index] = true;
+    range->location = (location_t){
+        .kind = range->is_float ? LOCATION_XMM : LOCATION_GPR,
+        .number = registers[index],
+        .displacement = (int32_t)index};
+    active[active_count++] = i;
+    if (!range->is_float && is_callee_saved(registers[index])) {
+      callee_saved |= 1u << registers[index];
+    }
+  }
+  return callee_saved;
+}
+
+typedef struct {
+  uint8_t *code;
+  size_t count;
+  size_t trap;
+  uint32_t callee_saved;
+} emitter_t;
+
+static void byte(emitter_t *emitter, uint8_t value) {
+  emitter->code[emitter->count++] = value;
+}
+
+static void int32(emitter_t *emitter, int32_t value) {
+  memcpy(emitter->code + emitter->count, &value, sizeof(value));
+  emitter->count += sizeof(value);
+}
+
+// Emits an instruction with a ModRM byte: `reg` in its register field and
+// `rm` as its register or memory operand. Memory operands are always
+// `[rdi + displacement]`.
+static void modrm(emitter_t *emitter, uint8_t prefix, bool wide,
+                  uint16_t opcode, uint8_t reg, location_t rm) {
+  if (prefix != 0) {
+    byte(emitter, prefix);
+  }
+  uint8_t rex = 0x40 | wide << 3 | (reg & 8) >> 1;
+  if (rm.kind != LOCATION_MEMORY) {
+    rex |= (rm.number & 8) >> 3;
+  }
+  if (rex != 0x40) {
+    byte(emitter, rex);
+  }
+  if (opcode > 0xFF) {
+    byte(emitter, opcode >> 8);
+  }
+  byte(emitter, opcode & 0xFF);
+  if (rm.kind == LOCATION_MEMORY) {
+    byte(emitter, 0x80 | (reg & 7) << 3 | RDI);
+    int32(emitter, rm.displacement);
+  } else {
+    byte(emitter, 0xC0 | (reg & 7) << 3 | (rm.number & 7));
+  }
+}
+
+static void load_gpr(emitter_t *emitter, uint8_t target, location_t from) {
+  if (from.kind == LOCATION_XMM) {
+    modrm(emitter, 0x66, true, 0x0F7E, from.number, gpr(target));
+  } else if (from.kind == LOCATION_MEMORY || from.number != target) {
+    modrm(emitter, 0, true, 0x8B, target, from);
+  }
+}
+
+static void store_gpr(emitter_t *emitter, location_t to, uint8_t source) {
+  if (to.kind == LOCATION_XMM) {
+    modrm(emitter, 0x66, true, 0x0F6E, to.number, gpr(source));
+  } else if (to.kind == LOCATION_MEMORY) {
+    modrm(emitter, 0, true, 0x89, source, to);
+  } else if (to.number != source) {
+    modrm(emitter, 0, true, 0x8B, to.number, gpr(source));
+  }
+}
+
+static void load_xmm(emitter_t *emitter, uint8_t target, location_t from) {
+  if (from.kind == LOCATION_GPR) {
+    modrm(emitter, 0x66, true, 0x0F6E, target, from);
+  } else if (from.kind == LOCATION_MEMORY) {
+    modrm(emitter, 0xF2, false, 0x0F10, target, from);
+  } else if (from.number != target) {
+    modrm(emitter, 0x66, false, 0x0F28, target, from);
+  }
+}
+
+static void store_xmm(emitter_t *emitter, location_t to, uint8_t source) {
+  if (to.kind == LOCATION_GPR) {
+    modrm(emitter, 0x66, true, 0x0F7E, source, to);
+  } else if (to.kind == LOCATION_MEMORY) {
+    modrm(emitter, 0xF2, false, 0x0F11, source, to);
+  } else if (to.number != source) {
+    modrm(emitter, 0x66, false, 0x0F28, to.number, xmm(source));
+  }
+}
+
+// The location of a value about to be read. A parameter or constant given a
+// machine register is loaded from the register file on its first read.
+static location_t use(emitter_t *emitter, range_t *range) {
+  if (range->live_in && !range->loaded &&
+      range->location.kind != LOCATION_MEMORY) {
+    if (range->is_float) {
+      load_xmm(emitter, range->location.number, memory(range->register_));
+    } else {
+      load_gpr(emitter, range->location.number, memory(range->register_));
+    }
+    range->loaded = true;
+  }
+  return range->location;
+}
+
+// A general purpose register or memory operand holding the value.
+static location_t gpr_operand(emitter_t *emitter, location_t from,
+                              uint8_t scratch) {
+  if (from.kind != LOCATION_XMM) {
+    return from;
+  }
+  load_gpr(emitter, scratch, from);
+  return gpr(scratch);
+}
+
+// An SSE register or memory operand holding the value.
+static location_t xmm_operand(emitter_t *emitter, location_t from,
+                              uint8_t scratch) {
+  if (from.kind != LOCATION_GPR) {
+    return from;
+  }
+  load_xmm(emitter, scratch, from);
+  return xmm(scratch);
+}
+
+static void jump_to_trap(emitter_t *emitter, uint8_t condition) {
+  byte(emitter, 0x0F);
+  byte(emitter, condition);
+  int32(emitter, (int32_t)(emitter->trap - (emitter->count + 4)));
+}
+
+// Sets `al` from a condition code and widens it to `rax`.
+static void set_rax(emitter_t *emitter, uint8_t condition) {
+  byte(emitter, 0x0F);
+  byte(emitter, condition);
+  byte(emitter, 0xC0);
+  byte(emitter, 0x0F);
+  byte(emitter, 0xB6);
+  byte(emitter, 0xC0);
+}
+
+static void push_callee_saved(emitter_t *emitter) {
+  for (uint8_t gpr = 0; gpr <= R15; gpr++) {
+    if (emitter->callee_saved & 1u << gpr) {
+      if (gpr >= R8) {
+        byte(emitter, 0x41);
+      }
+      byte(emitter, 0x50 | (gpr & 7));
+    }
+  }
+}
+
+static void pop_callee_saved_and_return(emitter_t *emitter) {
+  for (uint8_t gpr = R15 + 1; gpr-- > 0;) {
+    if (emitter->callee_saved & 1u << gpr) {
+      if (gpr >= R8) {
+        byte(emitter, 0x41);
+      }
+      byte(emitter, 0x58 | (gpr & 7));
+    }
+  }
+  byte(emitter, 0xC3);
+}
+
+// Opcodes of `op rax, r/m64` and the SSE arithmetic instructions.
+static uint16_t gpr_opcode(smith_opcode_t opcode) {
+  switch (opcode) {
+  case SMITH_OPCODE_INT_ADD:
+    return 0x03;
+  case SMITH_OPCODE_INT_SUB:
+    return 0x2B;
+  case SMITH_OPCODE_INT_MUL:
+    return 0x0FAF;
+  case SMITH_OPCODE_INT_BIT_AND:
+  case SMITH_OPCODE_BOOL_AND:
+    return 0x23;
+  case SMITH_OPCODE_INT_BIT_OR:
+  case SMITH_OPCODE_BOOL_OR:
+    return 0x0B;
+  case SMITH_OPCODE_BOOL_EQ:
+  case SMITH_OPCODE_BOOL_NOT_EQ:
+    return 0x33;
+  default:
+    return 0x3B;
+  }
+}
+
+static uint16_t sse_opcode(smith_opcode_t opcode) {
+  switch (opcode) {
+  case SMITH_OPCODE_FLOAT_ADD:
+    return 0x0F58;
+  case SMITH_OPCODE_FLOAT_SUB:
+    return 0x0F5C;
+  case SMITH_OPCODE_FLOAT_MUL:
+    return 0x0F59;
+  default:
+    return 0x0F5E;
+  }
+}
+
+// The `setcc` opcode for each comparison.
+static uint8_t condition(smith_opcode_t opcode) {
+  switch (opcode) {
+  case SMITH_OPCODE_INT_EQ:
+  case SMITH_OPCODE_BOOL_EQ:
+    return 0x94;
+  case SMITH_OPCODE_INT_NOT_EQ:
+  case SMITH_OPCODE_BOOL_NOT_EQ:
+    return 0x95;
+  case SMITH_OPCODE_INT_LT:
+    return 0x9C;
+  case SMITH_OPCODE_INT_LE:
+    return 0x9E;
+  case SMITH_OPCODE_INT_GT:
+    return 0x9F;
+  case SMITH_OPCODE_INT_GE:
+    return 0x9D;
+  case SMITH_OPCODE_FLOAT_LT:
+  case SMITH_OPCODE_FLOAT_GT:
+    return 0x97;
+  default:
+    return 0x93;
+  }
+}
+
+static void emit_int_division(emitter_t *emitter, location_t left,
+                              location_t right) {
+  load_gpr(emitter, RAX, left);
+  location_t divisor = gpr_operand(emitter, right, R11);
+  // cmp divisor, 0; je trap; cmp divisor, -1; jne divide
+  modrm(emitter, 0, true, 0x83, 7, divisor);
+  byte(emitter, 0x00);
+  jump_to_trap(emitter, 0x84);
+  modrm(emitter, 0, true, 0x83, 7, divisor);
+  byte(emitter, 0xFF);
+  byte(emitter, 0x75);
+  byte(emitter, 19);
+  // movabs rdx, INT64_MIN; cmp rax, rdx; je trap
+  byte(emitter, 0x48);
+  byte(emitter, 0xBA);
+  uint64_t minimum = (uint64_t)INT64_MIN;
+  memcpy(emitter->code + emitter->count, &minimum, sizeof(minimum));
+  emitter->count += sizeof(minimum);
+  modrm(emitter, 0, true, 0x3B, RAX, gpr(RDX));
+  jump_to_trap(emitter, 0x84);
+  // divide: cqo; idiv divisor
+  byte(emitter, 0x48);
+  byte(emitter, 0x99);
+  modrm(emitter, 0, true, 0xF7, 7, divisor);
+}
+
+static void emit_instruction(emitter_t *emitter, smith_opcode_t opcode,
+                             range_t *ranges, operands_t operands) {
+  location_t left = use(emitter, &ranges[operands.left]);
+  location_t right = operands.right != NO_RANGE
+                         ? use(emitter, &ranges[operands.right])
+                         : left;
+  location_t destination = operands.destination != NO_RANGE
+                               ? ranges[operands.destination].location
+                               : left;
+  switch (opcode) {
+  case SMITH_OPCODE_MOVE:
+    if (ranges[operands.left].is_float) {
+      load_xmm(emitter, 0, left);
+      store_xmm(emitter, destination, 0);
+    } else {
+      load_gpr(emitter, RAX, left);
+      store_gpr(emitter, destination, RAX);
+    }
+    return;
+  case SMITH_OPCODE_INT_ADD:
+  case SMITH_OPCODE_INT_SUB:
+  case SMITH_OPCODE_INT_MUL:
+    load_gpr(emitter, RAX, left);
+    modrm(emitter, 0, true, gpr_opcode(opcode), RAX,
+          gpr_operand(emitter, right, RDX));
+    jump_to_trap(emitter, 0x80);
+    store_gpr(emitter, destination, RAX);
+    return;
+  case SMITH_OPCODE_INT_DIV:
+    emit_int_division(emitter, left, right);
+    store_gpr(emitter, destination, RAX);
+    return;
+  case SMITH_OPCODE_INT_BIT_AND:
+  case SMITH_OPCODE_INT_BIT_OR:
+    load_gpr(emitter, RAX, left);
+    modrm(emitter, 0, true, gpr_opcode(opcode), RAX,
+          gpr_operand(emitter, right, RDX));
+    store_gpr(emitter, destination, RAX);
+    return;
+  case SMITH_OPCODE_BOOL_AND:
+  case SMITH_OPCODE_BOOL_OR:
+    // Only the low byte of a bool is meaningful.
+    load_gpr(emitter, RAX, left);
+    modrm(emitter, 0, true, gpr_opcode(opcode), RAX,
+          gpr_operand(emitter, right, RDX));
+    byte(emitter, 0x0F);
+    byte(emitter, 0xB6);
+    byte(emitter, 0xC0);
+    store_gpr(emitter, destination, RAX);
+    return;
+  case SMITH_OPCODE_BOOL_EQ:
+  case SMITH_OPCODE_BOOL_NOT_EQ:
+    load_gpr(emitter, RAX, left);
+    modrm(emitter, 0, true, gpr_opcode(opcode), RAX,
+          gpr_operand(emitter, right, RDX));
+    // test al, al
+    byte(emitter, 0x84);
+    byte(emitter, 0xC0);
+    set_rax(emitter, condition(opcode));
+    store_gpr(emitter, destination, RAX);
+    return;
+  case SMITH_OPCODE_INT_EQ:
+  case SMITH_OPCODE_INT_NOT_EQ:
+  case SMITH_OPCODE_INT_LT:
+  case SMITH_OPCODE_INT_LE:
+  case SMITH_OPCODE_INT_GT:
+  case SMITH_OPCODE_INT_GE:
+    load_gpr(emitter, RAX, left);
+    modrm(emitter, 0, true, 0x3B, RAX, gpr_operand(emitter, right, RDX));
+    set_rax(emitter, condition(opcode));
+    store_gpr(emitter, destination, RAX);
+    return;
+  case SMITH_OPCODE_FLOAT_ADD:
+  case SMITH_OPCODE_FLOAT_SUB:
+  case SMITH_OPCODE_FLOAT_MUL:
+  case SMITH_OPCODE_FLOAT_DIV:
+    load_xmm(emitter, 0, left);
+    modrm(emitter, 0xF2, false, sse_opcode(opcode), 0,
+          xmm_operand(emitter, right, 1));
+    store_xmm(emitter, destination, 0);
+    return;
+  case SMITH_OPCODE_FLOAT_EQ:
+  case SMITH_OPCODE_FLOAT_NOT_EQ: {
+    load_xmm(emitter, 0, left);
+    modrm(emitter, 0x66, false, 0x0F2E, 0, xmm_operand(emitter, right, 1));
+    // An unordered comparison sets the parity flag: NaN equals nothing.
+    bool equal = opcode == SMITH_OPCODE_FLOAT_EQ;
+    byte(emitter, 0x0F);
+    byte(emitter, equal ? 0x94 : 0x95);
+    byte(emitter, 0xC0);
+    byte(emitter, 0x0F);
+    byte(emitter, equal ? 0x9B : 0x9A);
+    byte(emitter, 0xC2);
+    byte(emitter, equal ? 0x20 : 0x08);
+    byte(emitter, 0xD0);
+    byte(emitter, 0x0F);
+    byte(emitter, 0xB6);
+    byte(emitter, 0xC0);
+    store_gpr(emitter, destination, RAX);
+    return;
+  }
+  case SMITH_OPCODE_FLOAT_LT:
+  case SMITH_OPCODE_FLOAT_LE:
+  case SMITH_OPCODE_FLOAT_GT:
+  case SMITH_OPCODE_FLOAT_GE: {
+    // `a < b` is computed as `b > a`, since only "above" conditions are
+    // false for unordered operands.
+    bool swap =
+        opcode == SMITH_OPCODE_FLOAT_LT || opcode == SMITH_OPCODE_FLOAT_LE;
+    load_xmm(emitter, 0, swap ? right : left);
+    modrm(emitter, 0x66, false, 0x0F2E, 0,
+          xmm_operand(emitter, swap ? left : right, 1));
+    set_rax(emitter, condition(opcode));
+    store_gpr(emitter, destination, RAX);
+    return;
+  }
+  case SMITH_OPCODE_RETURN:
+    if (ranges[operands.left].is_float) {
+      load_xmm(emitter, 0, left);
+      store_xmm(emitter, memory(0), 0);
+    } else {
+      load_gpr(emitter, RAX, left);
+      store_gpr(emitter, memory(0), RAX);
+    }
+    // mov eax, 1
+    byte(emitter, 0xB8);
+    int32(emitter, 1);
+    pop_callee_saved_and_return(emitter);
+    return;
+  }
+}
+
+// An upper bound on the machine code of one instruction, including loading
+// its operands.
+#define MAX_INSTRUCTION_SIZE 128
+#define MAX_FRAME_SIZE 64
+
+// Translates the bytecode to machine code, or leaves `jit->function` null.
+static bool translate(smith_jit_t *jit) {
+  const smith_bytecode_t *bytecode = &jit->bytecode;
+  smith_allocator_t allocator = jit->allocator;
+  size_t count = bytecode->count;
+  size_t range_capacity = count * 3;
+  range_t *ranges =
+      smith_allocator_allocate_array(allocator, range_t, range_capacity);
+  operands_t *operands =
+      smith_allocator_allocate_array(allocator, operands_t, count);
+  uint32_t register_count = bytecode->register_count;
+  uint32_t *current =
+      smith_allocator_allocate_array(allocator, uint32_t, register_count);
+  if (ranges == nullptr || operands == nullptr || current == nullptr) {
+    smith_allocator_deallocate(allocator, ranges);
+    smith_allocator_deallocate(allocator, operands);
+    smith_allocator_deallocate(allocator, current);
+    return false;
+  }
+  size_t range_count = build_ranges(bytecode, ranges, operands, current);
+  smith_allocator_deallocate(allocator, current);
+  uint32_t callee_saved = allocate_registers(ranges, range_count);
+  size_t size = count * MAX_INSTRUCTION_SIZE + MAX_FRAME_SIZE;
+  void *code = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  bool success = code != MAP_FAILED;
+  if (success) {
+    emitter_t emitter = {.code = code, .callee_saved = callee_saved};
+    push_callee_saved(&emitter);
+    // jmp over the trap handler: xor eax, eax; pop; ret
+    byte(&emitter, 0xEB);
+    size_t jump = emitter.count;
+    byte(&emitter, 0);
+    emitter.trap = emitter.count;
+    byte(&emitter, 0x31);
+    byte(&emitter, 0xC0);
+    pop_callee_saved_and_return(&emitter);
+    emitter.code[jump] = (uint8_t)(emitter.count - jump - 1);
+    for (size_t i = 0; i < count; i++) {
+      emit_instruction(&emitter, bytecode->instructions[i].opcode, ranges,
+                       operands[i]);
+    }
+    success = mprotect(code, size, PROT_READ | PROT_EXEC) == 0;
+    if (success) {
+      jit->code = code;
+      jit->code_size = size;
+      jit->function = (bool (*)(smith_constant_value_t *))code;
+    } else {
+      munmap(code, size);
+    }
+  }
+  smith_allocator_deallocate(allocator, ranges);
+  smith_allocator_deallocate(allocator, operands);
+  return success;
+}
+
+static void unmap(smith_jit_t jit) {
+  if (jit.code != nullptr) {
+    munmap(jit.code, jit.code_size);
+  }
+}
+
+#else
+
+static bool translate(smith_jit_t *jit) { return false; }
+
+static void unmap(smith_jit_t jit) {}
+
+#endif
+
+smith_jit_compile_result_t
+smith_jit_compile(smith_allocator_t allocator,
+                  const smith_expression_t *expression,
+                  const smith_bytecode_parameter_t *parameters,
+                  uint32_t parameter_count) {
+  smith_bytecode_compile_result_t compile_result = smith_bytecode_compile(
+      allocator, expression, parameters, parameter_count);
+  if (!compile_result.success) {
+    return (smith_jit_compile_result_t){};
+  }
+  smith_jit_t jit = {.allocator = allocator,
+                     .bytecode = compile_result.bytecode};
+  translate(&jit);
+  return (smith_jit_compile_result_t){.jit = jit, .success = true};
+}
+
+smith_vm_run_result_t smith_jit_run(const smith_jit_t *jit,
+                                    const smith_constant_value_t *arguments) {
+  if (jit->function == nullptr) {
+    return smith_vm_run(jit->allocator, &jit->bytecode, arguments);
+  }
+  const smith_bytecode_t *bytecode = &jit->bytecode;
+  smith_constant_value_t inline_registers[SMITH_VM_INLINE_REGISTERS];
+  smith_constant_value_t *registers = inline_registers;
+  if (bytecode->register_count > SMITH_VM_INLINE_REGISTERS) {
+    registers = smith_allocator_allocate_array(
+        jit->allocator, smith_constant_value_t, bytecode->register_count);
+    if (registers == nullptr) {
+      return (smith_vm_run_result_t){};
+    }
+  }
+  if (bytecode->parameter_count > 0) {
+    memcpy(registers, arguments,
+           bytecode->parameter_count * sizeof(smith_constant_value_t));
+  }
+  if (bytecode->constant_count > 0) {
+    memcpy(registers + bytecode->parameter_count, bytecode->constants,
+           bytecode->constant_count * sizeof(smith_constant_value_t));
+  }
+  smith_vm_run_result_t run_result = {.success = jit->function(registers)};
+  run_result.value = registers[0];
+  if (registers != inline_registers) {
+    smith_allocator_deallocate(jit->allocator, registers);
+  }
+  return run_result;
+}
+
+void smith_jit_destroy(smith_jit_t jit) {
+  unmap(jit);
+  smith_bytecode_destroy(jit.bytecode);
+}
@@ -1,3 +1,214 @@
-#include <stdint.h>
+#define SMITH_ENABLE_ALLOCATOR_MACROS
 
-int32_t main() { return 0; }
+#include "smith/bytecode.h"
+#include "smith/constant.h"
+#include "smith/null_interner.h"
+#include "smith/system_allocator.h"
+#include "smith/vm.h"
+#include <stdio.h>
+#include <string.h>
+
+// Reads a whole file into a null terminated string.
+static char *read_file(smith_allocator_t allocator, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+  char *source = nullptr;
+  long length = -1;
+  if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 &&
+      fseek(file, 0, SEEK_SET) == 0) {
+    size_t size = (size_t)length + 1;
+    source = smith_allocator_allocate_array(allocator, char, size);
+  }
+  if (source != nullptr) {
+    if (fread(source, 1, (size_t)length, file) != (size_t)length) {
+      smith_allocator_deallocate(allocator, source);
+      source = nullptr;
+    } else {
+      source[length] = '\0';
+    }
+  }
+  fclose(file);
+  return source;
+}
+
+// Reads the digits of an int argument. A negative value is accumulated
+// below zero, so INT64_MIN, whose magnitude does not fit, is read too.
+static smith_constant_result_t parse_int(const char *digits, bool negative) {
+  int64_t value = 0;
+  for (size_t i = 0; digits[i] != '\0'; i++) {
+    int64_t digit = digits[i] - '0';
+    if (__builtin_mul_overflow(value, 10, &value) ||
+        (negative ? __builtin_sub_overflow(value, digit, &value)
+                  : __builtin_add_overflow(value, digit, &value))) {
+      return (smith_constant_result_t){};
+    }
+  }
+  return (smith_constant_result_t){
+      .constant = {.kind = SMITH_CONSTANT_KIND_INT, .value.int_ = value},
+      .success = true};
+}
+
+// Reads a command line argument as a bool, an int or a float, taking its
+// type from its spelling as a literal would. A leading `-` negates it.
+static smith_constant_result_t parse_argument(const char *text) {
+  if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+    return (smith_constant_result_t){
+        .constant = {.kind = SMITH_CONSTANT_KIND_BOOL,
+                     .value.bool_ = text[0] == 't'},
+        .success = true};
+  }
+  bool negative = text[0] == '-';
+  const char *digits = text + negative;
+  size_t digit_count = 0;
+  size_t point_count = 0;
+  for (size_t i = 0; digits[i] != '\0'; i++) {
+    if (digits[i] == '.') {
+      point_count++;
+    } else if (digits[i] >= '0' && digits[i] <= '9') {
+      digit_count++;
+    } else {
+      return (smith_constant_result_t){};
+    }
+  }
+  if (digit_count == 0 || point_count > 1) {
+    return (smith_constant_result_t){};
+  }
+  if (point_count == 0) {
+    return parse_int(digits, negative);
+  }
+  // `strtod` reads the sign along with the digits.
+  return smith_constant_from_literal(
+      SMITH_EXPRESSION_KIND_FLOAT,
+      (smith_string_t){.data = (char *)text, .length = strlen(text)});
+}
+
+static void print_value(smith_constant_kind_t kind,
+                        smith_constant_value_t value) {
+  switch (kind) {
+  case SMITH_CONSTANT_KIND_INT:
+    printf("%lld\n", (long long)value.int_);
+    break;
+  case SMITH_CONSTANT_KIND_FLOAT:
+    printf("%.17g\n", value.float_);
+    break;
+  case SMITH_CONSTANT_KIND_BOOL:
+    printf("%s\n", value.bool_ ? "true" : "false");
+    break;
+  }
+}
+
+static const smith_function_t *find_main(const smith_module_t *module) {
+  for (size_t i = 0; i < module->count; i++) {
+    smith_string_t name = module->functions[i].name.text;
+    if (name.length == 4 && memcmp(name.data, "main", 4) == 0) {
+      return &module->functions[i];
+    }
+  }
+  return nullptr;
+}
+
+// Compiles the `main` function of a source file to bytecode and runs it with
+// the given arguments, printing the value it returns. The type of each
+// parameter is the type of its argument.
+static int32_t run(smith_allocator_t allocator, const char *path, int argc,
+                   char **argv) {
+  char *source = read_file(allocator, path);
+  if (source == nullptr) {
+    fprintf(stderr, "error: cannot read %s\n", path);
+    return 1;
+  }
+  smith_tokenize_result_t tokenize_result =
+      smith_tokenize(allocator, smith_null_interner_create(), source);
+  if (!tokenize_result.success) {
+    fprintf(stderr, "error: cannot tokenize %s\n", path);
+    smith_allocator_deallocate(allocator, source);
+    return 1;
+  }
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create(),
+                                    .fold_constants = true};
+  smith_parse_module_result_t parse_result =
+      smith_parse_module(context, &tokenize_result.buffer);
+  if (!parse_result.success) {
+    smith_position_t error = parse_result.error.start;
+    fprintf(stderr, "error: %s:%u:%u: syntax error\n", path, error.line + 1,
+            error.column + 1);
+    smith_module_destroy(parse_result.module);
+    smith_token_buffer_destroy(tokenize_result.buffer);
+    smith_allocator_deallocate(allocator, source);
+    return 1;
+  }
+  smith_module_t module = parse_result.module;
+  int32_t status = 1;
+  const smith_function_t *function = find_main(&module);
+  smith_bytecode_parameter_t *parameters = smith_allocator_allocate_array(
+      allocator, smith_bytecode_parameter_t, (size_t)argc + 1);
+  smith_constant_value_t *arguments = smith_allocator_allocate_array(
+      allocator, smith_constant_value_t, (size_t)argc + 1);
+  if (function == nullptr) {
+    fprintf(stderr, "error: %s has no main function\n", path);
+  } else if (parameters == nullptr || arguments == nullptr) {
+    fprintf(stderr, "error: out of memory\n");
+  } else if (function->parameter_count != (uint32_t)argc) {
+    fprintf(stderr, "error: main takes %u arguments, not %d\n",
+            function->parameter_count, argc);
+  } else {
+    bool arguments_valid = true;
+    for (int i = 0; i < argc; i++) {
+      smith_constant_result_t argument_result = parse_argument(argv[i]);
+      if (!argument_result.success) {
+        fprintf(stderr, "error: invalid argument %s\n", argv[i]);
+        arguments_valid = false;
+        break;
+      }
+      parameters[i] = (smith_bytecode_parameter_t){
+          .name = module.ast.payloads[function->parameters + i].leaf.text,
+          .kind = argument_result.constant.kind};
+      arguments[i] = argument_result.constant.value;
+    }
+    smith_ast_to_expression_result_t to_expression_result =
+        smith_ast_to_expression(allocator, &module.ast, function->body);
+    smith_expression_t body = to_expression_result.expression;
+    if (arguments_valid && !to_expression_result.success) {
+      fprintf(stderr, "error: out of memory\n");
+      arguments_valid = false;
+    }
+    smith_bytecode_compile_result_t compile_result =
+        arguments_valid ? smith_bytecode_compile(allocator, &body, parameters,
+                                                 (uint32_t)argc)
+                        : (smith_bytecode_compile_result_t){};
+    if (arguments_valid && !compile_result.success) {
+      fprintf(stderr, "error: cannot compile main\n");
+    } else if (compile_result.success) {
+      smith_vm_run_result_t run_result =
+          smith_vm_run(allocator, &compile_result.bytecode, arguments);
+      if (run_result.success) {
+        print_value(compile_result.bytecode.result_kind, run_result.value);
+        status = 0;
+      } else {
+        fprintf(stderr, "error: main trapped\n");
+      }
+      smith_bytecode_destroy(compile_result.bytecode);
+    }
+    smith_expression_destroy(allocator, body);
+  }
+  smith_allocator_deallocate(allocator, arguments);
+  smith_allocator_deallocate(allocator, parameters);
+  smith_module_destroy(module);
+  smith_token_buffer_destroy(tokenize_result.buffer);
+  smith_allocator_deallocate(allocator, source);
+  return status;
+}
+
+int32_t main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <file> [arguments...]\n", argv[0]);
+    return 1;
+  }
+  smith_allocator_t allocator = smith_system_allocator_create();
+  int32_t status = run(allocator, argv[1], argc - 2, argv + 2);
+  smith_allocator_destroy(allocator);
+  return status;
+}
@@ -0,0 +1,147 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/module.h"
+#include <string.h>
+
+smith_module_t smith_module_create(smith_allocator_t allocator) {
+  return (smith_module_t){.ast = smith_ast_create(allocator)};
+}
+
+bool smith_module_reserve(smith_module_t *module, size_t capacity) {
+  if (capacity <= module->capacity) {
+    return true;
+  }
+  size_t new_capacity = module->capacity * 2;
+  if (new_capacity < capacity) {
+    new_capacity = capacity;
+  }
+  if (new_capacity < SMITH_MODULE_MIN_CAPACITY) {
+    new_capacity = SMITH_MODULE_MIN_CAPACITY;
+  }
+  smith_allocator_t allocator = module->ast.allocator;
+  smith_function_t *functions =
+      smith_allocator_allocate_array(allocator, smith_function_t, new_capacity);
+  if (functions == nullptr) {
+    return false;
+  }
+  if (module->count > 0) {
+    memcpy(functions, module->functions,
+           module->count * sizeof(smith_function_t));
+  }
+  smith_allocator_deallocate(allocator, module->functions);
+  module->functions = functions;
+  module->capacity = new_capacity;
+  return true;
+}
+
+bool smith_module_push_function(smith_module_t *module,
+                                smith_function_t function) {
+  if (!smith_module_reserve(module, module->count + 1)) {
+    return false;
+  }
+  module->functions[module->count] = function;
+  module->count++;
+  return true;
+}
+
+static void shift_position(smith_position_t *position, uint32_t anchor_line,
+                           smith_function_shift_t shift) {
+  if (position->line == anchor_line) {
+    position->column =
+        (uint32_t)((int64_t)position->column + shift.column_delta);
+  }
+  position->line = (uint32_t)((int64_t)position->line + shift.line_delta);
+}
+
+void smith_module_settle_function(smith_module_t *module, size_t index) {
+  smith_function_t *function = &module->functions[index];
+  smith_function_shift_t shift = function->shift;
+  if (shift.line_delta == 0 && shift.column_delta == 0 &&
+      shift.text_delta == 0) {
+    return;
+  }
+  // The line the function started on when its nodes were stored.
+  uint32_t anchor_line =
+      (uint32_t)((int64_t)function->span.start.line - shift.line_delta);
+  smith_ast_t *ast = &module->ast;
+  for (smith_ast_node_t node = function->parameters; node <= function->body;
+       node++) {
+    switch (ast->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_SYMBOL:
+    case SMITH_EXPRESSION_KIND_INT:
+    case SMITH_EXPRESSION_KIND_FLOAT: {
+      // The old text may be gone, so its address is only used as a number.
+      smith_string_t *text = &ast->payloads[node].leaf.text;
+      text->data =
+          (char *)((uintptr_t)text->data + (uintptr_t)shift.text_delta);
+      break;
+    }
+    default:
+      break;
+    }
+    shift_position(&ast->spans[node].start, anchor_line, shift);
+    shift_position(&ast->spans[node].end, anchor_line, shift);
+  }
+  function->shift = (smith_function_shift_t){};
+}
+
+// Copies `count` nodes from `first` on to the end of `ast`, which has room
+// for them, pointing their children at the copies.
+static void copy_nodes(smith_ast_t *ast, const smith_ast_t *from,
+                       smith_ast_node_t first, uint32_t count) {
+  uint32_t base = ast->count;
+  memcpy(ast->kinds + base, from->kinds + first, count * sizeof(uint8_t));
+  memcpy(ast->spans + base, from->spans + first, count * sizeof(smith_span_t));
+  memcpy(ast->payloads + base, from->payloads + first,
+         count * sizeof(smith_ast_payload_t));
+  for (uint32_t i = 0; i < count; i++) {
+    smith_ast_children_t children = from->children[first + i];
+    if (from->kinds[first + i] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      children.left = children.left - first + base;
+      children.right = children.right - first + base;
+    }
+    ast->children[base + i] = children;
+  }
+  ast->count += count;
+}
+
+bool smith_module_settle(smith_module_t *module) {
+  // The nodes are in order when each function starts where the one before
+  // it ends and the last one ends the AST.
+  bool in_order = true;
+  smith_ast_node_t next = 0;
+  uint32_t live = 0;
+  for (size_t i = 0; i < module->count; i++) {
+    smith_function_t function = module->functions[i];
+    in_order = in_order && function.parameters == next;
+    next = function.body + 1;
+    live += function.body + 1 - function.parameters;
+  }
+  if (!in_order || live != module->ast.count) {
+    smith_ast_t ast = smith_ast_create(module->ast.allocator);
+    if (!smith_ast_reserve(&ast, live)) {
+      smith_ast_destroy(ast);
+      return false;
+    }
+    for (size_t i = 0; i < module->count; i++) {
+      smith_function_t *function = &module->functions[i];
+      smith_ast_node_t parameters = ast.count;
+      copy_nodes(&ast, &module->ast, function->parameters,
+                 function->body + 1 - function->parameters);
+      function->body = function->body - function->parameters + parameters;
+      function->parameters = parameters;
+    }
+    smith_ast_destroy(module->ast);
+    module->ast = ast;
+    module->garbage = 0;
+  }
+  for (size_t i = 0; i < module->count; i++) {
+    smith_module_settle_function(module, i);
+  }
+  return true;
+}
+
+void smith_module_destroy(smith_module_t module) {
+  smith_allocator_deallocate(module.ast.allocator, module.functions);
+  smith_ast_destroy(module.ast);
+}
@@ -0,0 +1,15 @@
+#include "smith/null_interner.h"
+
+static smith_lookup_result_t lookup(const void *interner,
+                                    smith_interned_t interned) {
+  return (smith_lookup_result_t){};
+}
+
+static void destroy(void *interner) {}
+
+smith_interner_t smith_null_interner_create() {
+  return (smith_interner_t){.intern = nullptr,
+                            .lookup = lookup,
+                            .destroy = destroy,
+                            .state = nullptr};
+}
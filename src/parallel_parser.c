@@ -0,0 +1,231 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/parallel_parser.h"
+#include "smith/arena_allocator.h"
+#include "smith/null_interner.h"
+
+typedef struct {
+  size_t start;
+  size_t end;
+  smith_allocator_t arena;
+  smith_module_t module;
+  smith_span_t error;
+  bool failed;
+} batch_t;
+
+typedef struct {
+  const smith_token_buffer_t *buffer;
+  bool fold_constants;
+  size_t *items;
+  size_t item_count;
+  batch_t *batches;
+} parse_parallel_t;
+
+// Finds the index of every `fn` keyword outside of braces. With `items` null
+// they are only counted.
+static size_t find_items(const smith_token_buffer_t *buffer, size_t *items) {
+  size_t count = 0;
+  size_t depth = 0;
+  for (size_t i = 0; i < buffer->count; i++) {
+    smith_token_t token = smith_token_buffer_get(buffer, i);
+    switch (token.kind) {
+    case SMITH_TOKEN_KIND_DELIMITER:
+      if (token.value.delimiter.kind == SMITH_DELIMITER_KIND_OPEN_BRACE) {
+        depth++;
+      } else if (token.value.delimiter.kind ==
+                     SMITH_DELIMITER_KIND_CLOSE_BRACE &&
+                 depth > 0) {
+        depth--;
+      }
+      break;
+    case SMITH_TOKEN_KIND_KEYWORD:
+      if (depth == 0 && token.value.keyword.kind == SMITH_KEYWORD_KIND_FN) {
+        if (items != nullptr) {
+          items[count] = i;
+        }
+        count++;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return count;
+}
+
+static void parse_batch(void *state, size_t index) {
+  parse_parallel_t *parse_parallel = state;
+  batch_t *batch = &parse_parallel->batches[index];
+  smith_parser_context_t context = {
+      .allocator = batch->arena,
+      .interner = smith_null_interner_create(),
+      .fold_constants = parse_parallel->fold_constants};
+  batch->module = smith_module_create(batch->arena);
+  for (size_t i = batch->start; i < batch->end; i++) {
+    smith_parse_function_result_t parse_result = smith_parse_function(
+        context, &batch->module.ast, parse_parallel->buffer,
+        parse_parallel->items[i]);
+    if (!parse_result.success) {
+      batch->error = parse_result.error;
+      batch->failed = true;
+      return;
+    }
+    // Every function must end where the next one starts, or something other
+    // than a function sits between them, which is where the serial parser
+    // would report the error.
+    size_t end = i + 1 < parse_parallel->item_count
+                     ? parse_parallel->items[i + 1]
+                     : parse_parallel->buffer->count - 1;
+    if (parse_result.index != end) {
+      smith_token_t token =
+          smith_token_buffer_get(parse_parallel->buffer, parse_result.index);
+      batch->error = *smith_token_span(&token);
+      batch->failed = true;
+      return;
+    }
+    // Running out of memory fails the batch with an empty error.
+    if (!smith_module_push_function(&batch->module, parse_result.function)) {
+      batch->failed = true;
+      return;
+    }
+  }
+}
+
+static bool intern_leaf(smith_interner_t interner, smith_ast_leaf_t *leaf) {
+  smith_intern_result_t intern_result =
+      smith_interner_intern(interner, leaf->text);
+  leaf->interned = intern_result.interned;
+  return intern_result.success;
+}
+
+// Appends the nodes and functions of a batch to the module. Batches are
+// merged in order and every name is interned in the order the serial parser
+// would intern it: the name of a function, then its leaves in node order.
+// Room for the nodes and functions is reserved up front, so only interning
+// can fail.
+static bool merge_batch(smith_module_t *module, batch_t *batch,
+                        smith_interner_t interner) {
+  smith_ast_node_t base = module->ast.count;
+  smith_ast_append(&module->ast, &batch->module.ast);
+  bool intern = !smith_interner_is_null(interner);
+  smith_ast_t *ast = &module->ast;
+  for (size_t i = 0; i < batch->module.count; i++) {
+    smith_function_t function = batch->module.functions[i];
+    function.parameters += base;
+    function.body += base;
+    if (intern) {
+      if (!intern_leaf(interner, &function.name)) {
+        return false;
+      }
+      for (smith_ast_node_t node = function.parameters; node <= function.body;
+           node++) {
+        switch (ast->kinds[node]) {
+        case SMITH_EXPRESSION_KIND_SYMBOL:
+        case SMITH_EXPRESSION_KIND_INT:
+        case SMITH_EXPRESSION_KIND_FLOAT:
+          if (!intern_leaf(interner, &ast->payloads[node].leaf)) {
+            return false;
+          }
+          break;
+        default:
+          break;
+        }
+      }
+    }
+    module->functions[module->count] = function;
+    module->count++;
+  }
+  return true;
+}
+
+// Releases the arenas of the batches in `[first, end)`, the batches and the
+// items, returning a failed result with the given error.
+static smith_parse_module_result_t fail(smith_allocator_t allocator,
+                                        size_t *items, batch_t *batches,
+                                        size_t first, size_t end,
+                                        smith_span_t error) {
+  for (size_t i = first; i < end; i++) {
+    smith_allocator_destroy(batches[i].arena);
+  }
+  smith_allocator_deallocate(allocator, batches);
+  smith_allocator_deallocate(allocator, items);
+  return (smith_parse_module_result_t){
+      .module = smith_module_create(allocator), .error = error};
+}
+
+smith_parse_module_result_t
+smith_parse_module_parallel(smith_parser_context_t context,
+                            smith_thread_pool_t pool,
+                            const smith_token_buffer_t *buffer) {
+  size_t item_count = find_items(buffer, nullptr);
+  if (item_count == 0) {
+    return smith_parse_module(context, buffer);
+  }
+  size_t *items = smith_allocator_allocate_array(context.allocator, size_t,
+                                                 item_count);
+  size_t batch_count = smith_thread_pool_concurrency(pool) *
+                       SMITH_PARALLEL_PARSER_BATCHES_PER_THREAD;
+  if (batch_count > item_count) {
+    batch_count = item_count;
+  }
+  batch_t *batches =
+      smith_allocator_allocate_array(context.allocator, batch_t, batch_count);
+  if (items == nullptr || batches == nullptr) {
+    return fail(context.allocator, items, batches, 0, 0, (smith_span_t){});
+  }
+  find_items(buffer, items);
+  // The first item must be the first token, or the file starts with
+  // something other than a function.
+  if (items[0] != 0) {
+    smith_token_t token = smith_token_buffer_get(buffer, 0);
+    return fail(context.allocator, items, batches, 0, 0,
+                *smith_token_span(&token));
+  }
+  for (size_t i = 0; i < batch_count; i++) {
+    smith_arena_allocator_create_result_t create_result =
+        smith_arena_allocator_create(context.allocator);
+    if (!create_result.success) {
+      return fail(context.allocator, items, batches, 0, i, (smith_span_t){});
+    }
+    batches[i] = (batch_t){.start = item_count * i / batch_count,
+                           .end = item_count * (i + 1) / batch_count,
+                           .arena = create_result.allocator};
+  }
+  parse_parallel_t parse_parallel = {.buffer = buffer,
+                                     .fold_constants = context.fold_constants,
+                                     .items = items,
+                                     .item_count = item_count,
+                                     .batches = batches};
+  smith_thread_pool_run(pool, parse_batch, &parse_parallel, batch_count);
+  // Batches cover the file in order, so the first batch that failed holds
+  // the first error.
+  for (size_t i = 0; i < batch_count; i++) {
+    if (batches[i].failed) {
+      return fail(context.allocator, items, batches, 0, batch_count,
+                  batches[i].error);
+    }
+  }
+  smith_module_t module = smith_module_create(context.allocator);
+  uint32_t node_count = 0;
+  for (size_t i = 0; i < batch_count; i++) {
+    node_count += batches[i].module.ast.count;
+  }
+  if (!smith_ast_reserve(&module.ast, node_count) ||
+      !smith_module_reserve(&module, item_count)) {
+    smith_module_destroy(module);
+    return fail(context.allocator, items, batches, 0, batch_count,
+                (smith_span_t){});
+  }
+  for (size_t i = 0; i < batch_count; i++) {
+    if (!merge_batch(&module, &batches[i], context.interner)) {
+      smith_module_destroy(module);
+      return fail(context.allocator, items, batches, i, batch_count,
+                  (smith_span_t){});
+    }
+    // The batch module lives entirely in the arena.
+    smith_allocator_destroy(batches[i].arena);
+  }
+  smith_allocator_deallocate(context.allocator, batches);
+  smith_allocator_deallocate(context.allocator, items);
+  return (smith_parse_module_result_t){.module = module, .success = true};
+}
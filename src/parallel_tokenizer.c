@@ -0,0 +1,194 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/parallel_tokenizer.h"
+#include "smith/dfa_tokenizer.h"
+#include "smith/null_interner.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+  size_t start;
+  size_t end;
+  uint32_t lines;
+  smith_token_buffer_t buffer;
+  smith_cursor_t resume;
+  bool success;
+} piece_t;
+
+typedef struct {
+  smith_allocator_t allocator;
+  char *source;
+  size_t length;
+  piece_t *pieces;
+  size_t piece_count;
+} tokenize_parallel_t;
+
+static uint32_t count_lines(const char *source, size_t length) {
+  uint32_t lines = 0;
+  const char *end = source + length;
+  while ((source = memchr(source, '\n', end - source)) != nullptr) {
+    lines++;
+    source++;
+  }
+  return lines;
+}
+
+// Tokenizes a piece from the cursor on. Every piece but the last stops before
+// its first token at or past the end of the piece and remembers where that
+// token starts, since the next piece has to start its first token there too.
+static bool lex_piece(piece_t *piece, char *source, smith_cursor_t cursor,
+                      bool last) {
+  smith_interner_t interner = smith_null_interner_create();
+  while (true) {
+    cursor = smith_trim_whitespace(cursor);
+    size_t start = cursor.source - source;
+    if (!last && start >= piece->end) {
+      piece->resume = cursor;
+      return true;
+    }
+    smith_next_token_result_t result = smith_dfa_next_token(interner, cursor);
+    smith_offsets_t offsets = {.start = start,
+                               .end = result.cursor.source - source};
+    if (!smith_token_buffer_push(&piece->buffer, result.token, offsets)) {
+      return false;
+    }
+    if (result.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      piece->resume = result.cursor;
+      return true;
+    }
+    cursor = result.cursor;
+  }
+}
+
+// Tokenizes one piece as if it were the start of the file, which is only
+// wrong if the piece starts inside a block comment.
+static void tokenize_piece(void *state, size_t index) {
+  tokenize_parallel_t *tokenize_parallel = state;
+  piece_t *piece = &tokenize_parallel->pieces[index];
+  bool last = index + 1 == tokenize_parallel->piece_count;
+  char *source = tokenize_parallel->source;
+  piece->lines = count_lines(source + piece->start, piece->end - piece->start);
+  piece->buffer = smith_token_buffer_create(tokenize_parallel->allocator);
+  smith_cursor_t cursor = {.source = source + piece->start};
+  piece->success = lex_piece(piece, source, cursor, last);
+}
+
+// Tokenizes a piece again, serially, from where the previous piece says its
+// first token starts. The positions of the tokens are then absolute.
+static bool relex_piece(smith_allocator_t allocator, piece_t *piece,
+                        char *source, smith_cursor_t resume, bool last) {
+  smith_token_buffer_destroy(piece->buffer);
+  piece->buffer = smith_token_buffer_create(allocator);
+  return lex_piece(piece, source, resume, last);
+}
+
+static size_t first_token_start(piece_t *piece, char *source) {
+  if (piece->buffer.count > 0) {
+    return smith_token_buffer_offsets(&piece->buffer, 0).start;
+  }
+  return piece->resume.source - source;
+}
+
+// Rebases the tokens of a piece and interns their text. Pieces are stitched
+// in order, so the interner sees strings in the same order as a serial
+// tokenization.
+static bool stitch_piece(smith_token_buffer_t *buffer, piece_t *piece,
+                         uint32_t line, smith_interner_t interner) {
+  bool intern = !smith_interner_is_null(interner);
+  for (size_t i = 0; i < piece->buffer.count; i++) {
+    smith_token_t token = smith_token_buffer_get(&piece->buffer, i);
+    smith_span_t *span = smith_token_span(&token);
+    span->start.line += line;
+    span->end.line += line;
+    if (intern) {
+      token = smith_token_intern(interner, token);
+    }
+    smith_offsets_t offsets = smith_token_buffer_offsets(&piece->buffer, i);
+    if (!smith_token_buffer_push(buffer, token, offsets)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Splits the source right after newlines, roughly every `piece_size` bytes.
+static size_t split(piece_t *pieces, char *source, size_t length,
+                    size_t piece_size) {
+  size_t piece_count = 0;
+  size_t start = 0;
+  while (true) {
+    size_t target = start + piece_size;
+    char *newline = target < length
+                        ? memchr(source + target, '\n', length - target)
+                        : nullptr;
+    if (newline == nullptr) {
+      pieces[piece_count++] = (piece_t){.start = start, .end = length};
+      return piece_count;
+    }
+    size_t end = newline - source + 1;
+    pieces[piece_count++] = (piece_t){.start = start, .end = end};
+    start = end;
+  }
+}
+
+smith_tokenize_result_t
+smith_tokenize_parallel(smith_allocator_t allocator, smith_interner_t interner,
+                        smith_thread_pool_t pool,
+                        char *source, size_t piece_size) {
+  size_t length = strlen(source);
+  if (piece_size == 0) {
+    piece_size = 1;
+  }
+  size_t max_pieces = length / piece_size + 1;
+  piece_t *pieces =
+      smith_allocator_allocate_array(allocator, piece_t, max_pieces);
+  if (pieces == nullptr) {
+    return (smith_tokenize_result_t){};
+  }
+  tokenize_parallel_t tokenize_parallel = {
+      .allocator = allocator,
+      .source = source,
+      .length = length,
+      .pieces = pieces,
+      .piece_count = split(pieces, source, length, piece_size),
+  };
+  smith_thread_pool_run(pool, tokenize_piece, &tokenize_parallel,
+                        tokenize_parallel.piece_count);
+  smith_token_buffer_t buffer = smith_token_buffer_create(allocator);
+  size_t token_count = 0;
+  bool success = true;
+  for (size_t i = 0; i < tokenize_parallel.piece_count; i++) {
+    success = success && pieces[i].success;
+    token_count += pieces[i].buffer.count;
+  }
+  success = success && smith_token_buffer_reserve(&buffer, token_count);
+  // Pieces start right after newlines, which only block comments span. Such a
+  // piece was tokenized from the wrong state, which shows as its first token
+  // starting somewhere else than the previous piece expects.
+  uint32_t line = 0;
+  smith_cursor_t resume = {.source = source};
+  for (size_t i = 0; i < tokenize_parallel.piece_count && success; i++) {
+    piece_t *piece = &pieces[i];
+    uint32_t base = line;
+    if (i > 0 && first_token_start(piece, source) !=
+                     (size_t)(resume.source - source)) {
+      bool last = i + 1 == tokenize_parallel.piece_count;
+      success = relex_piece(allocator, piece, source, resume, last);
+      base = 0;
+    }
+    success = success && stitch_piece(&buffer, piece, base, interner);
+    resume = piece->resume;
+    resume.position.line += base;
+    line += piece->lines;
+  }
+  for (size_t i = 0; i < tokenize_parallel.piece_count; i++) {
+    smith_token_buffer_destroy(pieces[i].buffer);
+  }
+  smith_allocator_deallocate(allocator, pieces);
+  if (!success) {
+    smith_token_buffer_destroy(buffer);
+    return (smith_tokenize_result_t){};
+  }
+  buffer.source = source;
+  return (smith_tokenize_result_t){.buffer = buffer, .success = true};
+}
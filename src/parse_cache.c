@@ -0,0 +1,609 @@
+// For `mkstemp` and `fchmod`, which strict C modes hide.
+#define _DEFAULT_SOURCE 1
+
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/parse_cache.h"
+#include "smith/null_interner.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A cache file is a header followed by its sections, each starting at a
+// multiple of eight bytes. Section offsets are relative to the start of the
+// file, so the file means the same wherever it is mapped.
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t source_hash;
+  uint32_t node_count;
+  uint32_t function_count;
+  uint64_t string_count;
+  uint64_t byte_count;
+  uint64_t kinds;
+  uint64_t children;
+  uint64_t spans;
+  uint64_t payloads;
+  uint64_t functions;
+  uint64_t strings;
+  uint64_t bytes;
+} header_t;
+
+static const char magic[8] = "SMITHAST";
+
+// Written in the byte order of the machine, so a file from a machine of the
+// other byte order reads back as a different value and is rejected.
+static const uint32_t byte_order = 0x01020304;
+
+// A leaf stores the index of its text in the string table; a binary operator
+// its kind, precedence and associativity; a constant its kind and the bits of
+// its value.
+typedef struct {
+  uint64_t bits;
+  uint32_t tag;
+  uint32_t extra;
+} stored_payload_t;
+
+typedef struct {
+  smith_span_t span;
+  smith_span_t name_span;
+  smith_offsets_t offsets;
+  uint64_t name;
+  uint32_t parameters;
+  uint32_t parameter_count;
+  uint32_t body;
+  uint32_t padding;
+} stored_function_t;
+
+typedef struct {
+  uint64_t offset;
+  uint64_t length;
+} stored_string_t;
+
+static inline uint64_t mix(uint64_t hash) {
+  hash ^= hash >> 32;
+  hash *= 0xD6E8FEB86659FD93;
+  hash ^= hash >> 32;
+  hash *= 0xD6E8FEB86659FD93;
+  return hash ^ hash >> 32;
+}
+
+uint64_t smith_source_hash(smith_string_t source) {
+  uint64_t hash = 0x9E3779B97F4A7C15 ^ source.length;
+  size_t i = 0;
+  for (; source.length - i >= 8; i += 8) {
+    uint64_t word;
+    memcpy(&word, source.data + i, sizeof(word));
+    hash = (hash ^ mix(word)) * 0x9E3779B97F4A7C15;
+    hash = hash << 27 | hash >> 37;
+  }
+  uint64_t word = 0;
+  memcpy(&word, source.data + i, source.length - i);
+  return mix(hash ^ mix(word));
+}
+
+static inline uint64_t align(uint64_t offset) { return (offset + 7) & ~7ull; }
+
+static inline uint64_t hash_text(smith_string_t text) {
+  uint64_t hash = text.length;
+  for (size_t i = 0; i < text.length; i++) {
+    hash = hash * 31 + (uint8_t)text.data[i];
+  }
+  return mix(hash);
+}
+
+// The distinct texts of the leaves and function names, in the order the
+// parser first interns them, so that interning the table in order assigns
+// the same identifiers a fresh parse would.
+typedef struct {
+  smith_allocator_t allocator;
+  smith_string_t *strings;
+  uint64_t *slots;
+  uint64_t slot_capacity;
+  uint64_t count;
+  uint64_t byte_count;
+} string_table_t;
+
+static bool string_table_create(string_table_t *table,
+                                smith_allocator_t allocator,
+                                uint64_t capacity) {
+  uint64_t slot_capacity = 16;
+  while (slot_capacity < capacity * 2) {
+    slot_capacity *= 2;
+  }
+  *table = (string_table_t){.allocator = allocator,
+                            .slot_capacity = slot_capacity};
+  table->strings =
+      smith_allocator_allocate_array(allocator, smith_string_t, capacity);
+  table->slots =
+      smith_allocator_allocate_array(allocator, uint64_t, slot_capacity);
+  if (table->strings == nullptr || table->slots == nullptr) {
+    return false;
+  }
+  memset(table->slots, 0, slot_capacity * sizeof(uint64_t));
+  return true;
+}
+
+// Slots hold a string index plus one, so that zero marks an empty slot.
+static uint64_t string_table_add(string_table_t *table, smith_string_t text) {
+  uint64_t index = hash_text(text) & (table->slot_capacity - 1);
+  while (table->slots[index] != 0) {
+    smith_string_t existing = table->strings[table->slots[index] - 1];
+    if (existing.length == text.length &&
+        memcmp(existing.data, text.data, text.length) == 0) {
+      return table->slots[index] - 1;
+    }
+    index = (index + 1) & (table->slot_capacity - 1);
+  }
+  table->strings[table->count] = text;
+  table->slots[index] = ++table->count;
+  table->byte_count += text.length;
+  return table->count - 1;
+}
+
+static void string_table_destroy(string_table_t table) {
+  smith_allocator_deallocate(table.allocator, table.strings);
+  smith_allocator_deallocate(table.allocator, table.slots);
+}
+
+static inline bool is_leaf(uint8_t kind) {
+  return kind == SMITH_EXPRESSION_KIND_SYMBOL ||
+         kind == SMITH_EXPRESSION_KIND_INT ||
+         kind == SMITH_EXPRESSION_KIND_FLOAT;
+}
+
+static void add_leaves(string_table_t *table, const smith_ast_t *ast,
+                       uint32_t start, uint32_t end, uint64_t *leaf_strings) {
+  for (uint32_t node = start; node < end; node++) {
+    if (is_leaf(ast->kinds[node])) {
+      leaf_strings[node] =
+          string_table_add(table, ast->payloads[node].leaf.text);
+    }
+  }
+}
+
+static stored_payload_t store_payload(uint8_t kind, smith_ast_payload_t payload,
+                                      uint64_t leaf_string) {
+  switch (kind) {
+  case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
+    return (stored_payload_t){
+        .bits = payload.binary_operator.precedence,
+        .tag = payload.binary_operator.kind,
+        .extra = payload.binary_operator.associativity};
+  case SMITH_EXPRESSION_KIND_CONSTANT: {
+    stored_payload_t stored = {.tag = payload.constant.kind};
+    switch (payload.constant.kind) {
+    case SMITH_CONSTANT_KIND_INT:
+      stored.bits = (uint64_t)payload.constant.value.int_;
+      break;
+    case SMITH_CONSTANT_KIND_FLOAT:
+      memcpy(&stored.bits, &payload.constant.value.float_,
+             sizeof(stored.bits));
+      break;
+    case SMITH_CONSTANT_KIND_BOOL:
+      stored.bits = payload.constant.value.bool_;
+      break;
+    }
+    return stored;
+  }
+  default:
+    return (stored_payload_t){.bits = leaf_string};
+  }
+}
+
+static bool write_all(int file_descriptor, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t length = write(file_descriptor, data, size);
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += length;
+    size -= length;
+  }
+  return true;
+}
+
+// Writes the file under a fresh name next to `path` and renames it into
+// place, so readers never see a partial file. `mkstemp` creates the name
+// exclusively, so it cannot be a file or link planted there beforehand.
+static bool write_file(smith_allocator_t allocator, const char *path,
+                       const char *data, size_t size) {
+  size_t path_length = strlen(path);
+  size_t temporary_capacity = path_length + sizeof(".XXXXXX");
+  char *temporary =
+      smith_allocator_allocate_array(allocator, char, temporary_capacity);
+  if (temporary == nullptr) {
+    return false;
+  }
+  snprintf(temporary, temporary_capacity, "%s.XXXXXX", path);
+  bool success = false;
+  int file_descriptor = mkstemp(temporary);
+  if (file_descriptor >= 0) {
+    // `mkstemp` leaves the file readable only by its owner.
+    success = fchmod(file_descriptor, 0644) == 0 &&
+              write_all(file_descriptor, data, size);
+    success = close(file_descriptor) == 0 && success;
+    success = success && rename(temporary, path) == 0;
+    if (!success) {
+      unlink(temporary);
+    }
+  }
+  smith_allocator_deallocate(allocator, temporary);
+  return success;
+}
+
+bool smith_parse_cache_write(smith_allocator_t allocator,
+                             const smith_module_t *module,
+                             uint64_t source_hash, const char *path) {
+  const smith_ast_t *ast = &module->ast;
+  uint32_t node_count = ast->count;
+  uint64_t function_count = module->count;
+  if (function_count > UINT32_MAX) {
+    return false;
+  }
+  uint64_t leaf_capacity = (uint64_t)node_count + function_count;
+  uint64_t *leaf_strings =
+      smith_allocator_allocate_array(allocator, uint64_t, leaf_capacity);
+  string_table_t table;
+  bool table_created = string_table_create(&table, allocator, leaf_capacity);
+  if (leaf_strings == nullptr || !table_created) {
+    smith_allocator_deallocate(allocator, leaf_strings);
+    string_table_destroy(table);
+    return false;
+  }
+  // Each function's name, then its nodes, as the parser interns them.
+  uint64_t *name_strings = leaf_strings + node_count;
+  uint32_t next = 0;
+  for (size_t i = 0; i < function_count; i++) {
+    smith_function_t function = module->functions[i];
+    name_strings[i] = string_table_add(&table, function.name.text);
+    add_leaves(&table, ast, next, function.body + 1, leaf_strings);
+    next = function.body + 1;
+  }
+  add_leaves(&table, ast, next, node_count, leaf_strings);
+
+  header_t header = {
+      .version = SMITH_PARSE_CACHE_VERSION,
+      .byte_order = byte_order,
+      .source_hash = source_hash,
+      .node_count = node_count,
+      .function_count = (uint32_t)function_count,
+      .string_count = table.count,
+      .byte_count = table.byte_count,
+  };
+  memcpy(header.magic, magic, sizeof(magic));
+  header.kinds = align(sizeof(header_t));
+  header.children = align(header.kinds + node_count * sizeof(uint8_t));
+  header.spans =
+      header.children + node_count * sizeof(smith_ast_children_t);
+  header.payloads = header.spans + node_count * sizeof(smith_span_t);
+  header.functions = header.payloads + node_count * sizeof(stored_payload_t);
+  header.strings =
+      header.functions + function_count * sizeof(stored_function_t);
+  header.bytes = header.strings + table.count * sizeof(stored_string_t);
+  uint64_t size = header.bytes + table.byte_count;
+
+  char *file = allocator.allocate(allocator.state, size, alignof(uint64_t));
+  if (file == nullptr) {
+    smith_allocator_deallocate(allocator, leaf_strings);
+    string_table_destroy(table);
+    return false;
+  }
+  memset(file, 0, header.children);
+  memcpy(file, &header, sizeof(header));
+  if (node_count > 0) {
+    memcpy(file + header.kinds, ast->kinds, node_count * sizeof(uint8_t));
+    memcpy(file + header.spans, ast->spans, node_count * sizeof(smith_span_t));
+  }
+  smith_ast_children_t *children =
+      (smith_ast_children_t *)(file + header.children);
+  stored_payload_t *payloads = (stored_payload_t *)(file + header.payloads);
+  for (uint32_t node = 0; node < node_count; node++) {
+    uint8_t kind = ast->kinds[node];
+    // Only binary operators have meaningful children.
+    children[node] = kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR
+                         ? ast->children[node]
+                         : (smith_ast_children_t){};
+    payloads[node] = store_payload(kind, ast->payloads[node],
+                                   is_leaf(kind) ? leaf_strings[node] : 0);
+  }
+  stored_function_t *functions = (stored_function_t *)(file + header.functions);
+  for (size_t i = 0; i < function_count; i++) {
+    smith_function_t function = module->functions[i];
+    functions[i] = (stored_function_t){
+        .span = function.span,
+        .name_span = function.name_span,
+        .offsets = function.offsets,
+        .name = name_strings[i],
+        .parameters = function.parameters,
+        .parameter_count = function.parameter_count,
+        .body = function.body,
+    };
+  }
+  stored_string_t *strings = (stored_string_t *)(file + header.strings);
+  uint64_t offset = 0;
+  for (uint64_t i = 0; i < table.count; i++) {
+    smith_string_t text = table.strings[i];
+    strings[i] = (stored_string_t){.offset = offset, .length = text.length};
+    memcpy(file + header.bytes + offset, text.data, text.length);
+    offset += text.length;
+  }
+  smith_allocator_deallocate(allocator, leaf_strings);
+  string_table_destroy(table);
+  bool success = write_file(allocator, path, file, size);
+  smith_allocator_deallocate(allocator, file);
+  return success;
+}
+
+static bool section_fits(uint64_t offset, uint64_t count, uint64_t element_size,
+                         uint64_t size) {
+  return offset % 8 == 0 && offset <= size &&
+         count <= (size - offset) / element_size;
+}
+
+static bool header_valid(const header_t *header, uint64_t size,
+                         uint64_t source_hash) {
+  return memcmp(header->magic, magic, sizeof(magic)) == 0 &&
+         header->version == SMITH_PARSE_CACHE_VERSION &&
+         header->byte_order == byte_order &&
+         header->source_hash == source_hash &&
+         section_fits(header->kinds, header->node_count, sizeof(uint8_t),
+                      size) &&
+         section_fits(header->children, header->node_count,
+                      sizeof(smith_ast_children_t), size) &&
+         section_fits(header->spans, header->node_count, sizeof(smith_span_t),
+                      size) &&
+         section_fits(header->payloads, header->node_count,
+                      sizeof(stored_payload_t), size) &&
+         section_fits(header->functions, header->function_count,
+                      sizeof(stored_function_t), size) &&
+         section_fits(header->strings, header->string_count,
+                      sizeof(stored_string_t), size) &&
+         header->bytes <= size && header->byte_count <= size - header->bytes;
+}
+
+static bool payload_valid(uint8_t kind, smith_ast_children_t children,
+                          stored_payload_t payload, smith_ast_node_t node,
+                          uint64_t string_count) {
+  switch (kind) {
+  case SMITH_EXPRESSION_KIND_SYMBOL:
+  case SMITH_EXPRESSION_KIND_INT:
+  case SMITH_EXPRESSION_KIND_FLOAT:
+    return payload.bits < string_count;
+  case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
+    // Children precede their parent, which also rules out cycles. That they
+    // are laid out as the parser lays them out is checked by `subtree_valid`.
+    return children.left < node && children.right < node &&
+           payload.tag <= SMITH_BINARY_OPERATOR_KIND_OR &&
+           payload.bits <= SMITH_PRECEDENCE_EQ &&
+           payload.extra <= SMITH_ASSOCIATIVITY_RIGHT;
+  case SMITH_EXPRESSION_KIND_CONSTANT:
+    return payload.tag <= SMITH_CONSTANT_KIND_BOOL &&
+           (payload.tag != SMITH_CONSTANT_KIND_BOOL || payload.bits <= 1);
+  default:
+    return false;
+  }
+}
+
+// Every consumer of the flat AST relies on a subtree filling the range from
+// its first node to its root, with the left subtree directly followed by the
+// right one and the right child directly before its parent. `firsts` holds
+// the first node of every subtree before `node`, and gets that of `node`.
+static bool subtree_valid(const smith_ast_t *ast, smith_ast_node_t node,
+                          smith_ast_node_t *firsts) {
+  if (ast->kinds[node] != SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    firsts[node] = node;
+    return true;
+  }
+  smith_ast_children_t children = ast->children[node];
+  if (children.right != node - 1 ||
+      firsts[children.right] != children.left + 1) {
+    return false;
+  }
+  firsts[node] = firsts[children.left];
+  return true;
+}
+
+static smith_ast_payload_t load_payload(uint8_t kind, stored_payload_t payload,
+                                        const smith_ast_leaf_t *leaves) {
+  switch (kind) {
+  case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
+    return (smith_ast_payload_t){
+        .binary_operator = {.kind = payload.tag,
+                            .precedence = payload.bits,
+                            .associativity = payload.extra}};
+  case SMITH_EXPRESSION_KIND_CONSTANT: {
+    smith_constant_t constant = {.kind = payload.tag};
+    switch (constant.kind) {
+    case SMITH_CONSTANT_KIND_INT:
+      constant.value.int_ = (int64_t)payload.bits;
+      break;
+    case SMITH_CONSTANT_KIND_FLOAT:
+      memcpy(&constant.value.float_, &payload.bits, sizeof(payload.bits));
+      break;
+    case SMITH_CONSTANT_KIND_BOOL:
+      constant.value.bool_ = payload.bits;
+      break;
+    }
+    return (smith_ast_payload_t){.constant = constant};
+  }
+  default:
+    return (smith_ast_payload_t){.leaf = leaves[payload.bits]};
+  }
+}
+
+// Builds the module from a validated mapping. Returns false if an allocation
+// or interning fails, or if the nodes or functions are malformed: every node
+// must belong to one subtree, and each function must be its parameter leaves
+// followed by the subtree of its body.
+static bool load_module(smith_module_t *module, smith_allocator_t allocator,
+                        smith_interner_t interner, const char *file) {
+  const header_t *header = (const header_t *)file;
+  uint32_t node_count = header->node_count;
+  uint64_t string_count = header->string_count;
+  // The text of every string points into the mapping and is interned once.
+  smith_ast_leaf_t *leaves =
+      smith_allocator_allocate_array(allocator, smith_ast_leaf_t, string_count);
+  smith_ast_node_t *firsts =
+      smith_allocator_allocate_array(allocator, smith_ast_node_t, node_count);
+  if ((leaves == nullptr && string_count > 0) ||
+      (firsts == nullptr && node_count > 0)) {
+    smith_allocator_deallocate(allocator, leaves);
+    smith_allocator_deallocate(allocator, firsts);
+    return false;
+  }
+  const stored_string_t *strings =
+      (const stored_string_t *)(file + header->strings);
+  bool success = true;
+  for (uint64_t i = 0; success && i < string_count; i++) {
+    stored_string_t string = strings[i];
+    success = string.offset <= header->byte_count &&
+              string.length <= header->byte_count - string.offset;
+    if (!success) {
+      break;
+    }
+    leaves[i] = (smith_ast_leaf_t){
+        .text = {.data = (char *)file + header->bytes + string.offset,
+                 .length = string.length}};
+    if (!smith_interner_is_null(interner)) {
+      smith_intern_result_t intern_result =
+          smith_interner_intern(interner, leaves[i].text);
+      success = intern_result.success;
+      leaves[i].interned = intern_result.interned;
+    }
+  }
+  success = success && smith_ast_reserve(&module->ast, node_count) &&
+            smith_module_reserve(module, header->function_count);
+  if (success && node_count > 0) {
+    smith_ast_t *ast = &module->ast;
+    memcpy(ast->kinds, file + header->kinds, node_count * sizeof(uint8_t));
+    memcpy(ast->children, file + header->children,
+           node_count * sizeof(smith_ast_children_t));
+    memcpy(ast->spans, file + header->spans, node_count * sizeof(smith_span_t));
+    const stored_payload_t *payloads =
+        (const stored_payload_t *)(file + header->payloads);
+    for (uint32_t node = 0; success && node < node_count; node++) {
+      uint8_t kind = ast->kinds[node];
+      success = payload_valid(kind, ast->children[node], payloads[node], node,
+                              string_count) &&
+                subtree_valid(ast, node, firsts);
+      if (success) {
+        ast->payloads[node] = load_payload(kind, payloads[node], leaves);
+      }
+    }
+    ast->count = node_count;
+  }
+  const stored_function_t *functions =
+      (const stored_function_t *)(file + header->functions);
+  for (uint32_t i = 0; success && i < header->function_count; i++) {
+    stored_function_t function = functions[i];
+    success = function.name < string_count && function.body < node_count &&
+              function.offsets.start <= function.offsets.end &&
+              function.parameters <= function.body &&
+              function.parameter_count <= function.body - function.parameters &&
+              firsts[function.body] ==
+                  function.parameters + function.parameter_count;
+    for (uint32_t j = 0; success && j < function.parameter_count; j++) {
+      success = module->ast.kinds[function.parameters + j] ==
+                SMITH_EXPRESSION_KIND_SYMBOL;
+    }
+    if (success) {
+      module->functions[i] = (smith_function_t){
+          .span = function.span,
+          .offsets = function.offsets,
+          .name = leaves[function.name],
+          .name_span = function.name_span,
+          .parameters = function.parameters,
+          .parameter_count = function.parameter_count,
+          .body = function.body,
+      };
+    }
+  }
+  if (success) {
+    module->count = header->function_count;
+  }
+  smith_allocator_deallocate(allocator, firsts);
+  smith_allocator_deallocate(allocator, leaves);
+  return success;
+}
+
+smith_parse_cache_load_result_t
+smith_parse_cache_load(smith_allocator_t allocator, smith_interner_t interner,
+                       const char *path, uint64_t source_hash) {
+  int file_descriptor = open(path, O_RDONLY);
+  if (file_descriptor < 0) {
+    return (smith_parse_cache_load_result_t){};
+  }
+  struct stat status;
+  if (fstat(file_descriptor, &status) != 0 ||
+      (uint64_t)status.st_size < sizeof(header_t)) {
+    close(file_descriptor);
+    return (smith_parse_cache_load_result_t){};
+  }
+  size_t size = status.st_size;
+  void *mapping =
+      mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  close(file_descriptor);
+  if (mapping == MAP_FAILED) {
+    return (smith_parse_cache_load_result_t){};
+  }
+  smith_parse_cache_t cache = {.mapping = mapping, .size = size};
+  if (!header_valid(mapping, size, source_hash)) {
+    smith_parse_cache_close(cache);
+    return (smith_parse_cache_load_result_t){};
+  }
+  smith_module_t module = smith_module_create(allocator);
+  if (!load_module(&module, allocator, interner, mapping)) {
+    smith_module_destroy(module);
+    smith_parse_cache_close(cache);
+    return (smith_parse_cache_load_result_t){};
+  }
+  return (smith_parse_cache_load_result_t){
+      .module = module, .cache = cache, .success = true};
+}
+
+void smith_parse_cache_close(smith_parse_cache_t cache) {
+  if (cache.mapping != nullptr) {
+    munmap(cache.mapping, cache.size);
+  }
+}
+
+smith_parse_module_cached_result_t
+smith_parse_module_cached(smith_parser_context_t context,
+                          smith_string_t source, const char *path) {
+  uint64_t source_hash = smith_source_hash(source);
+  smith_parse_cache_load_result_t load_result = smith_parse_cache_load(
+      context.allocator, context.interner, path, source_hash);
+  if (load_result.success) {
+    return (smith_parse_module_cached_result_t){.module = load_result.module,
+                                                .cache = load_result.cache,
+                                                .hit = true,
+                                                .success = true};
+  }
+  smith_tokenize_result_t tokenize_result = smith_tokenize(
+      context.allocator, smith_null_interner_create(), source.data);
+  if (!tokenize_result.success) {
+    return (smith_parse_module_cached_result_t){};
+  }
+  smith_parse_module_result_t parse_result =
+      smith_parse_module(context, &tokenize_result.buffer);
+  smith_token_buffer_destroy(tokenize_result.buffer);
+  if (!parse_result.success) {
+    smith_module_destroy(parse_result.module);
+    return (smith_parse_module_cached_result_t){};
+  }
+  // The cache only saves work next time, so failing to write it is not an
+  // error.
+  smith_parse_cache_write(context.allocator, &parse_result.module,
+                          source_hash, path);
+  return (smith_parse_module_cached_result_t){.module = parse_result.module,
+                                              .success = true};
+}
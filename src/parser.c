@@ -1,34 +1,145 @@
 #define SMITH_ENABLE_ALLOCATOR_MACROS
 
 #include "smith/parser.h"
-#include <assert.h>
+#include "smith/constant.h"
+#include "smith/dfa_tokenizer.h"
+#include "smith/null_interner.h"
+#include <string.h>
 
-static smith_next_token_result_t next_token(smith_parser_context_t context,
-                                            smith_cursor_t cursor) {
-  return smith_next_token(context.interner, cursor, context.keywords);
+// Where the parser reads its tokens from: a buffer lexed ahead of time, or the
+// source text, lexed on demand when `buffer` is null. Tokens lexed on demand
+// are not interned, since the token after an expression is lexed only to see
+// that it ends there. Names are interned once, when a node is built from them.
+// Running out of memory, for a node or while interning, stops the parse:
+// `exhausted` is set and no more nodes are read or built.
+typedef struct {
+  const smith_token_buffer_t *buffer;
+  size_t index;
+  smith_cursor_t cursor;
+  smith_cursor_t peeked;
+  smith_span_t error;
+  bool failed;
+  bool exhausted;
+} token_stream_t;
+
+// Returns the next token without consuming it. From text, the end of the
+// token is remembered so that `advance` does not lex it again.
+static smith_token_t peek(token_stream_t *stream) {
+  if (stream->buffer != nullptr) {
+    return smith_token_buffer_peek(stream->buffer, stream->index, 0);
+  }
+  smith_next_token_result_t next_token_result =
+      smith_dfa_next_token(smith_null_interner_create(), stream->cursor);
+  stream->peeked = next_token_result.cursor;
+  return next_token_result.token;
+}
+
+// Consumes the token returned by the last `peek`.
+static void advance(token_stream_t *stream) {
+  if (stream->buffer != nullptr) {
+    if (stream->index + 1 < stream->buffer->count) {
+      stream->index++;
+    }
+    return;
+  }
+  stream->cursor = stream->peeked;
+}
+
+// Records a syntax error at an unexpected token. Only the first error is
+// kept; parsing goes on without consuming the token so that it always ends.
+static void fail(token_stream_t *stream, smith_token_t token) {
+  if (!stream->failed) {
+    stream->error = *smith_token_span(&token);
+    stream->failed = true;
+  }
 }
 
-static smith_parse_result_t smith_parse_prefix(smith_parser_context_t context,
-                                               smith_cursor_t cursor) {
-  smith_next_token_result_t next_token_result = next_token(context, cursor);
-  switch (next_token_result.token.kind) {
+static smith_interned_t intern(smith_parser_context_t context,
+                               token_stream_t *stream, smith_string_t text) {
+  if (smith_interner_is_null(context.interner)) {
+    return 0;
+  }
+  smith_intern_result_t intern_result =
+      smith_interner_intern(context.interner, text);
+  if (!intern_result.success) {
+    stream->exhausted = true;
+  }
+  return intern_result.interned;
+}
+
+static smith_ast_node_t push_node(token_stream_t *stream,
+                                  smith_ast_push_result_t push_result) {
+  if (!push_result.success) {
+    stream->exhausted = true;
+  }
+  return push_result.node;
+}
+
+static smith_ast_node_t push_leaf(smith_parser_context_t context,
+                                  smith_ast_t *ast, token_stream_t *stream,
+                                  smith_expression_kind_t kind,
+                                  smith_span_t span, smith_string_t text) {
+  smith_ast_leaf_t leaf = {.text = text,
+                           .interned = intern(context, stream, text)};
+  return push_node(stream, smith_ast_push_leaf(ast, kind, span, leaf));
+}
+
+// Leaves of expressions are interned only once the whole expression is
+// parsed, in node order, so literals that are folded away are never interned.
+static smith_ast_node_t push_uninterned_leaf(smith_ast_t *ast,
+                                             token_stream_t *stream,
+                                             smith_expression_kind_t kind,
+                                             smith_span_t span,
+                                             smith_string_t text) {
+  smith_ast_leaf_t leaf = {.text = text};
+  return push_node(stream, smith_ast_push_leaf(ast, kind, span, leaf));
+}
+
+static void intern_leaves(smith_parser_context_t context, smith_ast_t *ast,
+                          token_stream_t *stream, smith_ast_node_t start) {
+  if (smith_interner_is_null(context.interner)) {
+    return;
+  }
+  for (smith_ast_node_t node = start; node < ast->count && !stream->exhausted;
+       node++) {
+    switch (ast->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_SYMBOL:
+    case SMITH_EXPRESSION_KIND_INT:
+    case SMITH_EXPRESSION_KIND_FLOAT: {
+      smith_ast_leaf_t *leaf = &ast->payloads[node].leaf;
+      leaf->interned = intern(context, stream, leaf->text);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+static smith_ast_node_t smith_parse_prefix(smith_ast_t *ast,
+                                           token_stream_t *stream) {
+  smith_token_t token = peek(stream);
+  smith_token_value_t value = token.value;
+  switch (token.kind) {
   case SMITH_TOKEN_KIND_SYMBOL:
-    return (smith_parse_result_t){
-        .expression = {.kind = SMITH_EXPRESSION_KIND_SYMBOL,
-                       .value.symbol = next_token_result.token.value.symbol},
-        .cursor = next_token_result.cursor};
+    advance(stream);
+    return push_uninterned_leaf(ast, stream, SMITH_EXPRESSION_KIND_SYMBOL,
+                                value.symbol.span, value.symbol.text);
   case SMITH_TOKEN_KIND_INT:
-    return (smith_parse_result_t){
-        .expression = {.kind = SMITH_EXPRESSION_KIND_INT,
-                       .value.int_ = next_token_result.token.value.int_},
-        .cursor = next_token_result.cursor};
+    advance(stream);
+    return push_uninterned_leaf(ast, stream, SMITH_EXPRESSION_KIND_INT,
+                                value.int_.span, value.int_.text);
   case SMITH_TOKEN_KIND_FLOAT:
-    return (smith_parse_result_t){
-        .expression = {.kind = SMITH_EXPRESSION_KIND_FLOAT,
-                       .value.float_ = next_token_result.token.value.float_},
-        .cursor = next_token_result.cursor};
+    advance(stream);
+    return push_uninterned_leaf(ast, stream, SMITH_EXPRESSION_KIND_FLOAT,
+                                value.float_.span, value.float_.text);
   default:
-    assert(false);
+    // A nameless symbol stands in for the missing operand, so the AST stays
+    // well formed.
+    fail(stream, token);
+    return push_uninterned_leaf(ast, stream, SMITH_EXPRESSION_KIND_SYMBOL,
+                                *smith_token_span(&token),
+                                (smith_string_t){});
   }
 }
 
@@ -68,63 +179,472 @@ static infix_parser_t infix_parser_for(smith_token_t token) {
   }
 }
 
-static smith_parse_result_t smith_parse_binary_operator(
-    smith_parser_context_t context, smith_cursor_t cursor,
-    smith_binary_operator_parser_t op, smith_expression_t left) {
-  smith_expression_t *left_ =
-      smith_allocator_allocate(context.allocator, smith_expression_t);
-  // TODO: Handle allocation failure.
-  assert(left_ != nullptr);
-  *left_ = left;
-  smith_parse_result_t right_parse_result =
-      smith_parse_expression(context, cursor);
-  smith_expression_t *right =
-      smith_allocator_allocate(context.allocator, smith_expression_t);
-  // TODO: Handle allocation failure.
-  assert(right != nullptr);
-  *right = right_parse_result.expression;
-  return (smith_parse_result_t){
-      .expression = {.kind = SMITH_EXPRESSION_KIND_BINARY_OPERATOR,
-                     .value.binary_operator =
-                         {.info = smith_binary_operator_mapping[op.kind],
-                          .op_span = op.span,
-                          .left = left_,
-                          .right = right}},
-      .cursor = right_parse_result.cursor};
+// Operands and the operators between them that are still waiting for their
+// right hand side to be complete. There is always one more operand than
+// operator. Short expressions stay in the inline arrays; longer ones move both
+// stacks to the heap, so nesting depth never costs native stack frames.
+#define PARSE_STACK_INLINE_CAPACITY 16
+
+typedef struct {
+  smith_binary_operator_info_t info;
+  smith_span_t span;
+} pending_operator_t;
+
+typedef struct {
+  smith_ast_node_t *operands;
+  pending_operator_t *operators;
+  size_t count;
+  size_t capacity;
+  smith_ast_node_t inline_operands[PARSE_STACK_INLINE_CAPACITY + 1];
+  pending_operator_t inline_operators[PARSE_STACK_INLINE_CAPACITY];
+} parse_stack_t;
+
+// Returns false if the stacks could not grow.
+static bool parse_stack_push(smith_parser_context_t context,
+                             parse_stack_t *stack, pending_operator_t op,
+                             smith_ast_node_t operand) {
+  if (stack->count == stack->capacity) {
+    size_t capacity = stack->capacity * 2;
+    smith_ast_node_t *operands = smith_allocator_allocate_array(
+        context.allocator, smith_ast_node_t, capacity + 1);
+    pending_operator_t *operators = smith_allocator_allocate_array(
+        context.allocator, pending_operator_t, capacity);
+    if (operands == nullptr || operators == nullptr) {
+      smith_allocator_deallocate(context.allocator, operands);
+      smith_allocator_deallocate(context.allocator, operators);
+      return false;
+    }
+    memcpy(operands, stack->operands,
+           (stack->count + 1) * sizeof(smith_ast_node_t));
+    memcpy(operators, stack->operators,
+           stack->count * sizeof(pending_operator_t));
+    if (stack->operands != stack->inline_operands) {
+      smith_allocator_deallocate(context.allocator, stack->operands);
+      smith_allocator_deallocate(context.allocator, stack->operators);
+    }
+    stack->operands = operands;
+    stack->operators = operators;
+    stack->capacity = capacity;
+  }
+  stack->operators[stack->count] = op;
+  stack->count++;
+  stack->operands[stack->count] = operand;
+  return true;
+}
+
+// The value of an operand, if it is a literal or an already folded constant.
+static smith_constant_result_t constant_of(const smith_ast_t *ast,
+                                           smith_ast_node_t node) {
+  switch (ast->kinds[node]) {
+  case SMITH_EXPRESSION_KIND_CONSTANT:
+    return (smith_constant_result_t){.constant = ast->payloads[node].constant,
+                                      .success = true};
+  case SMITH_EXPRESSION_KIND_INT:
+  case SMITH_EXPRESSION_KIND_FLOAT:
+    return smith_constant_from_literal(ast->kinds[node],
+                                       ast->payloads[node].leaf.text);
+  default:
+    return (smith_constant_result_t){};
+  }
+}
+
+// Replaces an operator over two constant operands by its value. Operands that
+// are leaves are always the last two nodes, since nothing is added between
+// the left operand of an operator and its right, so the constant simply takes
+// their place, in room the AST already has.
+static smith_ast_push_result_t fold(smith_ast_t *ast, pending_operator_t op,
+                                    smith_ast_children_t children) {
+  if (children.right != ast->count - 1 ||
+      children.left != children.right - 1) {
+    return (smith_ast_push_result_t){};
+  }
+  smith_constant_result_t left = constant_of(ast, children.left);
+  if (!left.success) {
+    return (smith_ast_push_result_t){};
+  }
+  smith_constant_result_t right = constant_of(ast, children.right);
+  if (!right.success) {
+    return (smith_ast_push_result_t){};
+  }
+  smith_constant_result_t folded =
+      smith_constant_fold(op.info.kind, left.constant, right.constant);
+  if (!folded.success) {
+    return (smith_ast_push_result_t){};
+  }
+  smith_span_t span = {.start = ast->spans[children.left].start,
+                       .end = ast->spans[children.right].end};
+  ast->count = children.left;
+  return smith_ast_push_constant(ast, span, folded.constant);
+}
+
+// Combines the top operator with the two operands on either side of it.
+static void parse_stack_reduce(smith_parser_context_t context,
+                               smith_ast_t *ast, token_stream_t *stream,
+                               parse_stack_t *stack) {
+  smith_ast_children_t children = {.left = stack->operands[stack->count - 1],
+                                   .right = stack->operands[stack->count]};
+  stack->count--;
+  pending_operator_t op = stack->operators[stack->count];
+  if (context.fold_constants) {
+    smith_ast_push_result_t fold_result = fold(ast, op, children);
+    if (fold_result.success) {
+      stack->operands[stack->count] = fold_result.node;
+      return;
+    }
+  }
+  stack->operands[stack->count] = push_node(
+      stream, smith_ast_push_binary_operator(ast, op.info, op.span, children));
+}
+
+// Whether the operator on top of the stack takes the operand after it before
+// `next` can, i.e. it binds tighter or equally tight and to the left.
+static bool binds_before(pending_operator_t top,
+                         smith_binary_operator_info_t next) {
+  return top.info.precedence > next.precedence ||
+         (top.info.precedence == next.precedence &&
+          next.associativity == SMITH_ASSOCIATIVITY_LEFT);
+}
+
+static smith_ast_node_t parse_expression(smith_parser_context_t context,
+                                         smith_ast_t *ast,
+                                         token_stream_t *stream) {
+  smith_ast_node_t start = ast->count;
+  parse_stack_t stack = {.capacity = PARSE_STACK_INLINE_CAPACITY};
+  stack.operands = stack.inline_operands;
+  stack.operators = stack.inline_operators;
+  stack.operands[0] = smith_parse_prefix(ast, stream);
+  while (!stream->exhausted) {
+    infix_parser_t infix_parser = infix_parser_for(peek(stream));
+    if (infix_parser.kind == INFIX_PARSER_KIND_NONE) {
+      break;
+    }
+    advance(stream);
+    smith_binary_operator_parser_t binary_operator =
+        infix_parser.value.binary_operator;
+    pending_operator_t op = {
+        .info = smith_binary_operator_mapping[binary_operator.kind],
+        .span = binary_operator.span};
+    while (!stream->exhausted && stack.count > 0 &&
+           binds_before(stack.operators[stack.count - 1], op.info)) {
+      parse_stack_reduce(context, ast, stream, &stack);
+    }
+    smith_ast_node_t operand = smith_parse_prefix(ast, stream);
+    if (!stream->exhausted &&
+        !parse_stack_push(context, &stack, op, operand)) {
+      stream->exhausted = true;
+    }
+  }
+  while (!stream->exhausted && stack.count > 0) {
+    parse_stack_reduce(context, ast, stream, &stack);
+  }
+  smith_ast_node_t root = stack.operands[0];
+  if (stack.operands != stack.inline_operands) {
+    smith_allocator_deallocate(context.allocator, stack.operands);
+    smith_allocator_deallocate(context.allocator, stack.operators);
+  }
+  if (!stream->exhausted) {
+    intern_leaves(context, ast, stream, start);
+  }
+  // The nodes of an expression that ran out of memory are dropped.
+  if (stream->exhausted) {
+    ast->count = start;
+  }
+  return root;
+}
+
+smith_parse_ast_result_t smith_parse_ast(smith_parser_context_t context,
+                                         smith_ast_t *ast,
+                                         smith_cursor_t cursor) {
+  token_stream_t stream = {.cursor = cursor};
+  smith_ast_node_t root = parse_expression(context, ast, &stream);
+  return (smith_parse_ast_result_t){
+      .root = root, .cursor = stream.cursor, .success = !stream.exhausted};
+}
+
+smith_parse_ast_buffer_result_t
+smith_parse_ast_buffer(smith_parser_context_t context, smith_ast_t *ast,
+                       const smith_token_buffer_t *buffer, size_t index) {
+  token_stream_t stream = {.buffer = buffer, .index = index};
+  smith_ast_node_t root = parse_expression(context, ast, &stream);
+  return (smith_parse_ast_buffer_result_t){
+      .root = root, .index = stream.index, .success = !stream.exhausted};
+}
+
+// Consumes a token of the given kind. Any other token is a syntax error, and
+// is returned without being consumed.
+static smith_token_t expect(token_stream_t *stream, smith_token_kind_t kind) {
+  smith_token_t token = peek(stream);
+  if (token.kind != kind) {
+    fail(stream, token);
+    return token;
+  }
+  advance(stream);
+  return token;
+}
+
+static bool is_delimiter(smith_token_t token, smith_delimiter_kind_t kind) {
+  return token.kind == SMITH_TOKEN_KIND_DELIMITER &&
+         token.value.delimiter.kind == kind;
+}
+
+static smith_span_t expect_delimiter(token_stream_t *stream,
+                                     smith_delimiter_kind_t kind) {
+  smith_token_t token = peek(stream);
+  if (!is_delimiter(token, kind)) {
+    fail(stream, token);
+    return *smith_token_span(&token);
+  }
+  advance(stream);
+  return token.value.delimiter.span;
+}
+
+smith_parse_function_result_t
+smith_parse_function(smith_parser_context_t context, smith_ast_t *ast,
+                     const smith_token_buffer_t *buffer, size_t index) {
+  token_stream_t stream = {.buffer = buffer, .index = index};
+  smith_token_t fn = peek(&stream);
+  if (fn.kind != SMITH_TOKEN_KIND_KEYWORD ||
+      fn.value.keyword.kind != SMITH_KEYWORD_KIND_FN) {
+    return (smith_parse_function_result_t){.index = index,
+                                           .error = *smith_token_span(&fn)};
+  }
+  advance(&stream);
+  smith_token_t name_token = expect(&stream, SMITH_TOKEN_KIND_SYMBOL);
+  if (stream.failed) {
+    return (smith_parse_function_result_t){.index = stream.index,
+                                           .error = stream.error};
+  }
+  smith_symbol_t name = name_token.value.symbol;
+  smith_function_t function = {
+      .name = {.text = name.text,
+               .interned = intern(context, &stream, name.text)},
+      .name_span = name.span,
+      .parameters = ast->count,
+  };
+  expect_delimiter(&stream, SMITH_DELIMITER_KIND_OPEN_PAREN);
+  while (!stream.failed && !stream.exhausted &&
+         !is_delimiter(peek(&stream), SMITH_DELIMITER_KIND_CLOSE_PAREN)) {
+    smith_token_t parameter_token = expect(&stream, SMITH_TOKEN_KIND_SYMBOL);
+    if (stream.failed) {
+      break;
+    }
+    smith_symbol_t parameter = parameter_token.value.symbol;
+    push_leaf(context, ast, &stream, SMITH_EXPRESSION_KIND_SYMBOL,
+              parameter.span, parameter.text);
+    function.parameter_count++;
+    if (!is_delimiter(peek(&stream), SMITH_DELIMITER_KIND_COMMA)) {
+      break;
+    }
+    advance(&stream);
+  }
+  expect_delimiter(&stream, SMITH_DELIMITER_KIND_CLOSE_PAREN);
+  expect_delimiter(&stream, SMITH_DELIMITER_KIND_OPEN_BRACE);
+  if (!stream.exhausted) {
+    function.body = parse_expression(context, ast, &stream);
+  }
+  smith_span_t close = expect_delimiter(&stream, SMITH_DELIMITER_KIND_CLOSE_BRACE);
+  if (stream.exhausted) {
+    ast->count = function.parameters;
+    return (smith_parse_function_result_t){.index = stream.index};
+  }
+  if (stream.failed) {
+    ast->count = function.parameters;
+    return (smith_parse_function_result_t){.index = stream.index,
+                                           .error = stream.error};
+  }
+  function.span = (smith_span_t){.start = fn.value.keyword.span.start,
+                                 .end = close.end};
+  function.offsets =
+      (smith_offsets_t){
+          .start = smith_token_buffer_offsets(buffer, index).start,
+          .end = smith_token_buffer_offsets(buffer, stream.index - 1).end};
+  return (smith_parse_function_result_t){
+      .function = function, .index = stream.index, .success = true};
+}
+
+smith_parse_module_result_t
+smith_parse_module(smith_parser_context_t context,
+                   const smith_token_buffer_t *buffer) {
+  smith_module_t module = smith_module_create(context.allocator);
+  size_t index = 0;
+  while (smith_token_buffer_peek(buffer, index, 0).kind !=
+         SMITH_TOKEN_KIND_END_OF_FILE) {
+    smith_parse_function_result_t parse_result =
+        smith_parse_function(context, &module.ast, buffer, index);
+    if (!parse_result.success) {
+      smith_module_destroy(module);
+      return (smith_parse_module_result_t){
+          .module = smith_module_create(context.allocator),
+          .error = parse_result.error};
+    }
+    if (!smith_module_push_function(&module, parse_result.function)) {
+      smith_module_destroy(module);
+      return (smith_parse_module_result_t){
+          .module = smith_module_create(context.allocator)};
+    }
+    index = parse_result.index;
+  }
+  return (smith_parse_module_result_t){.module = module, .success = true};
 }
 
 smith_parse_result_t smith_parse_expression(smith_parser_context_t context,
                                             smith_cursor_t cursor) {
-  smith_parse_result_t prefix_parse_result =
-      smith_parse_prefix(context, cursor);
-  smith_next_token_result_t next_token_result =
-      next_token(context, prefix_parse_result.cursor);
-  infix_parser_t infix_parser = infix_parser_for(next_token_result.token);
-  switch (infix_parser.kind) {
-  case INFIX_PARSER_KIND_BINARY_OPERATOR: {
-    return smith_parse_binary_operator(context, next_token_result.cursor,
-                                       infix_parser.value.binary_operator,
-                                       prefix_parse_result.expression);
+  smith_ast_t ast = smith_ast_create(context.allocator);
+  smith_parse_ast_result_t parse_result =
+      smith_parse_ast(context, &ast, cursor);
+  if (!parse_result.success) {
+    smith_ast_destroy(ast);
+    return (smith_parse_result_t){.cursor = parse_result.cursor};
+  }
+  smith_ast_to_expression_result_t to_expression_result =
+      smith_ast_to_expression(context.allocator, &ast, parse_result.root);
+  smith_ast_destroy(ast);
+  return (smith_parse_result_t){.expression = to_expression_result.expression,
+                                .cursor = parse_result.cursor,
+                                .success = to_expression_result.success};
+}
+
+smith_parse_buffer_result_t
+smith_parse_expression_buffer(smith_parser_context_t context,
+                              const smith_token_buffer_t *buffer,
+                              size_t index) {
+  smith_ast_t ast = smith_ast_create(context.allocator);
+  smith_parse_ast_buffer_result_t parse_result =
+      smith_parse_ast_buffer(context, &ast, buffer, index);
+  if (!parse_result.success) {
+    smith_ast_destroy(ast);
+    return (smith_parse_buffer_result_t){.index = parse_result.index};
   }
-  case INFIX_PARSER_KIND_NONE:
-    return prefix_parse_result;
+  smith_ast_to_expression_result_t to_expression_result =
+      smith_ast_to_expression(context.allocator, &ast, parse_result.root);
+  smith_ast_destroy(ast);
+  return (smith_parse_buffer_result_t){
+      .expression = to_expression_result.expression,
+      .index = parse_result.index,
+      .success = to_expression_result.success};
+}
+
+// Destroys the expressions built so far for the nodes of `ast` in
+// `[first, end)` that no operator holds yet: the roots of the subtrees that
+// end right before `end`, one after another back to `first`.
+static void destroy_built(smith_allocator_t allocator, const smith_ast_t *ast,
+                          smith_expression_t *expressions,
+                          smith_ast_node_t first, smith_ast_node_t end) {
+  smith_ast_node_t node = end;
+  while (node > first) {
+    node--;
+    smith_expression_destroy(allocator, expressions[node - first]);
+    node = smith_ast_first(ast, node);
   }
 }
 
+// Children precede their parents, so one pass over the subtree in node order
+// builds every operand before the operator that holds it.
+smith_ast_to_expression_result_t
+smith_ast_to_expression(smith_allocator_t allocator, const smith_ast_t *ast,
+                        smith_ast_node_t root) {
+  smith_ast_node_t first = smith_ast_first(ast, root);
+  size_t count = root - first + 1;
+  smith_expression_t *expressions =
+      smith_allocator_allocate_array(allocator, smith_expression_t, count);
+  if (expressions == nullptr) {
+    return (smith_ast_to_expression_result_t){};
+  }
+  for (smith_ast_node_t node = first; node <= root; node++) {
+    smith_span_t span = ast->spans[node];
+    smith_ast_payload_t payload = ast->payloads[node];
+    smith_expression_t *expression = &expressions[node - first];
+    switch ((smith_expression_kind_t)ast->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_SYMBOL:
+      *expression = (smith_expression_t){
+          .kind = SMITH_EXPRESSION_KIND_SYMBOL,
+          .value.symbol = {.span = span,
+                           .text = payload.leaf.text,
+                           .interned = payload.leaf.interned}};
+      break;
+    case SMITH_EXPRESSION_KIND_INT:
+      *expression = (smith_expression_t){
+          .kind = SMITH_EXPRESSION_KIND_INT,
+          .value.int_ = {.span = span,
+                         .text = payload.leaf.text,
+                         .interned = payload.leaf.interned}};
+      break;
+    case SMITH_EXPRESSION_KIND_FLOAT:
+      *expression = (smith_expression_t){
+          .kind = SMITH_EXPRESSION_KIND_FLOAT,
+          .value.float_ = {.span = span,
+                           .text = payload.leaf.text,
+                           .interned = payload.leaf.interned}};
+      break;
+    case SMITH_EXPRESSION_KIND_CONSTANT:
+      *expression = (smith_expression_t){
+          .kind = SMITH_EXPRESSION_KIND_CONSTANT,
+          .value.constant = {.span = span, .constant = payload.constant}};
+      break;
+    case SMITH_EXPRESSION_KIND_BINARY_OPERATOR: {
+      smith_ast_children_t children = ast->children[node];
+      smith_expression_t *left =
+          smith_allocator_allocate(allocator, smith_expression_t);
+      smith_expression_t *right =
+          smith_allocator_allocate(allocator, smith_expression_t);
+      if (left == nullptr || right == nullptr) {
+        smith_allocator_deallocate(allocator, left);
+        smith_allocator_deallocate(allocator, right);
+        destroy_built(allocator, ast, expressions, first, node);
+        smith_allocator_deallocate(allocator, expressions);
+        return (smith_ast_to_expression_result_t){};
+      }
+      *left = expressions[children.left - first];
+      *right = expressions[children.right - first];
+      *expression = (smith_expression_t){
+          .kind = SMITH_EXPRESSION_KIND_BINARY_OPERATOR,
+          .value.binary_operator = {.info = payload.binary_operator,
+                                    .op_span = span,
+                                    .left = left,
+                                    .right = right}};
+      break;
+    }
+    }
+  }
+  smith_expression_t expression = expressions[root - first];
+  smith_allocator_deallocate(allocator, expressions);
+  return (smith_ast_to_expression_result_t){.expression = expression,
+                                            .success = true};
+}
+
+// Frees the tree without recursion or a stack by rotating it as it goes:
+// while the current node has an operator on its left, that operator is
+// rotated up to take its place, so the tree becomes a right leaning chain that
+// is freed from the top down. Each rotation moves one operator off the left
+// spine for good, so the whole teardown is linear in the number of nodes. The
+// root is held by value rather than allocated, so it is never freed.
 void smith_expression_destroy(smith_allocator_t allocator,
                               smith_expression_t expression) {
-  switch (expression.kind) {
-  case SMITH_EXPRESSION_KIND_BINARY_OPERATOR: {
-    smith_expression_t *left = expression.value.binary_operator.left;
-    smith_expression_t *right = expression.value.binary_operator.right;
-    smith_expression_destroy(allocator, *left);
-    smith_expression_destroy(allocator, *right);
-    smith_allocator_deallocate(allocator, left);
-    smith_allocator_deallocate(allocator, right);
-    break;
+  smith_expression_t *root = &expression;
+  smith_expression_t *node = root;
+  while (node->kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    smith_binary_operator_t *binary_operator = &node->value.binary_operator;
+    smith_expression_t *left = binary_operator->left;
+    smith_expression_t *next;
+    if (left == nullptr) {
+      next = binary_operator->right;
+    } else if (left->kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      binary_operator->left = left->value.binary_operator.right;
+      left->value.binary_operator.right = node;
+      node = left;
+      continue;
+    } else {
+      smith_allocator_deallocate(allocator, left);
+      binary_operator->left = nullptr;
+      continue;
+    }
+    if (node != root) {
+      smith_allocator_deallocate(allocator, node);
+    }
+    node = next;
   }
-  default:
-    break;
+  if (node != root) {
+    smith_allocator_deallocate(allocator, node);
   }
 }
 
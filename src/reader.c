@@ -0,0 +1,10 @@
+#include "smith/reader.h"
+
+smith_read_result_t smith_reader_read(smith_reader_t reader, char *buffer,
+                                      size_t capacity) {
+  return reader.read(reader.state, buffer, capacity);
+}
+
+void smith_reader_destroy(smith_reader_t reader) {
+  reader.destroy(reader.state);
+}
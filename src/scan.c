@@ -0,0 +1,44 @@
+#include "smith/scan.h"
+#include <stdint.h>
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+static inline unsigned matches(__m128i block, __m128i a, __m128i b, __m128i c) {
+  __m128i match = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(block, a), _mm_cmpeq_epi8(block, b)),
+      _mm_or_si128(_mm_cmpeq_epi8(block, c),
+                   _mm_cmpeq_epi8(block, _mm_setzero_si128())));
+  return (unsigned)_mm_movemask_epi8(match);
+}
+
+// Only aligned blocks are loaded. They never cross a page boundary, so reading
+// the whole block holding the terminator is safe even though it runs past the
+// end of the string, which is also why the address sanitizer is turned off.
+__attribute__((no_sanitize_address)) char *smith_scan(char *source, char a,
+                                                      char b, char c) {
+  __m128i a_ = _mm_set1_epi8(a);
+  __m128i b_ = _mm_set1_epi8(b);
+  __m128i c_ = _mm_set1_epi8(c);
+  uintptr_t misalignment = (uintptr_t)source & 15;
+  const __m128i *block = (const __m128i *)(source - misalignment);
+  unsigned mask = matches(_mm_load_si128(block), a_, b_, c_) >> misalignment
+                  << misalignment;
+  while (mask == 0) {
+    block++;
+    mask = matches(_mm_load_si128(block), a_, b_, c_);
+  }
+  return (char *)block + __builtin_ctz(mask);
+}
+
+#else
+
+char *smith_scan(char *source, char a, char b, char c) {
+  while (*source != '\0' && *source != a && *source != b && *source != c) {
+    source++;
+  }
+  return source;
+}
+
+#endif
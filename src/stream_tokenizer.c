@@ -0,0 +1,265 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/stream_tokenizer.h"
+#include "smith/dfa_tokenizer.h"
+#include "smith/scan.h"
+#include <string.h>
+
+static bool reserve(smith_stream_tokenizer_t *tokenizer, size_t capacity) {
+  if (capacity <= tokenizer->capacity) {
+    return true;
+  }
+  size_t new_capacity = tokenizer->capacity * 2;
+  if (new_capacity < capacity) {
+    new_capacity = capacity;
+  }
+  char *buffer = smith_allocator_allocate_array(tokenizer->allocator, char,
+                                                new_capacity + 1);
+  if (buffer == nullptr) {
+    return false;
+  }
+  memcpy(buffer, tokenizer->buffer, tokenizer->length);
+  smith_allocator_deallocate(tokenizer->allocator, tokenizer->buffer);
+  tokenizer->buffer = buffer;
+  tokenizer->capacity = new_capacity;
+  return true;
+}
+
+// Finds the last guaranteed token boundary in `[low, high]`, or returns null.
+static char *last_boundary_in(char *low, char *high) {
+  for (char *boundary = high; boundary >= low; boundary--) {
+    if (smith_is_token_boundary(boundary[-1], boundary[0])) {
+      return boundary;
+    }
+  }
+  return nullptr;
+}
+
+// Finds where the string literal or comment at `source` ends, or returns null
+// if it may continue past the buffered text.
+static char *skip_string_or_comment(char *source) {
+  if (source[0] == '"') {
+    while (true) {
+      source = smith_scan(source + 1, '"', '\\', '\n');
+      switch (*source) {
+      case '"':
+        return source + 1;
+      case '\n':
+        return source;
+      case '\\':
+        if (source[1] == '\0') {
+          return nullptr;
+        }
+        if (source[1] == '\n') {
+          return source + 1;
+        }
+        source++;
+        break;
+      default:
+        return nullptr;
+      }
+    }
+  }
+  if (source[1] == '/') {
+    source = smith_scan(source + 2, '\n', '\n', '\n');
+    return *source == '\n' ? source : nullptr;
+  }
+  source++;
+  while (true) {
+    source = smith_scan(source + 1, '*', '*', '*');
+    if (*source == '\0') {
+      return nullptr;
+    }
+    if (source[1] == '/') {
+      return source + 2;
+    }
+  }
+}
+
+// Finds the last guaranteed token boundary after the cursor, or returns the
+// cursor if the buffered text after it could still be a single token. String
+// literals and comments are skipped with `smith_scan`, so no boundary is ever
+// placed inside one. A comment that runs past the buffered text ends the text
+// at its start, as no token ends in the slash opening it, so the tokenizer
+// reaches it and skips it as it is read rather than buffering all of it.
+static char *last_boundary(smith_stream_tokenizer_t *tokenizer) {
+  char *start = tokenizer->cursor.source;
+  char *end = tokenizer->buffer + tokenizer->length;
+  if (tokenizer->end_of_stream) {
+    return end;
+  }
+  char *boundary = start;
+  char *normal = start + 1;
+  char *source = start;
+  while (true) {
+    source = smith_scan(source, '"', '/', '/');
+    bool opens = *source == '"' ||
+                 (*source == '/' && (source[1] == '/' || source[1] == '*'));
+    if (*source == '/' && !opens && source[1] != '\0') {
+      source++;
+      continue;
+    }
+    char *high = *source == '\0' ? source - 1 : source;
+    if (normal <= high) {
+      char *candidate = last_boundary_in(normal, high);
+      if (candidate != nullptr) {
+        boundary = candidate;
+      }
+    }
+    if (!opens) {
+      return boundary;
+    }
+    char *opening = source;
+    source = skip_string_or_comment(source);
+    if (source == nullptr) {
+      return *opening == '/' ? opening : boundary;
+    }
+    normal = source > start + 1 ? source : start + 1;
+  }
+}
+
+// Terminates the text handed to the tokenizer at `end`, remembering the byte
+// that was overwritten so it can be restored before the next refill.
+static void hold(smith_stream_tokenizer_t *tokenizer, char *end) {
+  tokenizer->end = end;
+  tokenizer->held = *end;
+  *end = '\0';
+}
+
+// Moves the cursor past as much of the comment it is inside of or on the
+// start of as is buffered, so the bytes of a long comment are dropped by the
+// next refill rather than kept. A star at the very end of a block comment is
+// kept, as the slash closing the comment may be in the next chunk.
+static void skip_comment(smith_stream_tokenizer_t *tokenizer) {
+  smith_cursor_t cursor = tokenizer->cursor;
+  char *source = cursor.source;
+  if (tokenizer->comment == SMITH_STREAM_COMMENT_NONE) {
+    if (source[0] != '/' || (source[1] != '/' && source[1] != '*')) {
+      return;
+    }
+    tokenizer->comment = source[1] == '/' ? SMITH_STREAM_COMMENT_LINE
+                                          : SMITH_STREAM_COMMENT_BLOCK;
+    tokenizer->comment_start = cursor.position;
+    source += 2;
+  }
+  if (tokenizer->comment == SMITH_STREAM_COMMENT_LINE) {
+    source = smith_scan(source, '\n', '\n', '\n');
+    if (*source == '\n' || tokenizer->end_of_stream) {
+      tokenizer->comment = SMITH_STREAM_COMMENT_NONE;
+    }
+  } else {
+    while (true) {
+      source = smith_scan(source, '*', '\n', '\n');
+      if (*source == '\0') {
+        break;
+      }
+      if (*source == '\n') {
+        source++;
+        cursor = (smith_cursor_t){
+            .source = source, .position = {.line = cursor.position.line + 1}};
+        continue;
+      }
+      if (source[1] == '/') {
+        source += 2;
+        tokenizer->comment = SMITH_STREAM_COMMENT_NONE;
+        break;
+      }
+      if (source[1] == '\0' && !tokenizer->end_of_stream) {
+        break;
+      }
+      source++;
+    }
+  }
+  tokenizer->cursor = (smith_cursor_t){
+      .source = source,
+      .position = {.line = cursor.position.line,
+                   .column = cursor.position.column +
+                             (uint32_t)(source - cursor.source)}};
+}
+
+// Discards the consumed prefix of the buffer and appends the next chunk.
+static bool refill(smith_stream_tokenizer_t *tokenizer) {
+  *tokenizer->end = tokenizer->held;
+  skip_comment(tokenizer);
+  size_t consumed = tokenizer->cursor.source - tokenizer->buffer;
+  size_t remaining = tokenizer->length - consumed;
+  memmove(tokenizer->buffer, tokenizer->cursor.source, remaining);
+  tokenizer->length = remaining;
+  bool reserved = reserve(tokenizer, remaining + tokenizer->chunk_size);
+  tokenizer->cursor.source = tokenizer->buffer;
+  tokenizer->buffer[tokenizer->length] = '\0';
+  if (!reserved) {
+    hold(tokenizer, tokenizer->buffer);
+    return false;
+  }
+  smith_read_result_t read_result =
+      smith_reader_read(tokenizer->reader, tokenizer->buffer + remaining,
+                        tokenizer->chunk_size);
+  if (!read_result.success) {
+    hold(tokenizer, tokenizer->buffer);
+    return false;
+  }
+  tokenizer->length += read_result.length;
+  tokenizer->buffer[tokenizer->length] = '\0';
+  tokenizer->end_of_stream = read_result.length == 0;
+  skip_comment(tokenizer);
+  hold(tokenizer, tokenizer->comment == SMITH_STREAM_COMMENT_NONE
+                      ? last_boundary(tokenizer)
+                      : tokenizer->cursor.source);
+  return true;
+}
+
+smith_stream_tokenizer_create_result_t
+smith_stream_tokenizer_create(smith_allocator_t allocator,
+                              smith_interner_t interner, smith_reader_t reader,
+                              size_t chunk_size) {
+  char *buffer = smith_allocator_allocate_array(allocator, char, chunk_size + 1);
+  if (buffer == nullptr) {
+    return (smith_stream_tokenizer_create_result_t){};
+  }
+  buffer[0] = '\0';
+  return (smith_stream_tokenizer_create_result_t){
+      .tokenizer = {.allocator = allocator,
+                    .interner = interner,
+                    .reader = reader,
+                    .buffer = buffer,
+                    .end = buffer,
+                    .capacity = chunk_size,
+                    .chunk_size = chunk_size,
+                    .cursor = {.source = buffer}},
+      .success = true};
+}
+
+smith_stream_next_token_result_t
+smith_stream_next_token(smith_stream_tokenizer_t *tokenizer) {
+  while (true) {
+    // Skipping whitespace first keeps long runs of it out of the buffer.
+    tokenizer->cursor = smith_trim_whitespace(tokenizer->cursor);
+    if (tokenizer->cursor.source < tokenizer->end ||
+        tokenizer->end_of_stream) {
+      if (tokenizer->comment == SMITH_STREAM_COMMENT_BLOCK) {
+        tokenizer->comment = SMITH_STREAM_COMMENT_NONE;
+        smith_span_t span = {.start = tokenizer->comment_start,
+                             .end = tokenizer->cursor.position};
+        return (smith_stream_next_token_result_t){
+            .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                      .value.error = {.kind =
+                                          SMITH_ERROR_KIND_UNTERMINATED_COMMENT,
+                                      .value.unterminated_comment.span = span}},
+            .success = true};
+      }
+      smith_next_token_result_t result =
+          smith_dfa_next_token(tokenizer->interner, tokenizer->cursor);
+      tokenizer->cursor = result.cursor;
+      return (smith_stream_next_token_result_t){.token = result.token,
+                                                .success = true};
+    }
+    if (!refill(tokenizer)) {
+      return (smith_stream_next_token_result_t){};
+    }
+  }
+}
+
+void smith_stream_tokenizer_destroy(smith_stream_tokenizer_t tokenizer) {
+  smith_allocator_deallocate(tokenizer.allocator, tokenizer.buffer);
+}
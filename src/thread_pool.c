@@ -0,0 +1,133 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/thread_pool.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <threads.h>
+
+typedef struct {
+  smith_allocator_t allocator;
+  thrd_t *threads;
+  size_t thread_count;
+  mtx_t mutex;
+  cnd_t work_available;
+  cnd_t work_done;
+  void (*task)(void *state, size_t index);
+  void *state;
+  size_t count;
+  atomic_size_t next;
+  size_t active;
+  uint64_t generation;
+  bool stopping;
+} thread_pool_t;
+
+static void run_tasks(thread_pool_t *pool) {
+  while (true) {
+    size_t index = atomic_fetch_add(&pool->next, 1);
+    if (index >= pool->count) {
+      return;
+    }
+    pool->task(pool->state, index);
+  }
+}
+
+static int worker(void *argument) {
+  thread_pool_t *pool = argument;
+  uint64_t generation = 0;
+  mtx_lock(&pool->mutex);
+  while (true) {
+    while (!pool->stopping && pool->generation == generation) {
+      cnd_wait(&pool->work_available, &pool->mutex);
+    }
+    if (pool->stopping) {
+      mtx_unlock(&pool->mutex);
+      return 0;
+    }
+    generation = pool->generation;
+    mtx_unlock(&pool->mutex);
+    run_tasks(pool);
+    mtx_lock(&pool->mutex);
+    pool->active--;
+    if (pool->active == 0) {
+      cnd_signal(&pool->work_done);
+    }
+  }
+}
+
+static void stop(thread_pool_t *pool, size_t started) {
+  mtx_lock(&pool->mutex);
+  pool->stopping = true;
+  cnd_broadcast(&pool->work_available);
+  mtx_unlock(&pool->mutex);
+  for (size_t i = 0; i < started; i++) {
+    thrd_join(pool->threads[i], nullptr);
+  }
+  cnd_destroy(&pool->work_done);
+  cnd_destroy(&pool->work_available);
+  mtx_destroy(&pool->mutex);
+  smith_allocator_deallocate(pool->allocator, pool->threads);
+  smith_allocator_deallocate(pool->allocator, pool);
+}
+
+smith_thread_pool_create_result_t
+smith_thread_pool_create(smith_allocator_t allocator, size_t thread_count) {
+  thread_pool_t *pool = smith_allocator_allocate(allocator, thread_pool_t);
+  if (pool == nullptr) {
+    return (smith_thread_pool_create_result_t){};
+  }
+  thrd_t *threads =
+      smith_allocator_allocate_array(allocator, thrd_t, thread_count);
+  if (threads == nullptr && thread_count > 0) {
+    smith_allocator_deallocate(allocator, pool);
+    return (smith_thread_pool_create_result_t){};
+  }
+  *pool = (thread_pool_t){.allocator = allocator,
+                          .threads = threads,
+                          .thread_count = thread_count};
+  mtx_init(&pool->mutex, mtx_plain);
+  cnd_init(&pool->work_available);
+  cnd_init(&pool->work_done);
+  for (size_t i = 0; i < thread_count; i++) {
+    if (thrd_create(&threads[i], worker, pool) != thrd_success) {
+      stop(pool, i);
+      return (smith_thread_pool_create_result_t){};
+    }
+  }
+  return (smith_thread_pool_create_result_t){.pool = {.state = pool},
+                                             .success = true};
+}
+
+void smith_thread_pool_run(smith_thread_pool_t pool,
+                           void (*task)(void *state, size_t index),
+                           void *state, size_t count) {
+  thread_pool_t *thread_pool = pool.state;
+  assert(thread_pool != nullptr);
+  mtx_lock(&thread_pool->mutex);
+  thread_pool->task = task;
+  thread_pool->state = state;
+  thread_pool->count = count;
+  atomic_store(&thread_pool->next, 0);
+  thread_pool->active = thread_pool->thread_count;
+  thread_pool->generation++;
+  cnd_broadcast(&thread_pool->work_available);
+  mtx_unlock(&thread_pool->mutex);
+  run_tasks(thread_pool);
+  mtx_lock(&thread_pool->mutex);
+  while (thread_pool->active > 0) {
+    cnd_wait(&thread_pool->work_done, &thread_pool->mutex);
+  }
+  mtx_unlock(&thread_pool->mutex);
+}
+
+size_t smith_thread_pool_concurrency(smith_thread_pool_t pool) {
+  thread_pool_t *thread_pool = pool.state;
+  assert(thread_pool != nullptr);
+  return thread_pool->thread_count + 1;
+}
+
+void smith_thread_pool_destroy(smith_thread_pool_t pool) {
+  thread_pool_t *thread_pool = pool.state;
+  assert(thread_pool != nullptr);
+  stop(thread_pool, thread_pool->thread_count);
+}
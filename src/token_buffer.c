@@ -0,0 +1,290 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/token_buffer.h"
+#include "smith/dfa_tokenizer.h"
+#include <string.h>
+
+smith_token_buffer_t smith_token_buffer_create(smith_allocator_t allocator) {
+  return (smith_token_buffer_t){.allocator = allocator};
+}
+
+// Where the token at `index` is stored.
+static size_t slot_of(const smith_token_buffer_t *buffer, size_t index) {
+  return index < buffer->gap ? index
+                             : index + buffer->capacity - buffer->count;
+}
+
+static void shift_position(smith_position_t *position,
+                           smith_token_shift_t shift) {
+  if (position->line == shift.anchor_line) {
+    position->column =
+        (uint32_t)((int64_t)position->column + shift.column_delta);
+  }
+  position->line = (uint32_t)((int64_t)position->line + shift.line_delta);
+}
+
+// Undoes `shift_position`, storing a position as it was before the shift.
+static void unshift_position(smith_position_t *position,
+                             smith_token_shift_t shift) {
+  position->line = (uint32_t)((int64_t)position->line - shift.line_delta);
+  if (position->line == shift.anchor_line) {
+    position->column =
+        (uint32_t)((int64_t)position->column - shift.column_delta);
+  }
+}
+
+static void shift_token(smith_token_t *token, smith_offsets_t *offsets,
+                        smith_token_shift_t shift) {
+  smith_span_t *span = smith_token_span(token);
+  shift_position(&span->start, shift);
+  shift_position(&span->end, shift);
+  offsets->start += shift.offset_delta;
+  offsets->end += shift.offset_delta;
+}
+
+static void unshift_token(smith_token_t *token, smith_offsets_t *offsets,
+                          smith_token_shift_t shift) {
+  smith_span_t *span = smith_token_span(token);
+  unshift_position(&span->start, shift);
+  unshift_position(&span->end, shift);
+  offsets->start -= shift.offset_delta;
+  offsets->end -= shift.offset_delta;
+}
+
+static uint32_t stored_line(const smith_token_buffer_t *buffer, size_t slot) {
+  return smith_token_span(&buffer->tokens[slot])->start.line;
+}
+
+// Moves the gap to `index`. Tokens leaving the end of the buffer are shifted
+// as they move, and tokens joining it are stored as they were before the
+// shift. Columns only move on the line the first token after the gap starts
+// on, so when that line changes the column shift is first applied to the
+// tokens on the old line.
+static void move_gap(smith_token_buffer_t *buffer, size_t index) {
+  size_t gap_length = buffer->capacity - buffer->count;
+  smith_token_shift_t *shift = &buffer->shift;
+  if (index > buffer->gap) {
+    for (size_t i = buffer->gap; i < index; i++) {
+      buffer->tokens[i] = buffer->tokens[i + gap_length];
+      buffer->offsets[i] = buffer->offsets[i + gap_length];
+      shift_token(&buffer->tokens[i], &buffer->offsets[i], *shift);
+    }
+    buffer->gap = index;
+    if (index == buffer->count) {
+      *shift = (smith_token_shift_t){};
+    } else if (stored_line(buffer, index + gap_length) != shift->anchor_line) {
+      // No position after the gap is on the old anchor line any more.
+      shift->anchor_line = stored_line(buffer, index + gap_length);
+      shift->column_delta = 0;
+    }
+    return;
+  }
+  if (index == buffer->gap) {
+    return;
+  }
+  uint32_t line = smith_token_span(&buffer->tokens[index])->start.line;
+  if (buffer->gap == buffer->count) {
+    // Nothing is pending behind a gap at the end, so the tokens move as is.
+    *shift = (smith_token_shift_t){.anchor_line = line};
+    memmove(buffer->tokens + index + gap_length, buffer->tokens + index,
+            (buffer->gap - index) * sizeof(smith_token_t));
+    memmove(buffer->offsets + index + gap_length, buffer->offsets + index,
+            (buffer->gap - index) * sizeof(smith_offsets_t));
+    buffer->gap = index;
+    return;
+  }
+  if ((int64_t)line - shift->line_delta != shift->anchor_line &&
+             shift->column_delta != 0) {
+    smith_token_shift_t columns = {.column_delta = shift->column_delta,
+                                   .anchor_line = shift->anchor_line};
+    for (size_t slot = buffer->gap + gap_length;
+         slot < buffer->capacity &&
+         stored_line(buffer, slot) == shift->anchor_line;
+         slot++) {
+      smith_span_t *span = smith_token_span(&buffer->tokens[slot]);
+      shift_position(&span->start, columns);
+      shift_position(&span->end, columns);
+    }
+    shift->column_delta = 0;
+  }
+  if (shift->column_delta == 0) {
+    shift->anchor_line = (uint32_t)((int64_t)line - shift->line_delta);
+  }
+  for (size_t i = buffer->gap; i > index; i--) {
+    buffer->tokens[i - 1 + gap_length] = buffer->tokens[i - 1];
+    buffer->offsets[i - 1 + gap_length] = buffer->offsets[i - 1];
+    unshift_token(&buffer->tokens[i - 1 + gap_length],
+                  &buffer->offsets[i - 1 + gap_length], *shift);
+  }
+  buffer->gap = index;
+}
+
+bool smith_token_buffer_reserve(smith_token_buffer_t *buffer,
+                                size_t capacity) {
+  if (capacity <= buffer->capacity) {
+    return true;
+  }
+  size_t new_capacity = buffer->capacity * 2;
+  if (new_capacity < SMITH_TOKEN_BUFFER_MIN_CAPACITY) {
+    new_capacity = SMITH_TOKEN_BUFFER_MIN_CAPACITY;
+  }
+  if (new_capacity < capacity) {
+    new_capacity = capacity;
+  }
+  smith_allocator_t allocator = buffer->allocator;
+  smith_token_t *tokens =
+      smith_allocator_allocate_array(allocator, smith_token_t, new_capacity);
+  if (tokens == nullptr) {
+    return false;
+  }
+  smith_offsets_t *offsets =
+      smith_allocator_allocate_array(allocator, smith_offsets_t, new_capacity);
+  if (offsets == nullptr) {
+    smith_allocator_deallocate(allocator, tokens);
+    return false;
+  }
+  size_t after = buffer->count - buffer->gap;
+  if (buffer->gap > 0) {
+    memcpy(tokens, buffer->tokens, buffer->gap * sizeof(smith_token_t));
+    memcpy(offsets, buffer->offsets, buffer->gap * sizeof(smith_offsets_t));
+  }
+  if (after > 0) {
+    memcpy(tokens + new_capacity - after,
+           buffer->tokens + buffer->capacity - after,
+           after * sizeof(smith_token_t));
+    memcpy(offsets + new_capacity - after,
+           buffer->offsets + buffer->capacity - after,
+           after * sizeof(smith_offsets_t));
+  }
+  smith_allocator_deallocate(allocator, buffer->tokens);
+  smith_allocator_deallocate(allocator, buffer->offsets);
+  buffer->tokens = tokens;
+  buffer->offsets = offsets;
+  buffer->capacity = new_capacity;
+  return true;
+}
+
+bool smith_token_buffer_push(smith_token_buffer_t *buffer, smith_token_t token,
+                             smith_offsets_t offsets) {
+  if (!smith_token_buffer_reserve(buffer, buffer->count + 1)) {
+    return false;
+  }
+  move_gap(buffer, buffer->count);
+  buffer->tokens[buffer->count] = token;
+  buffer->offsets[buffer->count] = offsets;
+  buffer->count++;
+  buffer->gap = buffer->count;
+  return true;
+}
+
+smith_token_t smith_token_buffer_get(const smith_token_buffer_t *buffer,
+                                     size_t index) {
+  size_t slot = slot_of(buffer, index);
+  smith_token_t token = buffer->tokens[slot];
+  smith_offsets_t offsets = buffer->offsets[slot];
+  if (index >= buffer->gap) {
+    shift_token(&token, &offsets, buffer->shift);
+  }
+  smith_string_t *text = smith_token_text(&token);
+  if (text != nullptr && buffer->source != nullptr) {
+    // The text of a string literal starts after its opening quote.
+    text->data = buffer->source + offsets.start +
+                 (token.kind == SMITH_TOKEN_KIND_STRING);
+  }
+  return token;
+}
+
+smith_offsets_t smith_token_buffer_offsets(const smith_token_buffer_t *buffer,
+                                           size_t index) {
+  smith_offsets_t offsets = buffer->offsets[slot_of(buffer, index)];
+  if (index >= buffer->gap) {
+    offsets.start += buffer->shift.offset_delta;
+    offsets.end += buffer->shift.offset_delta;
+  }
+  return offsets;
+}
+
+void smith_token_buffer_shift(smith_token_buffer_t *buffer, size_t index,
+                              int64_t offset_delta, int64_t line_delta,
+                              int64_t column_delta) {
+  if (index == buffer->count) {
+    return;
+  }
+  move_gap(buffer, index);
+  // The first token after the gap starts on the anchor line, so the columns
+  // of the same positions move as before.
+  buffer->shift.offset_delta += offset_delta;
+  buffer->shift.line_delta += line_delta;
+  buffer->shift.column_delta += column_delta;
+}
+
+bool smith_token_buffer_splice(smith_token_buffer_t *buffer, size_t start,
+                               size_t end,
+                               const smith_token_buffer_t *replacement) {
+  size_t count = buffer->count - (end - start) + replacement->count;
+  if (!smith_token_buffer_reserve(buffer, count)) {
+    return false;
+  }
+  move_gap(buffer, end);
+  buffer->gap = start;
+  buffer->count -= end - start;
+  for (size_t i = 0; i < replacement->count; i++) {
+    buffer->tokens[buffer->gap] = smith_token_buffer_get(replacement, i);
+    buffer->offsets[buffer->gap] = smith_token_buffer_offsets(replacement, i);
+    buffer->gap++;
+  }
+  buffer->count = count;
+  return true;
+}
+
+size_t smith_token_buffer_find(const smith_token_buffer_t *buffer,
+                               size_t offset) {
+  size_t low = 0;
+  size_t high = buffer->count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (smith_token_buffer_offsets(buffer, middle).end < offset) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+smith_token_t smith_token_buffer_peek(const smith_token_buffer_t *buffer,
+                                      size_t index, size_t lookahead) {
+  size_t last = buffer->count - 1;
+  if (index >= last || lookahead >= last - index) {
+    return smith_token_buffer_get(buffer, last);
+  }
+  return smith_token_buffer_get(buffer, index + lookahead);
+}
+
+void smith_token_buffer_destroy(smith_token_buffer_t buffer) {
+  smith_allocator_deallocate(buffer.allocator, buffer.tokens);
+  smith_allocator_deallocate(buffer.allocator, buffer.offsets);
+}
+
+smith_tokenize_result_t smith_tokenize(smith_allocator_t allocator,
+                                       smith_interner_t interner,
+                                       char *source) {
+  smith_token_buffer_t buffer = smith_token_buffer_create(allocator);
+  smith_cursor_t cursor = {.source = source};
+  while (true) {
+    cursor = smith_trim_whitespace(cursor);
+    size_t start = cursor.source - source;
+    smith_next_token_result_t result = smith_dfa_next_token(interner, cursor);
+    smith_offsets_t offsets = {.start = start,
+                               .end = result.cursor.source - source};
+    if (!smith_token_buffer_push(&buffer, result.token, offsets)) {
+      smith_token_buffer_destroy(buffer);
+      return (smith_tokenize_result_t){};
+    }
+    if (result.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      buffer.source = source;
+      return (smith_tokenize_result_t){.buffer = buffer, .success = true};
+    }
+    cursor = result.cursor;
+  }
+}
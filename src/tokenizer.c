@@ -2,6 +2,12 @@
 
 #include "smith/tokenizer.h"
 #include "smith/interner.h"
+#include "smith/scan.h"
+#include "smith/unicode.h"
+#include <stdint.h>
+#include <string.h>
+
+#include "keyword_hash.inc"
 
 typedef struct {
   smith_string_t string;
@@ -51,39 +57,67 @@ static bool is_symbol_char(char c) {
          (c >= '0' && c <= '9') || c == '_';
 }
 
+static smith_next_token_result_t
+interning_failed(smith_string_t string, smith_span_t span,
+                 smith_cursor_t cursor) {
+  return (smith_next_token_result_t){
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
+                                .value.interning_failed = {.string = string,
+                                                           .span = span}}},
+      .cursor = cursor,
+  };
+}
+
+static take_while_result_t take_identifier(smith_cursor_t cursor,
+                                           size_t start_length) {
+  take_while_result_t take_while_result = take_while(
+      (smith_cursor_t){.source = cursor.source + start_length}, is_symbol_char);
+  char *end = take_while_result.cursor.source;
+  if ((uint8_t)*end >= 0x80) {
+    end = smith_skip_identifier(end);
+  }
+  size_t length = end - cursor.source;
+  return (take_while_result_t){
+      .string = {.data = cursor.source, .length = length},
+      .cursor = {.source = end,
+                 .position = {.line = cursor.position.line,
+                              .column = cursor.position.column + length}},
+  };
+}
+
 static smith_next_token_result_t tokenize_symbol(smith_interner_t intener,
                                                  smith_cursor_t cursor,
-                                                 smith_keywords_t keywords) {
-  take_while_result_t take_while_result = take_while(cursor, is_symbol_char);
-  smith_intern_result_t intern_result =
-      smith_interner_intern(intener, take_while_result.string);
-  if (intern_result.success) {
-    smith_span_t span = {.start = cursor.position,
-                         .end = take_while_result.cursor.position};
-    if (intern_result.interned == keywords.fn) {
-      return (smith_next_token_result_t){
-          .token = {.kind = SMITH_TOKEN_KIND_KEYWORD,
-                    .value.keyword = {.kind = SMITH_KEYWORD_KIND_FN,
-                                      .span = span}},
-          .cursor = take_while_result.cursor,
-      };
-    }
+                                                 size_t start_length) {
+  take_while_result_t take_while_result =
+      take_identifier(cursor, start_length);
+  smith_span_t span = {.start = cursor.position,
+                       .end = take_while_result.cursor.position};
+  smith_keyword_lookup_result_t keyword_lookup_result =
+      keyword_lookup(take_while_result.string);
+  if (keyword_lookup_result.success) {
     return (smith_next_token_result_t){
-        .token = {.kind = SMITH_TOKEN_KIND_SYMBOL,
-                  .value.symbol = {.interned = intern_result.interned,
-                                   .span = span}},
+        .token = {.kind = SMITH_TOKEN_KIND_KEYWORD,
+                  .value.keyword = {.kind = keyword_lookup_result.kind,
+                                    .span = span}},
         .cursor = take_while_result.cursor,
     };
   }
+  smith_interned_t interned = 0;
+  if (!smith_interner_is_null(intener)) {
+    smith_intern_result_t intern_result =
+        smith_interner_intern(intener, take_while_result.string);
+    if (!intern_result.success) {
+      return interning_failed(take_while_result.string, span,
+                              take_while_result.cursor);
+    }
+    interned = intern_result.interned;
+  }
   return (smith_next_token_result_t){
-      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
-                .value.error =
-                    {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
-                     .value = {.interning_failed =
-                                   {.string = take_while_result.string,
-                                    .span = {.start = cursor.position,
-                                             .end = take_while_result.cursor
-                                                        .position}}}}},
+      .token = {.kind = SMITH_TOKEN_KIND_SYMBOL,
+                .value.symbol = {.interned = interned,
+                                 .text = take_while_result.string,
+                                 .span = span}},
       .cursor = take_while_result.cursor,
   };
 }
@@ -106,32 +140,31 @@ static smith_next_token_result_t tokenize_number(smith_interner_t intener,
                                                  uint8_t decimals) {
   take_while_stateful_result_t take_while_result =
       take_while_stateful(cursor, is_numeric, &decimals);
-  smith_intern_result_t intern_result =
-      smith_interner_intern(intener, take_while_result.string);
-  if (!intern_result.success) {
-    return (smith_next_token_result_t){
-        .token =
-            {.kind = SMITH_TOKEN_KIND_ERROR,
-             .value = {.error = {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
-                                 .value = {.interning_failed =
-            {.string = take_while_result.string, .span = {.start = cursor.position,
-                                                         .end = take_while_result.cursor.position}}}}}},
-        .cursor = take_while_result.cursor,
-    };
-  }
   smith_span_t span = {.start = cursor.position,
                        .end = take_while_result.cursor.position};
+  smith_interned_t interned = 0;
+  if (!smith_interner_is_null(intener)) {
+    smith_intern_result_t intern_result =
+        smith_interner_intern(intener, take_while_result.string);
+    if (!intern_result.success) {
+      return interning_failed(take_while_result.string, span,
+                              take_while_result.cursor);
+    }
+    interned = intern_result.interned;
+  }
   if (decimals >= 1) {
     return (smith_next_token_result_t){
         .token = {.kind = SMITH_TOKEN_KIND_FLOAT,
-                  .value = {.float_ = {.interned = intern_result.interned,
+                  .value = {.float_ = {.interned = interned,
+                                       .text = take_while_result.string,
                                        .span = span}}},
         .cursor = take_while_result.cursor,
     };
   }
   return (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_INT,
-                .value = {.int_ = {.interned = intern_result.interned,
+                .value = {.int_ = {.interned = interned,
+                                   .text = take_while_result.string,
                                    .span = span}}},
       .cursor = take_while_result.cursor,
   };
@@ -170,7 +203,7 @@ tokenize_delimiter(smith_cursor_t cursor, smith_delimiter_kind_t kind) {
 }
 
 static smith_next_token_result_t
-tokenize_unexpected_character(smith_cursor_t cursor, char c) {
+tokenize_unexpected_character(smith_cursor_t cursor, char c, size_t length) {
   return (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_ERROR,
                 .value.error = {.kind = SMITH_ERROR_KIND_UNEXPECTED_CHARACTER,
@@ -178,26 +211,292 @@ tokenize_unexpected_character(smith_cursor_t cursor, char c) {
                                     {.character = c,
                                      .span = {.start = cursor.position,
                                               .end = cursor.position}}}},
-      .cursor = {.source = cursor.source + 1,
+      .cursor = {.source = cursor.source + length,
                  .position = {.line = cursor.position.line,
-                              .column = cursor.position.column + 1}},
+                              .column = cursor.position.column + length}},
   };
 }
 
-smith_keywords_create_result_t
-smith_keywords_create(smith_interner_t interner) {
-  smith_keywords_t keywords;
-  smith_intern_result_t intern_result = smith_interner_intern(
-      interner, (smith_string_t){.data = "fn", .length = 2});
-  if (!intern_result.success) {
-    return (smith_keywords_create_result_t){};
+smith_next_token_result_t smith_tokenize_non_ascii(smith_interner_t interner,
+                                                   smith_cursor_t cursor) {
+  smith_utf8_decode_result_t decode_result =
+      smith_utf8_decode(cursor.source);
+  if (!decode_result.success) {
+    return tokenize_unexpected_character(cursor, cursor.source[0], 1);
   }
-  keywords.fn = intern_result.interned;
-  return (smith_keywords_create_result_t){.keywords = keywords,
+  if (!smith_is_xid_start(decode_result.code_point)) {
+    return tokenize_unexpected_character(cursor, cursor.source[0],
+                                         decode_result.length);
+  }
+  return tokenize_symbol(interner, cursor, decode_result.length);
+}
+
+static bool decode_escape(char c, char *value) {
+  switch (c) {
+  case '\\':
+  case '"':
+    *value = c;
+    return true;
+  case 'n':
+    *value = '\n';
+    return true;
+  case 't':
+    *value = '\t';
+    return true;
+  case 'r':
+    *value = '\r';
+    return true;
+  case '0':
+    *value = '\0';
+    return true;
+  default:
+    return false;
+  }
+}
+
+static smith_position_t column_after(smith_cursor_t cursor, char *end) {
+  return (smith_position_t){.line = cursor.position.line,
+                            .column = cursor.position.column +
+                                      (uint32_t)(end - cursor.source)};
+}
+
+smith_next_token_result_t smith_tokenize_string(smith_cursor_t cursor) {
+  char *text = cursor.source + 1;
+  char *end = text;
+  char *invalid_escape = nullptr;
+  bool escaped = false;
+  while (true) {
+    end = smith_scan(end, '"', '\\', '\n');
+    if (*end != '\\') {
+      break;
+    }
+    escaped = true;
+    char value;
+    if (invalid_escape == nullptr && !decode_escape(end[1], &value)) {
+      invalid_escape = end;
+    }
+    if (end[1] == '\0' || end[1] == '\n') {
+      end++;
+      break;
+    }
+    end += 2;
+  }
+  if (*end != '"') {
+    smith_position_t position = column_after(cursor, end);
+    return (smith_next_token_result_t){
+        .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                  .value.error = {.kind = SMITH_ERROR_KIND_UNTERMINATED_STRING,
+                                  .value.unterminated_string.span =
+                                      {.start = cursor.position,
+                                       .end = position}}},
+        .cursor = {.source = end, .position = position},
+    };
+  }
+  smith_position_t position = column_after(cursor, end + 1);
+  if (invalid_escape != nullptr) {
+    smith_position_t start = column_after(cursor, invalid_escape);
+    return (smith_next_token_result_t){
+        .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                  .value.error = {.kind = SMITH_ERROR_KIND_INVALID_ESCAPE,
+                                  .value.invalid_escape =
+                                      {.character = invalid_escape[1],
+                                       .span = {.start = start,
+                                                .end = {.line = start.line,
+                                                        .column = start.column +
+                                                                  2}}}}},
+        .cursor = {.source = end + 1, .position = position},
+    };
+  }
+  return (smith_next_token_result_t){
+      .token = {.kind = SMITH_TOKEN_KIND_STRING,
+                .value.string = {.text = {.data = text,
+                                          .length = (size_t)(end - text)},
+                                 .escaped = escaped,
+                                 .span = {.start = cursor.position,
+                                          .end = position}}},
+      .cursor = {.source = end + 1, .position = position},
+  };
+}
+
+typedef struct {
+  smith_cursor_t cursor;
+  bool terminated;
+} skip_comment_result_t;
+
+static skip_comment_result_t skip_line_comment(smith_cursor_t cursor) {
+  char *end = smith_scan(cursor.source + 2, '\n', '\n', '\n');
+  return (skip_comment_result_t){
+      .cursor = {.source = end, .position = column_after(cursor, end)},
+      .terminated = true,
+  };
+}
+
+static skip_comment_result_t skip_block_comment(smith_cursor_t cursor) {
+  char *source = cursor.source + 2;
+  while (true) {
+    source = smith_scan(source, '*', '\n', '\n');
+    switch (*source) {
+    case '\n':
+      source++;
+      cursor = (smith_cursor_t){.source = source,
+                                .position = {.line = cursor.position.line + 1}};
+      break;
+    case '*':
+      source++;
+      if (*source == '/') {
+        source++;
+        return (skip_comment_result_t){
+            .cursor = {.source = source,
+                       .position = column_after(cursor, source)},
+            .terminated = true,
+        };
+      }
+      break;
+    default:
+      return (skip_comment_result_t){
+          .cursor = {.source = source,
+                     .position = column_after(cursor, source)},
+          .terminated = false,
+      };
+    }
+  }
+}
+
+smith_next_token_result_t
+smith_tokenize_unterminated_comment(smith_cursor_t cursor) {
+  smith_cursor_t end = skip_block_comment(cursor).cursor;
+  return (smith_next_token_result_t){
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_UNTERMINATED_COMMENT,
+                                .value.unterminated_comment.span =
+                                    {.start = cursor.position,
+                                     .end = end.position}}},
+      .cursor = end,
+  };
+}
+
+smith_decode_string_result_t
+smith_decode_string(smith_allocator_t allocator,
+                    smith_string_literal_t literal) {
+  if (!literal.escaped) {
+    return (smith_decode_string_result_t){.string = literal.text,
                                           .success = true};
+  }
+  char *data = smith_allocator_allocate_array(allocator, char,
+                                              literal.text.length + 1);
+  if (data == nullptr) {
+    return (smith_decode_string_result_t){};
+  }
+  char *source = literal.text.data;
+  char *end = source + literal.text.length;
+  size_t length = 0;
+  while (true) {
+    char *backslash = memchr(source, '\\', end - source);
+    size_t run = (backslash == nullptr ? end : backslash) - source;
+    memcpy(data + length, source, run);
+    length += run;
+    if (backslash == nullptr) {
+      break;
+    }
+    decode_escape(backslash[1], &data[length]);
+    length++;
+    source = backslash + 2;
+  }
+  data[length] = '\0';
+  return (smith_decode_string_result_t){
+      .string = {.data = data, .length = length}, .success = true};
+}
+
+smith_keyword_lookup_result_t smith_keyword_lookup(smith_string_t string) {
+  return keyword_lookup(string);
+}
+
+smith_span_t *smith_token_span(smith_token_t *token) {
+  switch (token->kind) {
+  case SMITH_TOKEN_KIND_SYMBOL:
+    return &token->value.symbol.span;
+  case SMITH_TOKEN_KIND_FLOAT:
+    return &token->value.float_.span;
+  case SMITH_TOKEN_KIND_INT:
+    return &token->value.int_.span;
+  case SMITH_TOKEN_KIND_STRING:
+    return &token->value.string.span;
+  case SMITH_TOKEN_KIND_OPERATOR:
+    return &token->value.operator_.span;
+  case SMITH_TOKEN_KIND_DELIMITER:
+    return &token->value.delimiter.span;
+  case SMITH_TOKEN_KIND_KEYWORD:
+    return &token->value.keyword.span;
+  case SMITH_TOKEN_KIND_END_OF_FILE:
+    return &token->value.end_of_file.span;
+  case SMITH_TOKEN_KIND_ERROR:
+    switch (token->value.error.kind) {
+    case SMITH_ERROR_KIND_UNEXPECTED_CHARACTER:
+      return &token->value.error.value.unexpected_character.span;
+    case SMITH_ERROR_KIND_INTERNING_FAILED:
+      return &token->value.error.value.interning_failed.span;
+    case SMITH_ERROR_KIND_UNTERMINATED_STRING:
+      return &token->value.error.value.unterminated_string.span;
+    case SMITH_ERROR_KIND_INVALID_ESCAPE:
+      return &token->value.error.value.invalid_escape.span;
+    case SMITH_ERROR_KIND_UNTERMINATED_COMMENT:
+      return &token->value.error.value.unterminated_comment.span;
+    }
+  }
+  return nullptr;
+}
+
+smith_string_t *smith_token_text(smith_token_t *token) {
+  switch (token->kind) {
+  case SMITH_TOKEN_KIND_SYMBOL:
+    return &token->value.symbol.text;
+  case SMITH_TOKEN_KIND_FLOAT:
+    return &token->value.float_.text;
+  case SMITH_TOKEN_KIND_INT:
+    return &token->value.int_.text;
+  case SMITH_TOKEN_KIND_STRING:
+    return &token->value.string.text;
+  case SMITH_TOKEN_KIND_ERROR:
+    if (token->value.error.kind == SMITH_ERROR_KIND_INTERNING_FAILED) {
+      return &token->value.error.value.interning_failed.string;
+    }
+    return nullptr;
+  default:
+    return nullptr;
+  }
+}
+
+smith_token_t smith_token_intern(smith_interner_t interner,
+                                 smith_token_t token) {
+  smith_interned_t *interned;
+  switch (token.kind) {
+  case SMITH_TOKEN_KIND_SYMBOL:
+    interned = &token.value.symbol.interned;
+    break;
+  case SMITH_TOKEN_KIND_FLOAT:
+    interned = &token.value.float_.interned;
+    break;
+  case SMITH_TOKEN_KIND_INT:
+    interned = &token.value.int_.interned;
+    break;
+  default:
+    return token;
+  }
+  smith_string_t text = *smith_token_text(&token);
+  smith_intern_result_t intern_result = smith_interner_intern(interner, text);
+  if (!intern_result.success) {
+    return (smith_token_t){
+        .kind = SMITH_TOKEN_KIND_ERROR,
+        .value.error = {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
+                        .value.interning_failed = {
+                            .string = text,
+                            .span = *smith_token_span(&token)}}};
+  }
+  *interned = intern_result.interned;
+  return token;
 }
 
-smith_cursor_t trim_whitespace(smith_cursor_t cursor) {
+smith_cursor_t smith_trim_whitespace(smith_cursor_t cursor) {
   while (true) {
     switch (*cursor.source) {
     case ' ':
@@ -208,6 +507,21 @@ smith_cursor_t trim_whitespace(smith_cursor_t cursor) {
       cursor.position.line++;
       cursor.position.column = 0;
       break;
+    case '/': {
+      skip_comment_result_t skip_comment_result;
+      if (cursor.source[1] == '/') {
+        skip_comment_result = skip_line_comment(cursor);
+      } else if (cursor.source[1] == '*') {
+        skip_comment_result = skip_block_comment(cursor);
+      } else {
+        return cursor;
+      }
+      if (!skip_comment_result.terminated) {
+        return cursor;
+      }
+      cursor = skip_comment_result.cursor;
+      continue;
+    }
     default:
       return cursor;
     }
@@ -215,14 +529,51 @@ smith_cursor_t trim_whitespace(smith_cursor_t cursor) {
   }
 }
 
+typedef enum {
+  CHARACTER_CLASS_WORD,
+  CHARACTER_CLASS_OPERATOR,
+  CHARACTER_CLASS_SINGLE,
+} character_class_t;
+
+static character_class_t character_class(char c) {
+  switch (c) {
+  case 'a' ... 'z':
+  case 'A' ... 'Z':
+  case '0' ... '9':
+  case '_':
+  case '.':
+  case '\x80' ... '\xff':
+    return CHARACTER_CLASS_WORD;
+  case '+':
+  case '-':
+  case '*':
+  case '/':
+  case '=':
+  case '!':
+  case '<':
+  case '>':
+  case '&':
+  case '|':
+    return CHARACTER_CLASS_OPERATOR;
+  default:
+    return CHARACTER_CLASS_SINGLE;
+  }
+}
+
+bool smith_is_token_boundary(char previous, char next) {
+  character_class_t previous_class = character_class(previous);
+  character_class_t next_class = character_class(next);
+  return previous_class != next_class ||
+         previous_class == CHARACTER_CLASS_SINGLE;
+}
+
 #define tokenize_operator(kind, next_char, next_kind)                          \
   tokenize_operator(cursor, SMITH_OPERATOR_KIND_##kind, next_char,             \
                     SMITH_OPERATOR_KIND_##next_kind)
 
 smith_next_token_result_t smith_next_token(smith_interner_t intener,
-                                           smith_cursor_t cursor,
-                                           smith_keywords_t keywords) {
-  cursor = trim_whitespace(cursor);
+                                           smith_cursor_t cursor) {
+  cursor = smith_trim_whitespace(cursor);
   if (cursor.source[0] == '\0') {
     return (smith_next_token_result_t){
         .token = {.kind = SMITH_TOKEN_KIND_END_OF_FILE,
@@ -235,7 +586,7 @@ smith_next_token_result_t smith_next_token(smith_interner_t intener,
   case 'a' ... 'z':
   case 'A' ... 'Z':
   case '_':
-    return tokenize_symbol(intener, cursor, keywords);
+    return tokenize_symbol(intener, cursor, 1);
   case '0' ... '9':
     return tokenize_number(intener, cursor, 0);
   case '.':
@@ -247,7 +598,12 @@ smith_next_token_result_t smith_next_token(smith_interner_t intener,
   case '*':
     return tokenize_operator(MUL, '=', MUL_ASSIGN);
   case '/':
+    if (cursor.source[1] == '*') {
+      return smith_tokenize_unterminated_comment(cursor);
+    }
     return tokenize_operator(DIV, '=', DIV_ASSIGN);
+  case '"':
+    return smith_tokenize_string(cursor);
   case '=':
     return tokenize_operator(ASSIGN, '=', EQ);
   case '!':
@@ -274,8 +630,10 @@ smith_next_token_result_t smith_next_token(smith_interner_t intener,
     return tokenize_delimiter(cursor, SMITH_DELIMITER_KIND_CLOSE_BRACKET);
   case ',':
     return tokenize_delimiter(cursor, SMITH_DELIMITER_KIND_COMMA);
+  case '\x80' ... '\xff':
+    return smith_tokenize_non_ascii(intener, cursor);
   default:
-    return tokenize_unexpected_character(cursor, cursor.source[0]);
+    return tokenize_unexpected_character(cursor, cursor.source[0], 1);
   }
 }
 
@@ -0,0 +1,193 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/type.h"
+#include <string.h>
+
+smith_type_table_t smith_type_table_create(smith_allocator_t allocator) {
+  return (smith_type_table_t){.allocator = allocator};
+}
+
+static uint64_t hash_type(smith_type_info_t info,
+                          const smith_type_t *parameters) {
+  uint64_t hash =
+      smith_hash_mix(smith_hash_mix(info.kind, info.width), info.result);
+  for (uint32_t i = 0; i < info.parameter_count; i++) {
+    hash = smith_hash_mix(hash, parameters[i]);
+  }
+  return smith_hash_mix(hash, info.parameter_count);
+}
+
+static bool grow_if_needed(smith_type_table_t *table) {
+  if (table->count < table->capacity) {
+    return true;
+  }
+  if (table->capacity > UINT32_MAX / 4) {
+    return false;
+  }
+  uint32_t capacity = table->capacity == 0 ? SMITH_TYPE_TABLE_MIN_CAPACITY
+                                           : table->capacity * 2;
+  smith_allocator_t allocator = table->allocator;
+  smith_type_info_t *types =
+      smith_allocator_allocate_array(allocator, smith_type_info_t, capacity);
+  uint64_t *hashes =
+      smith_allocator_allocate_array(allocator, uint64_t, capacity);
+  if (types == nullptr || hashes == nullptr ||
+      !smith_hash_index_resize(allocator, &table->index, capacity,
+                               table->hashes, table->count)) {
+    smith_allocator_deallocate(allocator, types);
+    smith_allocator_deallocate(allocator, hashes);
+    return false;
+  }
+  if (table->count > 0) {
+    memcpy(types, table->types, table->count * sizeof(smith_type_info_t));
+    memcpy(hashes, table->hashes, table->count * sizeof(uint64_t));
+  }
+  smith_allocator_deallocate(allocator, table->types);
+  smith_allocator_deallocate(allocator, table->hashes);
+  table->types = types;
+  table->hashes = hashes;
+  table->capacity = capacity;
+  return true;
+}
+
+// The old array is handed back rather than released, as the parameter types
+// being added may be a list already in it.
+static bool grow_parameters_if_needed(smith_type_table_t *table,
+                                      uint32_t count, smith_type_t **old) {
+  if (count > UINT32_MAX / 2 - table->parameter_count) {
+    return false;
+  }
+  uint32_t needed = table->parameter_count + count;
+  if (needed <= table->parameter_capacity) {
+    return true;
+  }
+  uint32_t capacity = table->parameter_capacity == 0
+                          ? SMITH_TYPE_TABLE_MIN_CAPACITY
+                          : table->parameter_capacity;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+  smith_type_t *parameters = smith_allocator_allocate_array(
+      table->allocator, smith_type_t, capacity);
+  if (parameters == nullptr) {
+    return false;
+  }
+  if (table->parameter_count > 0) {
+    memcpy(parameters, table->parameters,
+           table->parameter_count * sizeof(smith_type_t));
+  }
+  *old = table->parameters;
+  table->parameters = parameters;
+  table->parameter_capacity = capacity;
+  return true;
+}
+
+// What a type is looked up by, along with the table, for the equality
+// callback of the hash index.
+typedef struct {
+  const smith_type_table_t *table;
+  smith_type_info_t info;
+  const smith_type_t *parameters;
+} type_key_t;
+
+static bool type_equal(const void *state, uint32_t type) {
+  const type_key_t *key = state;
+  smith_type_info_t existing = key->table->types[type];
+  smith_type_info_t info = key->info;
+  return existing.kind == info.kind && existing.width == info.width &&
+         existing.result == info.result &&
+         existing.parameter_count == info.parameter_count &&
+         (info.parameter_count == 0 ||
+          memcmp(key->table->parameters + existing.parameters, key->parameters,
+                 info.parameter_count * sizeof(smith_type_t)) == 0);
+}
+
+static smith_type_intern_result_t intern(smith_type_table_t *table,
+                                         smith_type_info_t info,
+                                         const smith_type_t *parameters) {
+  // Growing first keeps the slot found below valid for the insertion.
+  if (!grow_if_needed(table)) {
+    return (smith_type_intern_result_t){};
+  }
+  uint64_t hash = hash_type(info, parameters);
+  type_key_t key = {.table = table, .info = info, .parameters = parameters};
+  uint32_t slot = smith_hash_index_find(&table->index, table->hashes, hash,
+                                        type_equal, &key);
+  if (table->index.slots[slot] != 0) {
+    return (smith_type_intern_result_t){.type = table->index.slots[slot] - 1,
+                                        .success = true};
+  }
+  smith_type_t *old = nullptr;
+  if (!grow_parameters_if_needed(table, info.parameter_count, &old)) {
+    return (smith_type_intern_result_t){};
+  }
+  info.parameters = table->parameter_count;
+  if (info.parameter_count > 0) {
+    memcpy(table->parameters + table->parameter_count, parameters,
+           info.parameter_count * sizeof(smith_type_t));
+  }
+  smith_allocator_deallocate(table->allocator, old);
+  table->parameter_count += info.parameter_count;
+  smith_type_t type = table->count++;
+  table->types[type] = info;
+  table->hashes[type] = hash;
+  table->index.slots[slot] = type + 1;
+  return (smith_type_intern_result_t){.type = type, .success = true};
+}
+
+smith_type_intern_result_t smith_type_intern_int(smith_type_table_t *table,
+                                                 uint32_t width) {
+  if (width == 0 || width > 64) {
+    return (smith_type_intern_result_t){};
+  }
+  return intern(table,
+                (smith_type_info_t){.kind = SMITH_TYPE_KIND_INT,
+                                    .width = width,
+                                    .result = SMITH_TYPE_NONE},
+                nullptr);
+}
+
+smith_type_intern_result_t smith_type_intern_float(smith_type_table_t *table,
+                                                   uint32_t width) {
+  if (width != 32 && width != 64) {
+    return (smith_type_intern_result_t){};
+  }
+  return intern(table,
+                (smith_type_info_t){.kind = SMITH_TYPE_KIND_FLOAT,
+                                    .width = width,
+                                    .result = SMITH_TYPE_NONE},
+                nullptr);
+}
+
+smith_type_intern_result_t smith_type_intern_bool(smith_type_table_t *table) {
+  return intern(table,
+                (smith_type_info_t){.kind = SMITH_TYPE_KIND_BOOL,
+                                    .result = SMITH_TYPE_NONE},
+                nullptr);
+}
+
+smith_type_intern_result_t
+smith_type_intern_function(smith_type_table_t *table,
+                           const smith_type_t *parameters,
+                           uint32_t parameter_count, smith_type_t result) {
+  if (result >= table->count) {
+    return (smith_type_intern_result_t){};
+  }
+  for (uint32_t i = 0; i < parameter_count; i++) {
+    if (parameters[i] >= table->count) {
+      return (smith_type_intern_result_t){};
+    }
+  }
+  return intern(table,
+                (smith_type_info_t){.kind = SMITH_TYPE_KIND_FUNCTION,
+                                    .parameter_count = parameter_count,
+                                    .result = result},
+                parameters);
+}
+
+void smith_type_table_destroy(smith_type_table_t table) {
+  smith_allocator_deallocate(table.allocator, table.types);
+  smith_allocator_deallocate(table.allocator, table.hashes);
+  smith_hash_index_destroy(table.allocator, table.index);
+  smith_allocator_deallocate(table.allocator, table.parameters);
+}
@@ -0,0 +1,152 @@
+#include "smith/unicode.h"
+
+#include "xid_table.inc"
+
+static inline bool is_continuation(uint8_t byte) {
+  return (byte & 0xC0) == 0x80;
+}
+
+smith_utf8_decode_result_t smith_utf8_decode(const char *source) {
+  const uint8_t *bytes = (const uint8_t *)source;
+  uint8_t lead = bytes[0];
+  if (lead < 0x80) {
+    return (smith_utf8_decode_result_t){
+        .code_point = lead, .length = 1, .success = true};
+  }
+  uint8_t length;
+  uint32_t code_point;
+  uint32_t minimum;
+  switch (lead) {
+  case 0xC2 ... 0xDF:
+    length = 2;
+    code_point = lead & 0x1F;
+    minimum = 0x80;
+    break;
+  case 0xE0 ... 0xEF:
+    length = 3;
+    code_point = lead & 0x0F;
+    minimum = 0x800;
+    break;
+  case 0xF0 ... 0xF4:
+    length = 4;
+    code_point = lead & 0x07;
+    minimum = 0x10000;
+    break;
+  default:
+    return (smith_utf8_decode_result_t){};
+  }
+  // A null terminator is not a continuation byte, so a truncated sequence
+  // fails before anything past the end of the string is read.
+  for (uint8_t i = 1; i < length; i++) {
+    if (!is_continuation(bytes[i])) {
+      return (smith_utf8_decode_result_t){};
+    }
+    code_point = code_point << 6 | (bytes[i] & 0x3F);
+  }
+  if (code_point < minimum || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    return (smith_utf8_decode_result_t){};
+  }
+  return (smith_utf8_decode_result_t){
+      .code_point = code_point, .length = length, .success = true};
+}
+
+// Checks the multi-byte sequence at `i`, which the caller knows starts with a
+// non-ASCII byte. Unlike `smith_utf8_decode` the string need not be null
+// terminated, so the sequence length is checked against `length` first.
+static size_t sequence_length(const uint8_t *bytes, size_t i, size_t length) {
+  uint8_t lead = bytes[i];
+  size_t size = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+  if (length - i < size) {
+    return 0;
+  }
+  char sequence[5] = {};
+  for (size_t j = 0; j < size; j++) {
+    sequence[j] = (char)bytes[i + j];
+  }
+  return smith_utf8_decode(sequence).length;
+}
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+static size_t skip_ascii(const uint8_t *bytes, size_t i, size_t length) {
+  while (length - i >= 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(bytes + i));
+    unsigned mask = (unsigned)_mm_movemask_epi8(block);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+    i += 16;
+  }
+  while (i < length && bytes[i] < 0x80) {
+    i++;
+  }
+  return i;
+}
+
+#else
+
+static size_t skip_ascii(const uint8_t *bytes, size_t i, size_t length) {
+  while (i < length && bytes[i] < 0x80) {
+    i++;
+  }
+  return i;
+}
+
+#endif
+
+smith_utf8_validate_result_t smith_utf8_validate(smith_string_t string) {
+  const uint8_t *bytes = (const uint8_t *)string.data;
+  size_t i = 0;
+  while (true) {
+    i = skip_ascii(bytes, i, string.length);
+    if (i == string.length) {
+      return (smith_utf8_validate_result_t){.offset = i, .success = true};
+    }
+    size_t length = sequence_length(bytes, i, string.length);
+    if (length == 0) {
+      return (smith_utf8_validate_result_t){.offset = i};
+    }
+    i += length;
+  }
+}
+
+static inline bool xid_bit(uint32_t code_point, size_t set) {
+  if (code_point >> 8 >= sizeof(xid_stage1)) {
+    return false;
+  }
+  uint64_t word =
+      xid_blocks[xid_stage1[code_point >> 8]][set * 4 + (code_point >> 6 & 3)];
+  return word >> (code_point & 63) & 1;
+}
+
+bool smith_is_xid_start(uint32_t code_point) { return xid_bit(code_point, 0); }
+
+bool smith_is_xid_continue(uint32_t code_point) {
+  return xid_bit(code_point, 1);
+}
+
+char *smith_skip_identifier(char *source) {
+  while (true) {
+    switch (*source) {
+    case 'a' ... 'z':
+    case 'A' ... 'Z':
+    case '0' ... '9':
+    case '_':
+      source++;
+      continue;
+    case '\x80' ... '\xff':
+      break;
+    default:
+      return source;
+    }
+    smith_utf8_decode_result_t decode_result = smith_utf8_decode(source);
+    if (!decode_result.success ||
+        !smith_is_xid_continue(decode_result.code_point)) {
+      return source;
+    }
+    source += decode_result.length;
+  }
+}
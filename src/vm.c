@@ -0,0 +1,179 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/vm.h"
+#include <string.h>
+
+// Runs the instructions on a register file already holding the arguments and
+// constants.
+static smith_vm_run_result_t execute(const smith_instruction_t *instructions,
+                                     smith_constant_value_t *registers) {
+  static void *const handlers[] = {
+      [SMITH_OPCODE_MOVE] = &&move,
+      [SMITH_OPCODE_INT_ADD] = &&int_add,
+      [SMITH_OPCODE_INT_SUB] = &&int_sub,
+      [SMITH_OPCODE_INT_MUL] = &&int_mul,
+      [SMITH_OPCODE_INT_DIV] = &&int_div,
+      [SMITH_OPCODE_INT_EQ] = &&int_eq,
+      [SMITH_OPCODE_INT_NOT_EQ] = &&int_not_eq,
+      [SMITH_OPCODE_INT_LT] = &&int_lt,
+      [SMITH_OPCODE_INT_LE] = &&int_le,
+      [SMITH_OPCODE_INT_GT] = &&int_gt,
+      [SMITH_OPCODE_INT_GE] = &&int_ge,
+      [SMITH_OPCODE_INT_BIT_AND] = &&int_bit_and,
+      [SMITH_OPCODE_INT_BIT_OR] = &&int_bit_or,
+      [SMITH_OPCODE_FLOAT_ADD] = &&float_add,
+      [SMITH_OPCODE_FLOAT_SUB] = &&float_sub,
+      [SMITH_OPCODE_FLOAT_MUL] = &&float_mul,
+      [SMITH_OPCODE_FLOAT_DIV] = &&float_div,
+      [SMITH_OPCODE_FLOAT_EQ] = &&float_eq,
+      [SMITH_OPCODE_FLOAT_NOT_EQ] = &&float_not_eq,
+      [SMITH_OPCODE_FLOAT_LT] = &&float_lt,
+      [SMITH_OPCODE_FLOAT_LE] = &&float_le,
+      [SMITH_OPCODE_FLOAT_GT] = &&float_gt,
+      [SMITH_OPCODE_FLOAT_GE] = &&float_ge,
+      [SMITH_OPCODE_BOOL_EQ] = &&bool_eq,
+      [SMITH_OPCODE_BOOL_NOT_EQ] = &&bool_not_eq,
+      [SMITH_OPCODE_BOOL_AND] = &&bool_and,
+      [SMITH_OPCODE_BOOL_OR] = &&bool_or,
+      [SMITH_OPCODE_RETURN] = &&return_,
+  };
+  const smith_instruction_t *instruction = instructions;
+  smith_constant_value_t *destination;
+  smith_constant_value_t left;
+  smith_constant_value_t right;
+
+// Operands are read before the destination is written, so an instruction
+// may update one of its own operands.
+#define DISPATCH()                                                             \
+  do {                                                                         \
+    destination = &registers[instruction->destination];                        \
+    left = registers[instruction->left];                                       \
+    right = registers[instruction->right];                                     \
+    goto *handlers[(instruction++)->opcode];                                   \
+  } while (false)
+
+#define CHECKED(builtin)                                                       \
+  if (builtin(left.int_, right.int_, &destination->int_)) {                    \
+    goto trap;                                                                 \
+  }                                                                            \
+  DISPATCH()
+
+  DISPATCH();
+move:
+  *destination = left;
+  DISPATCH();
+int_add:
+  CHECKED(__builtin_add_overflow);
+int_sub:
+  CHECKED(__builtin_sub_overflow);
+int_mul:
+  CHECKED(__builtin_mul_overflow);
+int_div:
+  if (right.int_ == 0 || (left.int_ == INT64_MIN && right.int_ == -1)) {
+    goto trap;
+  }
+  destination->int_ = left.int_ / right.int_;
+  DISPATCH();
+int_eq:
+  destination->bool_ = left.int_ == right.int_;
+  DISPATCH();
+int_not_eq:
+  destination->bool_ = left.int_ != right.int_;
+  DISPATCH();
+int_lt:
+  destination->bool_ = left.int_ < right.int_;
+  DISPATCH();
+int_le:
+  destination->bool_ = left.int_ <= right.int_;
+  DISPATCH();
+int_gt:
+  destination->bool_ = left.int_ > right.int_;
+  DISPATCH();
+int_ge:
+  destination->bool_ = left.int_ >= right.int_;
+  DISPATCH();
+int_bit_and:
+  destination->int_ = left.int_ & right.int_;
+  DISPATCH();
+int_bit_or:
+  destination->int_ = left.int_ | right.int_;
+  DISPATCH();
+float_add:
+  destination->float_ = left.float_ + right.float_;
+  DISPATCH();
+float_sub:
+  destination->float_ = left.float_ - right.float_;
+  DISPATCH();
+float_mul:
+  destination->float_ = left.float_ * right.float_;
+  DISPATCH();
+float_div:
+  destination->float_ = left.float_ / right.float_;
+  DISPATCH();
+float_eq:
+  destination->bool_ = left.float_ == right.float_;
+  DISPATCH();
+float_not_eq:
+  destination->bool_ = left.float_ != right.float_;
+  DISPATCH();
+float_lt:
+  destination->bool_ = left.float_ < right.float_;
+  DISPATCH();
+float_le:
+  destination->bool_ = left.float_ <= right.float_;
+  DISPATCH();
+float_gt:
+  destination->bool_ = left.float_ > right.float_;
+  DISPATCH();
+float_ge:
+  destination->bool_ = left.float_ >= right.float_;
+  DISPATCH();
+bool_eq:
+  destination->bool_ = left.bool_ == right.bool_;
+  DISPATCH();
+bool_not_eq:
+  destination->bool_ = left.bool_ != right.bool_;
+  DISPATCH();
+bool_and:
+  destination->bool_ = left.bool_ && right.bool_;
+  DISPATCH();
+bool_or:
+  destination->bool_ = left.bool_ || right.bool_;
+  DISPATCH();
+return_:
+  return (smith_vm_run_result_t){.value = left, .success = true};
+trap:
+  return (smith_vm_run_result_t){};
+
+#undef CHECKED
+#undef DISPATCH
+}
+
+smith_vm_run_result_t smith_vm_run(smith_allocator_t allocator,
+                                   const smith_bytecode_t *bytecode,
+                                   const smith_constant_value_t *arguments) {
+  smith_constant_value_t inline_registers[SMITH_VM_INLINE_REGISTERS];
+  smith_constant_value_t *registers = inline_registers;
+  uint32_t register_count = bytecode->register_count;
+  if (register_count > SMITH_VM_INLINE_REGISTERS) {
+    registers = smith_allocator_allocate_array(
+        allocator, smith_constant_value_t, register_count);
+    if (registers == nullptr) {
+      return (smith_vm_run_result_t){};
+    }
+  }
+  if (bytecode->parameter_count > 0) {
+    memcpy(registers, arguments,
+           bytecode->parameter_count * sizeof(smith_constant_value_t));
+  }
+  if (bytecode->constant_count > 0) {
+    memcpy(registers + bytecode->parameter_count, bytecode->constants,
+           bytecode->constant_count * sizeof(smith_constant_value_t));
+  }
+  smith_vm_run_result_t run_result =
+      execute(bytecode->instructions, registers);
+  if (registers != inline_registers) {
+    smith_allocator_deallocate(allocator, registers);
+  }
+  return run_result;
+}
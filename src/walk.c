@@ -0,0 +1,205 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/walk.h"
+#include <string.h>
+
+smith_ast_iterator_t smith_ast_iterator_create(smith_allocator_t allocator,
+                                               const smith_ast_t *ast,
+                                               smith_ast_node_t root,
+                                               smith_walk_order_t order) {
+  smith_ast_iterator_t iterator = {.allocator = allocator,
+                                   .ast = ast,
+                                   .order = order,
+                                   .root = root,
+                                   .capacity = SMITH_WALK_INLINE_CAPACITY};
+  if (order == SMITH_WALK_ORDER_POST) {
+    iterator.next = smith_ast_first(ast, root);
+  } else {
+    iterator.inline_stack[iterator.count++] = root;
+  }
+  return iterator;
+}
+
+// The stack is found through the iterator rather than stored as a pointer to
+// the inline storage, so that iterators can be returned and copied by value.
+static smith_ast_node_t *ast_stack(smith_ast_iterator_t *iterator) {
+  return iterator->stack != nullptr ? iterator->stack : iterator->inline_stack;
+}
+
+static bool ast_reserve(smith_ast_iterator_t *iterator, size_t capacity) {
+  if (capacity <= iterator->capacity) {
+    return true;
+  }
+  size_t new_capacity = iterator->capacity * 2;
+  smith_ast_node_t *stack = smith_allocator_allocate_array(
+      iterator->allocator, smith_ast_node_t, new_capacity);
+  if (stack == nullptr) {
+    return false;
+  }
+  memcpy(stack, ast_stack(iterator), iterator->count * sizeof(smith_ast_node_t));
+  smith_allocator_deallocate(iterator->allocator, iterator->stack);
+  iterator->stack = stack;
+  iterator->capacity = new_capacity;
+  return true;
+}
+
+static inline void prefetch_node(const smith_ast_t *ast, smith_ast_node_t node) {
+  __builtin_prefetch(&ast->kinds[node]);
+  __builtin_prefetch(&ast->children[node]);
+  __builtin_prefetch(&ast->payloads[node]);
+}
+
+smith_ast_iterator_next_result_t
+smith_ast_iterator_next(smith_ast_iterator_t *iterator) {
+  if (iterator->order == SMITH_WALK_ORDER_POST) {
+    if (iterator->next > iterator->root) {
+      return (smith_ast_iterator_next_result_t){};
+    }
+    return (smith_ast_iterator_next_result_t){.node = iterator->next++,
+                                              .success = true};
+  }
+  if (iterator->count == 0) {
+    return (smith_ast_iterator_next_result_t){};
+  }
+  const smith_ast_t *ast = iterator->ast;
+  smith_ast_node_t node = ast_stack(iterator)[--iterator->count];
+  if (ast->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    if (!ast_reserve(iterator, iterator->count + 2)) {
+      iterator->failed = true;
+      iterator->count = 0;
+      return (smith_ast_iterator_next_result_t){};
+    }
+    // The left operand is pushed last so that it is visited first.
+    smith_ast_children_t children = ast->children[node];
+    smith_ast_node_t *stack = ast_stack(iterator);
+    stack[iterator->count++] = children.right;
+    stack[iterator->count++] = children.left;
+    prefetch_node(ast, children.right);
+    prefetch_node(ast, children.left);
+  }
+  return (smith_ast_iterator_next_result_t){.node = node, .success = true};
+}
+
+void smith_ast_iterator_destroy(smith_ast_iterator_t iterator) {
+  smith_allocator_deallocate(iterator.allocator, iterator.stack);
+}
+
+smith_expression_iterator_t
+smith_expression_iterator_create(smith_allocator_t allocator,
+                                 const smith_expression_t *expression,
+                                 smith_walk_order_t order) {
+  smith_expression_iterator_t iterator = {
+      .allocator = allocator,
+      .order = order,
+      .count = 1,
+      .capacity = SMITH_WALK_INLINE_CAPACITY};
+  iterator.inline_stack[0] = expression;
+  return iterator;
+}
+
+static const smith_expression_t **
+expression_stack(smith_expression_iterator_t *iterator) {
+  return iterator->stack != nullptr ? iterator->stack : iterator->inline_stack;
+}
+
+static bool *expression_expanded(smith_expression_iterator_t *iterator) {
+  return iterator->stack != nullptr ? iterator->expanded
+                                    : iterator->inline_expanded;
+}
+
+static bool expression_reserve(smith_expression_iterator_t *iterator,
+                               size_t capacity) {
+  if (capacity <= iterator->capacity) {
+    return true;
+  }
+  size_t new_capacity = iterator->capacity * 2;
+  smith_allocator_t allocator = iterator->allocator;
+  const smith_expression_t **stack = smith_allocator_allocate_array(
+      allocator, const smith_expression_t *, new_capacity);
+  bool *expanded = smith_allocator_allocate_array(allocator, bool, new_capacity);
+  if (stack == nullptr || expanded == nullptr) {
+    smith_allocator_deallocate(allocator, stack);
+    smith_allocator_deallocate(allocator, expanded);
+    return false;
+  }
+  memcpy(stack, expression_stack(iterator),
+         iterator->count * sizeof(const smith_expression_t *));
+  memcpy(expanded, expression_expanded(iterator),
+         iterator->count * sizeof(bool));
+  smith_allocator_deallocate(allocator, iterator->stack);
+  smith_allocator_deallocate(allocator, iterator->expanded);
+  iterator->stack = stack;
+  iterator->expanded = expanded;
+  iterator->capacity = new_capacity;
+  return true;
+}
+
+static void push(smith_expression_iterator_t *iterator,
+                 const smith_expression_t *expression, bool expanded) {
+  expression_stack(iterator)[iterator->count] = expression;
+  expression_expanded(iterator)[iterator->count] = expanded;
+  iterator->count++;
+}
+
+const smith_expression_t *
+smith_expression_iterator_next(smith_expression_iterator_t *iterator) {
+  while (iterator->count > 0) {
+    iterator->count--;
+    const smith_expression_t *expression =
+        expression_stack(iterator)[iterator->count];
+    bool expanded = expression_expanded(iterator)[iterator->count];
+    if (expression->kind != SMITH_EXPRESSION_KIND_BINARY_OPERATOR ||
+        expanded) {
+      return expression;
+    }
+    // A post-order walk visits a binary operator twice: once to push its
+    // operands and once, after them, to return it.
+    bool post = iterator->order == SMITH_WALK_ORDER_POST;
+    if (!expression_reserve(iterator, iterator->count + 3)) {
+      iterator->failed = true;
+      iterator->count = 0;
+      return nullptr;
+    }
+    const smith_binary_operator_t *binary_operator =
+        &expression->value.binary_operator;
+    if (post) {
+      push(iterator, expression, true);
+    }
+    // The left operand is pushed last so that it is visited first.
+    push(iterator, binary_operator->right, false);
+    push(iterator, binary_operator->left, false);
+    __builtin_prefetch(binary_operator->right);
+    __builtin_prefetch(binary_operator->left);
+    if (!post) {
+      return expression;
+    }
+  }
+  return nullptr;
+}
+
+void smith_expression_iterator_destroy(smith_expression_iterator_t iterator) {
+  smith_allocator_deallocate(iterator.allocator, iterator.stack);
+  smith_allocator_deallocate(iterator.allocator, iterator.expanded);
+}
+
+#define KIND_COUNT (SMITH_EXPRESSION_KIND_CONSTANT + 1)
+
+void smith_ast_visit_batches(const smith_ast_t *ast, smith_ast_node_t root,
+                             smith_ast_batch_visitor_t visitor) {
+  smith_ast_node_t batches[KIND_COUNT][SMITH_WALK_BATCH_SIZE];
+  size_t counts[KIND_COUNT] = {};
+  for (smith_ast_node_t node = smith_ast_first(ast, root); node <= root;
+       node++) {
+    uint8_t kind = ast->kinds[node];
+    batches[kind][counts[kind]++] = node;
+    if (counts[kind] == SMITH_WALK_BATCH_SIZE) {
+      visitor.visit(visitor.state, kind, batches[kind], SMITH_WALK_BATCH_SIZE);
+      counts[kind] = 0;
+    }
+  }
+  for (size_t kind = 0; kind < KIND_COUNT; kind++) {
+    if (counts[kind] > 0) {
+      visitor.visit(visitor.state, kind, batches[kind], counts[kind]);
+    }
+  }
+}
@@ -0,0 +1,10 @@
+#include "smith/writer.h"
+
+bool smith_writer_write(smith_writer_t writer, const char *buffer,
+                        size_t length) {
+  return writer.write(writer.state, buffer, length);
+}
+
+void smith_writer_destroy(smith_writer_t writer) {
+  writer.destroy(writer.state);
+}
@@ -9,12 +9,17 @@ void smith_assert_span_equal(smith_span_t actual, smith_span_t expected);
 
 void smith_assert_cursor_equal(smith_cursor_t actual, smith_cursor_t expected);
 
+void smith_assert_string_equal(smith_string_t actual, smith_string_t expected);
+
 void smith_assert_symbol_equal(smith_symbol_t actual, smith_symbol_t expected);
 
 void smith_assert_int_equal(smith_int_t actual, smith_int_t expected);
 
 void smith_assert_float_equal(smith_float_t actual, smith_float_t expected);
 
+void smith_assert_string_literal_equal(smith_string_literal_t actual,
+                                       smith_string_literal_t expected);
+
 void smith_assert_operator_equal(smith_operator_t actual,
                                  smith_operator_t expected);
 
@@ -33,6 +38,16 @@ void smith_assert_unexpected_character_equal(
 void smith_assert_interning_failed_equal(smith_interning_failed_t actual,
                                          smith_interning_failed_t expected);
 
+void smith_assert_unterminated_string_equal(
+    smith_unterminated_string_t actual, smith_unterminated_string_t expected);
+
+void smith_assert_invalid_escape_equal(smith_invalid_escape_t actual,
+                                       smith_invalid_escape_t expected);
+
+void smith_assert_unterminated_comment_equal(
+    smith_unterminated_comment_t actual,
+    smith_unterminated_comment_t expected);
+
 void smith_assert_error_equal(smith_error_t actual, smith_error_t expected);
 
 void smith_assert_token_equal(smith_token_t actual, smith_token_t expected);
@@ -40,8 +55,20 @@ void smith_assert_token_equal(smith_token_t actual, smith_token_t expected);
 void smith_assert_next_token_result_equal(smith_next_token_result_t actual,
                                           smith_next_token_result_t expected);
 
+void smith_assert_constant_equal(smith_constant_t actual,
+                                 smith_constant_t expected);
+
 void smith_assert_expression_equal(smith_expression_t actual,
                                    smith_expression_t expected);
 
 void smith_assert_parse_result_equal(smith_parse_result_t actual,
                                      smith_parse_result_t expected);
+
+void smith_assert_ast_leaf_equal(smith_ast_leaf_t actual,
+                                 smith_ast_leaf_t expected);
+
+void smith_assert_ast_equal(const smith_ast_t *actual,
+                            const smith_ast_t *expected);
+
+void smith_assert_module_equal(const smith_module_t *actual,
+                               const smith_module_t *expected);
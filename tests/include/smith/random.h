@@ -1,6 +1,7 @@
 #pragma once
 
 #include "smith/allocator.h"
+#include "smith/bytecode.h"
 #include "smith/string.h"
 
 smith_string_t smith_random_string(smith_allocator_t allocator);
@@ -10,3 +11,13 @@ smith_string_t smith_random_symbol(smith_allocator_t allocator);
 smith_string_t smith_random_int(smith_allocator_t allocator);
 
 smith_string_t smith_random_float(smith_allocator_t allocator);
+
+smith_string_t smith_random_source(smith_allocator_t allocator, size_t tokens);
+
+// The parameters of the expressions `smith_random_expression` writes: the int
+// `x`, the float `y` and the bool `b`.
+extern const smith_bytecode_parameter_t smith_random_parameters[3];
+
+// Writes a random expression over `x`, `y` and `b`, which may not compile.
+// Small operands and repeated terms give optimizations something to do.
+void smith_random_expression(char *source, size_t capacity);
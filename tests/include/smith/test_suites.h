@@ -5,3 +5,26 @@
 extern MunitSuite smith_tokenizer_suite;
 extern MunitSuite smith_parser_suite;
 extern MunitSuite smith_hash_interner_suite;
+extern MunitSuite smith_stream_tokenizer_suite;
+extern MunitSuite smith_incremental_tokenizer_suite;
+extern MunitSuite smith_thread_pool_suite;
+extern MunitSuite smith_parallel_tokenizer_suite;
+extern MunitSuite smith_dfa_tokenizer_suite;
+extern MunitSuite smith_scan_suite;
+extern MunitSuite smith_unicode_suite;
+extern MunitSuite smith_ast_suite;
+extern MunitSuite smith_arena_allocator_suite;
+extern MunitSuite smith_parallel_parser_suite;
+extern MunitSuite smith_dag_suite;
+extern MunitSuite smith_constant_suite;
+extern MunitSuite smith_parse_cache_suite;
+extern MunitSuite smith_incremental_parser_suite;
+extern MunitSuite smith_ast_index_suite;
+extern MunitSuite smith_walk_suite;
+extern MunitSuite smith_bytecode_suite;
+extern MunitSuite smith_jit_suite;
+extern MunitSuite smith_column_suite;
+extern MunitSuite smith_ir_suite;
+extern MunitSuite smith_c_backend_suite;
+extern MunitSuite smith_type_suite;
+extern MunitSuite smith_infer_suite;
@@ -1,5 +1,6 @@
 #include "smith/assertions.h"
 #include <munit.h>
+#include <string.h>
 
 void smith_assert_position_equal(smith_position_t actual,
                                  smith_position_t expected) {
@@ -17,19 +18,34 @@ void smith_assert_cursor_equal(smith_cursor_t actual, smith_cursor_t expected) {
   munit_assert_string_equal(actual.source, expected.source);
 }
 
+void smith_assert_string_equal(smith_string_t actual, smith_string_t expected) {
+  munit_assert_size(actual.length, ==, expected.length);
+  munit_assert_memory_equal(actual.length, actual.data, expected.data);
+}
+
 void smith_assert_symbol_equal(smith_symbol_t actual, smith_symbol_t expected) {
   smith_assert_span_equal(actual.span, expected.span);
-  munit_assert_int(actual.interned, ==, expected.interned);
+  smith_assert_string_equal(actual.text, expected.text);
+  munit_assert_size(actual.interned, ==, expected.interned);
 }
 
 void smith_assert_int_equal(smith_int_t actual, smith_int_t expected) {
   smith_assert_span_equal(actual.span, expected.span);
-  munit_assert_int(actual.interned, ==, expected.interned);
+  smith_assert_string_equal(actual.text, expected.text);
+  munit_assert_size(actual.interned, ==, expected.interned);
 }
 
 void smith_assert_float_equal(smith_float_t actual, smith_float_t expected) {
   smith_assert_span_equal(actual.span, expected.span);
-  munit_assert_int(actual.interned, ==, expected.interned);
+  smith_assert_string_equal(actual.text, expected.text);
+  munit_assert_size(actual.interned, ==, expected.interned);
+}
+
+void smith_assert_string_literal_equal(smith_string_literal_t actual,
+                                       smith_string_literal_t expected) {
+  smith_assert_span_equal(actual.span, expected.span);
+  smith_assert_string_equal(actual.text, expected.text);
+  munit_assert(actual.escaped == expected.escaped);
 }
 
 void smith_assert_operator_equal(smith_operator_t actual,
@@ -69,6 +85,23 @@ void smith_assert_interning_failed_equal(smith_interning_failed_t actual,
   munit_assert_string_equal(actual.string.data, expected.string.data);
 }
 
+void smith_assert_unterminated_string_equal(
+    smith_unterminated_string_t actual, smith_unterminated_string_t expected) {
+  smith_assert_span_equal(actual.span, expected.span);
+}
+
+void smith_assert_invalid_escape_equal(smith_invalid_escape_t actual,
+                                       smith_invalid_escape_t expected) {
+  smith_assert_span_equal(actual.span, expected.span);
+  munit_assert_char(actual.character, ==, expected.character);
+}
+
+void smith_assert_unterminated_comment_equal(
+    smith_unterminated_comment_t actual,
+    smith_unterminated_comment_t expected) {
+  smith_assert_span_equal(actual.span, expected.span);
+}
+
 void smith_assert_error_equal(smith_error_t actual, smith_error_t expected) {
   munit_assert_int(actual.kind, ==, expected.kind);
   switch (actual.kind) {
@@ -78,6 +111,15 @@ void smith_assert_error_equal(smith_error_t actual, smith_error_t expected) {
   case SMITH_ERROR_KIND_INTERNING_FAILED:
     return smith_assert_interning_failed_equal(actual.value.interning_failed,
                                                expected.value.interning_failed);
+  case SMITH_ERROR_KIND_UNTERMINATED_STRING:
+    return smith_assert_unterminated_string_equal(
+        actual.value.unterminated_string, expected.value.unterminated_string);
+  case SMITH_ERROR_KIND_INVALID_ESCAPE:
+    return smith_assert_invalid_escape_equal(actual.value.invalid_escape,
+                                             expected.value.invalid_escape);
+  case SMITH_ERROR_KIND_UNTERMINATED_COMMENT:
+    return smith_assert_unterminated_comment_equal(
+        actual.value.unterminated_comment, expected.value.unterminated_comment);
   }
 }
 
@@ -91,6 +133,9 @@ void smith_assert_token_equal(smith_token_t actual, smith_token_t expected) {
     return smith_assert_int_equal(actual.value.int_, expected.value.int_);
   case SMITH_TOKEN_KIND_FLOAT:
     return smith_assert_float_equal(actual.value.float_, expected.value.float_);
+  case SMITH_TOKEN_KIND_STRING:
+    return smith_assert_string_literal_equal(actual.value.string,
+                                             expected.value.string);
   case SMITH_TOKEN_KIND_OPERATOR:
     return smith_assert_operator_equal(actual.value.operator_,
                                        expected.value.operator_);
@@ -132,6 +177,23 @@ void smith_assert_binary_operator_equal(smith_binary_operator_t actual,
   smith_assert_expression_equal(*actual.right, *expected.right);
 }
 
+void smith_assert_constant_equal(smith_constant_t actual,
+                                 smith_constant_t expected) {
+  munit_assert_int(actual.kind, ==, expected.kind);
+  switch (actual.kind) {
+  case SMITH_CONSTANT_KIND_INT:
+    munit_assert_int64(actual.value.int_, ==, expected.value.int_);
+    break;
+  case SMITH_CONSTANT_KIND_FLOAT:
+    munit_assert_memory_equal(sizeof(double), &actual.value.float_,
+                              &expected.value.float_);
+    break;
+  case SMITH_CONSTANT_KIND_BOOL:
+    munit_assert(actual.value.bool_ == expected.value.bool_);
+    break;
+  }
+}
+
 void smith_assert_expression_equal(smith_expression_t actual,
                                    smith_expression_t expected) {
   munit_assert_int(actual.kind, ==, expected.kind);
@@ -146,6 +208,11 @@ void smith_assert_expression_equal(smith_expression_t actual,
   case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
     return smith_assert_binary_operator_equal(actual.value.binary_operator,
                                               expected.value.binary_operator);
+  case SMITH_EXPRESSION_KIND_CONSTANT:
+    smith_assert_span_equal(actual.value.constant.span,
+                            expected.value.constant.span);
+    return smith_assert_constant_equal(actual.value.constant.constant,
+                                       expected.value.constant.constant);
   }
 }
 
@@ -154,3 +221,59 @@ void smith_assert_parse_result_equal(smith_parse_result_t actual,
   smith_assert_expression_equal(actual.expression, expected.expression);
   smith_assert_cursor_equal(actual.cursor, expected.cursor);
 }
+
+void smith_assert_ast_leaf_equal(smith_ast_leaf_t actual,
+                                 smith_ast_leaf_t expected) {
+  smith_assert_string_equal(actual.text, expected.text);
+  munit_assert_size(actual.interned, ==, expected.interned);
+}
+
+void smith_assert_ast_equal(const smith_ast_t *actual,
+                            const smith_ast_t *expected) {
+  munit_assert_uint32(actual->count, ==, expected->count);
+  for (uint32_t node = 0; node < actual->count; node++) {
+    munit_assert_int(actual->kinds[node], ==, expected->kinds[node]);
+    smith_assert_span_equal(actual->spans[node], expected->spans[node]);
+    switch (actual->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
+      munit_assert_uint32(actual->children[node].left, ==,
+                          expected->children[node].left);
+      munit_assert_uint32(actual->children[node].right, ==,
+                          expected->children[node].right);
+      munit_assert_int(actual->payloads[node].binary_operator.kind, ==,
+                       expected->payloads[node].binary_operator.kind);
+      break;
+    case SMITH_EXPRESSION_KIND_CONSTANT:
+      smith_assert_constant_equal(actual->payloads[node].constant,
+                                  expected->payloads[node].constant);
+      break;
+    default:
+      smith_assert_ast_leaf_equal(actual->payloads[node].leaf,
+                                  expected->payloads[node].leaf);
+      break;
+    }
+  }
+}
+
+void smith_assert_module_equal(const smith_module_t *actual,
+                               const smith_module_t *expected) {
+  smith_assert_ast_equal(&actual->ast, &expected->ast);
+  munit_assert_size(actual->count, ==, expected->count);
+  for (size_t i = 0; i < actual->count; i++) {
+    smith_function_t actual_function = actual->functions[i];
+    smith_function_t expected_function = expected->functions[i];
+    smith_assert_span_equal(actual_function.span, expected_function.span);
+    munit_assert_size(actual_function.offsets.start, ==,
+                      expected_function.offsets.start);
+    munit_assert_size(actual_function.offsets.end, ==,
+                      expected_function.offsets.end);
+    smith_assert_ast_leaf_equal(actual_function.name, expected_function.name);
+    smith_assert_span_equal(actual_function.name_span,
+                            expected_function.name_span);
+    munit_assert_uint32(actual_function.parameters, ==,
+                        expected_function.parameters);
+    munit_assert_uint32(actual_function.parameter_count, ==,
+                        expected_function.parameter_count);
+    munit_assert_uint32(actual_function.body, ==, expected_function.body);
+  }
+}
@@ -2,6 +2,8 @@
 
 #include "smith/random.h"
 #include <munit.h>
+#include <stdio.h>
+#include <string.h>
 
 #define MIN_LENGTH 1
 #define MAX_LENGTH 10
@@ -63,3 +65,82 @@ smith_string_t smith_random_float(smith_allocator_t allocator) {
   data[length] = '\0';
   return (smith_string_t){.data = data, .length = length};
 }
+
+static const char *random_source_pieces[] = {
+    "+", "+=", "-", "-=", "*", "*=", "/", "/=", "=", "==", "!", "!=", "<",
+    "<=", ">", ">=", "&", "&&", "|", "||", "(", ")", "{", "}", "[", "]",
+    ",", "fn", ";", "\t", "\n", " ", "  ", "\"a b\"", "\"\\t\\\"\"",
+    "\"\\q\"", "\"ab\n", "// x\n", "/* y\n*/", "/**/", "\xc3\xa9t\xc3\xa9",
+    "\xe5\x90\x8d", "\xe2\x82\xac", "\xcc\x81", "\xc3",
+};
+
+smith_string_t smith_random_source(smith_allocator_t allocator, size_t tokens) {
+  size_t capacity = tokens * (MAX_LENGTH + 1) + 1;
+  char *data = smith_allocator_allocate_array(allocator, char, capacity);
+  munit_assert(data != nullptr);
+  size_t length = 0;
+  size_t piece_count =
+      sizeof(random_source_pieces) / sizeof(random_source_pieces[0]);
+  for (size_t i = 0; i < tokens; i++) {
+    smith_string_t piece;
+    switch (munit_rand_int_range(0, 4)) {
+    case 0:
+      piece = smith_random_symbol(allocator);
+      break;
+    case 1:
+      piece = smith_random_int(allocator);
+      break;
+    case 2:
+      piece = smith_random_float(allocator);
+      break;
+    default: {
+      const char *string =
+          random_source_pieces[munit_rand_int_range(0, piece_count - 1)];
+      memcpy(data + length, string, strlen(string));
+      length += strlen(string);
+      continue;
+    }
+    }
+    memcpy(data + length, piece.data, piece.length);
+    length += piece.length;
+    smith_allocator_deallocate(allocator, piece.data);
+  }
+  data[length] = '\0';
+  return (smith_string_t){.data = data, .length = length};
+}
+
+const smith_bytecode_parameter_t smith_random_parameters[3] = {
+    {.name = {.data = "x", .length = 1}, .kind = SMITH_CONSTANT_KIND_INT},
+    {.name = {.data = "y", .length = 1}, .kind = SMITH_CONSTANT_KIND_FLOAT},
+    {.name = {.data = "b", .length = 1}, .kind = SMITH_CONSTANT_KIND_BOOL},
+};
+
+void smith_random_expression(char *source, size_t capacity) {
+  const char *int_operands[] = {"x", "x", "0", "1", "3", "a"};
+  const char *float_operands[] = {"y", "y", "0.5", "2.0", "c"};
+  const char *operators[] = {"+", "-", "*", "/", "&", "|"};
+  const char *comparisons[] = {"==", "!=", "<", "<=", ">", ">="};
+  bool floats = munit_rand_int_range(0, 1);
+  size_t length = 0;
+  int count = munit_rand_int_range(1, 12);
+  for (int i = 0; i < count; i++) {
+    if (munit_rand_int_range(0, 4) == 0) {
+      length += snprintf(source + length, capacity - length, "%s = ",
+                         floats ? "c" : "a");
+    }
+    const char *operand = floats ? float_operands[munit_rand_int_range(0, 4)]
+                                 : int_operands[munit_rand_int_range(0, 5)];
+    length += snprintf(source + length, capacity - length, "%s", operand);
+    if (i + 1 < count) {
+      // Floats now and then take a bitwise operator, which does not compile.
+      int last = floats && munit_rand_int_range(0, 7) != 0 ? 3 : 5;
+      length += snprintf(source + length, capacity - length, " %s ",
+                         operators[munit_rand_int_range(0, last)]);
+    }
+  }
+  if (munit_rand_int_range(0, 2) == 0) {
+    length += snprintf(source + length, capacity - length, " %s %s == b",
+                       comparisons[munit_rand_int_range(0, 5)],
+                       floats ? "y" : "x");
+  }
+}
@@ -0,0 +1,117 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/arena_allocator.h"
+#include "smith/null_interner.h"
+#include "smith/parser.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdint.h>
+#include <string.h>
+
+static MunitResult test_smith_arena_allocate(const MunitParameter params[],
+                                             void *user_data_or_fixture) {
+  smith_arena_allocator_create_result_t create_result =
+      smith_arena_allocator_create(smith_system_allocator_create());
+  munit_assert_true(create_result.success);
+  smith_allocator_t allocator = create_result.allocator;
+  // Allocations of mixed sizes and alignments, including ones larger than a
+  // chunk, must be aligned and must not overlap.
+  size_t sizes[] = {1, 3, 8, 24, 100, SMITH_ARENA_MIN_CHUNK_SIZE * 3, 7};
+  size_t alignments[] = {1, 2, 4, 8, 16, 64};
+  unsigned char *pointers[200];
+  size_t lengths[200];
+  for (size_t i = 0; i < 200; i++) {
+    size_t size = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+    size_t alignment =
+        alignments[i % (sizeof(alignments) / sizeof(alignments[0]))];
+    pointers[i] = allocator.allocate(allocator.state, size, alignment);
+    munit_assert_not_null(pointers[i]);
+    munit_assert_size((uintptr_t)pointers[i] % alignment, ==, 0);
+    memset(pointers[i], (int)i, size);
+    lengths[i] = size;
+  }
+  for (size_t i = 0; i < 200; i++) {
+    for (size_t j = 0; j < lengths[i]; j++) {
+      munit_assert_uint8(pointers[i][j], ==, (uint8_t)i);
+    }
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_arena_reset(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_arena_allocator_create_result_t create_result =
+      smith_arena_allocator_create(smith_system_allocator_create());
+  munit_assert_true(create_result.success);
+  smith_allocator_t allocator = create_result.allocator;
+  for (size_t i = 0; i < 1000; i++) {
+    munit_assert_not_null(
+        allocator.allocate(allocator.state, 1000, alignof(max_align_t)));
+  }
+  smith_arena_allocator_reset(allocator);
+  // The largest chunk is kept, so the same allocations again fit in it and
+  // start where the first allocation after the reset does.
+  char *first = allocator.allocate(allocator.state, 1000, alignof(max_align_t));
+  munit_assert_not_null(first);
+  for (size_t i = 1; i < 100; i++) {
+    char *pointer =
+        allocator.allocate(allocator.state, 1000, alignof(max_align_t));
+    munit_assert_ptr_equal(pointer, first + i * 1008);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_arena_owns_expression(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_arena_allocator_create_result_t create_result =
+      smith_arena_allocator_create(smith_system_allocator_create());
+  munit_assert_true(create_result.success);
+  smith_allocator_t allocator = create_result.allocator;
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  size_t terms = 100000;
+  char *source = smith_allocator_allocate_array(allocator, char, terms * 4);
+  munit_assert_not_null(source);
+  for (size_t round = 0; round < 3; round++) {
+    for (size_t i = 0; i < terms; i++) {
+      memcpy(source + i * 4, "x * ", 4);
+    }
+    source[terms * 4 - 3] = '\0';
+    smith_parse_result_t actual =
+        smith_parse_expression(context, (smith_cursor_t){.source = source});
+    munit_assert_string_equal(actual.cursor.source, "");
+    munit_assert_int(actual.expression.kind, ==,
+                     SMITH_EXPRESSION_KIND_BINARY_OPERATOR);
+    // Releasing the arena frees every node, and the source with them, without
+    // walking the tree.
+    smith_arena_allocator_reset(allocator);
+    source = smith_allocator_allocate_array(allocator, char, terms * 4);
+    munit_assert_not_null(source);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_arena_allocator_tests[] = {
+    {
+        .name = "/test_smith_arena_allocate",
+        .test = test_smith_arena_allocate,
+    },
+    {
+        .name = "/test_smith_arena_reset",
+        .test = test_smith_arena_reset,
+    },
+    {
+        .name = "/test_smith_arena_owns_expression",
+        .test = test_smith_arena_owns_expression,
+    },
+    {}};
+
+MunitSuite smith_arena_allocator_suite = {
+    .prefix = "/arena_allocator",
+    .tests = smith_arena_allocator_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,134 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/assertions.h"
+#include "smith/null_interner.h"
+#include "smith/parser.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <string.h>
+
+static MunitResult test_smith_ast_push(const MunitParameter params[],
+                                       void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_ast_t ast = smith_ast_create(allocator);
+  char *text = "x";
+  // Enough nodes to grow past the minimum capacity a few times.
+  for (uint32_t i = 0; i < SMITH_AST_MIN_CAPACITY * 5; i++) {
+    smith_span_t span = {.start.column = i, .end.column = i + 1};
+    smith_ast_push_result_t push_result;
+    if (i == 0) {
+      push_result = smith_ast_push_leaf(
+          &ast, SMITH_EXPRESSION_KIND_SYMBOL, span,
+          (smith_ast_leaf_t){.text = {.data = text, .length = 1},
+                             .interned = i});
+    } else {
+      push_result = smith_ast_push_binary_operator(
+          &ast, smith_binary_operator_mapping[SMITH_OPERATOR_KIND_ADD], span,
+          (smith_ast_children_t){.left = i - 1, .right = 0});
+    }
+    munit_assert_true(push_result.success);
+    munit_assert_uint32(push_result.node, ==, i);
+  }
+  for (uint32_t i = 0; i < ast.count; i++) {
+    munit_assert_uint32(ast.spans[i].start.column, ==, i);
+    if (i > 0) {
+      munit_assert_int(ast.kinds[i], ==, SMITH_EXPRESSION_KIND_BINARY_OPERATOR);
+      munit_assert_uint32(ast.children[i].left, ==, i - 1);
+      munit_assert_int(ast.payloads[i].binary_operator.kind, ==,
+                       SMITH_BINARY_OPERATOR_KIND_ADD);
+    }
+  }
+  munit_assert_ptr_equal(ast.payloads[0].leaf.text.data, text);
+  munit_assert_uint32(smith_ast_first(&ast, ast.count - 1), ==, 0);
+  smith_ast_destroy(ast);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_parse_ast_matches_expression(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  char *sources[] = {"a", "1.5 * b", "a = b + c * d - e = f", "x / 2 == y"};
+  smith_ast_t ast = smith_ast_create(allocator);
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    uint32_t count = ast.count;
+    smith_parse_ast_result_t actual =
+        smith_parse_ast(context, &ast, (smith_cursor_t){.source = sources[i]});
+    // Each expression is appended after the ones before it and ends with its
+    // root, with every child before its parent.
+    munit_assert_uint32(smith_ast_first(&ast, actual.root), ==, count);
+    munit_assert_uint32(actual.root, ==, ast.count - 1);
+    for (uint32_t node = count; node < ast.count; node++) {
+      if (ast.kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+        munit_assert_uint32(ast.children[node].left, <, node);
+        munit_assert_uint32(ast.children[node].right, <, node);
+        munit_assert_uint32(ast.children[node].left, >=, count);
+      }
+    }
+    smith_parse_result_t expected = smith_parse_expression(
+        context, (smith_cursor_t){.source = sources[i]});
+    smith_ast_to_expression_result_t to_expression_result =
+        smith_ast_to_expression(allocator, &ast, actual.root);
+    munit_assert_true(to_expression_result.success);
+    smith_expression_t expression = to_expression_result.expression;
+    smith_assert_expression_equal(expression, expected.expression);
+    munit_assert_ptr_equal(actual.cursor.source, expected.cursor.source);
+    smith_expression_destroy(allocator, expression);
+    smith_expression_destroy(allocator, expected.expression);
+  }
+  smith_ast_destroy(ast);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_parse_ast_long_sum(const MunitParameter params[],
+                                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  size_t terms = 100000;
+  char *source = smith_allocator_allocate_array(allocator, char, terms * 4);
+  munit_assert_not_null(source);
+  for (size_t i = 0; i < terms; i++) {
+    memcpy(source + i * 4, "x + ", 4);
+  }
+  source[terms * 4 - 3] = '\0';
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t actual =
+      smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+  munit_assert_uint32(ast.count, ==, terms * 2 - 1);
+  munit_assert_uint32(actual.root, ==, ast.count - 1);
+  size_t additions = 0;
+  for (uint32_t node = 0; node < ast.count; node++) {
+    additions += ast.kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR;
+  }
+  munit_assert_size(additions, ==, terms - 1);
+  smith_ast_destroy(ast);
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_ast_tests[] = {
+    {
+        .name = "/test_smith_ast_push",
+        .test = test_smith_ast_push,
+    },
+    {
+        .name = "/test_smith_parse_ast_matches_expression",
+        .test = test_smith_parse_ast_matches_expression,
+    },
+    {
+        .name = "/test_smith_parse_ast_long_sum",
+        .test = test_smith_parse_ast_long_sum,
+    },
+    {}};
+
+MunitSuite smith_ast_suite = {
+    .prefix = "/ast",
+    .tests = smith_ast_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,237 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/ast_index.h"
+#include "smith/null_interner.h"
+#include "smith/parser.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdio.h>
+
+static bool position_less(smith_position_t a, smith_position_t b) {
+  return a.line < b.line || (a.line == b.line && a.column < b.column);
+}
+
+static smith_span_t extent(const smith_ast_t *ast, smith_ast_node_t node) {
+  smith_ast_node_t last = node;
+  while (ast->kinds[last] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    last = ast->children[last].right;
+  }
+  return (smith_span_t){.start = ast->spans[smith_ast_first(ast, node)].start,
+                        .end = ast->spans[last].end};
+}
+
+// Finds the innermost node by checking every node: the one with the smallest
+// subtree whose extent covers the position.
+static smith_ast_index_find_result_t
+innermost_bruteforce(const smith_ast_t *ast, smith_position_t position) {
+  smith_ast_index_find_result_t result = {};
+  uint32_t smallest = UINT32_MAX;
+  for (smith_ast_node_t node = 0; node < ast->count; node++) {
+    smith_span_t span = extent(ast, node);
+    uint32_t size = node - smith_ast_first(ast, node) + 1;
+    if (!position_less(position, span.start) &&
+        position_less(position, span.end) && size < smallest) {
+      result = (smith_ast_index_find_result_t){.node = node, .success = true};
+      smallest = size;
+    }
+  }
+  return result;
+}
+
+static smith_ast_index_t index_create(smith_allocator_t allocator,
+                                      const smith_ast_t *ast) {
+  smith_ast_index_create_result_t index_create_result =
+      smith_ast_index_create(allocator, ast);
+  munit_assert_true(index_create_result.success);
+  return index_create_result.index;
+}
+
+static void assert_innermost(const smith_ast_index_t *index,
+                             const smith_ast_t *ast,
+                             smith_position_t position) {
+  smith_ast_index_find_result_t expected =
+      innermost_bruteforce(ast, position);
+  smith_ast_index_find_result_t actual =
+      smith_ast_index_innermost(index, position);
+  munit_assert(actual.success == expected.success);
+  if (expected.success) {
+    munit_assert_uint32(actual.node, ==, expected.node);
+  }
+}
+
+static MunitResult test_smith_ast_index_innermost(const MunitParameter params[],
+                                                  void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  char *sources[] = {"a", "1.5 * b", "a = b + c * d - e = f", "x / 2 == y",
+                     "aa   +   bb"};
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    smith_ast_t ast = smith_ast_create(allocator);
+    smith_parse_ast(context, &ast, (smith_cursor_t){.source = sources[i]});
+    smith_ast_index_t index = index_create(allocator, &ast);
+    for (uint32_t column = 0; column < 30; column++) {
+      assert_innermost(&index, &ast, (smith_position_t){.column = column});
+    }
+    smith_ast_index_destroy(index);
+    smith_ast_destroy(ast);
+  }
+  // Between the operator and its right operand the operator is innermost.
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast(context, &ast, (smith_cursor_t){.source = "aa   +   bb"});
+  smith_ast_index_t index = index_create(allocator, &ast);
+  smith_ast_index_find_result_t find_result =
+      smith_ast_index_innermost(&index, (smith_position_t){.column = 7});
+  munit_assert_true(find_result.success);
+  munit_assert_int(ast.kinds[find_result.node], ==,
+                   SMITH_EXPRESSION_KIND_BINARY_OPERATOR);
+  find_result =
+      smith_ast_index_innermost(&index, (smith_position_t){.column = 11});
+  munit_assert_false(find_result.success);
+  smith_ast_index_destroy(index);
+  smith_ast_destroy(ast);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Writes `count` functions whose bodies span one or more lines.
+static char *random_module(smith_allocator_t allocator, size_t count) {
+  size_t capacity = count * 512 + 1;
+  char *source = smith_allocator_allocate_array(allocator, char, capacity);
+  munit_assert_not_null(source);
+  source[0] = '\0';
+  const char *operators[] = {"+", "-", "*", "/", "==", "="};
+  size_t length = 0;
+  for (size_t i = 0; i < count; i++) {
+    length += snprintf(source + length, capacity - length, "fn f%zu(p, q) {\n  p",
+                       i);
+    int terms = munit_rand_int_range(0, 12);
+    for (int t = 0; t < terms; t++) {
+      const char *op = operators[munit_rand_int_range(0, 5)];
+      const char *space = munit_rand_int_range(0, 4) ? " " : "\n    ";
+      if (munit_rand_int_range(0, 1)) {
+        length += snprintf(source + length, capacity - length, "%s%s %d",
+                           space, op, munit_rand_int_range(0, 99));
+      } else {
+        length += snprintf(source + length, capacity - length, "%s%s q",
+                           space, op);
+      }
+    }
+    length += snprintf(source + length, capacity - length, "\n}\n");
+  }
+  return source;
+}
+
+static MunitResult
+test_smith_ast_index_matches_bruteforce(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  for (int round = 0; round < 20; round++) {
+    smith_parser_context_t context = {.allocator = allocator,
+                                      .interner = smith_null_interner_create(),
+                                      .fold_constants = round % 2 == 1};
+    char *source = random_module(allocator, munit_rand_int_range(0, 6));
+    smith_tokenize_result_t tokenize_result =
+        smith_tokenize(allocator, smith_null_interner_create(), source);
+    munit_assert(tokenize_result.success);
+    smith_module_t module =
+        smith_parse_module(context, &tokenize_result.buffer).module;
+    smith_ast_t *ast = &module.ast;
+    smith_ast_index_t index = index_create(allocator, ast);
+    uint32_t lines = 0;
+    for (const char *c = source; *c != '\0'; c++) {
+      lines += *c == '\n';
+    }
+    for (int query = 0; query < 300; query++) {
+      smith_position_t position = {
+          .line = munit_rand_int_range(0, lines),
+          .column = munit_rand_int_range(0, 80)};
+      assert_innermost(&index, ast, position);
+      // The overlapping entries are exactly the nodes whose own span
+      // overlaps the range.
+      smith_position_t end = {
+          .line = position.line + munit_rand_int_range(0, 1),
+          .column = munit_rand_int_range(0, 80)};
+      if (position_less(end, position)) {
+        end = position;
+      }
+      smith_ast_index_range_t range =
+          smith_ast_index_overlapping(&index, (smith_span_t){position, end});
+      uint32_t expected = 0;
+      for (smith_ast_node_t node = 0; node < ast->count; node++) {
+        smith_span_t span = ast->spans[node];
+        expected += position_less(position, span.end) &&
+                    position_less(span.start, end);
+      }
+      munit_assert_uint32(range.end - range.start, ==, expected);
+      for (uint32_t i = range.start; i < range.end; i++) {
+        smith_span_t span = ast->spans[index.nodes[i]];
+        munit_assert_true(position_less(position, span.end));
+        munit_assert_true(position_less(span.start, end));
+      }
+    }
+    // Every node but a root has a parent whose extent covers its own.
+    for (smith_ast_node_t node = 0; node < ast->count; node++) {
+      smith_ast_node_t parent = index.parents[node];
+      if (parent != SMITH_AST_INDEX_NO_NODE) {
+        munit_assert_uint32(parent, >, node);
+        munit_assert_false(position_less(index.extents[node].start,
+                                         index.extents[parent].start));
+      }
+    }
+    smith_ast_index_destroy(index);
+    smith_module_destroy(module);
+    smith_token_buffer_destroy(tokenize_result.buffer);
+    smith_allocator_deallocate(allocator, source);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_ast_index_unsorted(const MunitParameter params[],
+                                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  // The second expression comes first in the source text.
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast(context, &ast,
+                  (smith_cursor_t){.source = "x * y", .position.line = 1});
+  smith_parse_ast(context, &ast, (smith_cursor_t){.source = "z + w"});
+  smith_ast_index_t index = index_create(allocator, &ast);
+  for (uint32_t i = 1; i < index.count; i++) {
+    munit_assert_false(
+        position_less(index.spans[i].start, index.spans[i - 1].start));
+  }
+  for (uint32_t line = 0; line < 2; line++) {
+    for (uint32_t column = 0; column < 6; column++) {
+      assert_innermost(&index, &ast,
+                       (smith_position_t){.line = line, .column = column});
+    }
+  }
+  smith_ast_index_destroy(index);
+  smith_ast_destroy(ast);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_ast_index_tests[] = {
+    {
+        .name = "/test_smith_ast_index_innermost",
+        .test = test_smith_ast_index_innermost,
+    },
+    {
+        .name = "/test_smith_ast_index_matches_bruteforce",
+        .test = test_smith_ast_index_matches_bruteforce,
+    },
+    {
+        .name = "/test_smith_ast_index_unsorted",
+        .test = test_smith_ast_index_unsorted,
+    },
+    {}};
+
+MunitSuite smith_ast_index_suite = {
+    .prefix = "/ast_index",
+    .tests = smith_ast_index_tests,
+    .iterations = 1,
+};
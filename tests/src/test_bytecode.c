@@ -0,0 +1,276 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/null_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/vm.h"
+#include <stdio.h>
+#include <string.h>
+
+// Every test expression can use an int `x`, a float `y` and a bool `b`.
+static const smith_constant_value_t arguments[] = {
+    {.int_ = 6}, {.float_ = 2.5}, {.bool_ = true}};
+
+static smith_bytecode_compile_result_t compile(smith_allocator_t allocator,
+                                               char *source) {
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_parse_result_t parse_result =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  smith_bytecode_compile_result_t compile_result = smith_bytecode_compile(
+      allocator, &parse_result.expression, smith_random_parameters, 3);
+  smith_expression_destroy(allocator, parse_result.expression);
+  return compile_result;
+}
+
+static smith_constant_t run(smith_allocator_t allocator, char *source) {
+  smith_bytecode_compile_result_t compile_result =
+      compile(allocator, source);
+  munit_assert_true(compile_result.success);
+  smith_vm_run_result_t run_result =
+      smith_vm_run(allocator, &compile_result.bytecode, arguments);
+  munit_assert_true(run_result.success);
+  smith_constant_t result = {.kind = compile_result.bytecode.result_kind,
+                             .value = run_result.value};
+  smith_bytecode_destroy(compile_result.bytecode);
+  return result;
+}
+
+static void assert_int(smith_allocator_t allocator, char *source,
+                       int64_t expected) {
+  smith_constant_t result = run(allocator, source);
+  munit_assert_int(result.kind, ==, SMITH_CONSTANT_KIND_INT);
+  munit_assert_int64(result.value.int_, ==, expected);
+}
+
+static void assert_float(smith_allocator_t allocator, char *source,
+                         double expected) {
+  smith_constant_t result = run(allocator, source);
+  munit_assert_int(result.kind, ==, SMITH_CONSTANT_KIND_FLOAT);
+  munit_assert_double(result.value.float_, ==, expected);
+}
+
+static void assert_bool(smith_allocator_t allocator, char *source,
+                        bool expected) {
+  smith_constant_t result = run(allocator, source);
+  munit_assert_int(result.kind, ==, SMITH_CONSTANT_KIND_BOOL);
+  munit_assert(result.value.bool_ == expected);
+}
+
+static MunitResult test_smith_bytecode_run(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  assert_int(allocator, "x", 6);
+  assert_int(allocator, "1 + 2 * 3", 7);
+  assert_int(allocator, "x * x - 1", 35);
+  assert_int(allocator, "x / 4 - 7 / 2", -2);
+  assert_int(allocator, "x & 3", 2);
+  assert_int(allocator, "x | 9", 15);
+  assert_float(allocator, "y * 2.0 - 0.5", 4.5);
+  assert_float(allocator, "y / 0.0", 1.0 / 0.0);
+  assert_bool(allocator, "x < 7", true);
+  assert_bool(allocator, "y >= 2.5", true);
+  assert_bool(allocator, "x != 6", false);
+  assert_bool(allocator, "x == 6 == b", true);
+  assert_bool(allocator, "b && b == b", true);
+  assert_bool(allocator, "b & b != b", false);
+  assert_bool(allocator, "b || b", true);
+  // An assignment's value is the assigned value, and variables keep theirs.
+  assert_int(allocator, "a = x + 1", 7);
+  assert_int(allocator, "a = c = 3", 3);
+  assert_int(allocator, "x += 4", 10);
+  assert_int(allocator, "x -= x * 2", -6);
+  assert_float(allocator, "y *= 2.0", 5.0);
+  assert_float(allocator, "y /= 2.0", 1.25);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_bytecode_errors(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char *invalid[] = {
+      "z",                    // Neither a parameter nor assigned.
+      "z + 1",                // Read before it is assigned.
+      "1 + 2.0",              // Operands of different types.
+      "x = 1.5",              // A variable keeps its type.
+      "z += 1",               // Updated before it is assigned.
+      "1 = 2",                // Only symbols can be assigned.
+      "x + 1 = 2",            // Nor can an operator.
+      "b + b",                // No meaning for bools.
+      "y & y",                // No meaning for floats.
+      "x && x",               // Only bools.
+      "x < y",                // Operands of different types.
+      "x ! x",                // No meaning as a binary operator.
+      "99999999999999999999", // Too large for an int.
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    smith_bytecode_compile_result_t compile_result =
+        compile(allocator, invalid[i]);
+    munit_assert_false(compile_result.success);
+  }
+  // Checked int arithmetic traps when the program runs.
+  char *trapping[] = {"x / 0", "9223372036854775807 + x",
+                            "0 - 9223372036854775807 - x",
+                            "a = 4611686018427387904 * x"};
+  for (size_t i = 0; i < sizeof(trapping) / sizeof(trapping[0]); i++) {
+    smith_bytecode_compile_result_t compile_result =
+        compile(allocator, trapping[i]);
+    munit_assert_true(compile_result.success);
+    smith_vm_run_result_t run_result =
+        smith_vm_run(allocator, &compile_result.bytecode, arguments);
+    munit_assert_false(run_result.success);
+    smith_bytecode_destroy(compile_result.bytecode);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_bytecode_layout(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  // The constant is pooled once and intermediate values reuse temporaries.
+  smith_bytecode_compile_result_t compile_result =
+      compile(allocator, "x * 2 + x * 2 + 2");
+  munit_assert_true(compile_result.success);
+  smith_bytecode_t *bytecode = &compile_result.bytecode;
+  munit_assert_uint32(bytecode->constant_count, ==, 1);
+  munit_assert_size(bytecode->count, ==, 5);
+  munit_assert_uint32(bytecode->register_count, ==, 3 + 1 + 2);
+  munit_assert_int(bytecode->instructions[4].opcode, ==, SMITH_OPCODE_RETURN);
+  smith_bytecode_destroy(compile_result.bytecode);
+  // A value computed for an assignment is computed into the variable.
+  compile_result = compile(allocator, "a = x * x");
+  munit_assert_true(compile_result.success);
+  bytecode = &compile_result.bytecode;
+  munit_assert_size(bytecode->count, ==, 2);
+  munit_assert_int(bytecode->instructions[0].opcode, ==, SMITH_OPCODE_INT_MUL);
+  munit_assert_uint32(bytecode->instructions[0].destination, ==, 3);
+  smith_bytecode_destroy(compile_result.bytecode);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_bytecode_deep(const MunitParameter params[],
+                                            void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  // Assignment groups to the right, so this nests as deep as it is long.
+  size_t terms = 50000;
+  char *source = smith_allocator_allocate_array(allocator, char, terms * 4 + 2);
+  munit_assert_not_null(source);
+  for (size_t i = 0; i < terms; i++) {
+    memcpy(source + i * 4, i % 2 == 0 ? "a = " : "c = ", 4);
+  }
+  memcpy(source + terms * 4, "x", 2);
+  assert_int(allocator, source, 6);
+  // A long sum needs one temporary however long it is.
+  for (size_t i = 0; i < terms; i++) {
+    memcpy(source + i * 4, "x + ", 4);
+  }
+  smith_bytecode_compile_result_t compile_result =
+      compile(allocator, source);
+  munit_assert_true(compile_result.success);
+  munit_assert_uint32(compile_result.bytecode.register_count, ==, 4);
+  smith_bytecode_destroy(compile_result.bytecode);
+  assert_int(allocator, source, 6 * (terms + 1));
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Writes literals joined by arithmetic and comparison operators, all ints or
+// all floats.
+static void random_literals(char *source, size_t capacity) {
+  const char *operators[] = {"+", "-", "*", "/", "==", "<", ">="};
+  bool floats = munit_rand_int_range(0, 1);
+  size_t length = 0;
+  int count = munit_rand_int_range(1, 8);
+  for (int i = 0; i < count; i++) {
+    int value = munit_rand_int_range(0, 5);
+    length += snprintf(source + length, capacity - length,
+                       floats ? "%d.5" : "%d", value);
+    if (i + 1 < count) {
+      length += snprintf(source + length, capacity - length, " %s ",
+                         operators[munit_rand_int_range(0, 6)]);
+    }
+  }
+}
+
+// The program computes what folding the expression at compile time would,
+// and traps or fails to compile where folding gives up.
+static MunitResult
+test_smith_bytecode_matches_folding(const MunitParameter params[],
+                                    void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create(),
+                                    .fold_constants = true};
+  char source[256];
+  for (int round = 0; round < 2000; round++) {
+    random_literals(source, sizeof(source));
+    smith_parse_result_t parse_result =
+        smith_parse_expression(context, (smith_cursor_t){.source = source});
+    smith_expression_t folded = parse_result.expression;
+    smith_bytecode_compile_result_t compile_result =
+        compile(allocator, source);
+    smith_vm_run_result_t run_result = {};
+    if (compile_result.success) {
+      run_result = smith_vm_run(allocator, &compile_result.bytecode, arguments);
+    }
+    if (folded.kind == SMITH_EXPRESSION_KIND_CONSTANT) {
+      smith_constant_t expected = folded.value.constant.constant;
+      munit_assert_true(run_result.success);
+      munit_assert_int(compile_result.bytecode.result_kind, ==, expected.kind);
+      switch (expected.kind) {
+      case SMITH_CONSTANT_KIND_INT:
+        munit_assert_int64(run_result.value.int_, ==, expected.value.int_);
+        break;
+      case SMITH_CONSTANT_KIND_FLOAT:
+        munit_assert_memory_equal(sizeof(double), &run_result.value.float_,
+                                  &expected.value.float_);
+        break;
+      case SMITH_CONSTANT_KIND_BOOL:
+        munit_assert(run_result.value.bool_ == expected.value.bool_);
+        break;
+      }
+    } else if (folded.kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      munit_assert_false(run_result.success);
+    }
+    if (compile_result.success) {
+      smith_bytecode_destroy(compile_result.bytecode);
+    }
+    smith_expression_destroy(allocator, folded);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_bytecode_tests[] = {
+    {
+        .name = "/test_smith_bytecode_run",
+        .test = test_smith_bytecode_run,
+    },
+    {
+        .name = "/test_smith_bytecode_errors",
+        .test = test_smith_bytecode_errors,
+    },
+    {
+        .name = "/test_smith_bytecode_layout",
+        .test = test_smith_bytecode_layout,
+    },
+    {
+        .name = "/test_smith_bytecode_deep",
+        .test = test_smith_bytecode_deep,
+    },
+    {
+        .name = "/test_smith_bytecode_matches_folding",
+        .test = test_smith_bytecode_matches_folding,
+    },
+    {}};
+
+MunitSuite smith_bytecode_suite = {
+    .prefix = "/bytecode",
+    .tests = smith_bytecode_tests,
+    .iterations = 1,
+};
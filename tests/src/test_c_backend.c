@@ -0,0 +1,332 @@
+// For `mkstemp` and `popen`, which strict C modes hide.
+#define _DEFAULT_SOURCE 1
+
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/c_backend.h"
+#include "smith/format.h"
+#include "smith/null_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/vm.h"
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct {
+  char data[4096];
+  size_t length;
+  size_t writes;
+} string_writer_t;
+
+static bool string_writer_write(void *writer, const char *buffer,
+                                size_t length) {
+  string_writer_t *string_writer = writer;
+  if (string_writer->length + length > sizeof(string_writer->data)) {
+    return false;
+  }
+  memcpy(string_writer->data + string_writer->length, buffer, length);
+  string_writer->length += length;
+  string_writer->writes++;
+  return true;
+}
+
+static void string_writer_destroy(void *writer) {}
+
+static smith_ir_function_t build(smith_allocator_t allocator, char *source) {
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t parse_result =
+      smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+  smith_ir_build_result_t build_result = smith_ir_build(
+      allocator, &ast, parse_result.root, smith_random_parameters, 3);
+  smith_ast_destroy(ast);
+  munit_assert_true(build_result.success);
+  munit_assert_true(smith_ir_optimize(&build_result.function, nullptr));
+  return build_result.function;
+}
+
+// A path for the compiler to write to.
+static void output_path(char *path) {
+  strcpy(path, "/tmp/smith-test-XXXXXX");
+  int file_descriptor = mkstemp(path);
+  munit_assert_int(file_descriptor, >=, 0);
+  close(file_descriptor);
+}
+
+static MunitResult
+test_smith_buffered_writer(const MunitParameter params[],
+                           void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  string_writer_t string_writer = {};
+  smith_writer_t writer = {.state = &string_writer,
+                           .write = string_writer_write,
+                           .destroy = string_writer_destroy};
+  smith_buffered_writer_create_result_t create_result =
+      smith_buffered_writer_create(allocator, writer, 16);
+  munit_assert_true(create_result.success);
+  smith_buffered_writer_t *buffered = &create_result.writer;
+  munit_assert_true(smith_buffered_writer_format(buffered, "%d + %d", 1, 2));
+  munit_assert_true(smith_buffered_writer_write(buffered, " = ", 3));
+  munit_assert_size(string_writer.writes, ==, 0);
+  // Fills the buffer, so what was buffered is passed on first.
+  munit_assert_true(smith_buffered_writer_format(buffered, "%s", "three four"));
+  munit_assert_size(string_writer.writes, ==, 1);
+  // Larger than the buffer, so passed on directly.
+  munit_assert_true(
+      smith_buffered_writer_format(buffered, ", %s", "which is odd, indeed"));
+  munit_assert_true(smith_buffered_writer_write(buffered, "!", 1));
+  munit_assert_true(smith_buffered_writer_flush(buffered));
+  munit_assert_size(string_writer.writes, ==, 4);
+  munit_assert_memory_equal(string_writer.length, string_writer.data,
+                            "1 + 2 = three four, which is odd, indeed!");
+  smith_buffered_writer_destroy(create_result.writer);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_c_emit(const MunitParameter params[],
+                                     void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  string_writer_t string_writer = {};
+  smith_writer_t writer = {.state = &string_writer,
+                           .write = string_writer_write,
+                           .destroy = string_writer_destroy};
+  smith_buffered_writer_create_result_t create_result =
+      smith_buffered_writer_create(allocator, writer, 0);
+  munit_assert_true(create_result.success);
+  smith_ir_function_t function = build(allocator, "x * 2 + 2 * x");
+  munit_assert_true(smith_c_emit(&create_result.writer, &function,
+                                 smith_random_parameters, "f",
+                                 SMITH_C_OUTPUT_SHARED_OBJECT));
+  munit_assert_true(smith_buffered_writer_flush(&create_result.writer));
+  string_writer.data[string_writer.length] = '\0';
+  // The optimized function: one product, and `y` and `b` are never read.
+  munit_assert_not_null(strstr(string_writer.data,
+                               "bool f(const smith_value_t *arguments, "
+                               "smith_value_t *result) {\n"
+                               "  const int64_t v0 = arguments[0].int_;\n"
+                               "  const int64_t v3 = INT64_C(2);\n"
+                               "  int64_t v4;\n"
+                               "  if (smith_mul(v0, v3, &v4)) {\n"
+                               "    return false;\n"
+                               "  }\n"
+                               "  int64_t v7;\n"
+                               "  if (smith_add(v4, v4, &v7)) {\n"
+                               "    return false;\n"
+                               "  }\n"
+                               "  result->int_ = v7;\n"
+                               "  return true;\n"
+                               "}\n"));
+  munit_assert_null(strstr(string_writer.data, "int main"));
+  smith_ir_function_destroy(function);
+  smith_buffered_writer_destroy(create_result.writer);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_c_rejects_names(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  string_writer_t string_writer = {};
+  smith_writer_t writer = {.state = &string_writer,
+                           .write = string_writer_write,
+                           .destroy = string_writer_destroy};
+  smith_buffered_writer_create_result_t create_result =
+      smith_buffered_writer_create(allocator, writer, 0);
+  munit_assert_true(create_result.success);
+  smith_ir_function_t function = build(allocator, "x + 1");
+  struct {
+    const char *name;
+    smith_c_output_kind_t kind;
+    bool valid;
+  } cases[] = {
+      {"f_2", SMITH_C_OUTPUT_EXECUTABLE, true},
+      {"main", SMITH_C_OUTPUT_SHARED_OBJECT, true},
+      {"result", SMITH_C_OUTPUT_SHARED_OBJECT, true},
+      {"", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"2f", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"_f", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"f-g", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"f(void); int g", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"caf\xc3\xa9", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"int", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"bool", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"smith_add", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"smith_value_t", SMITH_C_OUTPUT_SHARED_OBJECT, false},
+      {"main", SMITH_C_OUTPUT_EXECUTABLE, false},
+      {"argv", SMITH_C_OUTPUT_EXECUTABLE, false},
+      {"result", SMITH_C_OUTPUT_EXECUTABLE, false},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    bool emitted =
+        smith_c_emit(&create_result.writer, &function, smith_random_parameters,
+                     cases[i].name, cases[i].kind);
+    munit_assert_true(smith_buffered_writer_flush(&create_result.writer));
+    munit_assert(emitted == cases[i].valid);
+    // Nothing is written for a name that is not valid.
+    munit_assert(cases[i].valid || string_writer.length == 0);
+    string_writer.length = 0;
+  }
+  // Building fails before the compiler runs.
+  char path[64];
+  output_path(path);
+  unlink(path);
+  munit_assert_false(smith_c_build(allocator, &function,
+                                   smith_random_parameters, "main",
+                                   SMITH_C_OUTPUT_EXECUTABLE, path));
+  munit_assert_int(access(path, F_OK), !=, 0);
+  smith_ir_function_destroy(function);
+  smith_buffered_writer_destroy(create_result.writer);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_c_build_executable(const MunitParameter params[],
+                                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_ir_function_t function = build(allocator, "y > 1.5 == b");
+  char path[64];
+  output_path(path);
+  munit_assert_true(smith_c_build(allocator, &function,
+                                  smith_random_parameters, "f",
+                                  SMITH_C_OUTPUT_EXECUTABLE, path));
+  smith_ir_function_destroy(function);
+  struct {
+    const char *arguments;
+    const char *output;
+  } runs[] = {
+      {"0 1.75 true", "true\n"},
+      {"0 1.25 true", "false\n"},
+      {"0 1.25 false", "true\n"},
+  };
+  for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+    char *command = smith_format_string(allocator, "%s %s 2>/dev/null", path,
+                                        runs[i].arguments);
+    FILE *pipe = popen(command, "r");
+    munit_assert_not_null(pipe);
+    char output[64] = {};
+    munit_assert_size(fread(output, 1, sizeof(output) - 1, pipe), >, 0);
+    munit_assert_int(WEXITSTATUS(pclose(pipe)), ==, 0);
+    munit_assert_string_equal(output, runs[i].output);
+    smith_allocator_deallocate(allocator, command);
+  }
+  unlink(path);
+  // Traps exit with status 1.
+  function = build(allocator, "x / 0");
+  munit_assert_true(smith_c_build(allocator, &function,
+                                  smith_random_parameters, "f",
+                                  SMITH_C_OUTPUT_EXECUTABLE, path));
+  smith_ir_function_destroy(function);
+  char *command =
+      smith_format_string(allocator, "%s 7 0.0 false 2>/dev/null", path);
+  int status = system(command);
+  munit_assert_true(WIFEXITED(status));
+  munit_assert_int(WEXITSTATUS(status), ==, 1);
+  smith_allocator_deallocate(allocator, command);
+  unlink(path);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+typedef bool (*function_t)(const smith_constant_value_t *arguments,
+                           smith_constant_value_t *result);
+
+static MunitResult
+test_smith_c_build_shared_object(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char *sources[] = {
+      "x * x - 1",
+      "x / 7 + x & 255 | 3",
+      "y * 2.0 - y / 0.5 + 0.1",
+      "y / 0.0 * 0.0 + 1.0 / 0.0",
+      "0 - 9223372036854775807 - 1 + x",
+      "x > 2 == b && b || b",
+      "a = x += 4",
+      "b = b == b != b",
+  };
+  char path[64];
+  output_path(path);
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    smith_ir_function_t function = build(allocator, sources[i]);
+    smith_bytecode_compile_result_t compile_result =
+        smith_ir_to_bytecode(allocator, &function);
+    munit_assert_true(compile_result.success);
+    munit_assert_true(smith_c_build(allocator, &function,
+                                    smith_random_parameters, "f",
+                                    SMITH_C_OUTPUT_SHARED_OBJECT, path));
+    smith_ir_function_destroy(function);
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    munit_assert_not_null(handle);
+    function_t f = (function_t)dlsym(handle, "f");
+    munit_assert_not_null(f);
+    for (int row = 0; row < 100; row++) {
+      smith_constant_value_t arguments[] = {
+          {.int_ = munit_rand_int_range(-100, 100)},
+          {.float_ = munit_rand_int_range(-100, 100) * 0.25},
+          {.bool_ = munit_rand_int_range(0, 1)}};
+      if (row == 0) {
+        arguments[0].int_ = INT64_MAX;
+      }
+      smith_vm_run_result_t want =
+          smith_vm_run(allocator, &compile_result.bytecode, arguments);
+      smith_constant_value_t got;
+      munit_assert(f(arguments, &got) == want.success);
+      if (!want.success) {
+        continue;
+      }
+      switch (compile_result.bytecode.result_kind) {
+      case SMITH_CONSTANT_KIND_INT:
+        munit_assert_int64(got.int_, ==, want.value.int_);
+        break;
+      case SMITH_CONSTANT_KIND_FLOAT:
+        munit_assert_memory_equal(sizeof(double), &got.float_,
+                                  &want.value.float_);
+        break;
+      case SMITH_CONSTANT_KIND_BOOL:
+        munit_assert(got.bool_ == want.value.bool_);
+        break;
+      }
+    }
+    dlclose(handle);
+    smith_bytecode_destroy(compile_result.bytecode);
+  }
+  unlink(path);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_c_backend_tests[] = {
+    {
+        .name = "/test_smith_buffered_writer",
+        .test = test_smith_buffered_writer,
+    },
+    {
+        .name = "/test_smith_c_emit",
+        .test = test_smith_c_emit,
+    },
+    {
+        .name = "/test_smith_c_rejects_names",
+        .test = test_smith_c_rejects_names,
+    },
+    {
+        .name = "/test_smith_c_build_executable",
+        .test = test_smith_c_build_executable,
+    },
+    {
+        .name = "/test_smith_c_build_shared_object",
+        .test = test_smith_c_build_shared_object,
+    },
+    {}};
+
+MunitSuite smith_c_backend_suite = {
+    .prefix = "/c_backend",
+    .tests = smith_c_backend_tests,
+    .iterations = 1,
+};
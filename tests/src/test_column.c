@@ -0,0 +1,234 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/column.h"
+#include "smith/null_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/vm.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Spans several blocks and ends on an odd row.
+enum { ROW_COUNT = SMITH_COLUMN_BLOCK_SIZE * 2 + 77 };
+
+typedef struct {
+  int64_t x[ROW_COUNT];
+  double y[ROW_COUNT];
+  bool b[ROW_COUNT];
+} table_t;
+
+static smith_column_compile_result_t compile(smith_allocator_t allocator,
+                                             char *source) {
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_parse_result_t parse_result =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  smith_column_compile_result_t compile_result = smith_column_compile(
+      allocator, &parse_result.expression, smith_random_parameters, 3);
+  smith_expression_destroy(allocator, parse_result.expression);
+  return compile_result;
+}
+
+// Evaluates the program over the table and each row on the interpreter,
+// which must agree on every value or on some row trapping.
+static bool run_both(smith_allocator_t allocator,
+                     const smith_column_program_t *program,
+                     const table_t *table) {
+  const void *columns[] = {table->x, table->y, table->b};
+  smith_constant_value_t *results = smith_allocator_allocate_array(
+      allocator, smith_constant_value_t, ROW_COUNT);
+  munit_assert_not_null(results);
+  bool success = smith_column_run(program, columns, ROW_COUNT, results);
+  bool trapped = false;
+  for (size_t row = 0; row < ROW_COUNT; row++) {
+    smith_constant_value_t arguments[] = {{.int_ = table->x[row]},
+                                          {.float_ = table->y[row]},
+                                          {.bool_ = table->b[row]}};
+    smith_vm_run_result_t run_result =
+        smith_vm_run(allocator, &program->bytecode, arguments);
+    if (!run_result.success) {
+      trapped = true;
+      continue;
+    }
+    if (!success) {
+      continue;
+    }
+    switch (program->bytecode.result_kind) {
+    case SMITH_CONSTANT_KIND_INT:
+      munit_assert_int64(results[row].int_, ==, run_result.value.int_);
+      break;
+    case SMITH_CONSTANT_KIND_FLOAT:
+      munit_assert_memory_equal(sizeof(double), &results[row].float_,
+                                &run_result.value.float_);
+      break;
+    case SMITH_CONSTANT_KIND_BOOL:
+      munit_assert(((bool *)results)[row] == run_result.value.bool_);
+      break;
+    }
+  }
+  munit_assert(success == !trapped);
+  smith_allocator_deallocate(allocator, results);
+  return success;
+}
+
+static void fill(table_t *table, int64_t range) {
+  for (size_t row = 0; row < ROW_COUNT; row++) {
+    table->x[row] = munit_rand_int_range(-range, range);
+    table->y[row] = munit_rand_int_range(-range, range) * 0.5;
+    table->b[row] = munit_rand_int_range(0, 1);
+  }
+}
+
+static MunitResult test_smith_column_run(const MunitParameter params[],
+                                         void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  table_t *table = smith_allocator_allocate(allocator, table_t);
+  munit_assert_not_null(table);
+  fill(table, 1000);
+  table->y[5] = NAN;
+  char *sources[] = {
+      "x * x - 1",       "x / 7 + x & 255 | 3", "y * 2.0 - y / 0.5",
+      "y",               "b",                   "x <= 6 == b",
+      "y != y || b",     "y < 0.5 == b && b",   "y > 1.0 != b",
+      "a = x * 3",       "a = x += 4",          "y /= 2.0",
+      "b = b == b != b", "x > 9 == b",          "2.5",
+  };
+  int64_t x[ROW_COUNT];
+  memcpy(x, table->x, sizeof(x));
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    smith_column_compile_result_t compile_result =
+        compile(allocator, sources[i]);
+    munit_assert_true(compile_result.success);
+    munit_assert_true(run_both(allocator, &compile_result.program, table));
+    smith_column_program_destroy(compile_result.program);
+  }
+  // Updating a parameter leaves its column as it was.
+  munit_assert_memory_equal(sizeof(x), x, table->x);
+  smith_allocator_deallocate(allocator, table);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Sets every byte of each bool constant that the bool does not use, which
+// nothing guarantees to be zero.
+static void scramble_bool_constants(smith_expression_t *expression) {
+  if (expression->kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    scramble_bool_constants(expression->value.binary_operator.left);
+    scramble_bool_constants(expression->value.binary_operator.right);
+  } else if (expression->kind == SMITH_EXPRESSION_KIND_CONSTANT &&
+             expression->value.constant.constant.kind ==
+                 SMITH_CONSTANT_KIND_BOOL) {
+    smith_constant_value_t *value = &expression->value.constant.constant.value;
+    bool bool_ = value->bool_;
+    memset(value, 0xA5, sizeof(*value));
+    value->bool_ = bool_;
+  }
+}
+
+static MunitResult
+test_smith_column_bool_constants(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  table_t *table = smith_allocator_allocate(allocator, table_t);
+  munit_assert_not_null(table);
+  fill(table, 3);
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create(),
+                                    .fold_constants = true};
+  // Each comparison of literals folds to a bool constant.
+  char *sources[] = {"2 < 1",      "1 < 2 == b",     "2 < 1 != b",
+                     "1 < 2 && b", "a = 2 < 1 || b", "b = 2 < 1",
+                     "a = 2 < 1",  "a = b = 2 < 1"};
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    smith_parse_result_t parse_result = smith_parse_expression(
+        context, (smith_cursor_t){.source = sources[i]});
+    munit_assert_true(parse_result.success);
+    scramble_bool_constants(&parse_result.expression);
+    smith_column_compile_result_t compile_result = smith_column_compile(
+        allocator, &parse_result.expression, smith_random_parameters, 3);
+    smith_expression_destroy(allocator, parse_result.expression);
+    munit_assert_true(compile_result.success);
+    munit_assert_uint32(compile_result.program.bytecode.constant_count, >, 0);
+    munit_assert_true(run_both(allocator, &compile_result.program, table));
+    smith_column_program_destroy(compile_result.program);
+  }
+  smith_allocator_deallocate(allocator, table);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_column_traps(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  table_t *table = smith_allocator_allocate(allocator, table_t);
+  munit_assert_not_null(table);
+  fill(table, 1000);
+  char *sources[] = {"1 / x", "x + 9223372036854775000",
+                     "0 - 9223372036854775000 - x", "x * 1317624576693539401"};
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    smith_column_compile_result_t compile_result =
+        compile(allocator, sources[i]);
+    munit_assert_true(compile_result.success);
+    // A single row in the last block traps.
+    table->x[ROW_COUNT - 1] = i == 0 ? 0 : 1000;
+    for (size_t row = 0; row + 1 < ROW_COUNT; row++) {
+      table->x[row] = 1 + row % 7;
+    }
+    munit_assert_false(run_both(allocator, &compile_result.program, table));
+    table->x[ROW_COUNT - 1] = 1;
+    munit_assert_true(run_both(allocator, &compile_result.program, table));
+    smith_column_program_destroy(compile_result.program);
+  }
+  smith_allocator_deallocate(allocator, table);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_column_matches_interpreter(const MunitParameter params[],
+                                      void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  table_t *table = smith_allocator_allocate(allocator, table_t);
+  munit_assert_not_null(table);
+  char source[512];
+  for (int round = 0; round < 200; round++) {
+    smith_random_expression(source, sizeof(source));
+    smith_column_compile_result_t compile_result = compile(allocator, source);
+    if (!compile_result.success) {
+      continue;
+    }
+    fill(table, 3);
+    run_both(allocator, &compile_result.program, table);
+    smith_column_program_destroy(compile_result.program);
+  }
+  smith_allocator_deallocate(allocator, table);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_column_tests[] = {
+    {
+        .name = "/test_smith_column_run",
+        .test = test_smith_column_run,
+    },
+    {
+        .name = "/test_smith_column_bool_constants",
+        .test = test_smith_column_bool_constants,
+    },
+    {
+        .name = "/test_smith_column_traps",
+        .test = test_smith_column_traps,
+    },
+    {
+        .name = "/test_smith_column_matches_interpreter",
+        .test = test_smith_column_matches_interpreter,
+    },
+    {}};
+
+MunitSuite smith_column_suite = {
+    .prefix = "/column",
+    .tests = smith_column_tests,
+    .iterations = 1,
+};
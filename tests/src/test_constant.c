@@ -0,0 +1,156 @@
+#include "smith/constant.h"
+#include "smith/test_suites.h"
+#include <math.h>
+#include <string.h>
+
+static smith_string_t string(char *data) {
+  return (smith_string_t){.data = data, .length = strlen(data)};
+}
+
+static smith_constant_t int_(int64_t value) {
+  return (smith_constant_t){.kind = SMITH_CONSTANT_KIND_INT,
+                            .value.int_ = value};
+}
+
+static smith_constant_t float_(double value) {
+  return (smith_constant_t){.kind = SMITH_CONSTANT_KIND_FLOAT,
+                            .value.float_ = value};
+}
+
+static smith_constant_t bool_(bool value) {
+  return (smith_constant_t){.kind = SMITH_CONSTANT_KIND_BOOL,
+                            .value.bool_ = value};
+}
+
+static MunitResult
+test_smith_constant_from_literal(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_constant_result_t result = smith_constant_from_literal(
+      SMITH_EXPRESSION_KIND_INT, string("9223372036854775807"));
+  munit_assert_true(result.success);
+  munit_assert_int64(result.constant.value.int_, ==, INT64_MAX);
+  munit_assert_false(smith_constant_from_literal(SMITH_EXPRESSION_KIND_INT,
+                                                 string("9223372036854775808"))
+                         .success);
+  result = smith_constant_from_literal(SMITH_EXPRESSION_KIND_FLOAT,
+                                       string(".25"));
+  munit_assert_true(result.success);
+  munit_assert_int(result.constant.kind, ==, SMITH_CONSTANT_KIND_FLOAT);
+  munit_assert_double(result.constant.value.float_, ==, 0.25);
+  // Only the text of the literal is read, not what follows it.
+  result = smith_constant_from_literal(
+      SMITH_EXPRESSION_KIND_FLOAT, (smith_string_t){.data = "1.5e3", .length = 3});
+  munit_assert_true(result.success);
+  munit_assert_double(result.constant.value.float_, ==, 1.5);
+  munit_assert_false(
+      smith_constant_from_literal(SMITH_EXPRESSION_KIND_FLOAT, string("1.2.3"))
+          .success);
+  munit_assert_false(
+      smith_constant_from_literal(SMITH_EXPRESSION_KIND_FLOAT, string("."))
+          .success);
+  munit_assert_false(
+      smith_constant_from_literal(SMITH_EXPRESSION_KIND_SYMBOL, string("x"))
+          .success);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_constant_fold_int(const MunitParameter params[],
+                                                void *user_data_or_fixture) {
+  struct {
+    smith_binary_operator_kind_t kind;
+    int64_t left;
+    int64_t right;
+    int64_t value;
+  } folded[] = {
+      {SMITH_BINARY_OPERATOR_KIND_ADD, 2, 3, 5},
+      {SMITH_BINARY_OPERATOR_KIND_SUB, 2, 3, -1},
+      {SMITH_BINARY_OPERATOR_KIND_MUL, 3600, 24, 86400},
+      {SMITH_BINARY_OPERATOR_KIND_DIV, 7, 2, 3},
+      {SMITH_BINARY_OPERATOR_KIND_DIV, -7, 2, -3},
+      {SMITH_BINARY_OPERATOR_KIND_ADD, INT64_MAX - 1, 1, INT64_MAX},
+  };
+  for (size_t i = 0; i < sizeof(folded) / sizeof(folded[0]); i++) {
+    smith_constant_result_t result = smith_constant_fold(
+        folded[i].kind, int_(folded[i].left), int_(folded[i].right));
+    munit_assert_true(result.success);
+    munit_assert_int(result.constant.kind, ==, SMITH_CONSTANT_KIND_INT);
+    munit_assert_int64(result.constant.value.int_, ==, folded[i].value);
+  }
+  struct {
+    smith_binary_operator_kind_t kind;
+    int64_t left;
+    int64_t right;
+  } unfolded[] = {
+      {SMITH_BINARY_OPERATOR_KIND_ADD, INT64_MAX, 1},
+      {SMITH_BINARY_OPERATOR_KIND_SUB, INT64_MIN, 1},
+      {SMITH_BINARY_OPERATOR_KIND_MUL, INT64_MAX / 2 + 1, 2},
+      {SMITH_BINARY_OPERATOR_KIND_DIV, 1, 0},
+      {SMITH_BINARY_OPERATOR_KIND_DIV, INT64_MIN, -1},
+      {SMITH_BINARY_OPERATOR_KIND_ASSIGN, 1, 2},
+      {SMITH_BINARY_OPERATOR_KIND_BIT_AND, 1, 2},
+  };
+  for (size_t i = 0; i < sizeof(unfolded) / sizeof(unfolded[0]); i++) {
+    munit_assert_false(smith_constant_fold(unfolded[i].kind,
+                                           int_(unfolded[i].left),
+                                           int_(unfolded[i].right))
+                           .success);
+  }
+  smith_constant_result_t result =
+      smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_LE, int_(2), int_(2));
+  munit_assert_int(result.constant.kind, ==, SMITH_CONSTANT_KIND_BOOL);
+  munit_assert_true(result.constant.value.bool_);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_constant_fold_float_and_bool(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_constant_result_t result = smith_constant_fold(
+      SMITH_BINARY_OPERATOR_KIND_ADD, float_(0.1), float_(0.2));
+  munit_assert_true(result.success);
+  munit_assert_double(result.constant.value.float_, ==, 0.1 + 0.2);
+  result = smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_DIV, float_(1.0),
+                               float_(0.0));
+  munit_assert_true(result.success);
+  munit_assert_true(isinf(result.constant.value.float_));
+  result = smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_DIV, float_(0.0),
+                               float_(0.0));
+  munit_assert_true(isnan(result.constant.value.float_));
+  // NaN compares unequal to itself.
+  result = smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_EQ,
+                               result.constant, result.constant);
+  munit_assert_true(result.success);
+  munit_assert_false(result.constant.value.bool_);
+  result = smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_NOT_EQ, bool_(true),
+                               bool_(false));
+  munit_assert_true(result.success);
+  munit_assert_true(result.constant.value.bool_);
+  munit_assert_false(smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_ADD,
+                                         bool_(true), bool_(false))
+                         .success);
+  munit_assert_false(smith_constant_fold(SMITH_BINARY_OPERATOR_KIND_ADD,
+                                         int_(1), float_(1.0))
+                         .success);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_constant_tests[] = {
+    {
+        .name = "/test_smith_constant_from_literal",
+        .test = test_smith_constant_from_literal,
+    },
+    {
+        .name = "/test_smith_constant_fold_int",
+        .test = test_smith_constant_fold_int,
+    },
+    {
+        .name = "/test_smith_constant_fold_float_and_bool",
+        .test = test_smith_constant_fold_float_and_bool,
+    },
+    {}};
+
+MunitSuite smith_constant_suite = {
+    .prefix = "/constant",
+    .tests = smith_constant_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,152 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/dag.h"
+#include "smith/null_interner.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <string.h>
+
+static MunitResult test_smith_dag_shares_subtrees(const MunitParameter params[],
+                                                  void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t parse_result = smith_parse_ast(
+      context, &ast, (smith_cursor_t){.source = "a * b + 1 = a * b + 1"});
+  munit_assert_uint32(ast.count, ==, 11);
+  smith_dag_t dag = smith_dag_create(allocator);
+  smith_dag_intern_result_t intern_result =
+      smith_dag_intern_ast(&dag, &ast, parse_result.root);
+  munit_assert_true(intern_result.success);
+  // a, b, a * b, 1, a * b + 1 and the assignment.
+  munit_assert_uint32(dag.count, ==, 6);
+  munit_assert_uint32(intern_result.node, ==, 5);
+  smith_ast_children_t root = dag.children[intern_result.node];
+  munit_assert_uint32(root.left, ==, root.right);
+  for (smith_dag_node_t node = 0; node < dag.count; node++) {
+    if (dag.kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      munit_assert_uint32(dag.children[node].left, <, node);
+      munit_assert_uint32(dag.children[node].right, <, node);
+    }
+  }
+  // The same text as a symbol and as an int are different leaves, and
+  // operands in the other order are a different operator node.
+  smith_ast_leaf_t one = {.text = {.data = "1", .length = 1}};
+  smith_dag_intern_result_t int_result =
+      smith_dag_intern_leaf(&dag, SMITH_EXPRESSION_KIND_INT, one);
+  munit_assert_uint32(int_result.node, ==, 3);
+  smith_dag_intern_result_t symbol_result =
+      smith_dag_intern_leaf(&dag, SMITH_EXPRESSION_KIND_SYMBOL, one);
+  munit_assert_uint32(symbol_result.node, ==, 6);
+  smith_dag_intern_result_t swapped_result = smith_dag_intern_binary_operator(
+      &dag, smith_binary_operator_mapping[SMITH_OPERATOR_KIND_MUL],
+      (smith_ast_children_t){.left = 1, .right = 0});
+  munit_assert_uint32(swapped_result.node, ==, 7);
+  smith_dag_destroy(dag);
+  smith_ast_destroy(ast);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_dag_intern_expression(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  // A long sum of the same product: the product is stored once and each
+  // partial sum once, however many terms there are.
+  size_t terms = 20000;
+  char *source =
+      smith_allocator_allocate_array(allocator, char, terms * 8);
+  munit_assert_not_null(source);
+  for (size_t i = 0; i < terms; i++) {
+    memcpy(source + i * 8, "x * y + ", 8);
+  }
+  source[terms * 8 - 3] = '\0';
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t parse_result =
+      smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+  smith_dag_t dag = smith_dag_create(allocator);
+  smith_dag_intern_result_t ast_result =
+      smith_dag_intern_ast(&dag, &ast, parse_result.root);
+  munit_assert_true(ast_result.success);
+  munit_assert_uint32(dag.count, ==, terms + 2);
+  // The same expression as pointers adds nothing new.
+  smith_ast_to_expression_result_t to_expression_result =
+      smith_ast_to_expression(allocator, &ast, parse_result.root);
+  munit_assert_true(to_expression_result.success);
+  smith_expression_t expression = to_expression_result.expression;
+  smith_dag_intern_result_t expression_result =
+      smith_dag_intern_expression(&dag, expression);
+  munit_assert_true(expression_result.success);
+  munit_assert_uint32(expression_result.node, ==, ast_result.node);
+  munit_assert_uint32(dag.count, ==, terms + 2);
+  smith_expression_destroy(allocator, expression);
+  smith_dag_destroy(dag);
+  smith_ast_destroy(ast);
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static smith_string_t parameter_name(const void *parameters, uint32_t index) {
+  return ((const smith_string_t *)parameters)[index];
+}
+
+static MunitResult test_smith_dag_number_symbols(const MunitParameter params[],
+                                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t parse_result = smith_parse_ast(
+      context, &ast, (smith_cursor_t){.source = "x = a + y * a"});
+  munit_assert_uint32(ast.count, ==, 7);
+  smith_string_t parameters[] = {{.data = "y", .length = 1},
+                                 {.data = "a", .length = 1}};
+  smith_dag_node_t symbols[7];
+  smith_dag_t dag = smith_dag_create(allocator);
+  munit_assert_true(smith_dag_number_symbols(&dag, &ast, parse_result.root,
+                                             parameters, 2, parameter_name,
+                                             symbols));
+  // x, a, y and a, then the three operators.
+  smith_dag_node_t expected[] = {2, 1, 0, 1, SMITH_DAG_NO_NODE,
+                                 SMITH_DAG_NO_NODE, SMITH_DAG_NO_NODE};
+  for (size_t i = 0; i < 7; i++) {
+    munit_assert_uint32(symbols[i], ==, expected[i]);
+  }
+  smith_dag_destroy(dag);
+  // Two parameters with one name cannot both be their own index.
+  parameters[0] = parameters[1];
+  dag = smith_dag_create(allocator);
+  munit_assert_false(smith_dag_number_symbols(&dag, &ast, parse_result.root,
+                                              parameters, 2, parameter_name,
+                                              symbols));
+  smith_dag_destroy(dag);
+  smith_ast_destroy(ast);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_dag_tests[] = {
+    {
+        .name = "/test_smith_dag_shares_subtrees",
+        .test = test_smith_dag_shares_subtrees,
+    },
+    {
+        .name = "/test_smith_dag_intern_expression",
+        .test = test_smith_dag_intern_expression,
+    },
+    {
+        .name = "/test_smith_dag_number_symbols",
+        .test = test_smith_dag_number_symbols,
+    },
+    {}};
+
+MunitSuite smith_dag_suite = {
+    .prefix = "/dag",
+    .tests = smith_dag_tests,
+    .iterations = 1,
+};
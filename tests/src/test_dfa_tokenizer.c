@@ -0,0 +1,107 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/assertions.h"
+#include "smith/copying_interner.h"
+#include "smith/dfa_tokenizer.h"
+#include "smith/hash_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  smith_copying_interner_create_result_t copying_interner_create_result =
+      smith_copying_interner_create(allocator, interner_create_result.interner);
+  munit_assert(copying_interner_create_result.success);
+  return copying_interner_create_result.interner;
+}
+
+// Lexes `source` with both tokenizers and asserts they agree on every token.
+static void assert_tokenizers_agree(smith_interner_t interner, char *source) {
+  smith_cursor_t cursor = {.source = source};
+  while (true) {
+    smith_next_token_result_t expected = smith_next_token(interner, cursor);
+    smith_next_token_result_t actual = smith_dfa_next_token(interner, cursor);
+    smith_assert_next_token_result_equal(actual, expected);
+    munit_assert_ptr_equal(actual.cursor.source, expected.cursor.source);
+    if (expected.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      return;
+    }
+    cursor = expected.cursor;
+  }
+}
+
+static MunitResult
+test_smith_dfa_next_token_matches_next_token(const MunitParameter params[],
+                                             void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  for (size_t i = 0; i < 20; i++) {
+    smith_interner_t interner = interner_create(allocator);
+    smith_string_t source = smith_random_source(allocator, 200);
+    assert_tokenizers_agree(interner, source.data);
+    smith_interner_destroy(interner);
+    smith_allocator_deallocate(allocator, source.data);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_dfa_next_token_short_strings(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char alphabet[] = "aZ_09.+-*/=!<>&|()[]{},;#\"\\\t\n \x7f\x80\xff\xc3\xa9";
+  size_t alphabet_length = sizeof(alphabet) - 1;
+  char source[4] = {};
+  for (size_t a = 0; a < alphabet_length; a++) {
+    for (size_t b = 0; b <= alphabet_length; b++) {
+      for (size_t c = 0; c <= alphabet_length; c++) {
+        source[0] = alphabet[a];
+        source[1] = alphabet[b];
+        source[2] = b < alphabet_length ? alphabet[c] : '\0';
+        assert_tokenizers_agree(interner, source);
+      }
+    }
+  }
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_dfa_next_token_every_byte(const MunitParameter params[],
+                                     void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  for (size_t byte = 1; byte < 256; byte++) {
+    char source[] = {'a', (char)byte, '1', (char)byte, '\0'};
+    assert_tokenizers_agree(interner, source);
+  }
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_dfa_tokenizer_tests[] = {
+    {
+        .name = "/test_smith_dfa_next_token_matches_next_token",
+        .test = test_smith_dfa_next_token_matches_next_token,
+    },
+    {
+        .name = "/test_smith_dfa_next_token_short_strings",
+        .test = test_smith_dfa_next_token_short_strings,
+    },
+    {
+        .name = "/test_smith_dfa_next_token_every_byte",
+        .test = test_smith_dfa_next_token_every_byte,
+    },
+    {}};
+
+MunitSuite smith_dfa_tokenizer_suite = {
+    .prefix = "/dfa_tokenizer",
+    .tests = smith_dfa_tokenizer_tests,
+    .iterations = 1,
+};
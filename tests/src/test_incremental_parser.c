@@ -0,0 +1,360 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/assertions.h"
+#include "smith/copying_interner.h"
+#include "smith/hash_interner.h"
+#include "smith/incremental_parser.h"
+#include "smith/null_interner.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdio.h>
+#include <string.h>
+
+// The interner copies its strings, so old source text can be released as soon
+// as it has been edited.
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  smith_copying_interner_create_result_t copying_interner_create_result =
+      smith_copying_interner_create(allocator, interner_create_result.interner);
+  munit_assert(copying_interner_create_result.success);
+  return copying_interner_create_result.interner;
+}
+
+static smith_token_buffer_t tokenize(smith_allocator_t allocator,
+                                     char *source) {
+  smith_tokenize_result_t tokenize_result =
+      smith_tokenize(allocator, smith_null_interner_create(), source);
+  munit_assert(tokenize_result.success);
+  return tokenize_result.buffer;
+}
+
+static char *copy(smith_allocator_t allocator, const char *source) {
+  size_t length = strlen(source);
+  char *copied = smith_allocator_allocate_array(allocator, char, length + 1);
+  munit_assert_not_null(copied);
+  memcpy(copied, source, length + 1);
+  return copied;
+}
+
+// Applies the edit to `source`, returning a newly allocated string.
+static char *apply_edit(smith_allocator_t allocator, const char *source,
+                        smith_edit_t edit) {
+  size_t length = strlen(source);
+  size_t new_length = length - edit.removed_length + edit.inserted.length;
+  char *new_source =
+      smith_allocator_allocate_array(allocator, char, new_length + 1);
+  munit_assert_not_null(new_source);
+  memcpy(new_source, source, edit.offset);
+  memcpy(new_source + edit.offset, edit.inserted.data, edit.inserted.length);
+  strcpy(new_source + edit.offset + edit.inserted.length,
+         source + edit.offset + edit.removed_length);
+  return new_source;
+}
+
+// Settles one function of `actual` and checks it against the same function
+// of `expected`, wherever their nodes are.
+static void assert_function_equal(smith_module_t *actual, size_t index,
+                                  const smith_module_t *expected) {
+  smith_module_settle_function(actual, index);
+  smith_function_t function = actual->functions[index];
+  smith_function_t expected_function = expected->functions[index];
+  munit_assert_uint32(function.body - function.parameters, ==,
+                      expected_function.body - expected_function.parameters);
+  munit_assert_uint32(function.parameter_count, ==,
+                      expected_function.parameter_count);
+  const smith_ast_t *ast = &actual->ast;
+  const smith_ast_t *expected_ast = &expected->ast;
+  for (uint32_t i = 0; i <= function.body - function.parameters; i++) {
+    smith_ast_node_t node = function.parameters + i;
+    smith_ast_node_t expected_node = expected_function.parameters + i;
+    munit_assert_int(ast->kinds[node], ==, expected_ast->kinds[expected_node]);
+    smith_assert_span_equal(ast->spans[node],
+                            expected_ast->spans[expected_node]);
+    switch (ast->kinds[node]) {
+    case SMITH_EXPRESSION_KIND_BINARY_OPERATOR:
+      munit_assert_uint32(ast->children[node].left - function.parameters, ==,
+                          expected_ast->children[expected_node].left -
+                              expected_function.parameters);
+      munit_assert_uint32(ast->children[node].right - function.parameters, ==,
+                          expected_ast->children[expected_node].right -
+                              expected_function.parameters);
+      break;
+    case SMITH_EXPRESSION_KIND_CONSTANT:
+      smith_assert_constant_equal(
+          ast->payloads[node].constant,
+          expected_ast->payloads[expected_node].constant);
+      break;
+    default:
+      smith_assert_ast_leaf_equal(ast->payloads[node].leaf,
+                                  expected_ast->payloads[expected_node].leaf);
+      break;
+    }
+  }
+}
+
+// Reparses after the edit and releases the old source text.
+static smith_reparse_result_t reparse(smith_parser_context_t context,
+                                      smith_module_t *module,
+                                      smith_token_buffer_t *buffer,
+                                      char **source, smith_edit_t edit) {
+  char *new_source = apply_edit(context.allocator, *source, edit);
+  smith_reparse_result_t reparse_result =
+      smith_reparse(context, module, buffer, new_source, edit);
+  munit_assert_true(reparse_result.success);
+  smith_allocator_deallocate(context.allocator, *source);
+  *source = new_source;
+  return reparse_result;
+}
+
+// Checks that the module matches one parsed from scratch. The functions are
+// up to date as they are; their nodes once settled. Only the reparsed
+// functions and one other are settled, so most shifts pile up over several
+// edits before they are checked, and now and then the whole module is.
+static void check(smith_parser_context_t context, smith_module_t *module,
+                  char *source, smith_reparse_result_t reparse_result) {
+  smith_token_buffer_t expected_buffer = tokenize(context.allocator, source);
+  smith_parse_module_result_t parse_result =
+      smith_parse_module(context, &expected_buffer);
+  munit_assert(parse_result.success);
+  smith_module_t expected = parse_result.module;
+  munit_assert_size(module->count, ==, expected.count);
+  for (size_t i = 0; i < module->count; i++) {
+    smith_function_t function = module->functions[i];
+    smith_function_t expected_function = expected.functions[i];
+    smith_assert_span_equal(function.span, expected_function.span);
+    munit_assert_size(function.offsets.start, ==,
+                      expected_function.offsets.start);
+    munit_assert_size(function.offsets.end, ==, expected_function.offsets.end);
+    smith_assert_ast_leaf_equal(function.name, expected_function.name);
+    smith_assert_span_equal(function.name_span, expected_function.name_span);
+  }
+  for (size_t i = 0; i < reparse_result.reparsed; i++) {
+    assert_function_equal(module, reparse_result.first + i, &expected);
+  }
+  if (module->count > 0) {
+    assert_function_equal(
+        module, munit_rand_int_range(0, (int)module->count - 1), &expected);
+  }
+  if (munit_rand_int_range(0, 3) == 0) {
+    munit_assert_true(smith_module_settle(module));
+    smith_assert_module_equal(module, &expected);
+  }
+  smith_module_destroy(expected);
+  smith_token_buffer_destroy(expected_buffer);
+}
+
+static smith_reparse_result_t
+reparse_and_check(smith_parser_context_t context, smith_module_t *module,
+                  smith_token_buffer_t *buffer, char **source,
+                  smith_edit_t edit) {
+  smith_reparse_result_t reparse_result =
+      reparse(context, module, buffer, source, edit);
+  check(context, module, *source, reparse_result);
+  return reparse_result;
+}
+
+static MunitResult test_smith_reparse(const MunitParameter params[],
+                                      void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = interner_create(allocator)};
+  char *source = copy(allocator, "fn a() { 1 }\n"
+                                 "fn b(x) { x + 2 }\n"
+                                 "fn c() { 3 * c }\n");
+  smith_token_buffer_t buffer = tokenize(allocator, source);
+  smith_module_t module = smith_parse_module(context, &buffer).module;
+  // Only the edited function is parsed again.
+  smith_reparse_result_t reparse_result = reparse_and_check(
+      context, &module, &buffer, &source,
+      (smith_edit_t){.offset = 27,
+                     .removed_length = 1,
+                     .inserted = {.data = "20", .length = 2}});
+  munit_assert_size(reparse_result.first, ==, 1);
+  munit_assert_size(reparse_result.reparsed, ==, 1);
+  munit_assert_size(module.functions[2].offsets.start, ==, 32);
+  // A new line moves every later position.
+  smith_module_settle_function(&module, 2);
+  reparse_result = reparse(context, &module, &buffer, &source,
+                           (smith_edit_t){.offset = 22,
+                                          .removed_length = 1,
+                                          .inserted = {.data = "\n  ",
+                                                       .length = 3}});
+  munit_assert_size(reparse_result.reparsed, ==, 1);
+  munit_assert_uint32(module.functions[2].span.start.line, ==, 3);
+  // The nodes after the edit are not touched, only told how they moved.
+  smith_ast_node_t node = module.functions[2].body;
+  munit_assert_int64(module.functions[2].shift.line_delta, ==, 1);
+  munit_assert_uint32(module.ast.spans[node].start.line, ==, 2);
+  smith_module_settle_function(&module, 2);
+  munit_assert_uint32(module.ast.spans[node].start.line, ==, 3);
+  check(context, &module, source, reparse_result);
+  // A function inserted between two others is the only one parsed.
+  char *inserted = "fn d(y) { y }\n";
+  reparse_result = reparse_and_check(
+      context, &module, &buffer, &source,
+      (smith_edit_t){.offset = 13,
+                     .removed_length = 0,
+                     .inserted = {.data = inserted, .length = strlen(inserted)}});
+  munit_assert_size(module.count, ==, 4);
+  munit_assert_size(reparse_result.reparsed, <=, 2);
+  munit_assert_true(smith_module_settle(&module));
+  munit_assert_uint32(module.garbage, ==, 0);
+  smith_module_destroy(module);
+  smith_token_buffer_destroy(buffer);
+  smith_allocator_deallocate(allocator, source);
+  smith_interner_destroy(context.interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Writes `count` functions whose bodies are sums and products of parameters
+// and literals, each function starting on a new line.
+static char *random_module(smith_allocator_t allocator, size_t count) {
+  size_t capacity = count * 256 + 1;
+  char *source = smith_allocator_allocate_array(allocator, char, capacity);
+  munit_assert_not_null(source);
+  source[0] = '\0';
+  size_t length = 0;
+  for (size_t i = 0; i < count; i++) {
+    length += snprintf(source + length, capacity - length,
+                       "fn f%zu(p, q) {\n  p", i);
+    int terms = munit_rand_int_range(0, 8);
+    for (int t = 0; t < terms; t++) {
+      const char *op = munit_rand_int_range(0, 1) ? "+" : "*";
+      if (munit_rand_int_range(0, 1)) {
+        length += snprintf(source + length, capacity - length, " %s %d", op,
+                           munit_rand_int_range(1, 99));
+      } else {
+        length += snprintf(source + length, capacity - length, " %s q", op);
+      }
+    }
+    length += snprintf(source + length, capacity - length, "\n}\n");
+  }
+  return source;
+}
+
+// Picks a random occurrence of `pattern` in `source`, or returns -1.
+static long random_occurrence(const char *source, const char *pattern) {
+  long count = 0;
+  for (const char *at = strstr(source, pattern); at != nullptr;
+       at = strstr(at + 1, pattern)) {
+    count++;
+  }
+  if (count == 0) {
+    return -1;
+  }
+  long chosen = munit_rand_int_range(0, count - 1);
+  const char *at = strstr(source, pattern);
+  for (long i = 0; i < chosen; i++) {
+    at = strstr(at + 1, pattern);
+  }
+  return at - source;
+}
+
+// Makes a random edit that leaves the source text well formed.
+static smith_edit_t random_edit(const char *source) {
+  static char digits[] = "123456789";
+  while (true) {
+    long at;
+    switch (munit_rand_int_range(0, 5)) {
+    case 0:
+      // Changes a digit of a literal.
+      at = random_occurrence(source, " 1");
+      if (at >= 0) {
+        return (smith_edit_t){
+            .offset = at + 1,
+            .removed_length = 1,
+            .inserted = {.data = digits + munit_rand_int_range(0, 8),
+                         .length = 1}};
+      }
+      break;
+    case 1:
+      // Swaps an operator.
+      at = random_occurrence(source, " + ");
+      if (at >= 0) {
+        return (smith_edit_t){.offset = at + 1,
+                              .removed_length = 1,
+                              .inserted = {.data = "*", .length = 1}};
+      }
+      break;
+    case 2:
+      // Adds a term at the start of a body.
+      at = random_occurrence(source, "{\n  ");
+      if (at >= 0) {
+        return (smith_edit_t){.offset = at + 4,
+                              .inserted = {.data = "q * 7 + ", .length = 8}};
+      }
+      break;
+    case 3:
+      // Inserts a function before another or at the end.
+      at = random_occurrence(source, "fn ");
+      return (smith_edit_t){
+          .offset = at >= 0 && munit_rand_int_range(0, 3) ? at : strlen(source),
+          .inserted = {.data = "fn g(q) {\n  q / 2\n}\n", .length = 19}};
+    case 4: {
+      // Removes a whole function.
+      at = random_occurrence(source, "fn ");
+      if (at >= 0) {
+        const char *next = strstr(source + at + 1, "fn ");
+        size_t end = next != nullptr ? next - source : strlen(source);
+        return (smith_edit_t){.offset = at,
+                              .removed_length = end - at,
+                              .inserted = {.data = ""}};
+      }
+      break;
+    }
+    default:
+      // Splits an operand from its operator with a new line.
+      at = random_occurrence(source, " q");
+      if (at >= 0) {
+        return (smith_edit_t){.offset = at,
+                              .inserted = {.data = "\n   ", .length = 4}};
+      }
+      break;
+    }
+  }
+}
+
+static MunitResult test_smith_reparse_random_edits(const MunitParameter params[],
+                                                   void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  for (int round = 0; round < 40; round++) {
+    smith_parser_context_t context = {.allocator = allocator,
+                                      .interner = interner_create(allocator),
+                                      .fold_constants = round % 2 == 1};
+    char *source = random_module(allocator, munit_rand_int_range(0, 12));
+    smith_token_buffer_t buffer = tokenize(allocator, source);
+    smith_module_t module = smith_parse_module(context, &buffer).module;
+    for (int edit = 0; edit < 12; edit++) {
+      smith_reparse_result_t reparse_result = reparse_and_check(
+          context, &module, &buffer, &source, random_edit(source));
+      // An edit inside one function may also touch the end of the one before.
+      munit_assert_size(reparse_result.reparsed, <=, 2);
+    }
+    smith_module_destroy(module);
+    smith_token_buffer_destroy(buffer);
+    smith_allocator_deallocate(allocator, source);
+    smith_interner_destroy(context.interner);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_incremental_parser_tests[] = {
+    {
+        .name = "/test_smith_reparse",
+        .test = test_smith_reparse,
+    },
+    {
+        .name = "/test_smith_reparse_random_edits",
+        .test = test_smith_reparse_random_edits,
+    },
+    {}};
+
+MunitSuite smith_incremental_parser_suite = {
+    .prefix = "/incremental_parser",
+    .tests = smith_incremental_parser_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,223 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/assertions.h"
+#include "smith/copying_interner.h"
+#include "smith/hash_interner.h"
+#include "smith/incremental_tokenizer.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <string.h>
+
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  smith_copying_interner_create_result_t copying_interner_create_result =
+      smith_copying_interner_create(allocator, interner_create_result.interner);
+  munit_assert(copying_interner_create_result.success);
+  return copying_interner_create_result.interner;
+}
+
+static smith_token_buffer_t tokenize(smith_allocator_t allocator,
+                                     smith_interner_t interner, char *source) {
+  smith_tokenize_result_t tokenize_result =
+      smith_tokenize(allocator, interner, source);
+  munit_assert(tokenize_result.success);
+  return tokenize_result.buffer;
+}
+
+static void assert_token_buffer_equal(smith_token_buffer_t actual,
+                                      smith_token_buffer_t expected) {
+  munit_assert_int(actual.count, ==, expected.count);
+  for (size_t i = 0; i < actual.count; i++) {
+    smith_assert_token_equal(smith_token_buffer_get(&actual, i),
+                             smith_token_buffer_get(&expected, i));
+    smith_offsets_t actual_offsets = smith_token_buffer_offsets(&actual, i);
+    smith_offsets_t expected_offsets = smith_token_buffer_offsets(&expected, i);
+    munit_assert_int(actual_offsets.start, ==, expected_offsets.start);
+    munit_assert_int(actual_offsets.end, ==, expected_offsets.end);
+  }
+}
+
+// Applies the edit to `source`, returning a newly allocated string.
+static char *apply_edit(smith_allocator_t allocator, const char *source,
+                        smith_edit_t edit) {
+  size_t length = strlen(source);
+  size_t new_length = length - edit.removed_length + edit.inserted.length;
+  char *new_source =
+      smith_allocator_allocate_array(allocator, char, new_length + 1);
+  munit_assert_not_null(new_source);
+  memcpy(new_source, source, edit.offset);
+  memcpy(new_source + edit.offset, edit.inserted.data, edit.inserted.length);
+  strcpy(new_source + edit.offset + edit.inserted.length,
+         source + edit.offset + edit.removed_length);
+  return new_source;
+}
+
+static MunitResult test_smith_tokenize_buffer(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "fn f  (x)\n  x+=1";
+  smith_token_buffer_t buffer = tokenize(allocator, interner, source);
+  smith_offsets_t expected[] = {{0, 2},   {3, 4},   {6, 7},   {7, 8},
+                                {8, 9},   {12, 13}, {13, 15}, {15, 16},
+                                {16, 16}};
+  munit_assert_int(buffer.count, ==, sizeof(expected) / sizeof(expected[0]));
+  smith_cursor_t cursor = {.source = source};
+  for (size_t i = 0; i < buffer.count; i++) {
+    smith_next_token_result_t result = smith_next_token(interner, cursor);
+    smith_assert_token_equal(buffer.tokens[i], result.token);
+    munit_assert_int(buffer.offsets[i].start, ==, expected[i].start);
+    munit_assert_int(buffer.offsets[i].end, ==, expected[i].end);
+    cursor = result.cursor;
+  }
+  munit_assert_int(buffer.tokens[buffer.count - 1].kind, ==,
+                   SMITH_TOKEN_KIND_END_OF_FILE);
+  smith_token_buffer_destroy(buffer);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_token_buffer_peek(const MunitParameter params[],
+                                                void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  smith_token_buffer_t buffer = tokenize(allocator, interner, "a + b");
+  munit_assert_size(buffer.count, ==, 4);
+  for (size_t index = 0; index < buffer.count; index++) {
+    for (size_t lookahead = 0; lookahead < 6; lookahead++) {
+      size_t expected = index + lookahead < buffer.count ? index + lookahead
+                                                         : buffer.count - 1;
+      smith_assert_token_equal(
+          smith_token_buffer_peek(&buffer, index, lookahead),
+          smith_token_buffer_get(&buffer, expected));
+    }
+  }
+  smith_assert_token_equal(smith_token_buffer_peek(&buffer, 1, SIZE_MAX),
+                           smith_token_buffer_get(&buffer, 3));
+  smith_token_buffer_destroy(buffer);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_relex_matches_tokenize(const MunitParameter params[],
+                                  void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  smith_string_t insertions[] = {
+      {"", 0},  {"a", 1},  {" ", 1},     {"\n", 1},  {"+", 1},   {"=", 1},
+      {"&", 1}, {"12", 2}, {".5", 2},    {"fn", 2},  {"x y", 3}, {"(\n", 2},
+      {";", 1}, {"\n\n", 2}, {"b=c", 3}, {"  ", 2},
+  };
+  size_t insertion_count = sizeof(insertions) / sizeof(insertions[0]);
+  smith_string_t source = smith_random_source(allocator, 100);
+  char *text = source.data;
+  smith_token_buffer_t buffer = tokenize(allocator, interner, text);
+  for (size_t i = 0; i < 200; i++) {
+    size_t length = strlen(text);
+    size_t offset = munit_rand_int_range(0, length);
+    size_t removable = length - offset < 4 ? length - offset : 4;
+    smith_edit_t edit = {
+        .offset = offset,
+        .removed_length = munit_rand_int_range(0, removable),
+        .inserted = insertions[munit_rand_int_range(0, insertion_count - 1)],
+    };
+    char *new_text = apply_edit(allocator, text, edit);
+    smith_relex_result_t relex_result =
+        smith_relex(interner, &buffer, new_text, edit);
+    munit_assert(relex_result.success);
+    smith_token_buffer_t expected = tokenize(allocator, interner, new_text);
+    assert_token_buffer_equal(buffer, expected);
+    smith_token_buffer_destroy(expected);
+    smith_allocator_deallocate(allocator, text);
+    text = new_text;
+  }
+  smith_token_buffer_destroy(buffer);
+  smith_allocator_deallocate(allocator, text);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_relex_is_proportional_to_edit(const MunitParameter params[],
+                                         void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  size_t lines = 10000;
+  char *text = smith_allocator_allocate_array(allocator, char, lines * 10 + 1);
+  munit_assert_not_null(text);
+  for (size_t i = 0; i < lines; i++) {
+    memcpy(text + i * 10, "a = b + c\n", 10);
+  }
+  text[lines * 10] = '\0';
+  smith_token_buffer_t buffer = tokenize(allocator, interner, text);
+  smith_edit_t edit = {.offset = 5000 * 10 + 4,
+                       .removed_length = 1,
+                       .inserted = {"\nbb", 3}};
+  char *new_text = apply_edit(allocator, text, edit);
+  smith_relex_result_t relex_result =
+      smith_relex(interner, &buffer, new_text, edit);
+  munit_assert(relex_result.success);
+  munit_assert_int(relex_result.relexed, <=, 3);
+  smith_token_buffer_t expected = tokenize(allocator, interner, new_text);
+  assert_token_buffer_equal(buffer, expected);
+  smith_token_buffer_destroy(expected);
+  // A second edit nearby moves the gap past a few tokens and leaves the
+  // tokens after it as they are stored, though they move by a line.
+  size_t last = buffer.capacity - 1;
+  smith_token_t stored = buffer.tokens[last];
+  smith_offsets_t stored_offsets = buffer.offsets[last];
+  size_t capacity = buffer.capacity;
+  smith_edit_t next_edit = {.offset = 5010 * 10,
+                            .removed_length = 0,
+                            .inserted = {"d\n", 2}};
+  char *next_text = apply_edit(allocator, new_text, next_edit);
+  relex_result = smith_relex(interner, &buffer, next_text, next_edit);
+  munit_assert(relex_result.success);
+  munit_assert_size(buffer.capacity, ==, capacity);
+  munit_assert_size(buffer.gap, ==, relex_result.first + relex_result.relexed);
+  munit_assert(memcmp(&buffer.tokens[last], &stored, sizeof(stored)) == 0);
+  munit_assert(memcmp(&buffer.offsets[last], &stored_offsets,
+                      sizeof(stored_offsets)) == 0);
+  expected = tokenize(allocator, interner, next_text);
+  assert_token_buffer_equal(buffer, expected);
+  smith_token_buffer_destroy(expected);
+  smith_token_buffer_destroy(buffer);
+  smith_allocator_deallocate(allocator, next_text);
+  smith_allocator_deallocate(allocator, new_text);
+  smith_allocator_deallocate(allocator, text);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_incremental_tokenizer_tests[] = {
+    {
+        .name = "/test_smith_tokenize_buffer",
+        .test = test_smith_tokenize_buffer,
+    },
+    {
+        .name = "/test_smith_token_buffer_peek",
+        .test = test_smith_token_buffer_peek,
+    },
+    {
+        .name = "/test_smith_relex_matches_tokenize",
+        .test = test_smith_relex_matches_tokenize,
+    },
+    {
+        .name = "/test_smith_relex_is_proportional_to_edit",
+        .test = test_smith_relex_is_proportional_to_edit,
+    },
+    {}};
+
+MunitSuite smith_incremental_tokenizer_suite = {
+    .prefix = "/incremental_tokenizer",
+    .tests = smith_incremental_tokenizer_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,187 @@
+#include "smith/bytecode.h"
+#include "smith/infer.h"
+#include "smith/null_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdio.h>
+
+typedef struct {
+  smith_allocator_t allocator;
+  smith_type_table_t table;
+  smith_ast_t ast;
+  smith_typed_parameter_t parameters[3];
+} fixture_t;
+
+static fixture_t fixture_create(uint32_t int_width, uint32_t float_width) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  fixture_t fixture = {.allocator = allocator,
+                       .table = smith_type_table_create(allocator),
+                       .ast = smith_ast_create(allocator)};
+  smith_type_intern_result_t int_result =
+      smith_type_intern_int(&fixture.table, int_width);
+  smith_type_intern_result_t float_result =
+      smith_type_intern_float(&fixture.table, float_width);
+  smith_type_intern_result_t bool_result =
+      smith_type_intern_bool(&fixture.table);
+  munit_assert_true(int_result.success && float_result.success &&
+                    bool_result.success);
+  fixture.parameters[0] = (smith_typed_parameter_t){
+      .name = {.data = "x", .length = 1}, .type = int_result.type};
+  fixture.parameters[1] = (smith_typed_parameter_t){
+      .name = {.data = "y", .length = 1}, .type = float_result.type};
+  fixture.parameters[2] = (smith_typed_parameter_t){
+      .name = {.data = "b", .length = 1}, .type = bool_result.type};
+  return fixture;
+}
+
+static void fixture_destroy(fixture_t fixture) {
+  smith_ast_destroy(fixture.ast);
+  smith_type_table_destroy(fixture.table);
+  smith_allocator_destroy(fixture.allocator);
+}
+
+typedef struct {
+  smith_infer_result_t result;
+  smith_ast_node_t root;
+} inferred_t;
+
+static inferred_t infer(fixture_t *fixture, char *source) {
+  smith_parser_context_t context = {.allocator = fixture->allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_parse_ast_result_t parse_result = smith_parse_ast(
+      context, &fixture->ast, (smith_cursor_t){.source = source});
+  return (inferred_t){
+      .result = smith_infer_types(fixture->allocator, &fixture->table,
+                                  &fixture->ast, parse_result.root,
+                                  fixture->parameters, 3),
+      .root = parse_result.root};
+}
+
+static MunitResult test_smith_infer_types(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  fixture_t fixture = fixture_create(8, 32);
+  smith_type_t i8 = fixture.parameters[0].type;
+  smith_type_t f32 = fixture.parameters[1].type;
+  smith_type_t bool_ = fixture.parameters[2].type;
+  // The literal takes the width of `x`, so every node is an `i8`.
+  inferred_t inferred = infer(&fixture, "a = 1 + x");
+  munit_assert_true(inferred.result.success);
+  smith_ast_node_t first = smith_ast_first(&fixture.ast, inferred.root);
+  for (smith_ast_node_t node = first; node <= inferred.root; node++) {
+    munit_assert_uint32(inferred.result.types[node], ==, i8);
+  }
+  smith_type_info_t function = fixture.table.types[inferred.result.function];
+  munit_assert_int(function.kind, ==, SMITH_TYPE_KIND_FUNCTION);
+  munit_assert_uint32(function.result, ==, i8);
+  smith_type_t parameter_types[] = {i8, f32, bool_};
+  smith_type_intern_result_t function_result =
+      smith_type_intern_function(&fixture.table, parameter_types, 3, i8);
+  munit_assert_uint32(function_result.type, ==, inferred.result.function);
+  smith_allocator_deallocate(fixture.allocator, inferred.result.types);
+  // Nodes of an earlier expression in the same AST are not typed.
+  smith_ast_node_t previous_root = inferred.root;
+  inferred = infer(&fixture, "y < 2.5 == b");
+  munit_assert_true(inferred.result.success);
+  munit_assert_uint32(inferred.result.types[previous_root], ==,
+                      SMITH_TYPE_NONE);
+  first = smith_ast_first(&fixture.ast, inferred.root);
+  smith_type_t expected[] = {f32, f32, bool_, bool_, bool_};
+  for (smith_ast_node_t node = first; node <= inferred.root; node++) {
+    munit_assert_uint32(inferred.result.types[node], ==,
+                        expected[node - first]);
+  }
+  smith_allocator_deallocate(fixture.allocator, inferred.result.types);
+  // Too large for an `i8`, so the literal is an `i64`.
+  inferred = infer(&fixture, "x + 300");
+  munit_assert_false(inferred.result.success);
+  munit_assert_uint32(inferred.result.error, ==, inferred.root);
+  fixture_destroy(fixture);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_infer_errors(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  fixture_t fixture = fixture_create(64, 64);
+  struct {
+    char *source;
+    // The kind of the node reported.
+    smith_expression_kind_t kind;
+  } cases[] = {
+      {"z + x", SMITH_EXPRESSION_KIND_SYMBOL},
+      {"a = a", SMITH_EXPRESSION_KIND_SYMBOL},
+      {"x + 99999999999999999999", SMITH_EXPRESSION_KIND_INT},
+      {"x + y", SMITH_EXPRESSION_KIND_BINARY_OPERATOR},
+      {"y & y", SMITH_EXPRESSION_KIND_BINARY_OPERATOR},
+      {"1 = x", SMITH_EXPRESSION_KIND_BINARY_OPERATOR},
+      {"x = y", SMITH_EXPRESSION_KIND_BINARY_OPERATOR},
+      {"b += b", SMITH_EXPRESSION_KIND_BINARY_OPERATOR},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    inferred_t inferred = infer(&fixture, cases[i].source);
+    munit_assert_false(inferred.result.success);
+    munit_assert_null(inferred.result.types);
+    munit_assert_int(fixture.ast.kinds[inferred.result.error], ==,
+                     cases[i].kind);
+  }
+  fixture_destroy(fixture);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_infer_matches_compiler(const MunitParameter params[],
+                                  void *user_data_or_fixture) {
+  fixture_t fixture = fixture_create(64, 64);
+  smith_parser_context_t context = {.allocator = fixture.allocator,
+                                    .interner = smith_null_interner_create()};
+  static const smith_type_kind_t kinds[] = {
+      [SMITH_CONSTANT_KIND_INT] = SMITH_TYPE_KIND_INT,
+      [SMITH_CONSTANT_KIND_FLOAT] = SMITH_TYPE_KIND_FLOAT,
+      [SMITH_CONSTANT_KIND_BOOL] = SMITH_TYPE_KIND_BOOL,
+  };
+  char source[512];
+  for (int round = 0; round < 500; round++) {
+    smith_random_expression(source, sizeof(source));
+    smith_parse_result_t parse_result =
+        smith_parse_expression(context, (smith_cursor_t){.source = source});
+    smith_bytecode_compile_result_t compile_result =
+        smith_bytecode_compile(fixture.allocator, &parse_result.expression,
+                               smith_random_parameters, 3);
+    smith_expression_destroy(fixture.allocator, parse_result.expression);
+    inferred_t inferred = infer(&fixture, source);
+    munit_assert(inferred.result.success == compile_result.success);
+    if (!compile_result.success) {
+      continue;
+    }
+    smith_type_t type = inferred.result.types[inferred.root];
+    munit_assert_int(fixture.table.types[type].kind, ==,
+                     kinds[compile_result.bytecode.result_kind]);
+    smith_allocator_deallocate(fixture.allocator, inferred.result.types);
+    smith_bytecode_destroy(compile_result.bytecode);
+  }
+  // Only the parameter types, bool and the function types were added.
+  munit_assert_uint32(fixture.table.count, <=, 6);
+  fixture_destroy(fixture);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_infer_tests[] = {
+    {
+        .name = "/test_smith_infer_types",
+        .test = test_smith_infer_types,
+    },
+    {
+        .name = "/test_smith_infer_errors",
+        .test = test_smith_infer_errors,
+    },
+    {
+        .name = "/test_smith_infer_matches_compiler",
+        .test = test_smith_infer_matches_compiler,
+    },
+    {}};
+
+MunitSuite smith_infer_suite = {
+    .prefix = "/infer",
+    .tests = smith_infer_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,177 @@
+#include "smith/ir.h"
+#include "smith/null_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/vm.h"
+#include <stdio.h>
+#include <string.h>
+
+static smith_ir_build_result_t build(smith_allocator_t allocator,
+                                     char *source) {
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t parse_result =
+      smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+  smith_ir_build_result_t build_result = smith_ir_build(
+      allocator, &ast, parse_result.root, smith_random_parameters, 3);
+  smith_ast_destroy(ast);
+  return build_result;
+}
+
+// The number of instructions with an opcode, or of all instructions.
+static size_t count(const smith_ir_function_t *function,
+                    smith_ir_opcode_t opcode, bool all) {
+  size_t total = 0;
+  for (const smith_ir_instruction_t *instruction = function->blocks[0].first;
+       instruction != nullptr; instruction = instruction->next) {
+    total += all || instruction->opcode == opcode;
+  }
+  return total;
+}
+
+static MunitResult test_smith_ir_build(const MunitParameter params[],
+                                       void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_ir_build_result_t build_result = build(allocator, "a = x * 2 + a");
+  // `a` is read before it has a value.
+  munit_assert_false(build_result.success);
+  build_result = build(allocator, "a = x * 2 + x");
+  munit_assert_true(build_result.success);
+  smith_ir_function_t function = build_result.function;
+  munit_assert_uint32(function.block_count, ==, 1);
+  // Three parameters, the constant, the multiply, the add and the return.
+  munit_assert_size(count(&function, 0, true), ==, 7);
+  smith_ir_instruction_t *last = function.blocks[0].last;
+  munit_assert_int(last->opcode, ==, SMITH_IR_OPCODE_RETURN);
+  munit_assert_int(last->type, ==, SMITH_CONSTANT_KIND_INT);
+  smith_ir_instruction_t *add = last->operands[0];
+  munit_assert_int(add->opcode, ==, SMITH_IR_OPCODE_ADD);
+  munit_assert_int(add->operands[0]->opcode, ==, SMITH_IR_OPCODE_MUL);
+  munit_assert_int(add->operands[1]->opcode, ==, SMITH_IR_OPCODE_PARAMETER);
+  munit_assert_ptr_equal(add->operands[0]->operands[0], add->operands[1]);
+  smith_ir_function_destroy(function);
+  char *invalid[] = {"x + y", "y & y", "x && x", "y < b", "1 = x",
+                     "x += y", "c += 1", "x = y", "z"};
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    munit_assert_false(build(allocator, invalid[i]).success);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_ir_optimize(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_ir_pass_timings_t timings = {};
+  struct {
+    char *source;
+    size_t instructions;
+  } cases[] = {
+      // The constant and the product are shared, and the unread `y` and `b`
+      // removed.
+      {"x * 2 + 2 * x", 5},
+      // Folds to a single constant.
+      {"1 + 2 * 3 - 7 / 7", 2},
+      // The product is computed once.
+      {"y * y - y * y", 4},
+      // Division by zero is left to trap.
+      {"x / 0", 4},
+      // Folds to `true && b`.
+      {"3 | 5 == 7 && b", 4},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    smith_ir_build_result_t build_result = build(allocator, cases[i].source);
+    munit_assert_true(build_result.success);
+    munit_assert_true(smith_ir_optimize(&build_result.function, &timings));
+    munit_assert_size(count(&build_result.function, 0, true), ==,
+                      cases[i].instructions);
+    smith_ir_function_destroy(build_result.function);
+  }
+  munit_assert_uint64(timings.constant_propagation, >, 0);
+  munit_assert_uint64(timings.common_subexpression_elimination, >, 0);
+  munit_assert_uint64(timings.dead_code_elimination, >, 0);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_ir_matches_compiler(const MunitParameter params[],
+                               void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  char source[512];
+  for (int round = 0; round < 500; round++) {
+    smith_random_expression(source, sizeof(source));
+    smith_parse_result_t parse_result =
+        smith_parse_expression(context, (smith_cursor_t){.source = source});
+    smith_bytecode_compile_result_t expected = smith_bytecode_compile(
+        allocator, &parse_result.expression, smith_random_parameters, 3);
+    smith_expression_destroy(allocator, parse_result.expression);
+    smith_ir_build_result_t build_result = build(allocator, source);
+    munit_assert(build_result.success == expected.success);
+    if (!expected.success) {
+      continue;
+    }
+    munit_assert_true(smith_ir_optimize(&build_result.function, nullptr));
+    smith_bytecode_compile_result_t actual =
+        smith_ir_to_bytecode(allocator, &build_result.function);
+    smith_ir_function_destroy(build_result.function);
+    munit_assert_true(actual.success);
+    munit_assert_int(actual.bytecode.result_kind, ==,
+                     expected.bytecode.result_kind);
+    for (int row = 0; row < 20; row++) {
+      smith_constant_value_t arguments[] = {
+          {.int_ = munit_rand_int_range(-3, 3)},
+          {.float_ = munit_rand_int_range(-3, 3) * 0.5},
+          {.bool_ = munit_rand_int_range(0, 1)}};
+      smith_vm_run_result_t want =
+          smith_vm_run(allocator, &expected.bytecode, arguments);
+      smith_vm_run_result_t got =
+          smith_vm_run(allocator, &actual.bytecode, arguments);
+      munit_assert(got.success == want.success);
+      if (!want.success) {
+        continue;
+      }
+      switch (expected.bytecode.result_kind) {
+      case SMITH_CONSTANT_KIND_INT:
+        munit_assert_int64(got.value.int_, ==, want.value.int_);
+        break;
+      case SMITH_CONSTANT_KIND_FLOAT:
+        munit_assert_memory_equal(sizeof(double), &got.value.float_,
+                                  &want.value.float_);
+        break;
+      case SMITH_CONSTANT_KIND_BOOL:
+        munit_assert(got.value.bool_ == want.value.bool_);
+        break;
+      }
+    }
+    smith_bytecode_destroy(actual.bytecode);
+    smith_bytecode_destroy(expected.bytecode);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_ir_tests[] = {
+    {
+        .name = "/test_smith_ir_build",
+        .test = test_smith_ir_build,
+    },
+    {
+        .name = "/test_smith_ir_optimize",
+        .test = test_smith_ir_optimize,
+    },
+    {
+        .name = "/test_smith_ir_matches_compiler",
+        .test = test_smith_ir_matches_compiler,
+    },
+    {}};
+
+MunitSuite smith_ir_suite = {
+    .prefix = "/ir",
+    .tests = smith_ir_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,240 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/jit.h"
+#include "smith/null_interner.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdio.h>
+#include <string.h>
+
+static smith_jit_compile_result_t
+compile(smith_allocator_t allocator, char *source,
+        const smith_bytecode_parameter_t *parameters,
+        uint32_t parameter_count) {
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_parse_result_t parse_result =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  smith_jit_compile_result_t compile_result = smith_jit_compile(
+      allocator, &parse_result.expression, parameters, parameter_count);
+  smith_expression_destroy(allocator, parse_result.expression);
+  return compile_result;
+}
+
+static void assert_same_value(smith_constant_kind_t kind,
+                              smith_constant_value_t actual,
+                              smith_constant_value_t expected) {
+  switch (kind) {
+  case SMITH_CONSTANT_KIND_INT:
+    munit_assert_int64(actual.int_, ==, expected.int_);
+    break;
+  case SMITH_CONSTANT_KIND_FLOAT:
+    munit_assert_memory_equal(sizeof(double), &actual.float_,
+                              &expected.float_);
+    break;
+  case SMITH_CONSTANT_KIND_BOOL:
+    munit_assert(actual.bool_ == expected.bool_);
+    break;
+  }
+}
+
+// Runs the program natively and on the interpreter, which must agree on the
+// value or on trapping.
+static smith_vm_run_result_t
+run_both(smith_allocator_t allocator, const smith_jit_t *jit,
+         const smith_constant_value_t *arguments) {
+  smith_vm_run_result_t expected =
+      smith_vm_run(allocator, &jit->bytecode, arguments);
+  smith_vm_run_result_t actual = smith_jit_run(jit, arguments);
+  munit_assert(actual.success == expected.success);
+  if (expected.success) {
+    assert_same_value(jit->bytecode.result_kind, actual.value, expected.value);
+  }
+  return actual;
+}
+
+static MunitResult test_smith_jit_run(const MunitParameter params[],
+                                      void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_constant_value_t arguments[] = {
+      {.int_ = 6}, {.float_ = 2.5}, {.bool_ = true}};
+  struct {
+    char *source;
+    smith_constant_kind_t kind;
+    smith_constant_value_t value;
+  } cases[] = {
+      {"x * x - 1", SMITH_CONSTANT_KIND_INT, {.int_ = 35}},
+      {"x / 4 - 7 / 2", SMITH_CONSTANT_KIND_INT, {.int_ = -2}},
+      {"x & 3 | 8", SMITH_CONSTANT_KIND_INT, {.int_ = 10}},
+      {"y * 2.0 - 0.5", SMITH_CONSTANT_KIND_FLOAT, {.float_ = 4.5}},
+      {"y >= 2.5 == b", SMITH_CONSTANT_KIND_BOOL, {.bool_ = true}},
+      {"x <= 6 == b", SMITH_CONSTANT_KIND_BOOL, {.bool_ = true}},
+      {"b && b != b", SMITH_CONSTANT_KIND_BOOL, {.bool_ = false}},
+      {"a = x += 4", SMITH_CONSTANT_KIND_INT, {.int_ = 10}},
+      {"y /= 2.0", SMITH_CONSTANT_KIND_FLOAT, {.float_ = 1.25}},
+      {"y", SMITH_CONSTANT_KIND_FLOAT, {.float_ = 2.5}},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    smith_jit_compile_result_t compile_result =
+        compile(allocator, cases[i].source, smith_random_parameters, 3);
+    munit_assert_true(compile_result.success);
+#if defined(__x86_64__) && defined(__unix__)
+    munit_assert_not_null(compile_result.jit.function);
+#endif
+    munit_assert_int(compile_result.jit.bytecode.result_kind, ==,
+                     cases[i].kind);
+    smith_vm_run_result_t run_result =
+        run_both(allocator, &compile_result.jit, arguments);
+    munit_assert_true(run_result.success);
+    assert_same_value(cases[i].kind, run_result.value, cases[i].value);
+    smith_jit_destroy(compile_result.jit);
+  }
+  // NaN compares unequal to everything, itself included.
+  arguments[1].float_ = 0.0 / 0.0;
+  char *comparisons[] = {"y == y", "y != y", "y < 1.0", "y <= 1.0",
+                         "y > 1.0", "y >= 1.0"};
+  for (size_t i = 0; i < sizeof(comparisons) / sizeof(comparisons[0]); i++) {
+    smith_jit_compile_result_t compile_result =
+        compile(allocator, comparisons[i], smith_random_parameters, 3);
+    munit_assert_true(compile_result.success);
+    smith_vm_run_result_t run_result =
+        run_both(allocator, &compile_result.jit, arguments);
+    munit_assert(run_result.value.bool_ == (i == 1));
+    smith_jit_destroy(compile_result.jit);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_jit_traps(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_constant_value_t arguments[] = {
+      {.int_ = 0}, {.float_ = 0}, {.bool_ = false}};
+  char *trapping[] = {"1 / x", "9223372036854775807 + 1 + x",
+                      "0 - 9223372036854775807 - 2 + x",
+                      "a = 4611686018427387904 * 2 + x"};
+  for (size_t i = 0; i < sizeof(trapping) / sizeof(trapping[0]); i++) {
+    smith_jit_compile_result_t compile_result =
+        compile(allocator, trapping[i], smith_random_parameters, 3);
+    munit_assert_true(compile_result.success);
+    smith_vm_run_result_t run_result =
+        run_both(allocator, &compile_result.jit, arguments);
+    munit_assert_false(run_result.success);
+    smith_jit_destroy(compile_result.jit);
+  }
+  // The smallest int divided by -1 overflows.
+  smith_jit_compile_result_t compile_result =
+      compile(allocator, "x / y", (smith_bytecode_parameter_t[]){
+                                      {.name = {.data = "x", .length = 1},
+                                       .kind = SMITH_CONSTANT_KIND_INT},
+                                      {.name = {.data = "y", .length = 1},
+                                       .kind = SMITH_CONSTANT_KIND_INT}},
+              2);
+  munit_assert_true(compile_result.success);
+  smith_constant_value_t operands[] = {{.int_ = INT64_MIN}, {.int_ = -1}};
+  munit_assert_false(run_both(allocator, &compile_result.jit, operands).success);
+  operands[1].int_ = 1;
+  munit_assert_true(run_both(allocator, &compile_result.jit, operands).success);
+  smith_jit_destroy(compile_result.jit);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Sums more parameters than there are machine registers, twice over, so every
+// parameter stays live across the whole first sum and some must be spilled.
+static MunitResult
+test_smith_jit_register_pressure(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  enum { COUNT = 40 };
+  char names[COUNT][4];
+  smith_bytecode_parameter_t pressure_parameters[COUNT];
+  smith_constant_value_t arguments[COUNT];
+  char source[COUNT * 2 * 7 + 1];
+  for (int kind = 0; kind < 2; kind++) {
+    bool floats = kind == 1;
+    size_t length = 0;
+    for (int i = 0; i < COUNT; i++) {
+      snprintf(names[i], sizeof(names[i]), "p%d", i);
+      pressure_parameters[i] = (smith_bytecode_parameter_t){
+          .name = {.data = names[i], .length = strlen(names[i])},
+          .kind = floats ? SMITH_CONSTANT_KIND_FLOAT : SMITH_CONSTANT_KIND_INT};
+      if (floats) {
+        arguments[i].float_ = i + 0.5;
+      } else {
+        arguments[i].int_ = i;
+      }
+    }
+    for (int i = 0; i < COUNT * 2; i++) {
+      length += snprintf(source + length, sizeof(source) - length,
+                         i == 0 ? "%s" : " + %s", names[i % COUNT]);
+    }
+    smith_jit_compile_result_t compile_result =
+        compile(allocator, source, pressure_parameters, COUNT);
+    munit_assert_true(compile_result.success);
+    smith_vm_run_result_t run_result =
+        run_both(allocator, &compile_result.jit, arguments);
+    munit_assert_true(run_result.success);
+    if (floats) {
+      munit_assert_double(run_result.value.float_, ==, 2 * (780 + 20.0));
+    } else {
+      munit_assert_int64(run_result.value.int_, ==, 2 * 780);
+    }
+    smith_jit_destroy(compile_result.jit);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_jit_matches_interpreter(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char source[512];
+  int compiled = 0;
+  for (int round = 0; round < 2000; round++) {
+    smith_random_expression(source, sizeof(source));
+    smith_jit_compile_result_t compile_result =
+        compile(allocator, source, smith_random_parameters, 3);
+    if (!compile_result.success) {
+      continue;
+    }
+    compiled++;
+    smith_constant_value_t arguments[] = {
+        {.int_ = munit_rand_int_range(-3, 3)},
+        {.float_ = munit_rand_int_range(-3, 3) * 0.5},
+        {.bool_ = munit_rand_int_range(0, 1)}};
+    run_both(allocator, &compile_result.jit, arguments);
+    smith_jit_destroy(compile_result.jit);
+  }
+  munit_assert_int(compiled, >, 0);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_jit_tests[] = {
+    {
+        .name = "/test_smith_jit_run",
+        .test = test_smith_jit_run,
+    },
+    {
+        .name = "/test_smith_jit_traps",
+        .test = test_smith_jit_traps,
+    },
+    {
+        .name = "/test_smith_jit_register_pressure",
+        .test = test_smith_jit_register_pressure,
+    },
+    {
+        .name = "/test_smith_jit_matches_interpreter",
+        .test = test_smith_jit_matches_interpreter,
+    },
+    {}};
+
+MunitSuite smith_jit_suite = {
+    .prefix = "/jit",
+    .tests = smith_jit_tests,
+    .iterations = 1,
+};
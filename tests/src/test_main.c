@@ -3,7 +3,33 @@
 
 int32_t main(int argc, char *argv[]) {
   MunitSuite suites[] = {
-      smith_tokenizer_suite, smith_parser_suite, smith_hash_interner_suite, {}};
+      smith_tokenizer_suite,
+      smith_parser_suite,
+      smith_hash_interner_suite,
+      smith_stream_tokenizer_suite,
+      smith_incremental_tokenizer_suite,
+      smith_thread_pool_suite,
+      smith_parallel_tokenizer_suite,
+      smith_dfa_tokenizer_suite,
+      smith_scan_suite,
+      smith_unicode_suite,
+      smith_ast_suite,
+      smith_arena_allocator_suite,
+      smith_parallel_parser_suite,
+      smith_dag_suite,
+      smith_constant_suite,
+      smith_parse_cache_suite,
+      smith_incremental_parser_suite,
+      smith_ast_index_suite,
+      smith_walk_suite,
+      smith_bytecode_suite,
+      smith_jit_suite,
+      smith_column_suite,
+      smith_ir_suite,
+      smith_c_backend_suite,
+      smith_type_suite,
+      smith_infer_suite,
+      {}};
 
   MunitSuite main_suite = {.prefix = "All Tests",
                            .suites = suites,
@@ -0,0 +1,258 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/assertions.h"
+#include "smith/finite_allocator.h"
+#include "smith/hash_interner.h"
+#include "smith/null_interner.h"
+#include "smith/parallel_parser.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdio.h>
+
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  return interner_create_result.interner;
+}
+
+static smith_thread_pool_t thread_pool_create(smith_allocator_t allocator,
+                                              size_t thread_count) {
+  smith_thread_pool_create_result_t thread_pool_create_result =
+      smith_thread_pool_create(allocator, thread_count);
+  munit_assert(thread_pool_create_result.success);
+  return thread_pool_create_result.pool;
+}
+
+// Writes `count` functions with a few parameters each and bodies of random
+// length over their parameters and literals.
+static char *random_module(smith_allocator_t allocator, size_t count) {
+  size_t capacity = count * 512 + 1;
+  char *source = smith_allocator_allocate_array(allocator, char, capacity);
+  munit_assert_not_null(source);
+  source[0] = '\0';
+  const char *operators[] = {"+", "-", "*", "/", "==", "="};
+  size_t length = 0;
+  for (size_t i = 0; i < count; i++) {
+    int parameters = munit_rand_int_range(0, 3);
+    length += snprintf(source + length, capacity - length, "fn f%zu(", i);
+    for (int p = 0; p < parameters; p++) {
+      length += snprintf(source + length, capacity - length, "%sp%d",
+                         p > 0 ? ", " : "", p);
+    }
+    length += snprintf(source + length, capacity - length, ") {\n  x");
+    int terms = munit_rand_int_range(0, 20);
+    for (int t = 0; t < terms; t++) {
+      const char *op = operators[munit_rand_int_range(0, 5)];
+      switch (munit_rand_int_range(0, 2)) {
+      case 0:
+        length += snprintf(source + length, capacity - length, " %s %d", op,
+                           munit_rand_int_range(0, 1000));
+        break;
+      case 1:
+        length += snprintf(source + length, capacity - length, " %s %d.5", op,
+                           munit_rand_int_range(0, 9));
+        break;
+      default:
+        length += snprintf(source + length, capacity - length, " %s p%d", op,
+                           munit_rand_int_range(0, 3));
+        break;
+      }
+    }
+    length += snprintf(source + length, capacity - length, "\n}\n");
+  }
+  return source;
+}
+
+static MunitResult
+test_smith_parse_module_parallel_matches_parse_module(
+    const MunitParameter params[], void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  size_t thread_counts[] = {0, 3};
+  size_t function_counts[] = {0, 1, 5, 200};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]);
+       i++) {
+    smith_thread_pool_t pool = thread_pool_create(allocator, thread_counts[i]);
+    for (size_t j = 0;
+         j < sizeof(function_counts) / sizeof(function_counts[0]); j++) {
+      char *source = random_module(allocator, function_counts[j]);
+      smith_tokenize_result_t tokenize_result =
+          smith_tokenize(allocator, smith_null_interner_create(), source);
+      munit_assert(tokenize_result.success);
+      // Fresh interners so that identifiers are assigned from scratch by both.
+      // Half the modules are parsed with constant folding.
+      bool fold_constants = j % 2 == 1;
+      smith_parser_context_t serial_context = {
+          .allocator = allocator,
+          .interner = interner_create(allocator),
+          .fold_constants = fold_constants};
+      smith_parse_module_result_t serial_result =
+          smith_parse_module(serial_context, &tokenize_result.buffer);
+      munit_assert(serial_result.success);
+      smith_module_t expected = serial_result.module;
+      smith_parser_context_t parallel_context = {
+          .allocator = allocator,
+          .interner = interner_create(allocator),
+          .fold_constants = fold_constants};
+      smith_parse_module_result_t parallel_result =
+          smith_parse_module_parallel(parallel_context, pool,
+                                      &tokenize_result.buffer);
+      munit_assert(parallel_result.success);
+      smith_module_t actual = parallel_result.module;
+      munit_assert_size(actual.count, ==, function_counts[j]);
+      smith_assert_module_equal(&actual, &expected);
+      smith_module_destroy(actual);
+      smith_module_destroy(expected);
+      smith_interner_destroy(parallel_context.interner);
+      smith_interner_destroy(serial_context.interner);
+      smith_token_buffer_destroy(tokenize_result.buffer);
+      smith_allocator_deallocate(allocator, source);
+    }
+    smith_thread_pool_destroy(pool);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Writes `count` functions, one per line, where the one at `broken` is
+// missing the right operand of its body.
+static char *module_with_error(smith_allocator_t allocator, size_t count,
+                               size_t broken) {
+  size_t capacity = count * 32 + 1;
+  char *source = smith_allocator_allocate_array(allocator, char, capacity);
+  munit_assert_not_null(source);
+  source[0] = '\0';
+  size_t length = 0;
+  for (size_t i = 0; i < count; i++) {
+    length += snprintf(source + length, capacity - length,
+                       i == broken ? "fn f%zu(a) { a + }\n"
+                                   : "fn f%zu(a) { a + %zu }\n",
+                       i, i);
+  }
+  return source;
+}
+
+static MunitResult
+test_smith_parse_module_parallel_reports_syntax_errors(
+    const MunitParameter params[], void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char *broken = module_with_error(allocator, 100, 57);
+  struct {
+    char *source;
+    smith_position_t error;
+  } cases[] = {
+      {"fn main(x) { x * }\n", {.line = 0, .column = 17}},
+      {"1 fn f() { 1 }\n", {.line = 0, .column = 0}},
+      {"fn f() { 1 } 2\nfn g() { 2 }\n", {.line = 0, .column = 13}},
+      {"fn f(a b) { a }\nfn g() { 2 }\n", {.line = 0, .column = 7}},
+      {"fn f() { 1 }\nfn g() { 2\n", {.line = 2, .column = 0}},
+      {broken, {.line = 57, .column = 16}},
+  };
+  size_t thread_counts[] = {0, 3};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]);
+       i++) {
+    smith_thread_pool_t pool = thread_pool_create(allocator, thread_counts[i]);
+    for (size_t j = 0; j < sizeof(cases) / sizeof(cases[0]); j++) {
+      smith_tokenize_result_t tokenize_result = smith_tokenize(
+          allocator, smith_null_interner_create(), cases[j].source);
+      munit_assert(tokenize_result.success);
+      smith_parser_context_t context = {
+          .allocator = allocator, .interner = interner_create(allocator)};
+      smith_parse_module_result_t serial_result =
+          smith_parse_module(context, &tokenize_result.buffer);
+      munit_assert_false(serial_result.success);
+      smith_assert_position_equal(serial_result.error.start, cases[j].error);
+      smith_parse_module_result_t parallel_result = smith_parse_module_parallel(
+          context, pool, &tokenize_result.buffer);
+      munit_assert_false(parallel_result.success);
+      smith_assert_span_equal(parallel_result.error, serial_result.error);
+      munit_assert_size(parallel_result.module.count, ==, 0);
+      smith_module_destroy(parallel_result.module);
+      smith_module_destroy(serial_result.module);
+      smith_interner_destroy(context.interner);
+      smith_token_buffer_destroy(tokenize_result.buffer);
+    }
+    smith_thread_pool_destroy(pool);
+  }
+  smith_allocator_deallocate(allocator, broken);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Every allocation of the parse may fail, the interner's included. The parse
+// then fails and releases what it built; with enough of them it succeeds.
+// The pool runs batches on the calling thread, since the finite allocator is
+// not thread safe.
+static MunitResult
+test_smith_parse_module_parallel_allocation_failure(
+    const MunitParameter params[], void *user_data_or_fixture) {
+  smith_allocator_t system_allocator = smith_system_allocator_create();
+  smith_thread_pool_t pool = thread_pool_create(system_allocator, 0);
+  char *source = random_module(system_allocator, 12);
+  smith_tokenize_result_t tokenize_result =
+      smith_tokenize(system_allocator, smith_null_interner_create(), source);
+  munit_assert(tokenize_result.success);
+  smith_parser_context_t serial_context = {
+      .allocator = system_allocator,
+      .interner = interner_create(system_allocator)};
+  smith_parse_module_result_t serial_result =
+      smith_parse_module(serial_context, &tokenize_result.buffer);
+  munit_assert(serial_result.success);
+  for (size_t allocations = 0;; allocations++) {
+    smith_finite_allocator_create_result_t finite_allocator_create_result =
+        smith_finite_allocator_create(smith_system_allocator_create(),
+                                      allocations);
+    munit_assert(finite_allocator_create_result.success);
+    smith_allocator_t allocator = finite_allocator_create_result.allocator;
+    smith_hash_interner_create_result_t interner_create_result =
+        smith_hash_interner_create(allocator);
+    if (!interner_create_result.success) {
+      smith_allocator_destroy(allocator);
+      continue;
+    }
+    smith_parser_context_t context = {
+        .allocator = allocator, .interner = interner_create_result.interner};
+    smith_parse_module_result_t parse_result =
+        smith_parse_module_parallel(context, pool, &tokenize_result.buffer);
+    bool success = parse_result.success;
+    if (success) {
+      smith_assert_module_equal(&parse_result.module, &serial_result.module);
+    } else {
+      munit_assert_size(parse_result.module.count, ==, 0);
+    }
+    smith_module_destroy(parse_result.module);
+    smith_interner_destroy(context.interner);
+    smith_allocator_destroy(allocator);
+    if (success) {
+      break;
+    }
+  }
+  smith_module_destroy(serial_result.module);
+  smith_interner_destroy(serial_context.interner);
+  smith_token_buffer_destroy(tokenize_result.buffer);
+  smith_allocator_deallocate(system_allocator, source);
+  smith_thread_pool_destroy(pool);
+  smith_allocator_destroy(system_allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_parallel_parser_tests[] = {
+    {
+        .name = "/test_smith_parse_module_parallel_matches_parse_module",
+        .test = test_smith_parse_module_parallel_matches_parse_module,
+    },
+    {
+        .name = "/test_smith_parse_module_parallel_reports_syntax_errors",
+        .test = test_smith_parse_module_parallel_reports_syntax_errors,
+    },
+    {
+        .name = "/test_smith_parse_module_parallel_allocation_failure",
+        .test = test_smith_parse_module_parallel_allocation_failure,
+    },
+    {}};
+
+MunitSuite smith_parallel_parser_suite = {
+    .prefix = "/parallel_parser",
+    .tests = smith_parallel_parser_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,97 @@
+#include "smith/assertions.h"
+#include "smith/hash_interner.h"
+#include "smith/parallel_tokenizer.h"
+#include "smith/random.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  return interner_create_result.interner;
+}
+
+static smith_thread_pool_t thread_pool_create(smith_allocator_t allocator,
+                                              size_t thread_count) {
+  smith_thread_pool_create_result_t thread_pool_create_result =
+      smith_thread_pool_create(allocator, thread_count);
+  munit_assert(thread_pool_create_result.success);
+  return thread_pool_create_result.pool;
+}
+
+static void assert_token_buffer_equal(smith_token_buffer_t actual,
+                                      smith_token_buffer_t expected) {
+  munit_assert_int(actual.count, ==, expected.count);
+  for (size_t i = 0; i < actual.count; i++) {
+    smith_assert_token_equal(actual.tokens[i], expected.tokens[i]);
+    munit_assert_int(actual.offsets[i].start, ==, expected.offsets[i].start);
+    munit_assert_int(actual.offsets[i].end, ==, expected.offsets[i].end);
+  }
+}
+
+static MunitResult
+test_smith_tokenize_parallel_matches_tokenize(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_thread_pool_t pool = thread_pool_create(allocator, 3);
+  smith_string_t source = smith_random_source(allocator, 2000);
+  size_t piece_sizes[] = {1, 7, 64, 1000, 1 << 20};
+  for (size_t i = 0; i < sizeof(piece_sizes) / sizeof(piece_sizes[0]); i++) {
+    // Fresh interners so that identifiers are assigned from scratch by both.
+    smith_interner_t serial_interner = interner_create(allocator);
+    smith_tokenize_result_t expected =
+        smith_tokenize(allocator, serial_interner, source.data);
+    munit_assert(expected.success);
+    smith_interner_t parallel_interner = interner_create(allocator);
+    smith_tokenize_result_t actual =
+        smith_tokenize_parallel(allocator, parallel_interner, pool,
+                                source.data, piece_sizes[i]);
+    munit_assert(actual.success);
+    assert_token_buffer_equal(actual.buffer, expected.buffer);
+    smith_token_buffer_destroy(actual.buffer);
+    smith_token_buffer_destroy(expected.buffer);
+    smith_interner_destroy(parallel_interner);
+    smith_interner_destroy(serial_interner);
+  }
+  smith_allocator_deallocate(allocator, source.data);
+  smith_thread_pool_destroy(pool);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_parallel_empty_source(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_thread_pool_t pool = thread_pool_create(allocator, 2);
+  smith_interner_t interner = interner_create(allocator);
+  smith_tokenize_result_t actual =
+      smith_tokenize_parallel(allocator, interner, pool, "", 16);
+  munit_assert(actual.success);
+  munit_assert_int(actual.buffer.count, ==, 1);
+  munit_assert_int(actual.buffer.tokens[0].kind, ==,
+                   SMITH_TOKEN_KIND_END_OF_FILE);
+  smith_token_buffer_destroy(actual.buffer);
+  smith_interner_destroy(interner);
+  smith_thread_pool_destroy(pool);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_parallel_tokenizer_tests[] = {
+    {
+        .name = "/test_smith_tokenize_parallel_matches_tokenize",
+        .test = test_smith_tokenize_parallel_matches_tokenize,
+    },
+    {
+        .name = "/test_smith_tokenize_parallel_empty_source",
+        .test = test_smith_tokenize_parallel_empty_source,
+    },
+    {}};
+
+MunitSuite smith_parallel_tokenizer_suite = {
+    .prefix = "/parallel_tokenizer",
+    .tests = smith_parallel_tokenizer_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,283 @@
+#include "smith/assertions.h"
+#include "smith/hash_interner.h"
+#include "smith/null_interner.h"
+#include "smith/parse_cache.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  return interner_create_result.interner;
+}
+
+static void cache_path(char *path, size_t capacity) {
+  const char *directory = getenv("TMPDIR");
+  snprintf(path, capacity, "%s/smith_parse_cache_%ld",
+           directory != nullptr ? directory : "/tmp", (long)getpid());
+}
+
+static char source[] = "fn area(w, h) { w * h * 1.5 }\n"
+                       "fn day() { 60 * 60 * 24 == seconds }\n"
+                       "fn id(x,) { x = y = x }\n"
+                       "fn none() { 2 / 0 + w }\n";
+
+static smith_module_t parse_module(smith_parser_context_t context) {
+  smith_tokenize_result_t tokenize_result =
+      smith_tokenize(context.allocator, smith_null_interner_create(), source);
+  munit_assert(tokenize_result.success);
+  smith_parse_module_result_t parse_result =
+      smith_parse_module(context, &tokenize_result.buffer);
+  munit_assert(parse_result.success);
+  smith_token_buffer_destroy(tokenize_result.buffer);
+  return parse_result.module;
+}
+
+static MunitResult test_smith_parse_cache_round_trip(
+    const MunitParameter params[], void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char path[256];
+  cache_path(path, sizeof(path));
+  uint64_t source_hash = smith_source_hash(
+      (smith_string_t){.data = source, .length = strlen(source)});
+  for (int fold_constants = 0; fold_constants < 2; fold_constants++) {
+    smith_parser_context_t context = {.allocator = allocator,
+                                      .interner = interner_create(allocator),
+                                      .fold_constants = fold_constants};
+    smith_module_t expected = parse_module(context);
+    munit_assert_true(
+        smith_parse_cache_write(allocator, &expected, source_hash, path));
+    // A fresh interner assigns the same identifiers as the parse did.
+    smith_interner_t interner = interner_create(allocator);
+    smith_parse_cache_load_result_t load_result =
+        smith_parse_cache_load(allocator, interner, path, source_hash);
+    munit_assert_true(load_result.success);
+    smith_assert_module_equal(&load_result.module, &expected);
+    // Leaf text is not copied out of the mapping.
+    char *text = load_result.module.functions[0].name.text.data;
+    char *mapping = load_result.cache.mapping;
+    munit_assert_ptr(text, >=, mapping);
+    munit_assert_ptr(text, <, mapping + load_result.cache.size);
+    smith_module_destroy(load_result.module);
+    smith_parse_cache_close(load_result.cache);
+    // A cache written for other source text is a miss.
+    load_result =
+        smith_parse_cache_load(allocator, interner, path, source_hash + 1);
+    munit_assert_false(load_result.success);
+    smith_interner_destroy(interner);
+    smith_module_destroy(expected);
+    smith_interner_destroy(context.interner);
+  }
+  unlink(path);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_parse_cache_rejects_corruption(
+    const MunitParameter params[], void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char path[256];
+  cache_path(path, sizeof(path));
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_module_t module = parse_module(context);
+  munit_assert_true(smith_parse_cache_write(allocator, &module, 42, path));
+  FILE *file = fopen(path, "rb");
+  munit_assert_not_null(file);
+  char contents[4096];
+  size_t size = fread(contents, 1, sizeof(contents), file);
+  fclose(file);
+  munit_assert_size(size, <, sizeof(contents));
+  // Every truncation is rejected.
+  for (size_t length = 0; length < size; length++) {
+    file = fopen(path, "wb");
+    munit_assert_not_null(file);
+    fwrite(contents, 1, length, file);
+    fclose(file);
+    smith_parse_cache_load_result_t load_result =
+        smith_parse_cache_load(allocator, context.interner, path, 42);
+    munit_assert_false(load_result.success);
+  }
+  // Random byte flips either are rejected or load some well formed module.
+  for (int round = 0; round < 500; round++) {
+    char corrupt[sizeof(contents)];
+    memcpy(corrupt, contents, size);
+    size_t offset = munit_rand_int_range(0, size - 1);
+    corrupt[offset] ^= (char)munit_rand_int_range(1, 255);
+    file = fopen(path, "wb");
+    munit_assert_not_null(file);
+    fwrite(corrupt, 1, size, file);
+    fclose(file);
+    smith_parse_cache_load_result_t load_result =
+        smith_parse_cache_load(allocator, context.interner, path, 42);
+    if (load_result.success) {
+      smith_ast_t *ast = &load_result.module.ast;
+      for (uint32_t node = 0; node < ast->count; node++) {
+        munit_assert_uint32(smith_ast_first(ast, node), <=, node);
+      }
+      // Whatever loads is laid out as the consumers of the AST expect.
+      for (size_t i = 0; i < load_result.module.count; i++) {
+        smith_ast_to_expression_result_t to_expression_result =
+            smith_ast_to_expression(allocator, ast,
+                                    load_result.module.functions[i].body);
+        munit_assert_true(to_expression_result.success);
+        smith_expression_t expression = to_expression_result.expression;
+        smith_expression_destroy(allocator, expression);
+      }
+      smith_module_destroy(load_result.module);
+      smith_parse_cache_close(load_result.cache);
+    }
+  }
+  unlink(path);
+  smith_module_destroy(module);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Breaks the layout of the first functions of `source` in one of several
+// ways that every field on its own would still accept.
+static void malform(smith_module_t *module, int way) {
+  smith_ast_t *ast = &module->ast;
+  // `area` is w and h, then w * h (node 4) and its product with 1.5.
+  switch (way) {
+  case 0:
+    ast->children[4] = (smith_ast_children_t){.left = 3, .right = 2};
+    break;
+  case 1:
+    ast->children[6] = (smith_ast_children_t){.left = 5, .right = 5};
+    break;
+  case 2:
+    ast->children[6] = (smith_ast_children_t){.left = 3, .right = 5};
+    break;
+  case 3:
+    module->functions[0].parameters = 1;
+    break;
+  default:
+    // `day` takes no parameters; give it the last node of `area`.
+    module->functions[1].parameters--;
+    module->functions[1].parameter_count = 1;
+    break;
+  }
+}
+
+static MunitResult test_smith_parse_cache_rejects_malformed_trees(
+    const MunitParameter params[], void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char path[256];
+  cache_path(path, sizeof(path));
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  for (int way = 0; way < 5; way++) {
+    smith_module_t module = parse_module(context);
+    munit_assert_uint32(module.functions[0].body, ==, 6);
+    malform(&module, way);
+    munit_assert_true(smith_parse_cache_write(allocator, &module, 42, path));
+    smith_parse_cache_load_result_t load_result =
+        smith_parse_cache_load(allocator, context.interner, path, 42);
+    munit_assert_false(load_result.success);
+    smith_module_destroy(module);
+  }
+  unlink(path);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_parse_module_cached(const MunitParameter params[],
+                                                  void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char path[256];
+  cache_path(path, sizeof(path));
+  unlink(path);
+  smith_string_t text = {.data = source, .length = strlen(source)};
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = interner_create(allocator)};
+  smith_parse_module_cached_result_t miss =
+      smith_parse_module_cached(context, text, path);
+  munit_assert_true(miss.success);
+  munit_assert_false(miss.hit);
+  smith_interner_destroy(context.interner);
+  context.interner = interner_create(allocator);
+  smith_parse_module_cached_result_t hit =
+      smith_parse_module_cached(context, text, path);
+  munit_assert_true(hit.success);
+  munit_assert_true(hit.hit);
+  smith_assert_module_equal(&hit.module, &miss.module);
+  smith_module_destroy(hit.module);
+  // The interner refers to text in the mapping, so it goes first.
+  smith_interner_destroy(context.interner);
+  smith_parse_cache_close(hit.cache);
+  context.interner = interner_create(allocator);
+  // Editing the source invalidates the cache, which is then rewritten.
+  source[3] = 'b';
+  smith_parse_module_cached_result_t edited =
+      smith_parse_module_cached(context, text, path);
+  munit_assert_false(edited.hit);
+  smith_module_destroy(edited.module);
+  edited = smith_parse_module_cached(context, text, path);
+  munit_assert_true(edited.hit);
+  smith_assert_string_equal(edited.module.functions[0].name.text,
+                            (smith_string_t){.data = "brea", .length = 4});
+  source[3] = 'a';
+  smith_module_destroy(edited.module);
+  smith_interner_destroy(context.interner);
+  smith_parse_cache_close(edited.cache);
+  smith_module_destroy(miss.module);
+  unlink(path);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_parse_module_cached_syntax_error(const MunitParameter params[],
+                                            void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  char path[256];
+  cache_path(path, sizeof(path));
+  unlink(path);
+  char *broken = "fn main(x) { x * }\n";
+  smith_string_t text = {.data = broken, .length = strlen(broken)};
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = interner_create(allocator)};
+  smith_parse_module_cached_result_t result =
+      smith_parse_module_cached(context, text, path);
+  munit_assert_false(result.success);
+  // Nothing is cached for a source that does not parse.
+  munit_assert_int(access(path, F_OK), !=, 0);
+  smith_interner_destroy(context.interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_parse_cache_tests[] = {
+    {
+        .name = "/test_smith_parse_cache_round_trip",
+        .test = test_smith_parse_cache_round_trip,
+    },
+    {
+        .name = "/test_smith_parse_cache_rejects_corruption",
+        .test = test_smith_parse_cache_rejects_corruption,
+    },
+    {
+        .name = "/test_smith_parse_cache_rejects_malformed_trees",
+        .test = test_smith_parse_cache_rejects_malformed_trees,
+    },
+    {
+        .name = "/test_smith_parse_module_cached",
+        .test = test_smith_parse_module_cached,
+    },
+    {
+        .name = "/test_smith_parse_module_cached_syntax_error",
+        .test = test_smith_parse_module_cached_syntax_error,
+    },
+    {}};
+
+MunitSuite smith_parse_cache_suite = {
+    .prefix = "/parse_cache",
+    .tests = smith_parse_cache_tests,
+    .iterations = 1,
+};
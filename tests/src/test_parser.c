@@ -1,10 +1,16 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
 #include "smith/assertions.h"
+#include "smith/finite_allocator.h"
 #include "smith/format.h"
 #include "smith/hash_interner.h"
+#include "smith/null_interner.h"
 #include "smith/parser.h"
 #include "smith/random.h"
 #include "smith/system_allocator.h"
 #include "smith/test_suites.h"
+#include <stdio.h>
+#include <string.h>
 
 static smith_interner_t interner_create(smith_allocator_t allocator) {
   smith_hash_interner_create_result_t interner_create_result =
@@ -13,13 +19,6 @@ static smith_interner_t interner_create(smith_allocator_t allocator) {
   return interner_create_result.interner;
 }
 
-static smith_keywords_t keywords_create(smith_interner_t interner) {
-  smith_keywords_create_result_t keywords_create_result =
-      smith_keywords_create(interner);
-  munit_assert(keywords_create_result.success);
-  return keywords_create_result.keywords;
-}
-
 static smith_interned_t intern(smith_interner_t interner,
                                smith_string_t string) {
   smith_intern_result_t intern_result = smith_interner_intern(interner, string);
@@ -30,9 +29,8 @@ static smith_interned_t intern(smith_interner_t interner,
 static smith_parser_context_t parser_context_create() {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
-  return (smith_parser_context_t){
-      .allocator = allocator, .interner = interner, .keywords = keywords};
+  return (smith_parser_context_t){.allocator = allocator,
+                                  .interner = interner};
 }
 
 void parser_context_destroy(smith_parser_context_t context) {
@@ -50,7 +48,9 @@ static MunitResult test_smith_parse_symbol(const MunitParameter params[],
   smith_interned_t interned = intern(context.interner, symbol);
   smith_parse_result_t expected = {
       .expression = {.kind = SMITH_EXPRESSION_KIND_SYMBOL,
-                     .value.symbol = {.interned = interned, .span.end = end}},
+                     .value.symbol = {.interned = interned,
+                                      .text = symbol,
+                                      .span.end = end}},
       .cursor = {.source = "", .position = end}};
   smith_assert_parse_result_equal(actual, expected);
   smith_allocator_deallocate(context.allocator, symbol.data);
@@ -68,7 +68,9 @@ static MunitResult test_smith_parse_int(const MunitParameter params[],
   smith_interned_t interned = intern(context.interner, int_);
   smith_parse_result_t expected = {
       .expression = {.kind = SMITH_EXPRESSION_KIND_INT,
-                     .value.int_ = {.interned = interned, .span.end = end}},
+                     .value.int_ = {.interned = interned,
+                                    .text = int_,
+                                    .span.end = end}},
       .cursor = {.source = "", .position = end}};
   smith_assert_parse_result_equal(actual, expected);
   smith_allocator_deallocate(context.allocator, int_.data);
@@ -86,7 +88,9 @@ static MunitResult test_smith_parse_float(const MunitParameter params[],
   smith_interned_t interned = intern(context.interner, float_);
   smith_parse_result_t expected = {
       .expression = {.kind = SMITH_EXPRESSION_KIND_FLOAT,
-                     .value.float_ = {.interned = interned, .span.end = end}},
+                     .value.float_ = {.interned = interned,
+                                      .text = float_,
+                                      .span.end = end}},
       .cursor = {.source = "", .position = end}};
   smith_assert_parse_result_equal(actual, expected);
   smith_allocator_deallocate(context.allocator, float_.data);
@@ -128,11 +132,13 @@ test_smith_parse_binary_operator(const MunitParameter params[],
                             &(smith_expression_t){
                                 .kind = SMITH_EXPRESSION_KIND_SYMBOL,
                                 .value.symbol = {.interned = lhs_interned,
+                                                 .text = lhs,
                                                  .span.end = lhs_span.end}},
                         .right =
                             &(smith_expression_t){
                                 .kind = SMITH_EXPRESSION_KIND_SYMBOL,
                                 .value.symbol = {.interned = rhs_interned,
+                                                 .text = rhs,
                                                  .span = rhs_span}},
                     },
             },
@@ -148,6 +154,404 @@ test_smith_parse_binary_operator(const MunitParameter params[],
   return MUNIT_OK;
 }
 
+static MunitResult
+test_smith_parse_null_interner(const MunitParameter params[],
+                               void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  smith_string_t lhs = smith_random_symbol(allocator);
+  smith_string_t rhs = smith_random_int(allocator);
+  char *source = smith_format_string(allocator, "%s * %s", lhs.data, rhs.data);
+  munit_assert_not_null(source);
+  smith_parse_result_t actual =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  smith_span_t op_span = {.start.column = lhs.length + 1,
+                          .end.column = lhs.length + 2};
+  smith_span_t rhs_span = {.start.column = lhs.length + 3,
+                           .end.column = lhs.length + 3 + rhs.length};
+  smith_parse_result_t expected = {
+      .expression =
+          {
+              .kind = SMITH_EXPRESSION_KIND_BINARY_OPERATOR,
+              .value.binary_operator =
+                  {
+                      .info = smith_binary_operator_mapping
+                          [SMITH_OPERATOR_KIND_MUL],
+                      .op_span = op_span,
+                      .left =
+                          &(smith_expression_t){
+                              .kind = SMITH_EXPRESSION_KIND_SYMBOL,
+                              .value.symbol = {.text = lhs,
+                                               .span.end.column =
+                                                   lhs.length}},
+                      .right =
+                          &(smith_expression_t){
+                              .kind = SMITH_EXPRESSION_KIND_INT,
+                              .value.int_ = {.text = rhs, .span = rhs_span}},
+                  },
+          },
+      .cursor = {.source = "", .position = rhs_span.end},
+  };
+  smith_assert_parse_result_equal(actual, expected);
+  smith_expression_destroy(allocator, actual.expression);
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_deallocate(allocator, lhs.data);
+  smith_allocator_deallocate(allocator, rhs.data);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+// Writes the expression fully parenthesized, spelling each operator as it
+// appears in the single line `source`.
+static char *parenthesize(const char *source, smith_expression_t expression,
+                          char *output) {
+  switch (expression.kind) {
+  case SMITH_EXPRESSION_KIND_BINARY_OPERATOR: {
+    smith_binary_operator_t binary_operator =
+        expression.value.binary_operator;
+    smith_span_t op_span = binary_operator.op_span;
+    *output++ = '(';
+    output = parenthesize(source, *binary_operator.left, output);
+    *output++ = ' ';
+    size_t length = op_span.end.column - op_span.start.column;
+    memcpy(output, source + op_span.start.column, length);
+    output += length;
+    *output++ = ' ';
+    output = parenthesize(source, *binary_operator.right, output);
+    *output++ = ')';
+    return output;
+  }
+  case SMITH_EXPRESSION_KIND_SYMBOL:
+    memcpy(output, expression.value.symbol.text.data,
+           expression.value.symbol.text.length);
+    return output + expression.value.symbol.text.length;
+  case SMITH_EXPRESSION_KIND_INT:
+    memcpy(output, expression.value.int_.text.data,
+           expression.value.int_.text.length);
+    return output + expression.value.int_.text.length;
+  case SMITH_EXPRESSION_KIND_FLOAT:
+    memcpy(output, expression.value.float_.text.data,
+           expression.value.float_.text.length);
+    return output + expression.value.float_.text.length;
+  case SMITH_EXPRESSION_KIND_CONSTANT: {
+    smith_constant_t constant = expression.value.constant.constant;
+    switch (constant.kind) {
+    case SMITH_CONSTANT_KIND_INT:
+      return output + sprintf(output, "%lld", (long long)constant.value.int_);
+    case SMITH_CONSTANT_KIND_FLOAT:
+      return output + sprintf(output, "%g", constant.value.float_);
+    case SMITH_CONSTANT_KIND_BOOL:
+      return output +
+             sprintf(output, "%s", constant.value.bool_ ? "true" : "false");
+    }
+  }
+  }
+  munit_error("unexpected expression kind");
+}
+
+static MunitResult test_smith_parse_precedence(const MunitParameter params[],
+                                               void *user_data_or_fixture) {
+  smith_parser_context_t context = parser_context_create();
+  struct {
+    char *source;
+    char *expected;
+  } cases[] = {
+      {"a - b - c", "((a - b) - c)"},
+      {"a = b = c", "(a = (b = c))"},
+      {"a + b * c", "(a + (b * c))"},
+      {"a * b + c", "((a * b) + c)"},
+      {"a += b * c - d", "(a += ((b * c) - d))"},
+      {"a * b == c / d", "((a * (b == c)) / d)"},
+      {"a = b + c * d - e = f", "(a = (((b + (c * d)) - e) = f))"},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    smith_parse_result_t actual = smith_parse_expression(
+        context, (smith_cursor_t){.source = cases[i].source});
+    munit_assert_string_equal(actual.cursor.source, "");
+    char output[64] = {};
+    parenthesize(cases[i].source, actual.expression, output);
+    munit_assert_string_equal(output, cases[i].expected);
+    smith_expression_destroy(context.allocator, actual.expression);
+  }
+  parser_context_destroy(context);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_parse_long_sum(const MunitParameter params[],
+                                             void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  size_t terms = 100000;
+  char *source = smith_allocator_allocate_array(allocator, char, terms * 4);
+  munit_assert_not_null(source);
+  for (size_t i = 0; i < terms; i++) {
+    memcpy(source + i * 4, "x + ", 4);
+  }
+  source[terms * 4 - 3] = '\0';
+  smith_parse_result_t actual =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  munit_assert_string_equal(actual.cursor.source, "");
+  smith_expression_t expression = actual.expression;
+  for (size_t i = terms - 1; i > 0; i--) {
+    munit_assert_int(expression.kind, ==,
+                     SMITH_EXPRESSION_KIND_BINARY_OPERATOR);
+    smith_binary_operator_t binary_operator =
+        expression.value.binary_operator;
+    munit_assert_int(binary_operator.info.kind, ==,
+                     SMITH_BINARY_OPERATOR_KIND_ADD);
+    munit_assert_size(binary_operator.op_span.start.column, ==, i * 4 - 2);
+    munit_assert_int(binary_operator.right->kind, ==,
+                     SMITH_EXPRESSION_KIND_SYMBOL);
+    expression = *binary_operator.left;
+  }
+  munit_assert_int(expression.kind, ==, SMITH_EXPRESSION_KIND_SYMBOL);
+  // The sum is as deep as it is long.
+  smith_expression_destroy(allocator, actual.expression);
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_parse_long_assignment(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  // Assignments are right associative, so every one of them is pending until
+  // the last operand, which moves the parse stacks to the heap.
+  size_t assignments = 100;
+  char source[100 * 4 + 2];
+  for (size_t i = 0; i < assignments; i++) {
+    memcpy(source + i * 4, "a = ", 4);
+  }
+  memcpy(source + assignments * 4, "1", 2);
+  smith_parse_result_t actual =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  munit_assert_string_equal(actual.cursor.source, "");
+  smith_expression_t expression = actual.expression;
+  for (size_t i = 0; i < assignments; i++) {
+    munit_assert_int(expression.kind, ==,
+                     SMITH_EXPRESSION_KIND_BINARY_OPERATOR);
+    smith_binary_operator_t binary_operator =
+        expression.value.binary_operator;
+    munit_assert_int(binary_operator.info.kind, ==,
+                     SMITH_BINARY_OPERATOR_KIND_ASSIGN);
+    munit_assert_size(binary_operator.op_span.start.column, ==, i * 4 + 2);
+    munit_assert_int(binary_operator.left->kind, ==,
+                     SMITH_EXPRESSION_KIND_SYMBOL);
+    expression = *binary_operator.right;
+  }
+  munit_assert_int(expression.kind, ==, SMITH_EXPRESSION_KIND_INT);
+  smith_expression_destroy(allocator, actual.expression);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_expression_destroy_deep(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  // Assignments lean right and sums lean left, so alternating runs of them
+  // zigzag and exercise both directions of the teardown.
+  size_t runs = 2000;
+  size_t run_length = 50;
+  size_t length = runs * run_length * 8 + 2;
+  char *source = smith_allocator_allocate_array(allocator, char, length);
+  munit_assert_not_null(source);
+  char *end = source;
+  for (size_t i = 0; i < runs; i++) {
+    for (size_t j = 0; j < run_length; j++) {
+      memcpy(end, i % 2 == 0 ? "x = " : "x + ", 4);
+      end += 4;
+    }
+  }
+  memcpy(end, "x", 2);
+  smith_parse_result_t actual =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  munit_assert_string_equal(actual.cursor.source, "");
+  smith_expression_destroy(allocator, actual.expression);
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_parse_expression_buffer(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  smith_parser_context_t context = parser_context_create();
+  char *source = "a = b + c * d - e = f g * h";
+  smith_tokenize_result_t tokenize_result = smith_tokenize(
+      context.allocator, smith_null_interner_create(), source);
+  munit_assert(tokenize_result.success);
+  smith_token_buffer_t buffer = tokenize_result.buffer;
+  smith_parse_buffer_result_t actual =
+      smith_parse_expression_buffer(context, &buffer, 0);
+  smith_parse_result_t expected =
+      smith_parse_expression(context, (smith_cursor_t){.source = source});
+  smith_assert_expression_equal(actual.expression, expected.expression);
+  munit_assert_size(actual.index, ==, 11);
+  munit_assert_size(buffer.offsets[actual.index].start, ==,
+                    smith_trim_whitespace(expected.cursor).source - source);
+  smith_expression_destroy(context.allocator, actual.expression);
+  smith_expression_destroy(context.allocator, expected.expression);
+  actual = smith_parse_expression_buffer(context, &buffer, actual.index);
+  char output[64] = {};
+  parenthesize(source, actual.expression, output);
+  munit_assert_string_equal(output, "(g * h)");
+  munit_assert_int(buffer.tokens[actual.index].kind, ==,
+                   SMITH_TOKEN_KIND_END_OF_FILE);
+  smith_expression_destroy(context.allocator, actual.expression);
+  smith_token_buffer_destroy(buffer);
+  parser_context_destroy(context);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_parse_module(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  smith_parser_context_t context = parser_context_create();
+  char *source = "fn add(a, b) { a + b }\n"
+                 "fn one() { 1 }\n"
+                 "fn scale(x,) { x * 2.5 }";
+  smith_tokenize_result_t tokenize_result = smith_tokenize(
+      context.allocator, smith_null_interner_create(), source);
+  munit_assert(tokenize_result.success);
+  smith_parse_module_result_t parse_result =
+      smith_parse_module(context, &tokenize_result.buffer);
+  munit_assert(parse_result.success);
+  smith_module_t module = parse_result.module;
+  munit_assert_size(module.count, ==, 3);
+  smith_function_t add = module.functions[0];
+  munit_assert_string_equal(add.name.text.data, source + 3);
+  munit_assert_size(add.name.text.length, ==, 3);
+  munit_assert_uint32(add.parameter_count, ==, 2);
+  munit_assert_uint32(add.parameters, ==, 0);
+  munit_assert_int(module.ast.kinds[add.parameters + 1], ==,
+                   SMITH_EXPRESSION_KIND_SYMBOL);
+  munit_assert_int(module.ast.payloads[add.body].binary_operator.kind, ==,
+                   SMITH_BINARY_OPERATOR_KIND_ADD);
+  munit_assert_uint32(add.span.start.column, ==, 0);
+  munit_assert_uint32(add.span.end.column, ==, 22);
+  smith_function_t one = module.functions[1];
+  munit_assert_uint32(one.parameter_count, ==, 0);
+  munit_assert_uint32(one.parameters, ==, add.body + 1);
+  munit_assert_uint32(one.body, ==, one.parameters);
+  munit_assert_int(module.ast.kinds[one.body], ==, SMITH_EXPRESSION_KIND_INT);
+  munit_assert_uint32(one.span.start.line, ==, 1);
+  smith_function_t scale = module.functions[2];
+  munit_assert_uint32(scale.parameter_count, ==, 1);
+  munit_assert_uint32(smith_ast_first(&module.ast, scale.body), ==,
+                      scale.parameters + 1);
+  munit_assert_uint32(scale.body, ==, module.ast.count - 1);
+  // Names are interned as they are parsed, so both uses of `a` agree.
+  munit_assert_size(module.ast.payloads[0].leaf.interned, ==,
+                    module.ast.payloads[2].leaf.interned);
+  smith_module_destroy(module);
+  smith_token_buffer_destroy(tokenize_result.buffer);
+  parser_context_destroy(context);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_parse_fold_constants(const MunitParameter params[],
+                                                   void *user_data_or_fixture) {
+  smith_parser_context_t context = parser_context_create();
+  context.fold_constants = true;
+  struct {
+    char *source;
+    char *expected;
+  } cases[] = {
+      {"60 * 60 * 24", "86400"},
+      {"x + 2 * 3", "(x + 6)"},
+      {"1 + 2 + x", "(3 + x)"},
+      // Without reassociation only the operators over literals fold.
+      {"x + 1 + 2", "((x + 1) + 2)"},
+      {"1.5 * 2.0 - x", "(3 - x)"},
+      {"1 / 0", "(1 / 0)"},
+      {"9223372036854775807 + 1", "(9223372036854775807 + 1)"},
+      {"1 + 1.5", "(1 + 1.5)"},
+      {"x = 2 == 2", "(x = true)"},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    smith_parse_result_t actual = smith_parse_expression(
+        context, (smith_cursor_t){.source = cases[i].source});
+    munit_assert_string_equal(actual.cursor.source, "");
+    char output[64] = {};
+    parenthesize(cases[i].source, actual.expression, output);
+    munit_assert_string_equal(output, cases[i].expected);
+    smith_expression_destroy(context.allocator, actual.expression);
+  }
+  // A folded constant spans all of the text it was computed from.
+  smith_parse_result_t actual = smith_parse_expression(
+      context, (smith_cursor_t){.source = "60 * 60 * 24"});
+  munit_assert_int(actual.expression.kind, ==, SMITH_EXPRESSION_KIND_CONSTANT);
+  smith_constant_expression_t constant = actual.expression.value.constant;
+  munit_assert_int64(constant.constant.value.int_, ==, 86400);
+  munit_assert_uint32(constant.span.start.column, ==, 0);
+  munit_assert_uint32(constant.span.end.column, ==, 12);
+  parser_context_destroy(context);
+  return MUNIT_OK;
+}
+
+// Every allocation of the parse may fail, the interner's included. The parse
+// then fails and releases what it built; with enough of them it succeeds.
+static MunitResult
+test_smith_parse_allocation_failure(const MunitParameter params[],
+                                    void *user_data_or_fixture) {
+  smith_allocator_t system_allocator = smith_system_allocator_create();
+  // Enough pending assignments to move the parse stacks to the heap.
+  char source[256] = "";
+  for (int i = 0; i < 24; i++) {
+    strcat(source, "x = ");
+  }
+  strcat(source, "y * 2 + 3.5 - z");
+  smith_tokenize_result_t tokenize_result =
+      smith_tokenize(system_allocator, smith_null_interner_create(),
+                     "fn f(a, b) { a + b * 2 }\nfn g() { g - 1 }\n");
+  munit_assert(tokenize_result.success);
+  bool parsed = false;
+  bool module_parsed = false;
+  for (size_t allocations = 0; !parsed || !module_parsed; allocations++) {
+    smith_finite_allocator_create_result_t finite_allocator_create_result =
+        smith_finite_allocator_create(smith_system_allocator_create(),
+                                      allocations);
+    munit_assert(finite_allocator_create_result.success);
+    smith_allocator_t allocator = finite_allocator_create_result.allocator;
+    smith_hash_interner_create_result_t interner_create_result =
+        smith_hash_interner_create(allocator);
+    if (!interner_create_result.success) {
+      smith_allocator_destroy(allocator);
+      continue;
+    }
+    smith_parser_context_t context = {
+        .allocator = allocator, .interner = interner_create_result.interner};
+    smith_parse_result_t parse_result =
+        smith_parse_expression(context, (smith_cursor_t){.source = source});
+    if (parse_result.success) {
+      munit_assert_string_equal(parse_result.cursor.source, "");
+      smith_expression_destroy(allocator, parse_result.expression);
+      parsed = true;
+    }
+    smith_parse_module_result_t module_result =
+        smith_parse_module(context, &tokenize_result.buffer);
+    if (module_result.success) {
+      munit_assert_size(module_result.module.count, ==, 2);
+      module_parsed = true;
+    } else {
+      munit_assert_size(module_result.module.count, ==, 0);
+    }
+    smith_module_destroy(module_result.module);
+    smith_interner_destroy(context.interner);
+    smith_allocator_destroy(allocator);
+  }
+  smith_token_buffer_destroy(tokenize_result.buffer);
+  smith_allocator_destroy(system_allocator);
+  return MUNIT_OK;
+}
+
 static MunitTest smith_parser_tests[] = {
     {
         .name = "/test_smith_parse_symbol",
@@ -165,6 +569,42 @@ static MunitTest smith_parser_tests[] = {
         .name = "/test_smith_parse_binary_operator",
         .test = test_smith_parse_binary_operator,
     },
+    {
+        .name = "/test_smith_parse_null_interner",
+        .test = test_smith_parse_null_interner,
+    },
+    {
+        .name = "/test_smith_parse_precedence",
+        .test = test_smith_parse_precedence,
+    },
+    {
+        .name = "/test_smith_parse_long_sum",
+        .test = test_smith_parse_long_sum,
+    },
+    {
+        .name = "/test_smith_parse_long_assignment",
+        .test = test_smith_parse_long_assignment,
+    },
+    {
+        .name = "/test_smith_expression_destroy_deep",
+        .test = test_smith_expression_destroy_deep,
+    },
+    {
+        .name = "/test_smith_parse_expression_buffer",
+        .test = test_smith_parse_expression_buffer,
+    },
+    {
+        .name = "/test_smith_parse_fold_constants",
+        .test = test_smith_parse_fold_constants,
+    },
+    {
+        .name = "/test_smith_parse_module",
+        .test = test_smith_parse_module,
+    },
+    {
+        .name = "/test_smith_parse_allocation_failure",
+        .test = test_smith_parse_allocation_failure,
+    },
     {}};
 
 MunitSuite smith_parser_suite = {
@@ -0,0 +1,65 @@
+#include "smith/scan.h"
+#include "smith/test_suites.h"
+#include <string.h>
+
+static char *scan_bytewise(char *source, char a, char b, char c) {
+  while (*source != '\0' && *source != a && *source != b && *source != c) {
+    source++;
+  }
+  return source;
+}
+
+static MunitResult
+test_smith_scan_matches_bytewise(const MunitParameter params[],
+                                 void *user_data_or_fixture) {
+  char alphabet[] = "ab\"\\\n*/ ";
+  alignas(16) char buffer[96];
+  for (size_t round = 0; round < 2000; round++) {
+    size_t length = munit_rand_int_range(0, sizeof(buffer) - 1);
+    for (size_t i = 0; i < length; i++) {
+      buffer[i] = alphabet[munit_rand_int_range(0, sizeof(alphabet) - 2)];
+    }
+    buffer[length] = '\0';
+    // Every start covers every alignment of the first block.
+    for (size_t start = 0; start <= length; start++) {
+      munit_assert_ptr_equal(smith_scan(buffer + start, '"', '\\', '\n'),
+                             scan_bytewise(buffer + start, '"', '\\', '\n'));
+      munit_assert_ptr_equal(smith_scan(buffer + start, '*', '*', '*'),
+                             scan_bytewise(buffer + start, '*', '*', '*'));
+    }
+  }
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_scan_stops_at_terminator(const MunitParameter params[],
+                                    void *user_data_or_fixture) {
+  alignas(16) char buffer[64];
+  memset(buffer, 'a', sizeof(buffer));
+  for (size_t length = 0; length < sizeof(buffer); length++) {
+    buffer[length] = '\0';
+    for (size_t start = 0; start <= length; start++) {
+      munit_assert_ptr_equal(smith_scan(buffer + start, '"', '\\', '\n'),
+                             buffer + length);
+    }
+    buffer[length] = 'a';
+  }
+  return MUNIT_OK;
+}
+
+static MunitTest smith_scan_tests[] = {
+    {
+        .name = "/test_smith_scan_matches_bytewise",
+        .test = test_smith_scan_matches_bytewise,
+    },
+    {
+        .name = "/test_smith_scan_stops_at_terminator",
+        .test = test_smith_scan_stops_at_terminator,
+    },
+    {}};
+
+MunitSuite smith_scan_suite = {
+    .prefix = "/scan",
+    .tests = smith_scan_tests,
+    .iterations = 1,
+};
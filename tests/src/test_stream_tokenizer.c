@@ -0,0 +1,276 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/assertions.h"
+#include "smith/copying_interner.h"
+#include "smith/file_reader.h"
+#include "smith/hash_interner.h"
+#include "smith/random.h"
+#include "smith/stream_tokenizer.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include <string.h>
+#include <unistd.h>
+
+static smith_interner_t interner_create(smith_allocator_t allocator) {
+  smith_hash_interner_create_result_t interner_create_result =
+      smith_hash_interner_create(allocator);
+  munit_assert(interner_create_result.success);
+  smith_copying_interner_create_result_t copying_interner_create_result =
+      smith_copying_interner_create(allocator, interner_create_result.interner);
+  munit_assert(copying_interner_create_result.success);
+  return copying_interner_create_result.interner;
+}
+
+static smith_stream_tokenizer_t
+stream_tokenizer_create(smith_allocator_t allocator, smith_interner_t interner,
+                        smith_reader_t reader, size_t chunk_size) {
+  smith_stream_tokenizer_create_result_t stream_tokenizer_create_result =
+      smith_stream_tokenizer_create(allocator, interner, reader, chunk_size);
+  munit_assert(stream_tokenizer_create_result.success);
+  return stream_tokenizer_create_result.tokenizer;
+}
+
+typedef struct {
+  smith_string_t string;
+  size_t offset;
+  size_t chunk_size;
+} string_reader_t;
+
+// Hands out at most `chunk_size` bytes per read, regardless of capacity.
+static smith_read_result_t string_reader_read(void *reader, char *buffer,
+                                              size_t capacity) {
+  string_reader_t *string_reader = reader;
+  size_t length = string_reader->string.length - string_reader->offset;
+  if (length > capacity) {
+    length = capacity;
+  }
+  if (length > string_reader->chunk_size) {
+    length = string_reader->chunk_size;
+  }
+  memcpy(buffer, string_reader->string.data + string_reader->offset, length);
+  string_reader->offset += length;
+  return (smith_read_result_t){.success = true, .length = length};
+}
+
+static void string_reader_destroy(void *reader) {}
+
+static smith_reader_t string_reader_create(string_reader_t *state) {
+  return (smith_reader_t){.read = string_reader_read,
+                          .destroy = string_reader_destroy,
+                          .state = state};
+}
+
+// Returns the capacity the buffer grew to.
+static size_t assert_stream_matches(smith_allocator_t allocator,
+                                    smith_interner_t interner,
+                                    smith_string_t source,
+                                    smith_reader_t reader, size_t chunk_size) {
+  smith_stream_tokenizer_t tokenizer =
+      stream_tokenizer_create(allocator, interner, reader, chunk_size);
+  smith_cursor_t cursor = {.source = source.data};
+  while (true) {
+    smith_next_token_result_t expected = smith_next_token(interner, cursor);
+    smith_stream_next_token_result_t actual =
+        smith_stream_next_token(&tokenizer);
+    munit_assert(actual.success);
+    smith_assert_token_equal(actual.token, expected.token);
+    if (expected.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      break;
+    }
+    cursor = expected.cursor;
+  }
+  size_t capacity = tokenizer.capacity;
+  smith_stream_tokenizer_destroy(tokenizer);
+  return capacity;
+}
+
+static MunitResult
+test_smith_stream_tokenize_matches_next_token(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  smith_string_t source = smith_random_source(allocator, 200);
+  size_t chunk_sizes[] = {1, 2, 3, 7, 64, 4096};
+  for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++) {
+    string_reader_t state = {.string = source, .chunk_size = chunk_sizes[i]};
+    assert_stream_matches(allocator, interner, source,
+                          string_reader_create(&state), chunk_sizes[i]);
+  }
+  smith_allocator_deallocate(allocator, source.data);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_stream_tokenize_token_spans_chunks(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "abcdefghijklmnop+=12.5";
+  string_reader_t state = {.string = {.data = source, .length = strlen(source)},
+                           .chunk_size = 3};
+  smith_stream_tokenizer_t tokenizer = stream_tokenizer_create(
+      allocator, interner, string_reader_create(&state), 3);
+  smith_stream_next_token_result_t actual = smith_stream_next_token(&tokenizer);
+  munit_assert(actual.success);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_SYMBOL);
+  smith_lookup_result_t lookup_result =
+      smith_interner_lookup(interner, actual.token.value.symbol.interned);
+  munit_assert(lookup_result.success);
+  munit_assert_int(lookup_result.string.length, ==, 16);
+  munit_assert(memcmp(lookup_result.string.data, source, 16) == 0);
+  actual = smith_stream_next_token(&tokenizer);
+  munit_assert(actual.success);
+  smith_assert_token_equal(
+      actual.token,
+      (smith_token_t){.kind = SMITH_TOKEN_KIND_OPERATOR,
+                      .value.operator_ = {.kind = SMITH_OPERATOR_KIND_ADD_ASSIGN,
+                                          .span = {.start.column = 16,
+                                                   .end.column = 18}}});
+  actual = smith_stream_next_token(&tokenizer);
+  munit_assert(actual.success);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_FLOAT);
+  smith_assert_span_equal(actual.token.value.float_.span,
+                          (smith_span_t){.start.column = 18, .end.column = 22});
+  actual = smith_stream_next_token(&tokenizer);
+  munit_assert(actual.success);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_END_OF_FILE);
+  smith_stream_tokenizer_destroy(tokenizer);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_stream_tokenize_bounded_memory(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  size_t length = 1 << 16;
+  char *source = smith_allocator_allocate_array(allocator, char, length + 1);
+  munit_assert_not_null(source);
+  for (size_t i = 0; i < length; i += 4) {
+    memcpy(source + i, "a+b\n", 4);
+  }
+  source[length] = '\0';
+  string_reader_t state = {.string = {.data = source, .length = length},
+                           .chunk_size = 64};
+  smith_stream_tokenizer_t tokenizer = stream_tokenizer_create(
+      allocator, interner, string_reader_create(&state), 64);
+  size_t tokens = 0;
+  while (true) {
+    smith_stream_next_token_result_t actual =
+        smith_stream_next_token(&tokenizer);
+    munit_assert(actual.success);
+    if (actual.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      break;
+    }
+    tokens++;
+  }
+  munit_assert_int(tokens, ==, length / 4 * 3);
+  munit_assert_int(tokenizer.capacity, <=, 128);
+  smith_stream_tokenizer_destroy(tokenizer);
+  smith_allocator_deallocate(allocator, source);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static char *append(char *end, const char *text) {
+  size_t length = strlen(text);
+  memcpy(end, text, length);
+  return end + length;
+}
+
+static MunitResult
+test_smith_stream_tokenize_long_comments(const MunitParameter params[],
+                                         void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  // Runs of stars and newlines put a star at the end of many chunks, and the
+  // last block comment is never closed.
+  size_t comment_length = 1 << 18;
+  size_t length = 3 * comment_length + 64;
+  char *source = smith_allocator_allocate_array(allocator, char, length);
+  munit_assert_not_null(source);
+  char *end = source;
+  end = append(end, "a /*");
+  for (size_t i = 0; i < comment_length; i += 4) {
+    end = append(end, "**\n/");
+  }
+  end = append(end, "*/ b //");
+  memset(end, 'y', comment_length);
+  end += comment_length;
+  end = append(end, "\nc /*");
+  for (size_t i = 0; i < comment_length; i += 2) {
+    end = append(end, "*\n");
+  }
+  smith_string_t string = {.data = source, .length = end - source};
+  size_t chunk_sizes[] = {1, 7, 4095, 4096};
+  for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++) {
+    string_reader_t state = {.string = string, .chunk_size = chunk_sizes[i]};
+    size_t capacity =
+        assert_stream_matches(allocator, interner, string,
+                              string_reader_create(&state), chunk_sizes[i]);
+    // Comments are dropped as they are read, so only the chunk is buffered.
+    munit_assert_size(capacity, <=, 2 * chunk_sizes[i] + 8);
+  }
+  smith_allocator_deallocate(allocator, source);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_stream_tokenize_file_descriptor(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  smith_string_t source = smith_random_source(allocator, 50);
+  int pipe_file_descriptors[2];
+  munit_assert_int(pipe(pipe_file_descriptors), ==, 0);
+  munit_assert_int(write(pipe_file_descriptors[1], source.data, source.length),
+                   ==, source.length);
+  close(pipe_file_descriptors[1]);
+  smith_file_reader_create_result_t file_reader_create_result =
+      smith_file_reader_create(allocator, pipe_file_descriptors[0]);
+  munit_assert(file_reader_create_result.success);
+  assert_stream_matches(allocator, interner, source,
+                        file_reader_create_result.reader, 16);
+  smith_reader_destroy(file_reader_create_result.reader);
+  close(pipe_file_descriptors[0]);
+  smith_allocator_deallocate(allocator, source.data);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_stream_tokenizer_tests[] = {
+    {
+        .name = "/test_smith_stream_tokenize_matches_next_token",
+        .test = test_smith_stream_tokenize_matches_next_token,
+    },
+    {
+        .name = "/test_smith_stream_tokenize_token_spans_chunks",
+        .test = test_smith_stream_tokenize_token_spans_chunks,
+    },
+    {
+        .name = "/test_smith_stream_tokenize_bounded_memory",
+        .test = test_smith_stream_tokenize_bounded_memory,
+    },
+    {
+        .name = "/test_smith_stream_tokenize_long_comments",
+        .test = test_smith_stream_tokenize_long_comments,
+    },
+    {
+        .name = "/test_smith_stream_tokenize_file_descriptor",
+        .test = test_smith_stream_tokenize_file_descriptor,
+    },
+    {}};
+
+MunitSuite smith_stream_tokenizer_suite = {
+    .prefix = "/stream_tokenizer",
+    .tests = smith_stream_tokenizer_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,57 @@
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/thread_pool.h"
+#include <stdatomic.h>
+
+static smith_thread_pool_t thread_pool_create(smith_allocator_t allocator,
+                                              size_t thread_count) {
+  smith_thread_pool_create_result_t thread_pool_create_result =
+      smith_thread_pool_create(allocator, thread_count);
+  munit_assert(thread_pool_create_result.success);
+  return thread_pool_create_result.pool;
+}
+
+typedef struct {
+  atomic_int runs[1000];
+} runs_t;
+
+static void count_run(void *state, size_t index) {
+  runs_t *runs = state;
+  atomic_fetch_add(&runs->runs[index], 1);
+}
+
+static MunitResult
+test_smith_thread_pool_runs_every_task(const MunitParameter params[],
+                                       void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  size_t thread_counts[] = {0, 1, 3};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]);
+       i++) {
+    smith_thread_pool_t pool = thread_pool_create(allocator, thread_counts[i]);
+    munit_assert_int(smith_thread_pool_concurrency(pool), ==,
+                     thread_counts[i] + 1);
+    for (size_t round = 0; round < 10; round++) {
+      runs_t runs = {};
+      smith_thread_pool_run(pool, count_run, &runs, 1000);
+      for (size_t j = 0; j < 1000; j++) {
+        munit_assert_int(atomic_load(&runs.runs[j]), ==, 1);
+      }
+    }
+    smith_thread_pool_destroy(pool);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_thread_pool_tests[] = {
+    {
+        .name = "/test_smith_thread_pool_runs_every_task",
+        .test = test_smith_thread_pool_runs_every_task,
+    },
+    {}};
+
+MunitSuite smith_thread_pool_suite = {
+    .prefix = "/thread_pool",
+    .tests = smith_thread_pool_tests,
+    .iterations = 1,
+};
@@ -4,11 +4,13 @@
 #include "smith/finite_allocator.h"
 #include "smith/format.h"
 #include "smith/hash_interner.h"
+#include "smith/null_interner.h"
 #include "smith/random.h"
 #include "smith/string.h"
 #include "smith/system_allocator.h"
 #include "smith/test_suites.h"
 #include "smith/tokenizer.h"
+#include <string.h>
 
 static smith_interner_t interner_create(smith_allocator_t allocator) {
   smith_hash_interner_create_result_t interner_create_result =
@@ -17,13 +19,6 @@ static smith_interner_t interner_create(smith_allocator_t allocator) {
   return interner_create_result.interner;
 }
 
-static smith_keywords_t keywords_create(smith_interner_t interner) {
-  smith_keywords_create_result_t keywords_create_result =
-      smith_keywords_create(interner);
-  munit_assert(keywords_create_result.success);
-  return keywords_create_result.keywords;
-}
-
 static smith_interned_t intern(smith_interner_t interner,
                                smith_string_t string) {
   smith_intern_result_t intern_result = smith_interner_intern(interner, string);
@@ -43,16 +38,16 @@ static MunitResult test_smith_tokenize_symbol(const MunitParameter params[],
                                               void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t symbol = smith_random_symbol(allocator);
   smith_interned_t interned = intern(interner, symbol);
   smith_cursor_t cursor = {.source = symbol.data};
-  smith_next_token_result_t actual =
-      smith_next_token(interner, cursor, keywords);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
   smith_position_t end = {.column = symbol.length};
   smith_next_token_result_t expected = {
       .token = {.kind = SMITH_TOKEN_KIND_SYMBOL,
-                .value.symbol = {.interned = interned, .span.end = end}},
+                .value.symbol = {.interned = interned,
+                                 .text = symbol,
+                                 .span.end = end}},
       .cursor = {.source = "", .position = end}};
   smith_assert_next_token_result_equal(actual, expected);
   smith_interner_destroy(interner);
@@ -64,16 +59,16 @@ static MunitResult test_smith_tokenize_int(const MunitParameter params[],
                                            void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t int_ = smith_random_int(allocator);
   smith_interned_t interned = intern(interner, int_);
   smith_cursor_t cursor = {.source = int_.data};
-  smith_next_token_result_t actual =
-      smith_next_token(interner, cursor, keywords);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
   smith_position_t end = {.column = int_.length};
   smith_next_token_result_t expected = {
       .token = {.kind = SMITH_TOKEN_KIND_INT,
-                .value.int_ = {.interned = interned, .span.end = end}},
+                .value.int_ = {.interned = interned,
+                               .text = int_,
+                               .span.end = end}},
       .cursor = {.source = "", .position = end}};
   smith_assert_next_token_result_equal(actual, expected);
   smith_interner_destroy(interner);
@@ -85,16 +80,16 @@ static MunitResult test_smith_tokenize_float(const MunitParameter params[],
                                              void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t symbol = smith_random_float(allocator);
   smith_interned_t interned = intern(interner, symbol);
   smith_cursor_t cursor = {.source = symbol.data};
-  smith_next_token_result_t actual =
-      smith_next_token(interner, cursor, keywords);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
   smith_position_t end = {.column = symbol.length};
   smith_next_token_result_t expected = {
       .token = {.kind = SMITH_TOKEN_KIND_FLOAT,
-                .value.float_ = {.interned = interned, .span.end = end}},
+                .value.float_ = {.interned = interned,
+                                 .text = symbol,
+                                 .span.end = end}},
       .cursor = {.source = "", .position = end}};
   smith_assert_next_token_result_equal(actual, expected);
   smith_interner_destroy(interner);
@@ -106,7 +101,6 @@ static MunitResult test_smith_tokenize_operator(const MunitParameter params[],
                                                 void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t operators[] = {
       {"+", 1},  {"+=", 2}, {"-", 1},  {"-=", 2}, {"*", 1},
       {"*=", 2}, {"/", 1},  {"/=", 2}, {"=", 1},  {"==", 2},
@@ -127,8 +121,7 @@ static MunitResult test_smith_tokenize_operator(const MunitParameter params[],
   };
   for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
     smith_cursor_t cursor = {.source = operators[i].data};
-    smith_next_token_result_t actual =
-        smith_next_token(interner, cursor, keywords);
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
     smith_position_t end = {.column = operators[i].length};
     smith_next_token_result_t expected = {
         .token = {.kind = SMITH_TOKEN_KIND_OPERATOR,
@@ -145,7 +138,6 @@ static MunitResult test_smith_tokenize_delimiter(const MunitParameter params[],
                                                  void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t operators[] = {{"(", 1}, {")", 1}, {"{", 1}, {"}", 1},
                                 {"[", 1}, {"]", 1}, {",", 1}};
   smith_delimiter_kind_t kinds[] = {
@@ -156,8 +148,7 @@ static MunitResult test_smith_tokenize_delimiter(const MunitParameter params[],
   };
   for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
     smith_cursor_t cursor = {.source = operators[i].data};
-    smith_next_token_result_t actual =
-        smith_next_token(interner, cursor, keywords);
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
     smith_position_t end = {.column = operators[i].length};
     smith_next_token_result_t expected = {
         .token = {.kind = SMITH_TOKEN_KIND_DELIMITER,
@@ -174,7 +165,6 @@ static MunitResult test_smith_tokenize_keyword(const MunitParameter params[],
                                                void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t keyword_strings[] = {{"fn", 2}};
   smith_keyword_kind_t kinds[] = {
       SMITH_KEYWORD_KIND_FN,
@@ -182,8 +172,7 @@ static MunitResult test_smith_tokenize_keyword(const MunitParameter params[],
   for (size_t i = 0; i < sizeof(keyword_strings) / sizeof(keyword_strings[0]);
        i++) {
     smith_cursor_t cursor = {.source = keyword_strings[i].data};
-    smith_next_token_result_t actual =
-        smith_next_token(interner, cursor, keywords);
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
     smith_position_t end = {.column = keyword_strings[i].length};
     smith_next_token_result_t expected = {
         .token = {.kind = SMITH_TOKEN_KIND_KEYWORD,
@@ -196,15 +185,37 @@ static MunitResult test_smith_tokenize_keyword(const MunitParameter params[],
   return MUNIT_OK;
 }
 
+static MunitResult test_smith_keyword_lookup(const MunitParameter params[],
+                                             void *user_data_or_fixture) {
+#define KEYWORD(name, spelling)                                                \
+  {.string = {spelling, sizeof(spelling) - 1},                                 \
+   .kind = SMITH_KEYWORD_KIND_##name},
+  struct {
+    smith_string_t string;
+    smith_keyword_kind_t kind;
+  } keywords[] = {SMITH_TOKEN_TABLE_KEYWORDS(KEYWORD)};
+#undef KEYWORD
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    smith_keyword_lookup_result_t actual =
+        smith_keyword_lookup(keywords[i].string);
+    munit_assert(actual.success);
+    munit_assert_int(actual.kind, ==, keywords[i].kind);
+  }
+  smith_string_t symbols[] = {{"", 0},    {"f", 1},  {"n", 1},  {"fnn", 3},
+                              {"ffn", 3}, {"nf", 2}, {"fx", 2}, {"Fn", 2}};
+  for (size_t i = 0; i < sizeof(symbols) / sizeof(symbols[0]); i++) {
+    munit_assert(!smith_keyword_lookup(symbols[i]).success);
+  }
+  return MUNIT_OK;
+}
+
 static MunitResult
 test_smith_tokenize_empty_string(const MunitParameter params[],
                                  void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_cursor_t cursor = {.source = ""};
-  smith_next_token_result_t actual =
-      smith_next_token(interner, cursor, keywords);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
   smith_next_token_result_t expected = {
       .token.kind = SMITH_TOKEN_KIND_END_OF_FILE, .cursor.source = ""};
   smith_assert_next_token_result_equal(actual, expected);
@@ -218,10 +229,8 @@ test_smith_tokenize_invalid_token(const MunitParameter params[],
                                   void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_cursor_t cursor = {.source = ";"};
-  smith_next_token_result_t actual =
-      smith_next_token(interner, cursor, keywords);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
   smith_next_token_result_t expected = {
       .token = {.kind = SMITH_TOKEN_KIND_ERROR,
                 .value.error = {.kind = SMITH_ERROR_KIND_UNEXPECTED_CHARACTER,
@@ -234,6 +243,66 @@ test_smith_tokenize_invalid_token(const MunitParameter params[],
   return MUNIT_OK;
 }
 
+static MunitResult
+test_smith_tokenize_unicode_symbol(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  // café_名前2, x followed by a combining acute accent, and 名.
+  char *source = "caf\xc3\xa9_\xe5\x90\x8d\xe5\x89\x8d" "2 x\xcc\x81 \xe5\x90\x8d";
+  size_t starts[] = {0, 14, 18};
+  size_t lengths[] = {13, 3, 3};
+  smith_cursor_t cursor = {.source = source};
+  for (size_t i = 0; i < 3; i++) {
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
+    munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_SYMBOL);
+    smith_symbol_t symbol = actual.token.value.symbol;
+    munit_assert_ptr_equal(symbol.text.data, source + starts[i]);
+    munit_assert_size(symbol.text.length, ==, lengths[i]);
+    munit_assert_size(symbol.span.start.column, ==, starts[i]);
+    munit_assert_size(symbol.span.end.column, ==, starts[i] + lengths[i]);
+    cursor = actual.cursor;
+  }
+  munit_assert_int(smith_next_token(interner, cursor).token.kind, ==,
+                   SMITH_TOKEN_KIND_END_OF_FILE);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_unexpected_code_point(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  // The euro sign is consumed whole; a stray lead byte only by itself.
+  char *source = "\xe2\x82\xac\xc3(";
+  smith_cursor_t cursor = {.source = source};
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
+  smith_next_token_result_t expected = {
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_UNEXPECTED_CHARACTER,
+                                .value.unexpected_character = {.character =
+                                                                   '\xe2'}}},
+      .cursor = {.source = source + 3, .position.column = 3}};
+  smith_assert_next_token_result_equal(actual, expected);
+  munit_assert_ptr_equal(actual.cursor.source, source + 3);
+  actual = smith_next_token(interner, actual.cursor);
+  expected = (smith_next_token_result_t){
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_UNEXPECTED_CHARACTER,
+                                .value.unexpected_character =
+                                    {.character = '\xc3',
+                                     .span = {.start.column = 3,
+                                              .end.column = 3}}}},
+      .cursor = {.source = source + 4, .position.column = 4}};
+  smith_assert_next_token_result_equal(actual, expected);
+  munit_assert_ptr_equal(actual.cursor.source, source + 4);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
 static MunitResult
 test_smith_tokenize_interning_fails(const MunitParameter params[],
                                     void *user_data_or_fixture) {
@@ -241,14 +310,12 @@ test_smith_tokenize_interning_fails(const MunitParameter params[],
   smith_allocator_t finite_allocator =
       finite_allocator_create(system_allocator, 1);
   smith_interner_t interner = interner_create(finite_allocator);
-  smith_keywords_t keywords = {0};
   smith_string_t (*random_string[2])(smith_allocator_t) = {smith_random_symbol,
                                                            smith_random_int};
   for (size_t i = 0; i < 2; i++) {
     smith_string_t string = random_string[i](system_allocator);
     smith_cursor_t cursor = {.source = string.data};
-    smith_next_token_result_t actual =
-        smith_next_token(interner, cursor, keywords);
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
     smith_next_token_result_t expected = {
         .token = {.kind = SMITH_TOKEN_KIND_ERROR,
                   .value.error = {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
@@ -264,11 +331,233 @@ test_smith_tokenize_interning_fails(const MunitParameter params[],
   return MUNIT_OK;
 }
 
+static MunitResult test_smith_tokenize_string(const MunitParameter params[],
+                                              void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "\"a slightly longer string, past one block\" x";
+  smith_cursor_t cursor = {.source = source};
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
+  smith_string_t text = {.data = source + 1, .length = 40};
+  smith_next_token_result_t expected = {
+      .token = {.kind = SMITH_TOKEN_KIND_STRING,
+                .value.string = {.text = text,
+                                 .span.end.column = 42}},
+      .cursor = {.source = source + 42, .position.column = 42}};
+  smith_assert_next_token_result_equal(actual, expected);
+  munit_assert_ptr_equal(actual.token.value.string.text.data, text.data);
+  smith_decode_string_result_t decode_string_result =
+      smith_decode_string(allocator, actual.token.value.string);
+  munit_assert(decode_string_result.success);
+  munit_assert_ptr_equal(decode_string_result.string.data, text.data);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_escaped_string(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "\"tab\\t quote\\\" \\\\ nl\\n\\r\\0!\"";
+  smith_cursor_t cursor = {.source = source};
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
+  size_t length = strlen(source);
+  smith_next_token_result_t expected = {
+      .token = {.kind = SMITH_TOKEN_KIND_STRING,
+                .value.string = {.text = {.data = source + 1,
+                                          .length = length - 2},
+                                 .escaped = true,
+                                 .span.end.column = length}},
+      .cursor = {.source = "", .position.column = length}};
+  smith_assert_next_token_result_equal(actual, expected);
+  smith_decode_string_result_t decode_string_result =
+      smith_decode_string(allocator, actual.token.value.string);
+  munit_assert(decode_string_result.success);
+  char decoded[] = "tab\t quote\" \\ nl\n\r\0!";
+  munit_assert_size(decode_string_result.string.length, ==,
+                    sizeof(decoded) - 1);
+  munit_assert_memory_equal(sizeof(decoded), decode_string_result.string.data,
+                            decoded);
+  smith_allocator_deallocate(allocator, decode_string_result.string.data);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_invalid_escape(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "\"a\\qb\\x\" c";
+  smith_cursor_t cursor = {.source = source};
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
+  smith_next_token_result_t expected = {
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_INVALID_ESCAPE,
+                                .value.invalid_escape =
+                                    {.character = 'q',
+                                     .span = {.start.column = 2,
+                                              .end.column = 4}}}},
+      .cursor = {.source = source + 8, .position.column = 8}};
+  smith_assert_next_token_result_equal(actual, expected);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_unterminated_string(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *sources[] = {"\"abc\nd", "\"abc\\\nd", "\"abc", "\"abc\\"};
+  size_t ends[] = {4, 5, 4, 5};
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    smith_cursor_t cursor = {.source = sources[i]};
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
+    smith_next_token_result_t expected = {
+        .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                  .value.error = {.kind = SMITH_ERROR_KIND_UNTERMINATED_STRING,
+                                  .value.unterminated_string.span.end.column =
+                                      ends[i]}},
+        .cursor = {.source = sources[i] + ends[i],
+                   .position.column = ends[i]}};
+    smith_assert_next_token_result_equal(actual, expected);
+  }
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_tokenize_comments(const MunitParameter params[],
+                                                void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "// line \"comment\n"
+                 "/* block\n"
+                 " * comment **/ a //\n"
+                 "/**/ b /* c */";
+  smith_cursor_t cursor =
+      smith_trim_whitespace((smith_cursor_t){.source = source});
+  smith_cursor_t expected_cursor = {.source = strchr(source, 'a'),
+                                    .position = {.line = 2, .column = 15}};
+  smith_assert_cursor_equal(cursor, expected_cursor);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_SYMBOL);
+  actual = smith_next_token(interner, actual.cursor);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_SYMBOL);
+  smith_span_t span = {.start = {.line = 3, .column = 5},
+                       .end = {.line = 3, .column = 6}};
+  smith_assert_span_equal(actual.token.value.symbol.span, span);
+  actual = smith_next_token(interner, actual.cursor);
+  smith_next_token_result_t expected = {
+      .token = {.kind = SMITH_TOKEN_KIND_END_OF_FILE,
+                .value.end_of_file.span = {.start = {.line = 3, .column = 14},
+                                           .end = {.line = 3, .column = 14}}},
+      .cursor = {.source = "", .position = {.line = 3, .column = 14}}};
+  smith_assert_next_token_result_equal(actual, expected);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_unterminated_comment(const MunitParameter params[],
+                                         void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  char *source = "a /* b */ /* c\n d */ e */ /* f\ng";
+  smith_cursor_t cursor = {.source = source};
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
+  actual = smith_next_token(interner, actual.cursor);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_SYMBOL);
+  actual = smith_next_token(interner, actual.cursor);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_OPERATOR);
+  actual = smith_next_token(interner, actual.cursor);
+  munit_assert_int(actual.token.kind, ==, SMITH_TOKEN_KIND_OPERATOR);
+  actual = smith_next_token(interner, actual.cursor);
+  smith_position_t end = {.line = 2, .column = 1};
+  smith_next_token_result_t expected = {
+      .token = {.kind = SMITH_TOKEN_KIND_ERROR,
+                .value.error = {.kind = SMITH_ERROR_KIND_UNTERMINATED_COMMENT,
+                                .value.unterminated_comment.span =
+                                    {.start = {.line = 1, .column = 11},
+                                     .end = end}}},
+      .cursor = {.source = "", .position = end}};
+  smith_assert_next_token_result_equal(actual, expected);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_tokenize_null_interner(const MunitParameter params[],
+                                  void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = smith_null_interner_create();
+  smith_string_t (*random_string[3])(smith_allocator_t) = {
+      smith_random_symbol, smith_random_int, smith_random_float};
+  smith_token_kind_t kinds[3] = {SMITH_TOKEN_KIND_SYMBOL, SMITH_TOKEN_KIND_INT,
+                                 SMITH_TOKEN_KIND_FLOAT};
+  for (size_t i = 0; i < 3; i++) {
+    smith_string_t string = random_string[i](allocator);
+    smith_cursor_t cursor = {.source = string.data};
+    smith_next_token_result_t actual = smith_next_token(interner, cursor);
+    munit_assert_int(actual.token.kind, ==, kinds[i]);
+    smith_string_t *text = smith_token_text(&actual.token);
+    munit_assert_ptr_equal(text->data, string.data);
+    munit_assert_size(text->length, ==, string.length);
+    smith_span_t span = {.end.column = string.length};
+    smith_assert_span_equal(*smith_token_span(&actual.token), span);
+    smith_allocator_deallocate(allocator, string.data);
+  }
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_token_intern(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_interner_t interner = interner_create(allocator);
+  smith_interner_t null_interner = smith_null_interner_create();
+  smith_string_t source = smith_random_source(allocator, 100);
+  smith_cursor_t cursor = {.source = source.data};
+  while (true) {
+    smith_next_token_result_t expected = smith_next_token(interner, cursor);
+    smith_next_token_result_t lazy = smith_next_token(null_interner, cursor);
+    smith_assert_token_equal(smith_token_intern(interner, lazy.token),
+                             expected.token);
+    if (expected.token.kind == SMITH_TOKEN_KIND_END_OF_FILE) {
+      break;
+    }
+    cursor = expected.cursor;
+  }
+  smith_string_t symbol = smith_random_symbol(allocator);
+  smith_next_token_result_t lazy =
+      smith_next_token(null_interner, (smith_cursor_t){.source = symbol.data});
+  smith_token_t expected = {
+      .kind = SMITH_TOKEN_KIND_ERROR,
+      .value.error = {.kind = SMITH_ERROR_KIND_INTERNING_FAILED,
+                      .value.interning_failed = {
+                          .string = symbol,
+                          .span.end.column = symbol.length}}};
+  smith_assert_token_equal(smith_token_intern(null_interner, lazy.token),
+                           expected);
+  smith_allocator_deallocate(allocator, symbol.data);
+  smith_allocator_deallocate(allocator, source.data);
+  smith_interner_destroy(interner);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
 static MunitResult test_smith_tokenize_function(const MunitParameter params[],
                                                 void *user_data_or_fixture) {
   smith_allocator_t allocator = smith_system_allocator_create();
   smith_interner_t interner = interner_create(allocator);
-  smith_keywords_t keywords = keywords_create(interner);
   smith_string_t function_name = smith_random_symbol(allocator);
   smith_interned_t interned_function_name = intern(interner, function_name);
   char *format_string = "fn %s() {\n"
@@ -277,8 +566,7 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
   char *source =
       smith_format_string(allocator, format_string, function_name.data);
   smith_cursor_t cursor = {.source = source};
-  smith_next_token_result_t actual =
-      smith_next_token(interner, cursor, keywords);
+  smith_next_token_result_t actual = smith_next_token(interner, cursor);
   size_t end_column = 2;
   char *remaining_source = source + end_column;
   smith_next_token_result_t expected = {
@@ -291,10 +579,11 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
   size_t start_column = end_column + 1;
   end_column += 1 + function_name.length;
   remaining_source = source + end_column;
-  actual = smith_next_token(interner, actual.cursor, keywords);
+  actual = smith_next_token(interner, actual.cursor);
   expected = (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_SYMBOL,
                 .value.symbol = {.interned = interned_function_name,
+                                 .text = function_name,
                                  .span = {.start.column = start_column,
                                           .end.column = end_column}}},
       .cursor = {.source = remaining_source, .position.column = end_column}};
@@ -303,7 +592,7 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
   start_column = end_column;
   end_column += 1;
   remaining_source = source + end_column;
-  actual = smith_next_token(interner, actual.cursor, keywords);
+  actual = smith_next_token(interner, actual.cursor);
   expected = (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_DELIMITER,
                 .value.delimiter = {.kind = SMITH_DELIMITER_KIND_OPEN_PAREN,
@@ -315,7 +604,7 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
   start_column = end_column;
   end_column += 1;
   remaining_source = source + end_column;
-  actual = smith_next_token(interner, actual.cursor, keywords);
+  actual = smith_next_token(interner, actual.cursor);
   expected = (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_DELIMITER,
                 .value.delimiter = {.kind = SMITH_DELIMITER_KIND_CLOSE_PAREN,
@@ -327,7 +616,7 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
   start_column = end_column + 1;
   end_column += 2;
   remaining_source = source + end_column;
-  actual = smith_next_token(interner, actual.cursor, keywords);
+  actual = smith_next_token(interner, actual.cursor);
   expected = (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_DELIMITER,
                 .value.delimiter = {.kind = SMITH_DELIMITER_KIND_OPEN_BRACE,
@@ -336,7 +625,7 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
       .cursor = {.source = remaining_source, .position.column = end_column}};
   smith_assert_next_token_result_equal(actual, expected);
 
-  actual = smith_next_token(interner, actual.cursor, keywords);
+  actual = smith_next_token(interner, actual.cursor);
   expected = (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_DELIMITER,
                 .value.delimiter = {.kind = SMITH_DELIMITER_KIND_CLOSE_BRACE,
@@ -345,7 +634,7 @@ static MunitResult test_smith_tokenize_function(const MunitParameter params[],
       .cursor = {.source = "", .position = {.line = 2, .column = 1}}};
   smith_assert_next_token_result_equal(actual, expected);
 
-  actual = smith_next_token(interner, actual.cursor, keywords);
+  actual = smith_next_token(interner, actual.cursor);
   expected = (smith_next_token_result_t){
       .token = {.kind = SMITH_TOKEN_KIND_END_OF_FILE,
                 .value.end_of_file.span.start = {.line = 2, .column = 1}},
@@ -381,6 +670,10 @@ static MunitTest smith_tokenizer_tests[] = {
         .name = "/test_smith_tokenize_keyword",
         .test = test_smith_tokenize_keyword,
     },
+    {
+        .name = "/test_smith_keyword_lookup",
+        .test = test_smith_keyword_lookup,
+    },
     {
         .name = "/test_smith_tokenize_empty_string",
         .test = test_smith_tokenize_empty_string,
@@ -389,10 +682,50 @@ static MunitTest smith_tokenizer_tests[] = {
         .name = "/test_smith_tokenize_invalid_token",
         .test = test_smith_tokenize_invalid_token,
     },
+    {
+        .name = "/test_smith_tokenize_unicode_symbol",
+        .test = test_smith_tokenize_unicode_symbol,
+    },
+    {
+        .name = "/test_smith_tokenize_unexpected_code_point",
+        .test = test_smith_tokenize_unexpected_code_point,
+    },
     {
         .name = "/test_smith_tokenize_interning_fails",
         .test = test_smith_tokenize_interning_fails,
     },
+    {
+        .name = "/test_smith_tokenize_string",
+        .test = test_smith_tokenize_string,
+    },
+    {
+        .name = "/test_smith_tokenize_escaped_string",
+        .test = test_smith_tokenize_escaped_string,
+    },
+    {
+        .name = "/test_smith_tokenize_invalid_escape",
+        .test = test_smith_tokenize_invalid_escape,
+    },
+    {
+        .name = "/test_smith_tokenize_unterminated_string",
+        .test = test_smith_tokenize_unterminated_string,
+    },
+    {
+        .name = "/test_smith_tokenize_comments",
+        .test = test_smith_tokenize_comments,
+    },
+    {
+        .name = "/test_smith_tokenize_unterminated_comment",
+        .test = test_smith_tokenize_unterminated_comment,
+    },
+    {
+        .name = "/test_smith_tokenize_null_interner",
+        .test = test_smith_tokenize_null_interner,
+    },
+    {
+        .name = "/test_smith_token_intern",
+        .test = test_smith_token_intern,
+    },
     {
         .name = "/test_smith_tokenize_function",
         .test = test_smith_tokenize_function,
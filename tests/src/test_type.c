@@ -0,0 +1,104 @@
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/type.h"
+
+static smith_type_t intern(smith_type_intern_result_t intern_result) {
+  munit_assert_true(intern_result.success);
+  return intern_result.type;
+}
+
+static MunitResult test_smith_type_intern(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_type_table_t table = smith_type_table_create(allocator);
+  smith_type_t i32 = intern(smith_type_intern_int(&table, 32));
+  smith_type_t i64 = intern(smith_type_intern_int(&table, 64));
+  smith_type_t f32 = intern(smith_type_intern_float(&table, 32));
+  smith_type_t bool_ = intern(smith_type_intern_bool(&table));
+  munit_assert_uint32(table.count, ==, 4);
+  munit_assert_uint32(intern(smith_type_intern_int(&table, 32)), ==, i32);
+  munit_assert_uint32(intern(smith_type_intern_bool(&table)), ==, bool_);
+  munit_assert_uint32(table.count, ==, 4);
+  munit_assert_int(table.types[f32].kind, ==, SMITH_TYPE_KIND_FLOAT);
+  munit_assert_uint32(table.types[i64].width, ==, 64);
+  munit_assert_false(smith_type_intern_int(&table, 0).success);
+  munit_assert_false(smith_type_intern_int(&table, 65).success);
+  munit_assert_false(smith_type_intern_float(&table, 16).success);
+  // Functions are equal when their parameters and results are.
+  smith_type_t parameters[] = {i32, f32, i32};
+  smith_type_t f = intern(smith_type_intern_function(&table, parameters, 3,
+                                                     bool_));
+  munit_assert_uint32(
+      intern(smith_type_intern_function(&table, parameters, 3, bool_)), ==, f);
+  munit_assert_uint32(
+      intern(smith_type_intern_function(&table, parameters, 2, bool_)), !=, f);
+  munit_assert_uint32(
+      intern(smith_type_intern_function(&table, parameters, 3, i32)), !=, f);
+  smith_type_t thunk =
+      intern(smith_type_intern_function(&table, nullptr, 0, f));
+  smith_type_info_t info = table.types[f];
+  munit_assert_uint32(info.parameter_count, ==, 3);
+  munit_assert_uint32(info.result, ==, bool_);
+  munit_assert_memory_equal(sizeof(parameters),
+                            table.parameters + info.parameters, parameters);
+  munit_assert_uint32(table.types[thunk].result, ==, f);
+  munit_assert_false(
+      smith_type_intern_function(&table, parameters, 3, 1000).success);
+  smith_type_table_destroy(table);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_type_grow(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_type_table_t table = smith_type_table_create(allocator);
+  smith_type_t ints[64];
+  for (uint32_t width = 1; width <= 64; width++) {
+    ints[width - 1] = intern(smith_type_intern_int(&table, width));
+  }
+  smith_type_t functions[64];
+  for (uint32_t i = 0; i < 64; i++) {
+    functions[i] =
+        intern(smith_type_intern_function(&table, ints, i + 1, ints[i]));
+    // A parameter list read from the table itself, while the table grows.
+    smith_type_info_t info = table.types[functions[i]];
+    smith_type_t copy = intern(smith_type_intern_function(
+        &table, table.parameters + info.parameters, i + 1, ints[63 - i]));
+    munit_assert_uint32(copy, !=, functions[i]);
+    info = table.types[copy];
+    munit_assert_uint32(info.parameter_count, ==, i + 1);
+    munit_assert_memory_equal((i + 1) * sizeof(smith_type_t),
+                              table.parameters + info.parameters, ints);
+  }
+  for (uint32_t width = 1; width <= 64; width++) {
+    munit_assert_uint32(intern(smith_type_intern_int(&table, width)), ==,
+                        ints[width - 1]);
+  }
+  for (uint32_t i = 0; i < 64; i++) {
+    munit_assert_uint32(
+        intern(smith_type_intern_function(&table, ints, i + 1, ints[i])), ==,
+        functions[i]);
+  }
+  munit_assert_uint32(table.count, ==, 64 * 3);
+  smith_type_table_destroy(table);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_type_tests[] = {
+    {
+        .name = "/test_smith_type_intern",
+        .test = test_smith_type_intern,
+    },
+    {
+        .name = "/test_smith_type_grow",
+        .test = test_smith_type_grow,
+    },
+    {}};
+
+MunitSuite smith_type_suite = {
+    .prefix = "/type",
+    .tests = smith_type_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,147 @@
+#include "smith/test_suites.h"
+#include "smith/unicode.h"
+#include <string.h>
+
+// Validates by decoding one code point at a time from a null terminated copy.
+static smith_utf8_validate_result_t validate_bytewise(char *data,
+                                                      size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    smith_utf8_decode_result_t decode_result = smith_utf8_decode(data + i);
+    if (!decode_result.success || i + decode_result.length > length) {
+      return (smith_utf8_validate_result_t){.offset = i};
+    }
+    i += decode_result.length;
+  }
+  return (smith_utf8_validate_result_t){.offset = i, .success = true};
+}
+
+static MunitResult
+test_smith_utf8_validate_matches_bytewise(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  const char *pieces[] = {
+      "a", "fn x", "0123456789abcdef", "\xc3\xa9", "\xe2\x82\xac",
+      "\xf0\x9f\x98\x80", "\x80", "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80",
+      "\xf4\x90\x80\x80", "\xc3", "\xe2\x82", "\xff",
+  };
+  size_t piece_count = sizeof(pieces) / sizeof(pieces[0]);
+  char buffer[128];
+  for (size_t round = 0; round < 5000; round++) {
+    size_t length = 0;
+    while (true) {
+      const char *piece = pieces[munit_rand_int_range(0, piece_count - 1)];
+      size_t piece_length = strlen(piece);
+      if (length + piece_length >= sizeof(buffer)) {
+        break;
+      }
+      memcpy(buffer + length, piece, piece_length);
+      length += piece_length;
+      if (munit_rand_int_range(0, 7) == 0) {
+        break;
+      }
+    }
+    buffer[length] = '\0';
+    smith_utf8_validate_result_t expected = validate_bytewise(buffer, length);
+    smith_utf8_validate_result_t actual =
+        smith_utf8_validate((smith_string_t){.data = buffer, .length = length});
+    munit_assert(actual.success == expected.success);
+    munit_assert_size(actual.offset, ==, expected.offset);
+  }
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_smith_utf8_validate_truncated(const MunitParameter params[],
+                                   void *user_data_or_fixture) {
+  char source[] = "0123456789abcdef\xe2\x82\xac";
+  for (size_t length = 17; length < 19; length++) {
+    smith_utf8_validate_result_t result =
+        smith_utf8_validate((smith_string_t){.data = source, .length = length});
+    munit_assert_false(result.success);
+    munit_assert_size(result.offset, ==, 16);
+  }
+  smith_utf8_validate_result_t result =
+      smith_utf8_validate((smith_string_t){.data = source, .length = 19});
+  munit_assert_true(result.success);
+  munit_assert_size(result.offset, ==, 19);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_utf8_decode(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  struct {
+    const char *source;
+    uint32_t code_point;
+    uint8_t length;
+  } valid[] = {
+      {"a", 'a', 1},
+      {"\xc3\xa9", 0xE9, 2},
+      {"\xe2\x82\xac", 0x20AC, 3},
+      {"\xf0\x9f\x98\x80", 0x1F600, 4},
+      {"\xf4\x8f\xbf\xbf", 0x10FFFF, 4},
+  };
+  for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+    smith_utf8_decode_result_t result = smith_utf8_decode(valid[i].source);
+    munit_assert_true(result.success);
+    munit_assert_uint32(result.code_point, ==, valid[i].code_point);
+    munit_assert_uint8(result.length, ==, valid[i].length);
+  }
+  const char *invalid[] = {
+      "\x80", "\xc0\xaf", "\xc3", "\xe0\x80\xaf", "\xed\xa0\x80",
+      "\xf4\x90\x80\x80", "\xf8\x88\x80\x80\x80",
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    munit_assert_false(smith_utf8_decode(invalid[i]).success);
+  }
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_is_xid(const MunitParameter params[],
+                                     void *user_data_or_fixture) {
+  munit_assert_true(smith_is_xid_start('a'));
+  munit_assert_false(smith_is_xid_start('_'));
+  munit_assert_false(smith_is_xid_start('1'));
+  munit_assert_true(smith_is_xid_continue('_'));
+  munit_assert_true(smith_is_xid_continue('1'));
+  munit_assert_false(smith_is_xid_continue('+'));
+  // é, 名 and 𝑥 start identifiers.
+  munit_assert_true(smith_is_xid_start(0xE9));
+  munit_assert_true(smith_is_xid_start(0x540D));
+  munit_assert_true(smith_is_xid_start(0x1D465));
+  // A combining acute accent and an Arabic-Indic three only continue them.
+  munit_assert_false(smith_is_xid_start(0x301));
+  munit_assert_true(smith_is_xid_continue(0x301));
+  munit_assert_false(smith_is_xid_start(0x663));
+  munit_assert_true(smith_is_xid_continue(0x663));
+  // The euro sign, a no-break space and unassigned planes do neither.
+  munit_assert_false(smith_is_xid_continue(0x20AC));
+  munit_assert_false(smith_is_xid_continue(0xA0));
+  munit_assert_false(smith_is_xid_continue(0xF0000));
+  munit_assert_false(smith_is_xid_continue(0x10FFFF));
+  return MUNIT_OK;
+}
+
+static MunitTest smith_unicode_tests[] = {
+    {
+        .name = "/test_smith_utf8_validate_matches_bytewise",
+        .test = test_smith_utf8_validate_matches_bytewise,
+    },
+    {
+        .name = "/test_smith_utf8_validate_truncated",
+        .test = test_smith_utf8_validate_truncated,
+    },
+    {
+        .name = "/test_smith_utf8_decode",
+        .test = test_smith_utf8_decode,
+    },
+    {
+        .name = "/test_smith_is_xid",
+        .test = test_smith_is_xid,
+    },
+    {}};
+
+MunitSuite smith_unicode_suite = {
+    .prefix = "/unicode",
+    .tests = smith_unicode_tests,
+    .iterations = 1,
+};
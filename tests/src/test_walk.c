@@ -0,0 +1,234 @@
+#define SMITH_ENABLE_ALLOCATOR_MACROS
+
+#include "smith/null_interner.h"
+#include "smith/system_allocator.h"
+#include "smith/test_suites.h"
+#include "smith/walk.h"
+#include <stdio.h>
+#include <string.h>
+
+// Writes a chain of up to `terms` operands joined by random operators, so
+// that mixed precedence and associativity give trees of varied shapes.
+static void random_expression(char *source, size_t capacity, int terms) {
+  const char *operators[] = {"+", "-", "*", "/", "==", "=", "<", "|"};
+  const char *operands[] = {"a", "b", "1", "2.5"};
+  size_t length = snprintf(source, capacity, "%s",
+                           operands[munit_rand_int_range(0, 3)]);
+  int count = munit_rand_int_range(0, terms);
+  for (int i = 0; i < count; i++) {
+    length += snprintf(source + length, capacity - length, " %s %s",
+                       operators[munit_rand_int_range(0, 7)],
+                       operands[munit_rand_int_range(0, 3)]);
+  }
+}
+
+static void reference_pre_order(const smith_ast_t *ast, smith_ast_node_t node,
+                                smith_ast_node_t *nodes, size_t *count) {
+  nodes[(*count)++] = node;
+  if (ast->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    reference_pre_order(ast, ast->children[node].left, nodes, count);
+    reference_pre_order(ast, ast->children[node].right, nodes, count);
+  }
+}
+
+static void reference_post_order(const smith_ast_t *ast, smith_ast_node_t node,
+                                 smith_ast_node_t *nodes, size_t *count) {
+  if (ast->kinds[node] == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+    reference_post_order(ast, ast->children[node].left, nodes, count);
+    reference_post_order(ast, ast->children[node].right, nodes, count);
+  }
+  nodes[(*count)++] = node;
+}
+
+// Checks that both iterators visit the nodes of the expression at `root` in
+// the same order as `expected`, a node order of the flat AST.
+static void assert_walks(smith_allocator_t allocator, const smith_ast_t *ast,
+                         smith_ast_node_t root, smith_walk_order_t order,
+                         const smith_ast_node_t *expected, size_t count) {
+  smith_ast_iterator_t ast_iterator =
+      smith_ast_iterator_create(allocator, ast, root, order);
+  smith_ast_to_expression_result_t to_expression_result =
+      smith_ast_to_expression(allocator, ast, root);
+  munit_assert_true(to_expression_result.success);
+  smith_expression_t expression = to_expression_result.expression;
+  smith_expression_iterator_t expression_iterator =
+      smith_expression_iterator_create(allocator, &expression, order);
+  for (size_t i = 0; i < count; i++) {
+    smith_ast_iterator_next_result_t next_result =
+        smith_ast_iterator_next(&ast_iterator);
+    munit_assert_true(next_result.success);
+    munit_assert_uint32(next_result.node, ==, expected[i]);
+    const smith_expression_t *current =
+        smith_expression_iterator_next(&expression_iterator);
+    munit_assert_not_null(current);
+    uint8_t kind = ast->kinds[expected[i]];
+    munit_assert_int(current->kind, ==, kind);
+    if (kind == SMITH_EXPRESSION_KIND_BINARY_OPERATOR) {
+      munit_assert_int(current->value.binary_operator.info.kind, ==,
+                       ast->payloads[expected[i]].binary_operator.kind);
+    } else if (kind == SMITH_EXPRESSION_KIND_SYMBOL) {
+      // Both point into the same source text.
+      munit_assert_ptr_equal(current->value.symbol.text.data,
+                             ast->payloads[expected[i]].leaf.text.data);
+    }
+  }
+  munit_assert_false(smith_ast_iterator_next(&ast_iterator).success);
+  munit_assert_false(ast_iterator.failed);
+  munit_assert_null(smith_expression_iterator_next(&expression_iterator));
+  munit_assert_false(expression_iterator.failed);
+  smith_expression_iterator_destroy(expression_iterator);
+  smith_expression_destroy(allocator, expression);
+  smith_ast_iterator_destroy(ast_iterator);
+}
+
+static MunitResult test_smith_walk_orders(const MunitParameter params[],
+                                          void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  char source[1024];
+  smith_ast_node_t expected[256];
+  for (int round = 0; round < 200; round++) {
+    random_expression(source, sizeof(source), 60);
+    smith_ast_t ast = smith_ast_create(allocator);
+    // A second expression checks that walks stay within their subtree.
+    smith_parse_ast(context, &ast, (smith_cursor_t){.source = "x * y"});
+    smith_parse_ast_result_t parse_result =
+        smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+    size_t count = 0;
+    reference_pre_order(&ast, parse_result.root, expected, &count);
+    assert_walks(allocator, &ast, parse_result.root, SMITH_WALK_ORDER_PRE,
+                 expected, count);
+    count = 0;
+    reference_post_order(&ast, parse_result.root, expected, &count);
+    assert_walks(allocator, &ast, parse_result.root, SMITH_WALK_ORDER_POST,
+                 expected, count);
+    smith_ast_destroy(ast);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitResult test_smith_walk_deep(const MunitParameter params[],
+                                        void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  // Assignment groups to the right, so this nests as deep as it is long.
+  size_t terms = 50000;
+  char *source = smith_allocator_allocate_array(allocator, char, terms * 4);
+  munit_assert_not_null(source);
+  for (size_t i = 0; i < terms; i++) {
+    memcpy(source + i * 4, "a = ", 4);
+  }
+  source[terms * 4 - 3] = '\0';
+  smith_ast_t ast = smith_ast_create(allocator);
+  smith_parse_ast_result_t parse_result =
+      smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+  smith_ast_to_expression_result_t to_expression_result =
+      smith_ast_to_expression(allocator, &ast, parse_result.root);
+  munit_assert_true(to_expression_result.success);
+  smith_expression_t expression = to_expression_result.expression;
+  for (int order = SMITH_WALK_ORDER_PRE; order <= SMITH_WALK_ORDER_POST;
+       order++) {
+    smith_ast_iterator_t ast_iterator =
+        smith_ast_iterator_create(allocator, &ast, parse_result.root, order);
+    uint32_t count = 0;
+    while (smith_ast_iterator_next(&ast_iterator).success) {
+      count++;
+    }
+    munit_assert_false(ast_iterator.failed);
+    munit_assert_uint32(count, ==, ast.count);
+    smith_ast_iterator_destroy(ast_iterator);
+    smith_expression_iterator_t expression_iterator =
+        smith_expression_iterator_create(allocator, &expression, order);
+    const smith_expression_t *first =
+        smith_expression_iterator_next(&expression_iterator);
+    count = 1;
+    while (smith_expression_iterator_next(&expression_iterator) != nullptr) {
+      count++;
+    }
+    munit_assert_false(expression_iterator.failed);
+    munit_assert_uint32(count, ==, ast.count);
+    munit_assert_int(first->kind, ==,
+                     order == SMITH_WALK_ORDER_PRE
+                         ? SMITH_EXPRESSION_KIND_BINARY_OPERATOR
+                         : SMITH_EXPRESSION_KIND_SYMBOL);
+    smith_expression_iterator_destroy(expression_iterator);
+  }
+  smith_expression_destroy(allocator, expression);
+  smith_ast_destroy(ast);
+  smith_allocator_deallocate(allocator, source);
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+typedef struct {
+  const smith_ast_t *ast;
+  size_t counts[SMITH_EXPRESSION_KIND_CONSTANT + 1];
+  smith_ast_node_t last[SMITH_EXPRESSION_KIND_CONSTANT + 1];
+} batch_state_t;
+
+static void visit_batch(void *state, smith_expression_kind_t kind,
+                        const smith_ast_node_t *nodes, size_t count) {
+  batch_state_t *batch_state = state;
+  munit_assert_size(count, >, 0);
+  munit_assert_size(count, <=, SMITH_WALK_BATCH_SIZE);
+  for (size_t i = 0; i < count; i++) {
+    munit_assert_int(batch_state->ast->kinds[nodes[i]], ==, kind);
+    munit_assert_uint32(nodes[i], >=, batch_state->last[kind]);
+    batch_state->last[kind] = nodes[i] + 1;
+  }
+  batch_state->counts[kind] += count;
+}
+
+static MunitResult test_smith_walk_batches(const MunitParameter params[],
+                                           void *user_data_or_fixture) {
+  smith_allocator_t allocator = smith_system_allocator_create();
+  smith_parser_context_t context = {.allocator = allocator,
+                                    .interner = smith_null_interner_create()};
+  char source[8192];
+  for (int round = 0; round < 50; round++) {
+    random_expression(source, sizeof(source), 600);
+    smith_ast_t ast = smith_ast_create(allocator);
+    smith_parse_ast(context, &ast, (smith_cursor_t){.source = "x * y"});
+    smith_parse_ast_result_t parse_result =
+        smith_parse_ast(context, &ast, (smith_cursor_t){.source = source});
+    batch_state_t state = {.ast = &ast};
+    smith_ast_visit_batches(
+        &ast, parse_result.root,
+        (smith_ast_batch_visitor_t){.state = &state, .visit = visit_batch});
+    size_t expected[SMITH_EXPRESSION_KIND_CONSTANT + 1] = {};
+    for (smith_ast_node_t node = smith_ast_first(&ast, parse_result.root);
+         node <= parse_result.root; node++) {
+      expected[ast.kinds[node]]++;
+    }
+    for (size_t kind = 0; kind <= SMITH_EXPRESSION_KIND_CONSTANT; kind++) {
+      munit_assert_size(state.counts[kind], ==, expected[kind]);
+    }
+    smith_ast_destroy(ast);
+  }
+  smith_allocator_destroy(allocator);
+  return MUNIT_OK;
+}
+
+static MunitTest smith_walk_tests[] = {
+    {
+        .name = "/test_smith_walk_orders",
+        .test = test_smith_walk_orders,
+    },
+    {
+        .name = "/test_smith_walk_deep",
+        .test = test_smith_walk_deep,
+    },
+    {
+        .name = "/test_smith_walk_batches",
+        .test = test_smith_walk_batches,
+    },
+    {}};
+
+MunitSuite smith_walk_suite = {
+    .prefix = "/walk",
+    .tests = smith_walk_tests,
+    .iterations = 1,
+};
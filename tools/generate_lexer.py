@@ -0,0 +1,439 @@
+#!/usr/bin/env python3
+"""Generates src/dfa_lexer.inc and src/keyword_hash.inc from
+include/smith/token_table.h, and src/xid_table.inc from the Unicode database.
+
+Every operator, delimiter and literal shape in the token table is compiled to
+an NFA, determinized with the subset construction and minimized by partition
+refinement. Bytes that behave identically in every state are merged into
+character classes, and each state becomes a label whose row of successor
+labels is dispatched with a computed goto.
+
+Keywords are placed in a table indexed by a perfect hash of their length,
+first byte and last byte, so classifying an identifier costs one hash and at
+most one comparison.
+
+The XID_Start and XID_Continue properties are split into 256 code point
+blocks. Identical blocks are stored once, as a pair of 256 bit sets, and a
+first stage table maps each block number to its stored block.
+
+Usage: python3 tools/generate_lexer.py
+"""
+
+import pathlib
+import re
+import textwrap
+import unicodedata
+
+ROOT = pathlib.Path(__file__).resolve().parent.parent
+TABLE = ROOT / "include" / "smith" / "token_table.h"
+OUTPUT = ROOT / "src" / "dfa_lexer.inc"
+KEYWORD_OUTPUT = ROOT / "src" / "keyword_hash.inc"
+XID_OUTPUT = ROOT / "src" / "xid_table.inc"
+
+
+def read_table(text, name):
+    match = re.search(r"#define %s\(X\)((?:.*\\\n)*.*)" % name, text)
+    if match is None:
+        raise SystemExit("missing table %s" % name)
+    entries = re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', match.group(1))
+    return [(entry, re.sub(r"\\(.)", r"\1", spelling)) for entry, spelling in entries]
+
+
+class Nfa:
+    def __init__(self):
+        self.edges = []  # (bytes, target) per state
+        self.epsilons = []
+        self.accepts = {}
+
+    def state(self):
+        self.edges.append([])
+        self.epsilons.append([])
+        return len(self.edges) - 1
+
+    def literal(self, string):
+        start = self.state()
+        end = start
+        for byte in string.encode():
+            next_ = self.state()
+            self.edges[end].append((frozenset([byte]), next_))
+            end = next_
+        return start, end
+
+
+class RegexParser:
+    """Thompson construction for the small regular expression dialect."""
+
+    def __init__(self, nfa, pattern):
+        self.nfa = nfa
+        self.pattern = pattern
+        self.index = 0
+
+    def peek(self):
+        return self.pattern[self.index] if self.index < len(self.pattern) else None
+
+    def take(self):
+        character = self.pattern[self.index]
+        self.index += 1
+        return character
+
+    def parse(self):
+        start, end = self.alternation()
+        if self.peek() is not None:
+            raise SystemExit("unexpected %r in %r" % (self.peek(), self.pattern))
+        return start, end
+
+    def alternation(self):
+        start, end = self.concatenation()
+        while self.peek() == "|":
+            self.take()
+            other_start, other_end = self.concatenation()
+            new_start, new_end = self.nfa.state(), self.nfa.state()
+            self.nfa.epsilons[new_start] += [start, other_start]
+            self.nfa.epsilons[end].append(new_end)
+            self.nfa.epsilons[other_end].append(new_end)
+            start, end = new_start, new_end
+        return start, end
+
+    def concatenation(self):
+        start = end = self.nfa.state()
+        while self.peek() not in (None, "|", ")"):
+            factor_start, factor_end = self.repetition()
+            self.nfa.epsilons[end].append(factor_start)
+            end = factor_end
+        return start, end
+
+    def repetition(self):
+        start, end = self.atom()
+        while self.peek() in ("*", "+", "?"):
+            operator = self.take()
+            new_start, new_end = self.nfa.state(), self.nfa.state()
+            self.nfa.epsilons[new_start].append(start)
+            self.nfa.epsilons[end].append(new_end)
+            if operator in ("*", "?"):
+                self.nfa.epsilons[new_start].append(new_end)
+            if operator in ("*", "+"):
+                self.nfa.epsilons[end].append(start)
+            start, end = new_start, new_end
+        return start, end
+
+    def atom(self):
+        character = self.take()
+        if character == "(":
+            start, end = self.alternation()
+            if self.take() != ")":
+                raise SystemExit("unbalanced group in %r" % self.pattern)
+            return start, end
+        if character == "[":
+            bytes_ = set()
+            while self.peek() != "]":
+                low = self.escaped(self.take())
+                if self.peek() == "-" and self.pattern[self.index + 1] != "]":
+                    self.take()
+                    high = self.escaped(self.take())
+                    bytes_.update(range(ord(low), ord(high) + 1))
+                else:
+                    bytes_.add(ord(low))
+            self.take()
+        else:
+            bytes_ = {ord(self.escaped(character))}
+        start, end = self.nfa.state(), self.nfa.state()
+        self.nfa.edges[start].append((frozenset(bytes_), end))
+        return start, end
+
+    def escaped(self, character):
+        return self.take() if character == "\\" else character
+
+
+def build_nfa(tokens):
+    nfa = Nfa()
+    start = nfa.state()
+    for priority, (action, kind, spelling) in enumerate(tokens):
+        if kind == "literal":
+            token_start, token_end = RegexParser(nfa, spelling).parse()
+        else:
+            token_start, token_end = nfa.literal(spelling)
+        nfa.epsilons[start].append(token_start)
+        nfa.accepts[token_end] = (priority, action)
+    return nfa, start
+
+
+def closure(nfa, states):
+    stack = list(states)
+    seen = set(states)
+    while stack:
+        for next_ in nfa.epsilons[stack.pop()]:
+            if next_ not in seen:
+                seen.add(next_)
+                stack.append(next_)
+    return frozenset(seen)
+
+
+def determinize(nfa, start):
+    """Returns (transitions, accepts) with transitions[state][byte] or None."""
+    initial = closure(nfa, [start])
+    index = {initial: 0}
+    order = [initial]
+    transitions = []
+    accepts = []
+    for subset in order:
+        row = []
+        for byte in range(256):
+            targets = [
+                target
+                for state in subset
+                for bytes_, target in nfa.edges[state]
+                if byte in bytes_
+            ]
+            if byte == 0 or not targets:
+                row.append(None)
+                continue
+            next_ = closure(nfa, targets)
+            if next_ not in index:
+                index[next_] = len(order)
+                order.append(next_)
+            row.append(index[next_])
+        transitions.append(row)
+        matches = [nfa.accepts[state] for state in subset if state in nfa.accepts]
+        accepts.append(min(matches)[1] if matches else None)
+    return transitions, accepts
+
+
+def minimize(transitions, accepts):
+    """Moore partition refinement; the start state stays state 0."""
+    blocks = [accepts[state] for state in range(len(transitions))]
+    while True:
+        signatures = [
+            (blocks[state],)
+            + tuple(None if t is None else blocks[t] for t in transitions[state])
+            for state in range(len(transitions))
+        ]
+        numbering = {}
+        refined = [numbering.setdefault(s, len(numbering)) for s in signatures]
+        if len(numbering) == len(set(blocks)):
+            break
+        blocks = refined
+    numbering = {}
+    for state in range(len(transitions)):
+        numbering.setdefault(blocks[state], len(numbering))
+    count = len(numbering)
+    minimal_transitions = [None] * count
+    minimal_accepts = [None] * count
+    for state in range(len(transitions)):
+        block = numbering[blocks[state]]
+        minimal_transitions[block] = [
+            None if t is None else numbering[blocks[t]] for t in transitions[state]
+        ]
+        minimal_accepts[block] = accepts[state]
+    return minimal_transitions, minimal_accepts
+
+
+def character_classes(transitions):
+    columns = {}
+    classes = []
+    for byte in range(256):
+        column = tuple(row[byte] for row in transitions)
+        classes.append(columns.setdefault(column, len(columns)))
+    return classes, list(columns)
+
+
+def emit(transitions, accepts):
+    classes, columns = character_classes(transitions)
+    if len(columns) > 64:
+        raise SystemExit("more than 64 character classes")
+    lines = [
+        "// Generated by tools/generate_lexer.py from include/smith/token_table.h.",
+        "// Do not edit by hand; regenerate after changing the token table.",
+        "//",
+        "// Expanded inside smith_dfa_next_token, which provides `source`, `length`",
+        "// and the SMITH_DFA_ACCEPT_* and SMITH_DFA_REJECT macros. Entering a state",
+        "// consumes one byte; a state with no transition for the next byte accepts.",
+        "// %d states, %d character classes." % (len(transitions), len(columns)),
+        "",
+        "static const uint8_t dfa_classes[256] = {",
+    ]
+    for row in range(0, 256, 16):
+        lines.append("    " + " ".join("%d," % c for c in classes[row : row + 16]))
+    lines.append("};")
+    targets = set()
+    for state, row in enumerate(transitions):
+        labels = []
+        for column in columns:
+            target = column[state]
+            if target is not None:
+                labels.append("&&dfa_state_%d" % target)
+                targets.add(target)
+            elif accepts[state] is not None:
+                labels.append("&&dfa_accept_%d" % state)
+            else:
+                labels.append("&&dfa_reject")
+        lines.append("static const void *const dfa_row_%d[%d] = {" % (state, len(columns)))
+        lines += textwrap.wrap(
+            ", ".join(labels) + "};",
+            width=80,
+            initial_indent="    ",
+            subsequent_indent="    ",
+        )
+    if 0 in targets:
+        lines.append("goto dfa_dispatch_0;")
+    for state, row in enumerate(transitions):
+        if state in targets:
+            lines.append("dfa_state_%d:" % state)
+            lines.append("  length++;")
+        if state == 0 and 0 in targets:
+            lines.append("dfa_dispatch_0:")
+        stay = [i for i, column in enumerate(columns) if column[state] == state]
+        if stay:
+            # Runs of a self-looping state (identifiers, digits) take a well
+            # predicted conditional branch per byte instead of an indirect jump.
+            mask = sum(1 << i for i in stay)
+            lines.append(
+                "  while ((UINT64_C(%#x) >> dfa_classes[(uint8_t)source[length]]) & 1)"
+                % mask
+            )
+            lines.append("    length++;")
+        lines.append(
+            "  goto *dfa_row_%d[dfa_classes[(uint8_t)source[length]]];" % state
+        )
+        if accepts[state] is not None:
+            lines.append("dfa_accept_%d:" % state)
+            lines.append("  %s;" % accepts[state])
+    lines.append("dfa_reject:")
+    lines.append("  SMITH_DFA_REJECT();")
+    return "\n".join(lines) + "\n"
+
+
+def keyword_hash(keywords):
+    """Finds multipliers making (length, first, last) collision free."""
+    keys = {(len(spelling), spelling[0], spelling[-1]) for _, spelling in keywords}
+    if len(keys) != len(keywords):
+        raise SystemExit("keywords must differ in length, first or last byte")
+    size = 1
+    while size < len(keywords):
+        size *= 2
+    while True:
+        for length_multiplier in range(1, 64):
+            for first_multiplier in range(64):
+                slots = [
+                    (len(spelling) * length_multiplier
+                     + ord(spelling[0]) * first_multiplier
+                     + ord(spelling[-1])) % size
+                    for _, spelling in keywords
+                ]
+                if len(set(slots)) == len(slots):
+                    return size, length_multiplier, first_multiplier, slots
+        size *= 2
+
+
+def emit_keywords(keywords):
+    size, length_multiplier, first_multiplier, slots = keyword_hash(keywords)
+    lines = [
+        "// Generated by tools/generate_lexer.py from include/smith/token_table.h.",
+        "// Do not edit by hand; regenerate after changing the token table.",
+        "//",
+        "// Perfect hash of a keyword's length, first byte and last byte. A string",
+        "// is a keyword only if its slot holds an entry with the same spelling.",
+        "",
+        "static inline smith_keyword_lookup_result_t",
+        "keyword_lookup(smith_string_t string) {",
+        "  static const struct {",
+        "    const char *spelling;",
+        "    size_t length;",
+        "    smith_keyword_kind_t kind;",
+        "  } table[%d] = {" % size,
+    ]
+    for (name, spelling), slot in sorted(zip(keywords, slots), key=lambda k: k[1]):
+        lines.append(
+            '      [%d] = {"%s", %d, SMITH_KEYWORD_KIND_%s},'
+            % (slot, spelling, len(spelling), name)
+        )
+    lines += [
+        "  };",
+        "  if (string.length == 0) {",
+        "    return (smith_keyword_lookup_result_t){};",
+        "  }",
+        "  size_t slot = (string.length * %d +" % length_multiplier,
+        "                 (uint8_t)string.data[0] * %d +" % first_multiplier,
+        "                 (uint8_t)string.data[string.length - 1]) &",
+        "                %d;" % (size - 1),
+        "  if (table[slot].length != string.length ||",
+        "      memcmp(table[slot].spelling, string.data, string.length) != 0) {",
+        "    return (smith_keyword_lookup_result_t){};",
+        "  }",
+        "  return (smith_keyword_lookup_result_t){.kind = table[slot].kind,",
+        "                                         .success = true};",
+        "}",
+    ]
+    return "\n".join(lines) + "\n"
+
+
+def xid_blocks():
+    """Splits XID_Start and XID_Continue into deduplicated 256 bit blocks."""
+    blocks = {(0, 0): 0}
+    stage1 = []
+    for block in range(0x110000 >> 8):
+        start = 0
+        continue_ = 0
+        for low in range(256):
+            code_point = block << 8 | low
+            if 0xD800 <= code_point <= 0xDFFF:
+                continue
+            character = chr(code_point)
+            # A lone underscore is an identifier, but it is not XID_Start.
+            if character.isidentifier() and character != "_":
+                start |= 1 << low
+            if ("a" + character).isidentifier():
+                continue_ |= 1 << low
+        stage1.append(blocks.setdefault((start, continue_), len(blocks)))
+    while stage1[-1] == 0:
+        stage1.pop()
+    return stage1, sorted(blocks, key=blocks.get)
+
+
+def emit_xid(stage1, blocks):
+    lines = [
+        "// Generated by tools/generate_lexer.py from the Unicode %s database."
+        % unicodedata.unidata_version,
+        "// Do not edit by hand.",
+        "//",
+        "// xid_stage1 maps a code point's 256 code point block to a row of",
+        "// xid_blocks. Each row holds the four XID_Start words and then the four",
+        "// XID_Continue words of the block, lowest code point in the lowest bit.",
+        "// Blocks past the end of xid_stage1 have neither property.",
+        "",
+        "static const uint8_t xid_stage1[%d] = {" % len(stage1),
+    ]
+    for i in range(0, len(stage1), 12):
+        lines.append(
+            "    " + " ".join("%d," % index for index in stage1[i : i + 12])
+        )
+    lines += ["};", "", "static const uint64_t xid_blocks[%d][8] = {" % len(blocks)]
+    for start, continue_ in blocks:
+        words = [(bits >> (64 * i)) & (2**64 - 1)
+                 for bits in (start, continue_) for i in range(4)]
+        words = ["0x%016x" % word for word in words]
+        lines.append("    {%s," % ", ".join(words[0:3]))
+        lines.append("     %s," % ", ".join(words[3:6]))
+        lines.append("     %s}," % ", ".join(words[6:8]))
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    text = TABLE.read_text()
+    tokens = []
+    for name, spelling in read_table(text, "SMITH_TOKEN_TABLE_OPERATORS"):
+        tokens.append(("SMITH_DFA_ACCEPT_OPERATOR(%s)" % name, "fixed", spelling))
+    for name, spelling in read_table(text, "SMITH_TOKEN_TABLE_DELIMITERS"):
+        tokens.append(("SMITH_DFA_ACCEPT_DELIMITER(%s)" % name, "fixed", spelling))
+    for name, pattern in read_table(text, "SMITH_TOKEN_TABLE_LITERALS"):
+        tokens.append(("SMITH_DFA_ACCEPT_%s()" % name, "literal", pattern))
+    nfa, start = build_nfa(tokens)
+    transitions, accepts = minimize(*determinize(nfa, start))
+    OUTPUT.write_text(emit(transitions, accepts))
+    keywords = read_table(text, "SMITH_TOKEN_TABLE_KEYWORDS")
+    KEYWORD_OUTPUT.write_text(emit_keywords(keywords))
+    XID_OUTPUT.write_text(emit_xid(*xid_blocks()))
+
+
+if __name__ == "__main__":
+    main()